@@ -49,6 +49,9 @@ TasmotaSerial::TasmotaSerial(int receive_pin, int transmit_pin, int hardware_fal
   m_stop_bits = 1;
   m_nwmode = nwmode;
   serial_buffer_size = buffer_size;
+  m_buffer_mask = 1;
+  while (m_buffer_mask < serial_buffer_size) { m_buffer_mask <<= 1; }  // Round up to power of two
+  m_buffer_mask--;
   m_rx_pin = receive_pin;
   m_tx_pin = transmit_pin;
   m_in_pos = m_out_pos = 0;
@@ -65,7 +68,7 @@ TasmotaSerial::TasmotaSerial(int receive_pin, int transmit_pin, int hardware_fal
   }
   else {
     if (m_rx_pin > -1) {
-      m_buffer = (uint8_t*)malloc(serial_buffer_size);
+      m_buffer = (uint8_t*)malloc(m_buffer_mask +1);
       if (m_buffer == NULL) return;
       // Use getCycleCount() loop to get as exact timing as possible
       m_bit_time = ESP.getCpuFreqMHz() * 1000000 / TM_SERIAL_BAUDRATE;
@@ -169,7 +172,7 @@ void TasmotaSerial::flush() {
     TSerial->flush();
 #endif  // ESP32
   } else {
-    m_in_pos = m_out_pos = 0;
+    m_out_pos = m_in_pos;                     // Discard received data, only the interrupt writes m_in_pos
   }
 }
 
@@ -187,9 +190,22 @@ int TasmotaSerial::peek() {
   }
 }
 
+size_t TasmotaSerial::peek(uint8_t *buffer, size_t size) {
+  // Copy up to size bytes already received without removing them. Hardware serial peeks one byte only
+  if (m_hardserial) {
+    int ch = peek();
+    if ((ch < 0) || !size) { return 0; }
+    buffer[0] = ch;
+    return 1;
+  } else {
+    return copyOut(buffer, size, false);
+  }
+}
+
 int TasmotaSerial::read() {
   if (m_hardserial) {
 #ifdef ESP8266
+    if (Serial.hasOverrun()) { m_overrun++; }
     return Serial.read();
 #endif  // ESP8266
 #ifdef ESP32
@@ -198,11 +214,51 @@ int TasmotaSerial::read() {
   } else {
     if ((-1 == m_rx_pin) || (m_in_pos == m_out_pos)) return -1;
     uint32_t ch = m_buffer[m_out_pos];
-    m_out_pos = (m_out_pos +1) % serial_buffer_size;
+    m_out_pos = (m_out_pos +1) & m_buffer_mask;
     return ch;
   }
 }
 
+size_t TasmotaSerial::copyOut(uint8_t *buffer, size_t size, bool consume) {
+  if (-1 == m_rx_pin) return 0;
+  uint32_t in_pos = m_in_pos;                 // Snapshot as the interrupt may add data while copying
+  uint32_t out_pos = m_out_pos;
+  size_t count = 0;
+  while ((count < size) && (out_pos != in_pos)) {
+    uint32_t end = (in_pos > out_pos) ? in_pos : m_buffer_mask +1;  // Copy up to buffer wrap
+    uint32_t len = end - out_pos;
+    if (len > size - count) { len = size - count; }
+    memcpy(buffer + count, m_buffer + out_pos, len);
+    count += len;
+    out_pos = (out_pos + len) & m_buffer_mask;
+  }
+  if (consume) {
+    m_out_pos = out_pos;                      // Release space to the interrupt after copying
+  }
+  return count;
+}
+
+size_t TasmotaSerial::read(uint8_t *buffer, size_t size) {
+  // Read up to size bytes already received without waiting
+  if (m_hardserial) {
+#ifdef ESP8266
+    if (Serial.hasOverrun()) { m_overrun++; }
+    return Serial.read((char*)buffer, size);
+#endif  // ESP8266
+#ifdef ESP32
+    size_t count = 0;
+    size_t avail = TSerial->available();
+    if (size > avail) { size = avail; }
+    while (count < size) {
+      buffer[count++] = TSerial->read();
+    }
+    return count;
+#endif  // ESP32
+  } else {
+    return copyOut(buffer, size, true);
+  }
+}
+
 int TasmotaSerial::available() {
   if (m_hardserial) {
 #ifdef ESP8266
@@ -212,9 +268,7 @@ int TasmotaSerial::available() {
     return TSerial->available();
 #endif  // ESP32
   } else {
-    int avail = m_in_pos - m_out_pos;
-    if (avail < 0) avail += serial_buffer_size;
-    return avail;
+    return (m_in_pos - m_out_pos) & m_buffer_mask;
   }
 }
 
@@ -279,6 +333,35 @@ size_t TasmotaSerial::write(uint8_t b) {
   }
 }
 
+size_t TasmotaSerial::write(const uint8_t *buffer, size_t size) {
+  if (m_hardserial) {
+#ifdef ESP8266
+    return Serial.write(buffer, size);
+#endif  // ESP8266
+#ifdef ESP32
+    return TSerial->write(buffer, size);
+#endif  // ESP32
+  } else {
+    size_t count = 0;
+    while (count < size) {
+      if (!write(buffer[count])) { break; }
+      count++;
+    }
+    return count;
+  }
+}
+
+void ICACHE_RAM_ATTR TasmotaSerial::rxStore(uint32_t rec) {
+  // Store the received value in the buffer unless we have an overflow
+  uint32_t next = (m_in_pos +1) & m_buffer_mask;
+  if (next != m_out_pos) {
+    m_buffer[m_in_pos] = rec;
+    m_in_pos = next;                          // Publish byte to the consumer after storing it
+  } else {
+    m_overrun++;
+  }
+}
+
 void ICACHE_RAM_ATTR TasmotaSerial::rxRead() {
   if (!m_nwmode) {
     int32_t loop_read = m_very_high_speed ? serial_buffer_size : 1;
@@ -293,12 +376,7 @@ void ICACHE_RAM_ATTR TasmotaSerial::rxRead() {
         rec >>= 1;
         if (digitalRead(m_rx_pin)) rec |= 0x80;
       }
-      // Store the received value in the buffer unless we have an overflow
-      uint32_t next = (m_in_pos+1) % serial_buffer_size;
-      if (next != (int)m_out_pos) {
-        m_buffer[m_in_pos] = rec;
-        m_in_pos = next;
-      }
+      rxStore(rec);
 
       TM_SERIAL_WAIT_RCV_LOOP;    // wait for stop bit
       if (2 == m_stop_bits) {
@@ -358,11 +436,7 @@ void ICACHE_RAM_ATTR TasmotaSerial::rxRead() {
           ss_byte |= (1 << i);
         }
         //stobyte(0,ssp->ss_byte>>1);
-        uint32_t next = (m_in_pos + 1) % serial_buffer_size;
-        if (next != (uint32_t)m_out_pos) {
-          m_buffer[m_in_pos] = ss_byte >> 1;
-          m_in_pos = next;
-        }
+        rxStore(ss_byte >> 1);
 
         ss_bstart = ESP.getCycleCount() - (m_bit_time / 4);
         ss_byte = 0;
@@ -372,11 +446,7 @@ void ICACHE_RAM_ATTR TasmotaSerial::rxRead() {
       if (diff >= LASTBIT) {
         // bit zero was 0,
         //stobyte(0,ssp->ss_byte>>1);
-        uint32_t next = (m_in_pos + 1) % serial_buffer_size;
-        if (next != (uint32_t)m_out_pos) {
-          m_buffer[m_in_pos] = ss_byte >> 1;
-          m_in_pos = next;
-        }
+        rxStore(ss_byte >> 1);
         ss_byte = 0;
         ss_index = 0;
       } else {
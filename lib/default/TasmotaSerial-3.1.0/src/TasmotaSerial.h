@@ -22,6 +22,12 @@
 /*********************************************************************************************\
  * TasmotaSerial supports up to 115200 baud with default buffer size of 64 bytes using optional no iram
  *
+ * Software serial receive uses a single producer (interrupt) single consumer ring buffer of a power
+ * of two size. The interrupt only writes m_in_pos and the consumer only writes m_out_pos so no
+ * locking is needed. Received bytes not fitting the buffer are dropped and counted as overrun.
+ * On ESP8266 hardware serial the overrun count is the number of reads finding the UART buffer
+ * overrun flag set, not the number of bytes lost. On ESP32 hardware serial overruns are not counted.
+ *
  * Based on EspSoftwareSerial v3.4.3 by Peter Lerup (https://github.com/plerup/espsoftwareserial)
 \*********************************************************************************************/
 
@@ -44,15 +50,19 @@ class TasmotaSerial : public Stream {
     bool begin();
     bool hardwareSerial();
     int peek();
+    size_t peek(uint8_t *buffer, size_t size);
 
     virtual size_t write(uint8_t byte);
+    virtual size_t write(const uint8_t *buffer, size_t size);
     virtual int read();
+    size_t read(uint8_t *buffer, size_t size);
     virtual int available();
     virtual void flush();
 
     void rxRead();
 
     uint32_t getLoopReadMetric(void) const { return m_bit_follow_metric; }
+    uint32_t getOverrunCount(void) const { return m_overrun; }
 
 #ifdef ESP32
     uint32_t getUart(void) const { return m_uart; }
@@ -63,6 +73,8 @@ class TasmotaSerial : public Stream {
   private:
     bool isValidGPIOpin(int pin);
     size_t txWrite(uint8_t byte);
+    size_t copyOut(uint8_t *buffer, size_t size, bool consume);
+    void rxStore(uint32_t rec);
 
     // Member variables
     int m_rx_pin;
@@ -74,9 +86,11 @@ class TasmotaSerial : public Stream {
     uint32_t m_bit_time;
     uint32_t m_bit_start_time;
     uint32_t m_bit_follow_metric = 0;
-    uint32_t m_in_pos;
-    uint32_t m_out_pos;
+    volatile uint32_t m_in_pos;       // Written by interrupt only
+    volatile uint32_t m_out_pos;      // Written by consumer only
+    volatile uint32_t m_overrun = 0;
     uint32_t serial_buffer_size;
+    uint32_t m_buffer_mask;           // Software serial ring buffer size - 1
     bool m_valid;
     bool m_nwmode;
     bool m_hardserial;
@@ -189,4 +189,172 @@ String EscapeJSONString(const char *str) {
   }
 
   return r;
-}
\ No newline at end of file
+}
+/*********************************************************************************************\
+ * Streaming JSON Generator
+\*********************************************************************************************/
+JsonGeneratorStream::JsonGeneratorStream(char * buf, size_t size) :
+  _buf(buf), _size(size), _heap(false)
+{
+  if (_buf && _size) { _buf[0] = 0; }
+}
+
+JsonGeneratorStream::JsonGeneratorStream(void) :
+  _buf(nullptr), _size(0), _heap(true)
+{
+}
+
+JsonGeneratorStream::~JsonGeneratorStream() {
+  if (_heap) { free(_buf); }
+}
+
+bool JsonGeneratorStream::grow(void) {
+  size_t size = _size ? _size * 2 : 64;
+  char * buf = (char*) realloc(_buf, size);
+  if (nullptr == buf) { return false; }
+  _buf = buf;
+  _size = size;
+  return true;
+}
+
+// called when the buffer is full
+bool JsonGeneratorStream::room(void) {
+  if (_heap && grow()) { return true; }
+  _overflow++;
+  return false;
+}
+
+void JsonGeneratorStream::write(const char * s) {
+  char c;
+  while ((c = pgm_read_byte(s++))) { write(c); }
+}
+
+void JsonGeneratorStream::writeEscaped(const char * s) {
+  char c;
+  while ((c = pgm_read_byte(s++))) {
+    char c2 = EscapeJSONChar(c);
+    if (c2) {
+      write('\\');
+      write(c2);
+    } else {
+      write(c);
+    }
+  }
+}
+
+void JsonGeneratorStream::sep(void) {
+  if (_after_key) {             // the value follows its key
+    _after_key = false;
+    return;
+  }
+  uint32_t level = 1U << _depth;
+  if (_filled & level) { write(','); }
+  _filled |= level;
+}
+
+void JsonGeneratorStream::key(const char * name, const char * suffix) {
+  if (_skipped) { return; }
+  sep();
+  write('"');
+  if (name) { writeEscaped(name); }
+  if (suffix) { writeEscaped(suffix); }
+  write('"');
+  write(':');
+  _after_key = true;
+}
+
+void JsonGeneratorStream::open(char c, const char * key, bool array) {
+  if (_skipped || (_depth >= 31)) {     // too deep, can't track nesting, leave out key and content
+    _skipped++;
+    _overflow++;
+    return;
+  }
+  if (key) { this->key(key); }
+  sep();
+  write(c);
+  _depth++;
+  uint32_t level = 1U << _depth;
+  _filled &= ~level;
+  if (array) { _arrays |= level; } else { _arrays &= ~level; }
+}
+
+void JsonGeneratorStream::close(char c) {
+  if (_skipped) {
+    _skipped--;
+    return;
+  }
+  if (0 == _depth) { return; }
+  write(c);
+  _depth--;
+  _after_key = false;
+}
+
+void JsonGeneratorStream::beginObject(const char * key) {
+  open('{', key, false);
+}
+
+void JsonGeneratorStream::beginArray(const char * key) {
+  open('[', key, true);
+}
+
+void JsonGeneratorStream::end(void) {
+  _skipped = 0;
+  while (_depth) {
+    close((_arrays & (1U << _depth)) ? ']' : '}');
+  }
+}
+
+// decimal conversion without going through printf, it's called for most values
+static const char * JsonUIntToStr(uint32_t val, char * end) {
+  *end = 0;
+  do {
+    *--end = '0' + (val % 10);
+    val /= 10;
+  } while (val);
+  return end;
+}
+
+void JsonGeneratorStream::add(uint32_t uval32) {
+  char s[12];
+  addStrRaw(JsonUIntToStr(uval32, &s[11]));
+}
+
+void JsonGeneratorStream::add(int32_t uval32) {
+  char s[12];
+  if (uval32 >= 0) {
+    addStrRaw(JsonUIntToStr(uval32, &s[11]));
+  } else {
+    char * p = (char*) JsonUIntToStr(-(uint32_t)uval32, &s[11]);
+    *--p = '-';
+    addStrRaw(p);
+  }
+}
+
+void JsonGeneratorStream::addBool(bool bval) {
+  addStrRaw(bval ? PSTR("true") : PSTR("false"));
+}
+
+void JsonGeneratorStream::addNull(void) {
+  addStrRaw(PSTR("null"));
+}
+
+void JsonGeneratorStream::addStrRaw(const char * sval) {
+  if (_skipped) { return; }
+  sep();
+  if (sval) { write(sval); }
+}
+
+void JsonGeneratorStream::addStr(const char * sval) {
+  if (_skipped) { return; }
+  sep();
+  write('"');
+  if (sval) { writeEscaped(sval); }
+  write('"');
+}
+
+// Add up to 32 bits hex value
+void JsonGeneratorStream::addHex32(const char* key, uint32_t uval32) {
+  char hex[16];
+  snprintf_P(hex, sizeof(hex), PSTR("\"0x%08X\""), uval32);
+  addStrRaw(key, hex);
+}
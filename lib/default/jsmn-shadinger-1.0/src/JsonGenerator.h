@@ -70,4 +70,88 @@ protected:
   String val;
 };
 
+/*********************************************************************************************\
+ * Streaming JSON Generator
+ *
+ * Writes JSON sequentially into a single buffer, nested objects and arrays are written in place
+ * and tracked on a small stack (up to 31 levels) to place commas and close them. Deeper levels
+ * are left out with their key and content, and `overflow()` is set.
+ * The buffer is either provided by the caller (fixed size, output is truncated and `overflow()`
+ * counts the characters left out if it's too small) or allocated on the heap and grown as needed.
+ * At top level it accepts a list of keys/values, so it can produce a fragment of a larger JSON.
+ * Keys and strings can be in PROGMEM.
+ *
+ *   JsonGeneratorStream json(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data));
+ *   json.beginObject();
+ *   json.add(PSTR("Device"), 0x1234);
+ *   json.beginArray(PSTR("Endpoints"));
+ *   json.add(1);
+ *   json.end();      // close all levels -> {"Device":4660,"Endpoints":[1]}
+\*********************************************************************************************/
+class JsonGeneratorStream {
+public:
+
+  JsonGeneratorStream(char * buf, size_t size);     // write into caller buffer
+  JsonGeneratorStream(void);                        // write into a heap buffer growing as needed
+  ~JsonGeneratorStream();
+  JsonGeneratorStream(const JsonGeneratorStream &) = delete;
+  JsonGeneratorStream & operator=(const JsonGeneratorStream &) = delete;
+
+  // key for the next value, `suffix` is appended to the key if not nullptr
+  void key(const char * name, const char * suffix = nullptr);
+
+  // values, after `key()` or as array elements
+  void add(uint32_t uval32);
+  void add(int32_t uval32);
+  void addBool(bool bval);
+  void addNull(void);
+  void addStrRaw(const char * sval);    // not escaped, can be a sub-object or 'null', 'true', 'false'
+  void addStr(const char * sval);       // escaped JSON string
+
+  // key and value
+  void add(const char* key, uint32_t uval32)        { this->key(key); add(uval32); }
+  void add(const char* key, int32_t uval32)         { this->key(key); add(uval32); }
+  void addBool(const char* key, bool bval)          { this->key(key); addBool(bval); }
+  void addHex32(const char* key, uint32_t uval32);
+  void addStrRaw(const char* key, const char * sval) { this->key(key); addStrRaw(sval); }
+  void addStr(const char* key, const char * sval)   { this->key(key); addStr(sval); }
+
+  // nested objects and arrays, with optional key
+  void beginObject(const char * key = nullptr);
+  void beginArray(const char * key = nullptr);
+  void endObject(void)    { close('}'); }
+  void endArray(void)     { close(']'); }
+  void end(void);         // close all levels still open
+
+  inline const char * c_str(void) const { return _buf ? _buf : ""; }
+  inline size_t length(void) const      { return _len; }
+  inline uint32_t overflow(void) const  { return _overflow; }    // characters left out, 1 per level too deep
+
+protected:
+  void sep(void);                       // comma if needed before a new element
+  void open(char c, const char * key, bool array);
+  void close(char c);
+  inline void write(char c) {
+    if ((_len + 1 < _size) || room()) {   // keep room for NULL terminator
+      _buf[_len++] = c;
+      _buf[_len] = 0;
+    }
+  }
+  void write(const char * s);           // PROGMEM allowed
+  void writeEscaped(const char * s);    // PROGMEM allowed
+  bool room(void);
+  bool grow(void);
+
+  char      * _buf;
+  size_t      _size;
+  size_t      _len = 0;
+  uint32_t    _arrays = 0;              // bit n is set if level n is an array
+  uint32_t    _filled = 0;              // bit n is set if level n already has an element
+  uint8_t     _depth = 0;
+  uint8_t     _skipped = 0;             // open levels left out because too deep
+  bool        _after_key = false;
+  bool        _heap;
+  uint32_t    _overflow = 0;
+};
+
 #endif // __JSON_PARSER__
\ No newline at end of file
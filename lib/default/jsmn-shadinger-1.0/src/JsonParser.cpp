@@ -25,6 +25,7 @@
 \*********************************************************************************************/
 
 const char * k_current_json_buffer = "";
+const JsonParserIndex * k_current_json_index = nullptr;
 
 /*********************************************************************************************\
  * Lightweight String to Float, because atof() or strtof() takes 10KB
@@ -272,21 +273,51 @@ JsonParserToken JsonParserKey::getValue(void) const {
 // fall-back token object when parsing failed
 const jsmntok_t token_bad = { JSMN_INVALID, 0, 0, 0 };
 
+jsmntok_t * JsonParser::_pool = nullptr;
+uint16_t    JsonParser::_pool_size = 0;
+bool        JsonParser::_pool_busy = false;
+
 JsonParser::JsonParser(char * json_in) :
   _size(0),
   _token_len(0),
   _tokens(nullptr),
-  _json(nullptr)
+  _json(nullptr),
+  _owner(JSON_TOKENS_HEAP)
+{
+  if (!_pool_busy) {
+    _pool_busy = true;
+    _owner = JSON_TOKENS_POOL;
+    _tokens = _pool;
+    _size = _pool_size;
+  }
+  parse(json_in);
+}
+
+JsonParser::JsonParser(char * json_in, jsmntok_t * tokens, size_t tokens_len) :
+  _size(tokens_len),
+  _token_len(0),
+  _tokens(tokens),
+  _json(nullptr),
+  _owner(JSON_TOKENS_CALLER)
 {
   parse(json_in);
 }
 
+JsonParser::JsonParser(void) :
+  _size(0),
+  _token_len(0),
+  _tokens(nullptr),
+  _json(nullptr),
+  _owner(JSON_TOKENS_HEAP)
+{
+}
+
 JsonParser::~JsonParser() {
   this->free();
 }
 
 const JsonParserObject JsonParser::getRootObject(void) const {
-  return JsonParserObject(&_tokens[0]);
+  return JsonParserObject((*this)[0]);
 }
 
 const JsonParserToken JsonParser::operator[](int32_t i) const {
@@ -370,26 +401,30 @@ const char * JsonParserObject::getStr(const char * needle) const {
   return getStr(needle, "");
 }
 
-void JsonParser::parse(char * json_in) {
+// Single pass: start with a guess of the number of tokens, and if jsmn runs out of tokens
+// grow the buffer and resume where it stopped, jsmn keeps its state in `_parser`
+bool JsonParser::parse(char * json_in) {
   k_current_json_buffer = "";
-  if (nullptr == json_in) { return; }
+  _token_len = 0;
+  if (nullptr == json_in) { return false; }
   _json = json_in;
   k_current_json_buffer = _json;
   size_t json_len = strlen(json_in);
-  if (_size == 0) {
-    // first run is used to count tokens before allocation
-    jsmn_init(&this->_parser);
-    int32_t _token_len = jsmn_parse(&this->_parser, json_in, json_len, nullptr, 0);
-    if (_token_len <= 0) { return; }
-    _size = _token_len + 1;
-  }
-  allocate();
+  if (_size < 2) {
+    if (!grow(json_len / 6 + 4)) { return false; }    // about one token per 6 chars in typical Tasmota JSON
+  }
   jsmn_init(&this->_parser);
-  _token_len = jsmn_parse(&this->_parser, json_in, json_len, _tokens, _size);
+  int32_t token_len;
+  // always keep one token for the end marker
+  while (JSMN_ERROR_NOMEM == (token_len = jsmn_parse(&this->_parser, json_in, json_len, _tokens, _size - 1))) {
+    if (!grow(_size * 2)) { return false; }
+  }
+  _token_len = token_len;
   // TODO error checking
   if (_token_len >= 0) {
     postProcess(json_len);
   }
+  return _token_len > 0;
 }
 
 // post process the parsing by pre-munching extended types
@@ -459,6 +494,10 @@ JsonParserToken JsonParserObject::operator[](const char * needle) const {
   // if needle == "?" then we return the first valid key
   bool wildcard = (strcmp_P("?", needle) == 0);
 
+  if (!wildcard && k_current_json_index && k_current_json_index->isIndexOf(t)) {
+    return k_current_json_index->find(needle);
+  }
+
   for (const auto key : *this) {
     if (wildcard) { return key.getValue(); }
     if (0 == strcasecmp_P(key.getStr(), needle)) { return key.getValue(); }
@@ -519,15 +558,93 @@ const char * JsonParserObject::findConstCharNull(const char * needle) const {
 // }
 
 void JsonParser::free(void) {
-  if (nullptr != _tokens) {
-    delete[] _tokens;     // TODO
-    _tokens = nullptr;
+  if (JSON_TOKENS_POOL == _owner) {
+    if (_size > JSON_PARSER_POOL_MAX) {     // don't keep large buffers
+      ::free(_tokens);
+      _pool = nullptr;
+      _pool_size = 0;
+    }
+    _pool_busy = false;
+  } else if (JSON_TOKENS_HEAP == _owner) {
+    ::free(_tokens);
+  }
+  _tokens = nullptr;
+  _size = 0;
+  _owner = JSON_TOKENS_HEAP;
+}
+
+bool JsonParser::grow(size_t size) {
+  if (size <= _size) { return true; }
+  if (size > 0xFFFF) { return false; }
+  jsmntok_t * tokens;
+  if (JSON_TOKENS_CALLER == _owner) {
+    // move to the heap, the caller keeps its buffer
+    tokens = (jsmntok_t*) malloc(size * sizeof(jsmntok_t));
+    if (tokens) {
+      memcpy(tokens, _tokens, _size * sizeof(jsmntok_t));
+      _owner = JSON_TOKENS_HEAP;
+    }
+  } else {
+    tokens = (jsmntok_t*) realloc(_tokens, size * sizeof(jsmntok_t));
+  }
+  if (nullptr == tokens) { return false; }
+  _tokens = tokens;
+  _size = size;
+  if (JSON_TOKENS_POOL == _owner) {
+    _pool = _tokens;
+    _pool_size = _size;
   }
+  return true;
 }
 
-void JsonParser::allocate(void) {
-  this->free();
-  if (_size != 0) {
-    _tokens = new jsmntok_t[_size];
+/*********************************************************************************************\
+ * JsonParserIndex
+\*********************************************************************************************/
+
+// FNV-1a on lower case characters, needle can be in PROGMEM
+static uint32_t json_hash_key(const char * key) {
+  uint32_t hash = 2166136261;
+  uint8_t c;
+  while ((c = pgm_read_byte(key++))) {
+    hash ^= (uint8_t) tolower(c);
+    hash *= 16777619;
   }
+  return hash;
+}
+
+JsonParserIndex::JsonParserIndex(const JsonParserObject & obj) :
+  _obj(obj.t),
+  _keys(nullptr),
+  _mask(0),
+  _previous(k_current_json_index)
+{
+  if (!obj.isValid()) { return; }
+  uint32_t size = 8;
+  while (size < obj.size() * 2) { size <<= 1; }    // load factor below 50%
+  _keys = (const jsmntok_t **) calloc(size, sizeof(const jsmntok_t *));
+  if (nullptr == _keys) { return; }
+  _mask = size - 1;
+  for (const auto key : obj) {
+    const char * name = key.getStr();
+    uint32_t i;
+    for (i = json_hash_key(name) & _mask; _keys[i]; i = (i + 1) & _mask) {
+      if (0 == strcasecmp(&k_current_json_buffer[_keys[i]->start], name)) { break; }   // keep the first key
+    }
+    if (!_keys[i]) { _keys[i] = key.t; }
+  }
+  k_current_json_index = this;
+}
+
+JsonParserIndex::~JsonParserIndex() {
+  if (k_current_json_index == this) { k_current_json_index = _previous; }
+  ::free(_keys);
+}
+
+JsonParserToken JsonParserIndex::find(const char * needle) const {
+  for (uint32_t i = json_hash_key(needle) & _mask; _keys[i]; i = (i + 1) & _mask) {
+    if (0 == strcasecmp_P(&k_current_json_buffer[_keys[i]->start], needle)) {
+      return JsonParserToken(_keys[i] + 1);
+    }
+  }
+  return JsonParserToken(&token_bad);
 }
@@ -53,6 +53,10 @@ const extern jsmntok_t token_bad;
 // Warning: this makes code non-reentrant.
 extern const char * k_current_json_buffer;
 
+// the current key index, used by `JsonParserObject::operator[]` for the object it was built on
+class JsonParserIndex;
+extern const JsonParserIndex * k_current_json_index;
+
 /*********************************************************************************************\
  * Read-only JSON token object, fits in 32 bits
 \*********************************************************************************************/
@@ -215,27 +219,69 @@ public:
   const_iterator end() const { return const_iterator(JsonParserArray(&token_bad)); }        // end with null pointer
 };
 
+/*********************************************************************************************\
+ * Hash index on the keys of an object
+ *
+ * For objects with many lookups. While the index is alive, `operator[]` and the `getXXX()`
+ * helpers of the indexed object use it instead of scanning all keys. Lookups stay
+ * case-insensitive and return the first matching key, like the scan.
+ * The index must not outlive the parser, declare it after the parser in the same scope.
+ *
+ *   JsonParserObject root = parser.getRootObject();
+ *   JsonParserIndex index(root);
+ *   root[PSTR("Power")] ...
+\*********************************************************************************************/
+class JsonParserIndex {
+public:
+  JsonParserIndex(const JsonParserObject & obj);
+  ~JsonParserIndex();
+
+  // returns the value token, Invalid Token if not found
+  JsonParserToken find(const char * needle) const;
+  inline bool isIndexOf(const jsmntok_t * obj) const { return (obj == _obj) && (nullptr != _keys); }
+
+protected:
+  const jsmntok_t   * _obj;         // indexed object
+  const jsmntok_t  ** _keys;        // open addressing table of key tokens
+  uint32_t            _mask;        // table size - 1
+  const JsonParserIndex * _previous;  // index that was current before this one
+};
+
 /*********************************************************************************************\
  * JSON Parser
 \*********************************************************************************************/
 
+// Token buffers up to this number of tokens are kept between parsers
+#ifndef JSON_PARSER_POOL_MAX
+#define JSON_PARSER_POOL_MAX  64
+#endif
+
 class JsonParser {
 public:
   // constructor, parse the json buffer
   // Warning: the buffer is modified in the process (in-place parsing)
   // Input: `json_in` can be nullptr, but CANNOT be in PROGMEM (remember we need to change characters in-place)
+  // Tokens are taken from a buffer shared by all parsers when it is not in use, or allocated otherwise
   JsonParser(char * json_in);
+  // same but tokens are first stored in a buffer provided by the caller, the heap is used only if it's too small
+  JsonParser(char * json_in, jsmntok_t * tokens, size_t tokens_len);
+  // empty parser, use `parse()` - the token buffer is kept and reused by subsequent calls
+  JsonParser(void);
 
   // destructor
   ~JsonParser();
   
+  // parse the json buffer, previous results are discarded
+  // returns true if the parsing was successful
+  bool parse(char * json_in);
+
   // set the current buffer for attribute access (i.e. set the global)
   void setCurrent(void) { k_current_json_buffer = _json; }
 
   // test if the parsing was successful
   inline explicit operator bool() const { return _token_len > 0; }
 
-  const JsonParserToken getRoot(void) { return JsonParserToken(&_tokens[0]); }
+  const JsonParserToken getRoot(void) { return (*this)[0]; }   // Invalid Token if parsing failed, the buffer may hold stale tokens
   // const JsonParserObject getRootObject(void) { return JsonParserObject(&_tokens[0]); }
   const JsonParserObject getRootObject(void) const;
 
@@ -248,17 +294,23 @@ protected:
   jsmntok_t * _tokens;        // pointer to token buffer
   jsmn_parser _parser;        // jmsn_parser structure
   char      * _json;          // json buffer
+  uint8_t     _owner;         // who owns the token buffer, see below
+
+  enum { JSON_TOKENS_HEAP, JSON_TOKENS_POOL, JSON_TOKENS_CALLER };
+
+  // token buffer shared by parsers, only one parser uses it at a time
+  static jsmntok_t * _pool;
+  static uint16_t    _pool_size;
+  static bool        _pool_busy;
 
   // disallocate token buffer
   void free(void);
 
-  // allocate token buffer of size _size
-  void allocate(void);
+  // grow token buffer to `size` tokens, keeping tokens already parsed
+  bool grow(size_t size);
 
   // access tokens by index
   const JsonParserToken operator[](int32_t i) const;
-  // parse
-  void parse(char * json_in);
   // post-process parsing: insert NULL chars to split strings, compute a more precise token type
   void postProcess(size_t json_len);
 };
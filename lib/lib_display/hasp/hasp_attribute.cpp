@@ -977,7 +977,7 @@ void hasp_process_obj_attribute(lv_obj_t * obj, const char * attr_p, const char
         }
 
         case ATTR_ID:
-            return update ? (void)(obj->user_data.id = (uint8_t)val) : hasp_out_int(obj, attr, obj->user_data.id);
+            return update ? hasp_object_set_id(obj, (uint8_t)val) : hasp_out_int(obj, attr, obj->user_data.id);
 
         case ATTR_VIS:
             return update ? lv_obj_set_hidden(obj, !is_true(payload))
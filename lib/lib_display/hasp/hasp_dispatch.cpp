@@ -24,9 +24,21 @@ extern unsigned long debugLastMillis; // UpdateStatus timer
 uint8_t nCommands = 0;
 haspCommand_t commands[16];
 
+#define DISPATCH_BATCH_TIMEOUT 1000 // Milliseconds before an unterminated batch is rendered anyway
+#define DISPATCH_BATCH_SPARE 8      // Free invalid area slots kept while a batch is open
+
+struct
+{
+    uint32_t start;   // Millis when the batch started
+    uint16_t lines;   // Lines applied during the batch
+    uint8_t renders;  // Refresh cycles during the batch
+    uint8_t depth;    // Nested batch count, 0 = no batch
+} dispatchBatch;
+
 static void dispatch_config(const char * topic, const char * payload);
 static void dispatch_group_state(uint8_t groupid, uint8_t eventid, lv_obj_t * obj);
 static inline void dispatch_state_msg(const __FlashStringHelper * subtopic, const char * payload);
+static void dispatch_batch_line();
 
 bool is_true(const char * s)
 {
@@ -212,6 +224,7 @@ void dispatch_text_line(const char * cmnd)
         Log.notice(TAG_MSGR, F("%s = %s"), cmnd, empty_payload);
         dispatch_topic_payload(cmnd, empty_payload);
     }
+    dispatch_batch_line();
 }
 
 // send idle state to the client
@@ -442,6 +455,72 @@ void dispatch_group_state(uint8_t groupid, uint8_t eventid, lv_obj_t * obj)
     dispatch_state_msg(F("output"), payload);
 }
 
+/********************************************** Batch Updates ******************************************/
+
+/* While a batch is open the LVGL refresh task is paused so all attribute changes are applied first.
+ * LVGL gives up on its list of invalid areas when it overflows and redraws the full screen, so the
+ * changes applied so far are rendered when the list is almost full. Only the public LVGL 7 API is
+ * used: the refresh task is paused through its accessor and lv_refr_now() renders. */
+
+#if LVGL_VERSION_MAJOR == 7
+#define DISPATCH_REFR_PRIO LV_TASK_PRIO_MID // Refresh task priority set by lv_disp_drv_register()
+#endif
+
+void dispatch_batch_begin()
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    if(!disp) return;
+
+    if(dispatchBatch.depth++ == 0) {
+        dispatchBatch.start   = millis();
+        dispatchBatch.lines   = 0;
+        dispatchBatch.renders = 0;
+#if LVGL_VERSION_MAJOR == 7
+        lv_task_set_prio(_lv_disp_get_refr_task(disp), LV_TASK_PRIO_OFF);
+#endif
+    }
+}
+
+// Called after each applied line to render before the invalid area list overflows
+static void dispatch_batch_line()
+{
+    if(!dispatchBatch.depth) return;
+    dispatchBatch.lines++;
+#if LVGL_VERSION_MAJOR == 7
+    lv_disp_t * disp = lv_disp_get_default();
+    if(disp && lv_disp_get_inv_buf_size(disp) > LV_INV_BUF_SIZE - DISPATCH_BATCH_SPARE) {
+        lv_refr_now(disp);
+        dispatchBatch.renders++;
+    }
+#endif
+}
+
+void dispatch_batch_end(bool force)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    if(!disp || !dispatchBatch.depth) return;
+    if(--dispatchBatch.depth > 0 && !force) return;
+    dispatchBatch.depth = 0;
+
+#if LVGL_VERSION_MAJOR == 7
+    lv_task_set_prio(_lv_disp_get_refr_task(disp), DISPATCH_REFR_PRIO);
+    lv_refr_now(disp); // render remaining changes
+    dispatchBatch.renders++;
+    Log.verbose(TAG_MSGR, F("Batch of %u lines rendered in %u cycles, %u ms"), dispatchBatch.lines,
+                dispatchBatch.renders, millis() - dispatchBatch.start);
+#endif
+}
+
+// batch=1 opens, batch=0 renders the attribute changes received in between
+void dispatch_batch(const char *, const char * payload)
+{
+    if(is_true(payload)) {
+        dispatch_batch_begin();
+    } else {
+        dispatch_batch_end(true);
+    }
+}
+
 /********************************************** Native Commands ****************************************/
 
 void dispatch_parse_json(const char *, const char * payload)
@@ -462,9 +541,11 @@ void dispatch_parse_json(const char *, const char * payload)
 
     } else if(json.is<JsonArray>()) { // handle json as an array of commands
         JsonArray arr = json.as<JsonArray>();
+        dispatch_batch_begin();
         for(JsonVariant command : arr) {
             dispatch_text_line(command.as<String>().c_str());
         }
+        dispatch_batch_end(false);
     } else if(json.is<JsonObject>()) { // handle json as a jsonl
         uint8_t savedPage = haspGetPage();
         hasp_new_object(json.as<JsonObject>(), savedPage);
@@ -492,11 +573,14 @@ void dispatch_parse_jsonl(std::istringstream & stream)
     DynamicJsonDocument jsonl(4 * 128u); // max ~256 characters per line
     DeserializationError err = deserializeJson(jsonl, stream);
 
+    dispatch_batch_begin();
     while(err == DeserializationError::Ok) {
         hasp_new_object(jsonl.as<JsonObject>(), savedPage);
+        dispatch_batch_line();
         err = deserializeJson(jsonl, stream);
         line++;
     }
+    dispatch_batch_end(false);
 
     /* For debugging pourposes */
     if(err == DeserializationError::EmptyInput) {
@@ -722,6 +806,7 @@ void dispatchSetup()
     //dispatch_add_command(PSTR("brightness"), dispatch_dim);
     dispatch_add_command(PSTR("light"), dispatch_backlight);
     dispatch_add_command(PSTR("calibrate"), dispatch_calibrate);
+    dispatch_add_command(PSTR("batch"), dispatch_batch);
     //dispatch_add_command(PSTR("statusupdate"), dispatch_output_statusupdate);
     //dispatch_add_command(PSTR("update"), dispatch_web_update);
     //dispatch_add_command(PSTR("reboot"), dispatch_reboot);
@@ -734,5 +819,8 @@ void dispatchSetup()
 
 void IRAM_ATTR dispatchLoop()
 {
-    // Not used
+    // Render a batch that was never terminated
+    if(dispatchBatch.depth && (millis() - dispatchBatch.start > DISPATCH_BATCH_TIMEOUT)) {
+        dispatch_batch_end(true);
+    }
 }
@@ -19,6 +19,8 @@ void dispatch_topic_payload(const char * topic, const char * payload);
 void dispatch_text_line(const char * cmnd);
 void dispatch_parse_jsonl(Stream & stream);
 void dispatch_clear_page(const char * page);
+void dispatch_batch_begin();
+void dispatch_batch_end(bool force);
 
 // void dispatchPage(uint8_t page);
 void dispatch_page_next();
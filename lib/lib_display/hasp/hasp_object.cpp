@@ -25,6 +25,7 @@ using namespace ArduinoJson;
 #include <string>
 #include <stdlib.h>
 
+#include "hasp_conf.h"
 #include "hasp.h"
 //#include "hasp_gui.h"
 #include "hasp_object.h"
@@ -69,10 +70,54 @@ lv_obj_t * hasp_find_obj_from_parent_id(lv_obj_t * parent, uint8_t objid)
     return NULL;
 }
 
-// lv_obj_t * hasp_find_obj_from_page_id(uint8_t pageid, uint8_t objid)
-// {
-//     return hasp_find_obj_from_parent_id(get_page_obj(pageid), objid);
-// }
+// ##################### Object Index ##########################################################
+
+/* Per page table of 256 object pointers indexed by id, allocated when the first object is added.
+ * Objects are removed on their LV_EVENT_DELETE so the table never holds a deleted object.
+ * Layers and ids shared by several objects on a page fall back to the recursive tree search. */
+static lv_obj_t ** hasp_obj_index[HASP_NUM_PAGES];
+
+static void hasp_object_index_add(uint8_t pageid, lv_obj_t * obj)
+{
+    uint8_t objid = obj->user_data.id;
+    if(pageid >= HASP_NUM_PAGES || objid == 0) return;
+
+    if(!hasp_obj_index[pageid]) {
+        hasp_obj_index[pageid] = (lv_obj_t **)calloc(256, sizeof(lv_obj_t *));
+        if(!hasp_obj_index[pageid]) return;
+    }
+    if(!hasp_obj_index[pageid][objid]) hasp_obj_index[pageid][objid] = obj; // keep the first object using this id
+}
+
+static void hasp_object_index_remove(lv_obj_t * obj)
+{
+    uint8_t objid = obj->user_data.id;
+    for(uint8_t pageid = 0; pageid < HASP_NUM_PAGES; pageid++) {
+        if(hasp_obj_index[pageid] && hasp_obj_index[pageid][objid] == obj) hasp_obj_index[pageid][objid] = NULL;
+    }
+}
+
+/**
+ * Change the id of an object and keep the object index in sync
+ * @param obj pointer to the object
+ * @param objid the new id
+ */
+void hasp_object_set_id(lv_obj_t * obj, uint8_t objid)
+{
+    uint8_t pageid;
+    hasp_object_index_remove(obj);
+    obj->user_data.id = objid;
+    if(get_page_id(obj, &pageid)) hasp_object_index_add(pageid, obj);
+}
+
+lv_obj_t * hasp_find_obj_from_page_id(uint8_t pageid, uint8_t objid)
+{
+    if(pageid < HASP_NUM_PAGES && objid > 0 && hasp_obj_index[pageid]) {
+        lv_obj_t * obj = hasp_obj_index[pageid][objid];
+        if(obj) return obj;
+    }
+    return hasp_find_obj_from_parent_id(get_page_obj(pageid), objid);
+}
 
 bool hasp_find_id_from_obj(lv_obj_t * obj, uint8_t * pageid, uint8_t * objid)
 {
@@ -305,6 +350,7 @@ void IRAM_ATTR btn_event_handler(lv_obj_t * obj, lv_event_t event)
 
         case LV_EVENT_DELETE:
             Log.verbose(TAG_HASP, F("Object deleted Event %d occured"), event);
+            hasp_object_index_remove(obj);
             // TODO:free and destroy persistent memory allocated for certain objects
             return;
         default:
@@ -321,6 +367,16 @@ void IRAM_ATTR btn_event_handler(lv_obj_t * obj, lv_event_t event)
  * @param obj pointer to a button matrix
  * @param event type of event that occured
  */
+/**
+ * Called for objects without other event processing to keep the object index in sync
+ * @param obj pointer to the object
+ * @param event type of event that occured
+ */
+static void delete_event_handler(lv_obj_t * obj, lv_event_t event)
+{
+    if(event == LV_EVENT_DELETE) hasp_object_index_remove(obj);
+}
+
 void wakeup_event_handler(lv_obj_t * obj, lv_event_t event)
 {
     if(obj == lv_disp_get_layer_sys(NULL)) {
@@ -336,6 +392,7 @@ void wakeup_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void btnmap_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) {
         //guiCheckSleep(); // wakeup?
         hasp_send_obj_attribute_val(obj, lv_btnmatrix_get_active_btn(obj));
@@ -349,6 +406,7 @@ static void btnmap_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void table_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) {
         //guiCheckSleep(); // wakeup?
 
@@ -365,6 +423,7 @@ static void table_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 void IRAM_ATTR toggle_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) {
         //guiCheckSleep(); // wakeup?
         hasp_send_obj_attribute_val(obj, lv_checkbox_is_checked(obj));
@@ -378,6 +437,7 @@ void IRAM_ATTR toggle_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void switch_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) {
         //guiCheckSleep(); // wakeup?
         hasp_send_obj_attribute_val(obj, lv_switch_get_state(obj));
@@ -391,6 +451,7 @@ static void switch_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void checkbox_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) hasp_send_obj_attribute_val(obj, lv_checkbox_is_checked(obj));
 }
 
@@ -401,6 +462,7 @@ static void checkbox_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void ddlist_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) {
         hasp_send_obj_attribute_val(obj, lv_dropdown_get_selected(obj));
         char buffer[128];
@@ -416,6 +478,7 @@ static void ddlist_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void slider_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) hasp_send_obj_attribute_val(obj, lv_slider_get_value(obj));
 }
 
@@ -426,6 +489,7 @@ static void slider_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void cpicker_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     char color[6];
     snprintf_P(color, sizeof(color), PSTR("color"));
 
@@ -439,6 +503,7 @@ static void cpicker_event_handler(lv_obj_t * obj, lv_event_t event)
  */
 static void roller_event_handler(lv_obj_t * obj, lv_event_t event)
 {
+    if(event == LV_EVENT_DELETE) return hasp_object_index_remove(obj);
     if(event == LV_EVENT_VALUE_CHANGED) {
         hasp_send_obj_attribute_val(obj, lv_roller_get_selected(obj));
         char buffer[128];
@@ -453,7 +518,7 @@ static void roller_event_handler(lv_obj_t * obj, lv_event_t event)
 void hasp_process_attribute(uint8_t pageid, uint8_t objid, const char * attr, const char * payload)
 {
     lv_obj_t* obj;
-    if (obj = hasp_find_obj_from_parent_id(get_page_obj(pageid), objid)) {
+    if (obj = hasp_find_obj_from_page_id(pageid, objid)) {
             hasp_process_obj_attribute(obj, attr, payload, strlen(payload) > 0);
     } else {
         //Log.warning(TAG_HASP, F("Unknown object p[%d].b[%d]"), pageid, objid);
@@ -518,7 +583,7 @@ void hasp_new_object(const JsonObject & config, uint8_t & saved_page_id)
     lv_obj_t * parent_obj = page;
     if(!config[F("parentid")].isNull()) {
         uint8_t parentid = config[F("parentid")].as<uint8_t>();
-        parent_obj       = hasp_find_obj_from_parent_id(page, parentid);
+        parent_obj       = hasp_find_obj_from_page_id(pageid, parentid);
         if(!parent_obj) {
             return; //Log.warning(TAG_HASP, F("Parent ID p[%u].b[%u] not found, skipping..."), pageid, parentid);
             // parent_obj = page; // don't create on the page instead ??
@@ -532,7 +597,7 @@ void hasp_new_object(const JsonObject & config, uint8_t & saved_page_id)
     uint8_t id      = config[F("id")].as<uint8_t>();
 
     /* Define Objects*/
-    lv_obj_t * obj = hasp_find_obj_from_parent_id(parent_obj, id);
+    lv_obj_t * obj = (parent_obj == page) ? hasp_find_obj_from_page_id(pageid, id) : hasp_find_obj_from_parent_id(parent_obj, id);
     if(obj) {
         return; //Log.warning(TAG_HASP, F("Object ID %u already exists!"), id);
     }
@@ -770,6 +835,8 @@ void hasp_new_object(const JsonObject & config, uint8_t & saved_page_id)
     obj->user_data.id      = id;
     obj->user_data.objid   = (uint8_t)(objid & 0b11111);
     obj->user_data.groupid = (uint8_t)(groupid & 0b111);
+    if(!obj->event_cb) lv_obj_set_event_cb(obj, delete_event_handler);
+    hasp_object_index_add(pageid, obj);
 
     /* do not process these attributes */
     config.remove(F("page"));
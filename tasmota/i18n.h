@@ -248,6 +248,7 @@
 #define D_CMND_BLINKCOUNT "BlinkCount"
 #define D_CMND_SENSOR "Sensor"
 #define D_CMND_DRIVER "Driver"
+#define D_CMND_PROFILE "Profile"
 #define D_CMND_SAVEDATA "SaveData"
 #define D_CMND_SETOPTION "SetOption"
 #define D_CMND_SO "SO"
@@ -349,6 +350,7 @@
 
 // Commands xdrv_01_mqtt.ino
 #define D_CMND_MQTTLOG "MqttLog"
+#define D_CMND_MQTTQUEUE "MqttQueue"
 #define D_CMND_MQTTHOST "MqttHost"
 #define D_CMND_MQTTPORT "MqttPort"
 #define D_CMND_MQTTRETRY "MqttRetry"
@@ -591,6 +593,7 @@
 #define D_CMND_ZIGBEE_CONFIG "Config"
   #define D_JSON_ZIGBEE_CONFIG "Config"
 #define D_CMND_ZIGBEE_DATA "Data"
+#define D_CMND_ZIGBEE_ARENA "Arena"
 
 // Commands xdrv_25_A4988_Stepper.ino
 #define D_CMND_MOTOR "MOTOR"
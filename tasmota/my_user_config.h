@@ -63,6 +63,8 @@
 #define SAVE_DATA              1                 // [SaveData] Save changed parameters to Flash (0 = disable, 1 - 3600 seconds)
 #define SAVE_STATE             true              // [SetOption0] Save changed power state to Flash (false = disable, true = enable)
 #define BOOT_LOOP_OFFSET       1                 // [SetOption36] Number of boot loops before starting restoring defaults (0 = disable, 1..200 = boot loops offset)
+//#define USE_SETTINGS_JOURNAL                   // Append changed parameter blocks to a flash journal instead of rewriting the full sector on every save (+1k code, 256 bytes mem)
+                                                 //   Older firmware ignores the journal: serial flashing a downgrade loses changes since the last full save, execute SetOption12 0 before
 
 // -- Wifi ----------------------------------------
 #define WIFI_IP_ADDRESS        "0.0.0.0"         // [IpAddress1] Set to 0.0.0.0 for using DHCP or enter a static IP address
@@ -378,6 +380,11 @@
 #define MQTT_TELE_RETAIN       0                 // Tele messages may send retain flag (0 = off, 1 = on)
 #define MQTT_CLEAN_SESSION     1                 // Mqtt clean session connection (0 = No clean session, 1 = Clean session (default))
 
+#define USE_MQTT_QUEUE                           // Publish MQTT messages from a bounded queue drained by the main loop (+1k5 code)
+  #define MQTT_QUEUE_SIZE      8                 // Max number of queued messages
+  #define MQTT_QUEUE_MEMORY    3072              // Max number of bytes used by queued messages
+  #define MQTT_QUEUE_BUDGET    4                 // [SetOption49] Max number of messages published per loop
+
 // -- MQTT - Domoticz -----------------------------
 #define USE_DOMOTICZ                             // Enable Domoticz (+6k code, +0.3k mem)
   #define DOMOTICZ_IN_TOPIC    "domoticz/in"     // Domoticz Input Topic
@@ -414,6 +421,8 @@
 #define USE_WEBSERVER                            // Enable web server and Wifi Manager (+66k code, +8k mem)
   #define WEB_PORT             80                // Web server Port for User and Admin mode
   #define WEB_USERNAME         "admin"           // Web server Admin mode user name
+//  #define USE_WEBSOCKET                          // Push web console log and changed main page sensor rows over WebSocket (+4k code, +0k6 mem)
+    #define WEBSOCKET_PORT     81                // WebSocket server Port
 //  #define USE_JAVASCRIPT_ES6                     // Enable ECMAScript6 syntax using less JavaScript code bytes (fails on IE11)
 //  #define USE_WEBSEND_RESPONSE                   // Enable command WebSend response message (+1k code)
   #define USE_EMULATION_HUE                      // Enable Hue Bridge emulation for Alexa (+14k code, +2k mem common)
@@ -434,6 +443,12 @@
 // -- Ping ----------------------------------------
 //  #define USE_PING                                 // Enable Ping command (+2k code)
 
+// -- Profiler ------------------------------------
+//#define USE_PROFILER                             // Enable Profile command reporting driver and loop execution times (+2k code)
+
+// -- Command index -------------------------------
+#define USE_COMMAND_INDEX                        // Hash index on command tables for constant time command lookup (+0k6 code, 4 bytes mem per command)
+
 // -- Compression ---------------------------------
 #define USE_UNISHOX_COMPRESSION                  // Add support for string compression in Rules or Scripts
 
@@ -667,6 +682,10 @@
 // -- Power monitoring sensors --------------------
 #define USE_ENERGY_MARGIN_DETECTION              // Add support for Energy Margin detection (+1k6 code)
   #define USE_ENERGY_POWER_LIMIT                 // Add additional support for Energy Power Limit detection (+1k2 code)
+//#define USE_ENERGY_HISTORY                       // Add command EnergyHistory and web page /energy with per minute, hour and day power, voltage and current history (+3k code, +7k RAM)
+  #define ENERGY_HISTORY_MINUTES 120             // Number of minute records
+  #define ENERGY_HISTORY_HOURS   72              // Number of hour records
+  #define ENERGY_HISTORY_DAYS    31              // Number of day records
 #define USE_PZEM004T                             // Add support for PZEM004T Energy monitor (+2k code)
 #define USE_PZEM_AC                              // Add support for PZEM014,016 Energy monitor (+1k1 code)
 #define USE_PZEM_DC                              // Add support for PZEM003,017 Energy monitor (+1k1 code)
@@ -728,6 +728,12 @@ struct XDRVMAILBOX {
   char         *command;
 } XdrvMailbox;
 
+typedef struct {
+  uint16_t      offset;                    // Offset of log line in log buffer
+  uint16_t      length : 12;               // Length of log line including terminating zero
+  uint16_t      level : 4;                 // Loglevel
+} LogIndex;
+
 #ifdef USE_SHUTTER
 const uint8_t MAX_RULES_FLAG = 11;         // Number of bits used in RulesBitfield (tricky I know...)
 #else
@@ -456,6 +456,175 @@ char* SettingsText(uint32_t index)
   return position;
 }
 
+/*********************************************************************************************\
+ * Config Journal - Append changed Settings blocks to the next rotating flash slot
+ *
+ * Settings is split in 64 byte blocks each with a 32-bit hash to find changed blocks without
+ * a crc32 over the full structure. Changed blocks are appended as records to the sector
+ * following the current settings slot. Only when this journal sector is full a complete
+ * Settings image is written to the slot after the journal so a power loss never loses both.
+ *
+ * Journal sector layout:
+ * 0x000 - Header with magic, save_flag and cfg_crc32 of the settings image it belongs to
+ * 0x00C - Records with tag and block number, 64 bytes block data and crc32 of tag and data
+ *         The last record of a save is tagged "JC" so a save interrupted by power loss is ignored
+ *
+ * Firmware without the journal skips the journal sector and loads the last complete image, so
+ * changes saved to the journal only are lost on downgrade. OTA and web upload write a complete
+ * image first (SettingsSave(1)). Before serial flashing older firmware use SetOption12 0 to write one.
+\*********************************************************************************************/
+
+uint32_t SettingsNextLocation(uint32_t location)
+{
+  location--;
+  if (location <= (SETTINGS_LOCATION - CFG_ROTATES)) {
+    location = SETTINGS_LOCATION;
+  }
+  return location;
+}
+
+#ifdef USE_SETTINGS_JOURNAL
+
+const uint32_t SETTINGS_JOURNAL_BLOCK = 64;                                    // Bytes per block
+const uint32_t SETTINGS_JOURNAL_BLOCKS = sizeof(Settings) / SETTINGS_JOURNAL_BLOCK;
+const uint32_t SETTINGS_JOURNAL_MAGIC = 0x4C4E4A54;                            // "TJNL"
+const uint32_t SETTINGS_JOURNAL_TAG = 0x4A520000;                              // "JR" + block number
+const uint32_t SETTINGS_JOURNAL_COMMIT = 0x4A430000;                           // "JC" + block number of last record in a save
+const uint32_t SETTINGS_JOURNAL_HEADER = 12;                                   // Magic, save_flag and cfg_crc32
+const uint32_t SETTINGS_JOURNAL_RECORD = SETTINGS_JOURNAL_BLOCK + 8;           // Tag, block data and crc32
+static_assert(sizeof(Settings) % SETTINGS_JOURNAL_BLOCK == 0, "Settings size must be a multiple of SETTINGS_JOURNAL_BLOCK");
+
+struct {
+  uint32_t hash[SETTINGS_JOURNAL_BLOCKS];   // Block hashes of Settings as last saved
+  uint32_t save_flag;                       // Settings image the journal belongs to
+  uint32_t crc32;
+  uint16_t position;                        // Next free journal byte, 0 = sector needs erase
+} SettingsJournal;
+
+uint32_t SettingsBlockHash(uint32_t block)
+{
+  const uint32_t *data = (const uint32_t*)((uint8_t*)&Settings + (block * SETTINGS_JOURNAL_BLOCK));
+  uint32_t hash = block;
+  for (uint32_t i = 0; i < SETTINGS_JOURNAL_BLOCK / 4; i++) {
+    hash = (hash ^ data[i]) * 0x9E3779B1;   // Every step is reversible so any single word change alters the hash
+    hash = (hash << 15) | (hash >> 17);
+  }
+  return hash;
+}
+
+uint32_t SettingsJournalDirty(void)
+{
+  uint32_t dirty = 0;
+  for (uint32_t block = 0; block < SETTINGS_JOURNAL_BLOCKS; block++) {
+    if (SettingsBlockHash(block) != SettingsJournal.hash[block]) { dirty++; }
+  }
+  return dirty;
+}
+
+// Start a new journal for the Settings image just written or loaded
+void SettingsJournalReset(void)
+{
+  for (uint32_t block = 0; block < SETTINGS_JOURNAL_BLOCKS; block++) {
+    SettingsJournal.hash[block] = SettingsBlockHash(block);
+  }
+  SettingsJournal.save_flag = Settings.save_flag;
+  SettingsJournal.crc32 = Settings.cfg_crc32;
+  SettingsJournal.position = 0;
+}
+
+bool SettingsJournalAppend(void)
+{
+#ifdef ESP8266
+  if (TasmotaGlobal.stop_flash_rotate || (settings_location > SETTINGS_LOCATION) || (settings_location <= (SETTINGS_LOCATION - CFG_ROTATES))) {
+    return false;                           // No rotating slot available for a journal
+  }
+  uint32_t position = (SettingsJournal.position) ? SettingsJournal.position : SETTINGS_JOURNAL_HEADER;
+  uint32_t dirty = SettingsJournalDirty();
+  if (position + (dirty * SETTINGS_JOURNAL_RECORD) > SPI_FLASH_SEC_SIZE) {
+    return false;                           // Journal full - write a new image
+  }
+
+  uint32_t sector = SettingsNextLocation(settings_location);
+  uint32_t record[SETTINGS_JOURNAL_RECORD / 4];
+  if (!SettingsJournal.position) {
+    if (!ESP.flashEraseSector(sector)) { return false; }
+    record[0] = SETTINGS_JOURNAL_MAGIC;
+    record[1] = SettingsJournal.save_flag;
+    record[2] = SettingsJournal.crc32;
+    if (!ESP.flashWrite(sector * SPI_FLASH_SEC_SIZE, record, SETTINGS_JOURNAL_HEADER)) { return false; }
+    SettingsJournal.position = SETTINGS_JOURNAL_HEADER;
+  }
+
+  uint32_t records = 0;
+  for (uint32_t block = 0; block < SETTINGS_JOURNAL_BLOCKS; block++) {
+    uint32_t hash = SettingsBlockHash(block);
+    if (hash == SettingsJournal.hash[block]) { continue; }
+
+    records++;
+    record[0] = ((records < dirty) ? SETTINGS_JOURNAL_TAG : SETTINGS_JOURNAL_COMMIT) | block;
+    memcpy(&record[1], (uint8_t*)&Settings + (block * SETTINGS_JOURNAL_BLOCK), SETTINGS_JOURNAL_BLOCK);
+    record[(SETTINGS_JOURNAL_RECORD / 4) -1] = GetCfgCrc32((uint8_t*)record, SETTINGS_JOURNAL_RECORD -4);
+    if (!ESP.flashWrite((sector * SPI_FLASH_SEC_SIZE) + SettingsJournal.position, record, SETTINGS_JOURNAL_RECORD)) {
+      SettingsJournal.position = SPI_FLASH_SEC_SIZE;  // Unknown journal state - write a new image
+      return false;
+    }
+    SettingsJournal.position += SETTINGS_JOURNAL_RECORD;
+    SettingsJournal.hash[block] = hash;
+  }
+  AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_CONFIG "Journal at %X, " D_COUNT " %d, Records %d, " D_BYTES " %d"), sector, Settings.save_flag, records, SettingsJournal.position);
+  return true;
+#else
+  return false;                             // ESP32 NVS does its own wear leveling
+#endif  // ESP8266
+}
+
+// Replay the journal belonging to the Settings image just read from settings_location
+void SettingsJournalLoad(void)
+{
+  SettingsJournalReset();
+#ifdef ESP8266
+  uint32_t address = SettingsNextLocation(settings_location) * SPI_FLASH_SEC_SIZE;
+  uint32_t record[SETTINGS_JOURNAL_RECORD / 4];
+  ESP.flashRead(address, record, SETTINGS_JOURNAL_HEADER);
+  if ((record[0] != SETTINGS_JOURNAL_MAGIC) || (record[1] != SettingsJournal.save_flag) || (record[2] != SettingsJournal.crc32)) {
+    return;                                 // Sector holds no journal for this image
+  }
+
+  // Find end of last complete save
+  uint32_t committed = SETTINGS_JOURNAL_HEADER;
+  uint32_t position = SETTINGS_JOURNAL_HEADER;
+  while (position + SETTINGS_JOURNAL_RECORD <= SPI_FLASH_SEC_SIZE) {
+    ESP.flashRead(address + position, record, SETTINGS_JOURNAL_RECORD);
+    if (0xFFFFFFFF == record[0]) { break; }  // End of journal
+    uint32_t tag = record[0] & 0xFFFF0000;
+    if (((tag != SETTINGS_JOURNAL_TAG) && (tag != SETTINGS_JOURNAL_COMMIT)) || ((record[0] & 0xFFFF) >= SETTINGS_JOURNAL_BLOCKS) ||
+        (record[(SETTINGS_JOURNAL_RECORD / 4) -1] != GetCfgCrc32((uint8_t*)record, SETTINGS_JOURNAL_RECORD -4))) {
+      position = SPI_FLASH_SEC_SIZE;        // Interrupted write - do not append after it but write a new image
+      break;
+    }
+    position += SETTINGS_JOURNAL_RECORD;
+    if (SETTINGS_JOURNAL_COMMIT == tag) { committed = position; }
+  }
+  if (committed < position) {
+    position = SPI_FLASH_SEC_SIZE;          // Interrupted save - do not append after it but write a new image
+  }
+
+  uint32_t records = 0;
+  for (uint32_t offset = SETTINGS_JOURNAL_HEADER; offset < committed; offset += SETTINGS_JOURNAL_RECORD) {
+    ESP.flashRead(address + offset, record, SETTINGS_JOURNAL_RECORD);
+    memcpy((uint8_t*)&Settings + ((record[0] & 0xFFFF) * SETTINGS_JOURNAL_BLOCK), &record[1], SETTINGS_JOURNAL_BLOCK);
+    records++;
+  }
+  for (uint32_t block = 0; block < SETTINGS_JOURNAL_BLOCKS; block++) {
+    SettingsJournal.hash[block] = SettingsBlockHash(block);
+  }
+  SettingsJournal.position = position;
+  AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_CONFIG "Journal replayed %d records"), records);
+#endif  // ESP8266
+}
+
+#endif  // USE_SETTINGS_JOURNAL
+
 /*********************************************************************************************\
  * Config Save - Save parameters to Flash ONLY if any parameter has changed
 \*********************************************************************************************/
@@ -483,7 +652,16 @@ void SettingsSave(uint8_t rotate)
  */
 #ifndef FIRMWARE_MINIMAL
   UpdateBackwardCompatibility();
+#ifdef USE_SETTINGS_JOURNAL
+  if (SettingsJournalDirty() || rotate) {
+    Settings.save_flag++;
+    if (!rotate && SettingsJournalAppend()) {   // Only changed blocks appended to journal
+      RtcSettingsSave();
+      return;
+    }
+#else
   if ((GetSettingsCrc32() != settings_crc32) || rotate) {
+#endif  // USE_SETTINGS_JOURNAL
     if (1 == rotate) {   // Use eeprom flash slot only and disable flash rotate from now on (upgrade)
       TasmotaGlobal.stop_flash_rotate = 1;
     }
@@ -493,13 +671,17 @@ void SettingsSave(uint8_t rotate)
     if (TasmotaGlobal.stop_flash_rotate) {
       settings_location = SETTINGS_LOCATION;
     } else {
-      settings_location--;
-      if (settings_location <= (SETTINGS_LOCATION - CFG_ROTATES)) {
-        settings_location = SETTINGS_LOCATION;
+#ifdef USE_SETTINGS_JOURNAL
+      if (SettingsJournal.position && (settings_location <= SETTINGS_LOCATION)) {
+        settings_location = SettingsNextLocation(settings_location);  // Skip journal to keep it and its image until the new image is written
       }
+#endif  // USE_SETTINGS_JOURNAL
+      settings_location = SettingsNextLocation(settings_location);
     }
 
+#ifndef USE_SETTINGS_JOURNAL
     Settings.save_flag++;
+#endif  // USE_SETTINGS_JOURNAL
     if (UtcTime() > START_VALID_TIME) {
       Settings.cfg_timestamp = UtcTime();
     } else {
@@ -528,6 +710,9 @@ void SettingsSave(uint8_t rotate)
 #endif  // ESP32
 
     settings_crc32 = Settings.cfg_crc32;
+#ifdef USE_SETTINGS_JOURNAL
+    SettingsJournalReset();
+#endif  // USE_SETTINGS_JOURNAL
   }
 #endif  // FIRMWARE_MINIMAL
   RtcSettingsSave();
@@ -557,11 +742,17 @@ void SettingsLoad(void) {
   if (settings_location > 0) {
     ESP.flashRead(settings_location * SPI_FLASH_SEC_SIZE, (uint32*)&Settings, sizeof(Settings));
     AddLog_P(LOG_LEVEL_NONE, PSTR(D_LOG_CONFIG D_LOADED_FROM_FLASH_AT " %X, " D_COUNT " %lu"), settings_location, Settings.save_flag);
+#ifdef USE_SETTINGS_JOURNAL
+    SettingsJournalLoad();
+#endif  // USE_SETTINGS_JOURNAL
   }
 #endif  // ESP8266
 #ifdef ESP32
   SettingsRead(&Settings, sizeof(Settings));
   AddLog_P(LOG_LEVEL_NONE, PSTR(D_LOG_CONFIG "Loaded, " D_COUNT " %lu"), Settings.save_flag);
+#ifdef USE_SETTINGS_JOURNAL
+  SettingsJournalReset();
+#endif  // USE_SETTINGS_JOURNAL
 #endif  // ESP32
 
 #ifndef FIRMWARE_MINIMAL
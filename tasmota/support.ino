@@ -851,8 +851,148 @@ int GetCommandCode(char* destination, size_t destination_size, const char* needl
   return result;
 }
 
+#ifdef USE_COMMAND_INDEX
+/*********************************************************************************************\
+ * Command index
+ *
+ * Every command table passed to DecodeCommand is registered once and each of its commands,
+ * including the table prefix, is stored as a 16-bit hash in a sorted array. A command lookup
+ * is then a binary search followed by a single verification against the table in flash.
+\*********************************************************************************************/
+
+#define COMMAND_INDEX_MAX_TABLES 255
+
+typedef struct {
+  uint16_t hash;                               // Hash of upper case prefix and command
+  uint8_t table;                               // Index in CommandIndex.tables
+  uint8_t code;                                // Command index in table (0 is prefix)
+} CommandIndexEntry;
+
+struct {
+  const char **tables;                         // Registered command tables
+  CommandIndexEntry *entries;                  // Sorted on hash
+  uint16_t count;                              // Number of entries
+  uint8_t table_count;                         // Number of registered tables
+  bool failed;                                 // Out of memory so use linear search
+} CommandIndex;
+
+uint32_t CommandIndexHashAdd(uint32_t hash, const char* str)
+{
+  // FNV-1a, case insensitive
+  while (*str) {
+    hash ^= (uint8_t)toupper(*str++);
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+uint16_t CommandIndexHash(uint32_t hash)
+{
+  return (hash >> 16) ^ (hash & 0xFFFF);
+}
+
+int CommandIndexCompare(const void* a, const void* b)
+{
+  return (int)((const CommandIndexEntry*)a)->hash - (int)((const CommandIndexEntry*)b)->hash;
+}
+
+bool CommandIndexRegister(const char* haystack)
+{
+  for (uint32_t i = 0; i < CommandIndex.table_count; i++) {
+    if (CommandIndex.tables[i] == haystack) { return true; }
+  }
+  if (CommandIndex.table_count >= COMMAND_INDEX_MAX_TABLES) { return false; }
+
+  uint32_t commands = 0;
+  for (const char* read = haystack; pgm_read_byte(read); read++) {
+    if ('|' == pgm_read_byte(read)) { commands++; }
+  }
+  if (commands > 255) { return false; }
+
+  const char **tables = (const char**)realloc(CommandIndex.tables, (CommandIndex.table_count +1) * sizeof(const char*));
+  if (!tables) { return false; }
+  CommandIndex.tables = tables;
+  if (commands) {
+    CommandIndexEntry *entries = (CommandIndexEntry*)realloc(CommandIndex.entries, (CommandIndex.count + commands) * sizeof(CommandIndexEntry));
+    if (!entries) { return false; }
+    CommandIndex.entries = entries;
+  }
+
+  uint32_t table = CommandIndex.table_count++;
+  CommandIndex.tables[table] = haystack;
+
+  const char* read = haystack;
+  char name[CMDSZ];
+  uint32_t prefix_hash = 0;
+  for (uint32_t code = 0; code <= commands; code++) {
+    uint32_t size = 0;
+    char ch;
+    while ((ch = pgm_read_byte(read)) && (ch != '|')) {
+      if (size < sizeof(name) -1) { name[size++] = ch; }
+      read++;
+    }
+    read++;                                    // Skip separator
+    name[size] = '\0';
+    if (0 == code) {
+      prefix_hash = CommandIndexHashAdd(2166136261, name);
+    } else {
+      CommandIndexEntry *entry = &CommandIndex.entries[CommandIndex.count++];
+      entry->hash = CommandIndexHash(CommandIndexHashAdd(prefix_hash, name));
+      entry->table = table;
+      entry->code = code;
+    }
+  }
+  qsort(CommandIndex.entries, CommandIndex.count, sizeof(CommandIndexEntry), CommandIndexCompare);
+  return true;
+}
+
+// Returns command code (> 0) with prefix and command in destination, 0 if not found or -1 if haystack is not indexed
+int CommandIndexFind(char* destination, size_t destination_size, const char* needle, const char* haystack)
+{
+  if (CommandIndex.failed) { return -1; }
+  if (!CommandIndexRegister(haystack)) {
+    AddLog_P(LOG_LEVEL_DEBUG, PSTR("CMD: Command index disabled"));
+    CommandIndex.failed = true;
+    return -1;
+  }
+
+  uint16_t hash = CommandIndexHash(CommandIndexHashAdd(2166136261, needle));
+  uint32_t low = 0;
+  uint32_t high = CommandIndex.count;
+  while (low < high) {                         // Find first entry with hash
+    uint32_t mid = (low + high) / 2;
+    if (CommandIndex.entries[mid].hash < hash) {
+      low = mid +1;
+    } else {
+      high = mid;
+    }
+  }
+  for (; (low < CommandIndex.count) && (CommandIndex.entries[low].hash == hash); low++) {
+    CommandIndexEntry *entry = &CommandIndex.entries[low];
+    if (CommandIndex.tables[entry->table] == haystack) {
+      GetTextIndexed(destination, destination_size, 0, haystack);  // Get prefix if available
+      uint32_t prefix_length = strlen(destination);
+      GetTextIndexed(destination + prefix_length, destination_size - prefix_length, entry->code, haystack);
+      if (!strcasecmp(needle, destination)) {  // Hashes may collide
+        return entry->code;
+      }
+    }
+  }
+  return 0;
+}
+#endif  // USE_COMMAND_INDEX
+
 bool DecodeCommand(const char* haystack, void (* const MyCommand[])(void))
 {
+#ifdef USE_COMMAND_INDEX
+  int code = CommandIndexFind(XdrvMailbox.command, CMDSZ, XdrvMailbox.topic, haystack);
+  if (code > 0) {
+    XdrvMailbox.command_code = code -1;
+    MyCommand[XdrvMailbox.command_code]();
+    return true;
+  }
+  if (0 == code) { return false; }
+#endif  // USE_COMMAND_INDEX
   GetTextIndexed(XdrvMailbox.command, CMDSZ, 0, haystack);  // Get prefix if available
   int prefix_length = strlen(XdrvMailbox.command);
   if (prefix_length) {
@@ -862,7 +1002,7 @@ bool DecodeCommand(const char* haystack, void (* const MyCommand[])(void))
       return false;                                         // Prefix not in command
     }
   }
-  int command_code = GetCommandCode(XdrvMailbox.command + prefix_length, CMDSZ, XdrvMailbox.topic + prefix_length, haystack);
+  int command_code = GetCommandCode(XdrvMailbox.command + prefix_length, CMDSZ - prefix_length, XdrvMailbox.topic + prefix_length, haystack);
   if (command_code > 0) {                                   // Skip prefix
     XdrvMailbox.command_code = command_code -1;
     MyCommand[XdrvMailbox.command_code]();
@@ -1096,8 +1236,73 @@ char* ResponseGetTime(uint32_t format, char* time_str)
   return time_str;
 }
 
+/*********************************************************************************************\
+ * Response buffer
+ *
+ * Tracks the length of the response in TasmotaGlobal.mqtt_data so appends do not need a strlen
+ * and records if any part of the response was truncated. Code writing to mqtt_data directly
+ * must call ResponseInvalidate() afterwards (or use Response_P) to force a resync, or
+ * ResponseWritten() when it knows the length and the number of characters it dropped.
+ * ResponseLength() only catches a missed call if the write lengthened the response, emptied it
+ * or shortened it by one character. Build with DEBUG_TASMOTA_CORE to check every use with strlen.
+\*********************************************************************************************/
+
+struct {
+  uint16_t length;                             // Length of response in mqtt_data excluding terminating zero
+  uint16_t overflow;                           // Number of characters dropped due to buffer size
+} ResponseBuffer;
+
+void ResponseInvalidate(void) {
+  ResponseBuffer.length = sizeof(TasmotaGlobal.mqtt_data);  // Out of range forces strlen on next use
+}
+
+void ResponseWritten(uint32_t len, uint32_t overflow) {
+  ResponseBuffer.length = len;
+  ResponseBuffer.overflow = (overflow > 0xFFFF) ? 0xFFFF : overflow;
+}
+
+uint32_t ResponseLength(void) {
+  uint32_t len = ResponseBuffer.length;
+  if ((len >= sizeof(TasmotaGlobal.mqtt_data)) ||
+      (TasmotaGlobal.mqtt_data[len] != '\0') ||
+      (len && ((TasmotaGlobal.mqtt_data[0] == '\0') || (TasmotaGlobal.mqtt_data[len -1] == '\0')))) {
+    // Buffer changed outside the Response functions
+    len = strlen(TasmotaGlobal.mqtt_data);
+    ResponseBuffer.length = len;
+  }
+#ifdef DEBUG_TASMOTA_CORE
+  else {
+    uint32_t mqtt_len = strlen(TasmotaGlobal.mqtt_data);
+    if (mqtt_len != len) {
+      // Shortened by more than one character without ResponseInvalidate()
+      AddLog_P(LOG_LEVEL_ERROR, PSTR("RSP: Response length %d but mqtt_data holds %d characters"), len, mqtt_len);
+      len = mqtt_len;
+      ResponseBuffer.length = len;
+    }
+  }
+#endif  // DEBUG_TASMOTA_CORE
+  return len;
+}
+
+uint32_t ResponseOverflow(void) {
+  return ResponseBuffer.overflow;
+}
+
+// Update length after vsnprintf_P at offset returned len
+void ResponseUpdate(uint32_t offset, int len) {
+  if (len < 0) { len = 0; }
+  uint32_t size = sizeof(TasmotaGlobal.mqtt_data) - offset;
+  if ((uint32_t)len >= size) {
+    ResponseBuffer.overflow += len - (size -1);
+    len = size -1;
+  }
+  ResponseBuffer.length = offset + len;
+}
+
 void ResponseClear(void) {
   TasmotaGlobal.mqtt_data[0] = '\0';
+  ResponseBuffer.length = 0;
+  ResponseBuffer.overflow = 0;
 }
 
 int Response_P(const char* format, ...)        // Content send snprintf_P char data
@@ -1107,6 +1312,8 @@ int Response_P(const char* format, ...)        // Content send snprintf_P char d
   va_start(args, format);
   int len = vsnprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), format, args);
   va_end(args);
+  ResponseBuffer.overflow = 0;
+  ResponseUpdate(0, len);
   return len;
 }
 
@@ -1121,6 +1328,8 @@ int ResponseTime_P(const char* format, ...)    // Content send snprintf_P char d
   int mlen = strlen(TasmotaGlobal.mqtt_data);
   int len = vsnprintf_P(TasmotaGlobal.mqtt_data + mlen, sizeof(TasmotaGlobal.mqtt_data) - mlen, format, args);
   va_end(args);
+  ResponseBuffer.overflow = 0;
+  ResponseUpdate(mlen, len);
   return len + mlen;
 }
 
@@ -1129,9 +1338,10 @@ int ResponseAppend_P(const char* format, ...)  // Content send snprintf_P char d
   // This uses char strings. Be aware of sending %% if % is needed
   va_list args;
   va_start(args, format);
-  int mlen = strlen(TasmotaGlobal.mqtt_data);
+  int mlen = ResponseLength();
   int len = vsnprintf_P(TasmotaGlobal.mqtt_data + mlen, sizeof(TasmotaGlobal.mqtt_data) - mlen, format, args);
   va_end(args);
+  ResponseUpdate(mlen, len);
   return len + mlen;
 }
 
@@ -1938,14 +2148,47 @@ void SyslogAsync(bool refresh) {
   }
 }
 
+/*********************************************************************************************\
+ * Log buffer
+ *
+ * Ring buffer of zero terminated log lines addressed by index 1..255 where
+ * TasmotaGlobal.log_buffer_pointer is the index of the next log line. Log lines never wrap
+ * around the buffer end. TasmotaGlobal.log_index holds offset, length and loglevel of the
+ * stored lines, oldest first, so append, eviction and lookup do not scan the buffer.
+\*********************************************************************************************/
+
+uint32_t LogIndexSlot(uint32_t rank) {
+  return (TasmotaGlobal.log_index_first + rank) & (LOG_INDEX_SIZE -1);
+}
+
+int32_t LogIndexRank(uint32_t index) {
+  // Return position of log line index where 0 is the oldest or -1 if not available
+  if (!index || (index > 255) || !TasmotaGlobal.log_index_count) { return -1; }
+  uint32_t newest = (TasmotaGlobal.log_buffer_pointer > 1) ? TasmotaGlobal.log_buffer_pointer -1 : 255;
+  uint32_t distance = (newest + 255 - index) % 255;
+  if (distance >= TasmotaGlobal.log_index_count) { return -1; }
+  return TasmotaGlobal.log_index_count -1 - distance;
+}
+
+void LogRemoveOldest(void) {
+  LogIndex *entry = &TasmotaGlobal.log_index[TasmotaGlobal.log_index_first];
+  TasmotaGlobal.log_buffer_used -= entry->length;
+  TasmotaGlobal.log_index_first = LogIndexSlot(1);
+  TasmotaGlobal.log_index_count--;
+}
+
 bool NeedLogRefresh(uint32_t req_loglevel, uint32_t index) {
   // Skip initial buffer fill
-  if (strlen(TasmotaGlobal.log_buffer) < LOG_BUFFER_SIZE - LOGSZ) { return false; }
+  if ((TasmotaGlobal.log_buffer_used < LOG_BUFFER_SIZE - LOGSZ) &&
+      (TasmotaGlobal.log_index_count < LOG_INDEX_SIZE - LOG_INDEX_SIZE / 4)) { return false; }
 
-  char* line;
-  size_t len;
-  if (!GetLog(req_loglevel, &index, &line, &len)) { return false; }
-  return ((line - TasmotaGlobal.log_buffer) < LOG_BUFFER_SIZE / 4);
+  if (!req_loglevel || (index == TasmotaGlobal.log_buffer_pointer)) { return false; }
+  int32_t rank = LogIndexRank(index);
+  if (rank < 0) { return true; }           // Requested line already removed
+  // Refresh when the requested line is about to be removed
+  LogIndex *oldest = &TasmotaGlobal.log_index[TasmotaGlobal.log_index_first];
+  uint32_t distance = (TasmotaGlobal.log_index[LogIndexSlot(rank)].offset + LOG_BUFFER_SIZE - oldest->offset) % LOG_BUFFER_SIZE;
+  return ((distance < LOG_BUFFER_SIZE / 4) || (rank < LOG_INDEX_SIZE / 4));
 }
 
 bool GetLog(uint32_t req_loglevel, uint32_t* index_p, char** entry_pp, size_t* len_p) {
@@ -1954,43 +2197,45 @@ bool GetLog(uint32_t req_loglevel, uint32_t* index_p, char** entry_pp, size_t* l
   if (TasmotaGlobal.uptime < 3) { return false; }  // Allow time to setup correct log level
   if (!req_loglevel || (index == TasmotaGlobal.log_buffer_pointer)) { return false; }
 
-  if (!index) {                            // Dump all
-    index = TasmotaGlobal.log_buffer_pointer +1;
-    if (index > 255) { index = 1; }
+  int32_t rank = LogIndexRank(index);
+  if (rank < 0) {                          // Dump all or requested line already removed
+    rank = 0;
+    index = (TasmotaGlobal.log_buffer_pointer + 255 - TasmotaGlobal.log_index_count -1) % 255 +1;  // Oldest line
   }
 
-  do {
-    size_t len = 0;
-    uint32_t loglevel = 0;
-    char* entry_p = TasmotaGlobal.log_buffer;
-    do {
-      uint32_t cur_idx = *entry_p;
-      entry_p++;
-      size_t tmp = strchrspn(entry_p, '\1');
-      tmp++;                               // Skip terminating '\1'
-      if (cur_idx == index) {              // Found the requested entry
-        loglevel = *entry_p - '0';
-        entry_p++;                         // Skip loglevel
-        len = tmp -1;
-        break;
-      }
-      entry_p += tmp;
-    } while (entry_p < TasmotaGlobal.log_buffer + LOG_BUFFER_SIZE && *entry_p != '\0');
+  while (rank < TasmotaGlobal.log_index_count) {
+    LogIndex *entry = &TasmotaGlobal.log_index[LogIndexSlot(rank)];
+    rank++;
     index++;
     if (index > 255) { index = 1; }        // Skip 0 as it is not allowed
-    *index_p = index;
-    if ((len > 0) &&
-        (loglevel <= req_loglevel) &&
+    if ((entry->level <= req_loglevel) &&
         (TasmotaGlobal.masterlog_level <= req_loglevel)) {
-      *entry_pp = entry_p;
-      *len_p = len;
+      *index_p = index;
+      *entry_pp = TasmotaGlobal.log_buffer + entry->offset;
+      *len_p = entry->length;              // Line length including terminating zero
       return true;
     }
-    delay(0);
-  } while (index != TasmotaGlobal.log_buffer_pointer);
+  }
+  *index_p = TasmotaGlobal.log_buffer_pointer;
   return false;
 }
 
+uint32_t HighestLogLevel(void) {
+  uint32_t highest_loglevel = Settings.weblog_level;
+  if (Settings.mqttlog_level > highest_loglevel) { highest_loglevel = Settings.mqttlog_level; }
+  if (TasmotaGlobal.syslog_level > highest_loglevel) { highest_loglevel = TasmotaGlobal.syslog_level; }
+  if (TasmotaGlobal.templog_level > highest_loglevel) { highest_loglevel = TasmotaGlobal.templog_level; }
+  if (TasmotaGlobal.uptime < 3) { highest_loglevel = LOG_LEVEL_DEBUG_MORE; }  // Log all before setup correct log level
+  return highest_loglevel;
+}
+
+bool NeedLog(uint32_t loglevel) {
+  // Return true if AddLogData would output loglevel to any log destination
+  uint32_t highest_loglevel = HighestLogLevel();
+  if (TasmotaGlobal.seriallog_level > highest_loglevel) { highest_loglevel = TasmotaGlobal.seriallog_level; }
+  return ((loglevel <= highest_loglevel) && (TasmotaGlobal.masterlog_level <= highest_loglevel));
+}
+
 void AddLogData(uint32_t loglevel, const char* log_data) {
   char mxtime[14];  // "13:45:21.999 "
   snprintf_P(mxtime, sizeof(mxtime), PSTR("%02d" D_HOUR_MINUTE_SEPARATOR "%02d" D_MINUTE_SECOND_SEPARATOR "%02d.%03d "), RtcTime.hour, RtcTime.minute, RtcTime.second, RtcMillis());
@@ -2000,34 +2245,58 @@ void AddLogData(uint32_t loglevel, const char* log_data) {
     Serial.printf("%s%s\r\n", mxtime, log_data);
   }
 
-  uint32_t highest_loglevel = Settings.weblog_level;
-  if (Settings.mqttlog_level > highest_loglevel) { highest_loglevel = Settings.mqttlog_level; }
-  if (TasmotaGlobal.syslog_level > highest_loglevel) { highest_loglevel = TasmotaGlobal.syslog_level; }
-  if (TasmotaGlobal.templog_level > highest_loglevel) { highest_loglevel = TasmotaGlobal.templog_level; }
-  if (TasmotaGlobal.uptime < 3) { highest_loglevel = LOG_LEVEL_DEBUG_MORE; }  // Log all before setup correct log level
+  uint32_t highest_loglevel = HighestLogLevel();
 
   if ((loglevel <= highest_loglevel) &&    // Log only when needed
       (TasmotaGlobal.masterlog_level <= highest_loglevel)) {
-    // Delimited, zero-terminated buffer of log lines.
-    // Each entry has this format: [index][loglevel][log data]['\1']
     TasmotaGlobal.log_buffer_pointer &= 0xFF;
     if (!TasmotaGlobal.log_buffer_pointer) {
-      TasmotaGlobal.log_buffer_pointer++;  // Index 0 is not allowed as it is the end of char string
+      TasmotaGlobal.log_buffer_pointer++;  // Index 0 is not allowed
     }
-    while (TasmotaGlobal.log_buffer_pointer == TasmotaGlobal.log_buffer[0] ||  // If log already holds the next index, remove it
-           strlen(TasmotaGlobal.log_buffer) + strlen(log_data) + strlen(mxtime) + 4 > LOG_BUFFER_SIZE)  // 4 = log_buffer_pointer + '\1' + '\0'
-    {
-      char* it = TasmotaGlobal.log_buffer;
-      it++;                                // Skip log_buffer_pointer
-      it += strchrspn(it, '\1');           // Skip log line
-      it++;                                // Skip delimiting "\1"
-      memmove(TasmotaGlobal.log_buffer, it, LOG_BUFFER_SIZE -(it-TasmotaGlobal.log_buffer));  // Move buffer forward to remove oldest log line
+
+    uint32_t mxtime_len = strlen(mxtime);
+    uint32_t data_len = strlen(log_data);
+    if (mxtime_len + data_len +1 > LOGSZ) { data_len = LOGSZ - mxtime_len -1; }
+    uint32_t length = mxtime_len + data_len +1;  // Including terminating zero
+
+    uint32_t offset = TasmotaGlobal.log_buffer_head;
+    if (offset + length > LOG_BUFFER_SIZE) {
+      // Line does not fit at the buffer end so remove all lines stored there and restart at 0
+      while (TasmotaGlobal.log_index_count &&
+             (TasmotaGlobal.log_index[TasmotaGlobal.log_index_first].offset >= offset)) {
+        LogRemoveOldest();
+      }
+      offset = 0;
     }
-    snprintf_P(TasmotaGlobal.log_buffer, sizeof(TasmotaGlobal.log_buffer), PSTR("%s%c%c%s%s\1"),
-      TasmotaGlobal.log_buffer, TasmotaGlobal.log_buffer_pointer++, '0'+loglevel, mxtime, log_data);
+    while (TasmotaGlobal.log_index_count) {
+      LogIndex *oldest = &TasmotaGlobal.log_index[TasmotaGlobal.log_index_first];
+      if ((TasmotaGlobal.log_index_count < LOG_INDEX_SIZE) &&
+          ((oldest->offset >= offset + length) || (oldest->offset < offset))) {
+        break;                             // No overlap with new line
+      }
+      LogRemoveOldest();
+    }
+    if (!TasmotaGlobal.log_index_count) {
+      TasmotaGlobal.log_index_first = 0;
+    }
+
+    char* line = TasmotaGlobal.log_buffer + offset;
+    memcpy(line, mxtime, mxtime_len);
+    memcpy(line + mxtime_len, log_data, data_len);
+    line[length -1] = '\0';
+
+    LogIndex *entry = &TasmotaGlobal.log_index[LogIndexSlot(TasmotaGlobal.log_index_count)];
+    entry->offset = offset;
+    entry->length = length;
+    entry->level = loglevel;
+    TasmotaGlobal.log_index_count++;
+    TasmotaGlobal.log_buffer_used += length;
+    TasmotaGlobal.log_buffer_head = offset + length;
+
+    TasmotaGlobal.log_buffer_pointer++;
     TasmotaGlobal.log_buffer_pointer &= 0xFF;
     if (!TasmotaGlobal.log_buffer_pointer) {
-      TasmotaGlobal.log_buffer_pointer++;  // Index 0 is not allowed as it is the end of char string
+      TasmotaGlobal.log_buffer_pointer++;  // Index 0 is not allowed
     }
   }
 }
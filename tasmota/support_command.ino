@@ -39,6 +39,9 @@ const char kTasmotaCommands[] PROGMEM = "|"  // No prefix
   D_CMND_DEVGROUP_SHARE "|" D_CMND_DEVGROUPSTATUS "|"
 #endif  // USE_DEVICE_GROUPS
   D_CMND_SENSOR "|" D_CMND_DRIVER
+#ifdef USE_PROFILER
+  "|" D_CMND_PROFILE
+#endif  // USE_PROFILER
 #ifdef ESP32
    "|Info|" D_CMND_TOUCH_CAL "|" D_CMND_TOUCH_THRES "|" D_CMND_TOUCH_NUM "|" D_CMND_CPU_FREQUENCY "|" D_CMND_WIFI
 #endif  // ESP32
@@ -66,6 +69,9 @@ void (* const TasmotaCommand[])(void) PROGMEM = {
   &CmndDevGroupShare, &CmndDevGroupStatus,
 #endif  // USE_DEVICE_GROUPS
   &CmndSensor, &CmndDriver
+#ifdef USE_PROFILER
+  , &CmndProfile
+#endif  // USE_PROFILER
 #ifdef ESP32
   , &CmndInfo, &CmndTouchCal, &CmndTouchThres, &CmndTouchNum, &CmndCpuFrequency, &CmndWifi
 #endif  // ESP32
@@ -2001,7 +2007,9 @@ void CmndWifiPower(void)
 void CmndI2cScan(void)
 {
   if (TasmotaGlobal.i2c_enabled) {
+    ResponseClear();
     I2cScan(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data));
+    ResponseInvalidate();
   }
 }
 
@@ -85,8 +85,46 @@ bool TfsSaveFile(const char *fname, const uint8_t *buf, uint32_t len) {
     return false;
   }
 
-  file.write(buf, len);
+  uint32_t written = file.write(buf, len);
   file.close();
+  if (written != len) {
+    AddLog_P(LOG_LEVEL_INFO, PSTR("TFS: Save failed"));
+    return false;
+  }
+  return true;
+}
+
+uint32_t TfsFileSize(const char *fname) {
+  if (!TfsInit()) { return 0; }
+  if (!TASMOTA_FS.exists(fname)) { return 0; }
+
+  uint32_t size = 0;
+  File file = TASMOTA_FS.open(fname, "r");
+  if (file) {
+    size = file.size();
+    file.close();
+  }
+  return size;
+}
+
+bool TfsDeleteFile(const char *fname) {
+  if (!TfsInit()) { return false; }
+  if (!TASMOTA_FS.exists(fname)) { return true; }
+
+  if (!TASMOTA_FS.remove(fname)) {
+    AddLog_P(LOG_LEVEL_INFO, PSTR("TFS: Delete failed"));
+    return false;
+  }
+  return true;
+}
+
+bool TfsRenameFile(const char *fname1, const char *fname2) {
+  if (!TfsInit()) { return false; }
+
+  if (!TASMOTA_FS.rename(fname1, fname2)) {
+    AddLog_P(LOG_LEVEL_INFO, PSTR("TFS: Rename failed"));
+    return false;
+  }
   return true;
 }
 
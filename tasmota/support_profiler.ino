@@ -0,0 +1,234 @@
+/*
+  support_profiler.ino - driver execution time profiler for Tasmota
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef USE_PROFILER
+/*********************************************************************************************\
+ * Profiler
+ *
+ * Records cumulative time in microseconds, call count and worst case per xdrv/xsns driver
+ * and function plus the main loop phases. Statistics memory is only allocated when enabled.
+ *
+ * Profile         - Show top entries by cumulative time
+ * Profile 0       - Disable profiler and free memory
+ * Profile 1       - Enable profiler
+ * Profile 2       - Reset statistics
+\*********************************************************************************************/
+
+#define PROFILE_MAX_SHOW       10             // Max number of driver entries in Profile command response
+
+const char kProfilePhases[] PROGMEM = "Button|Switch|Backlog|Serial";
+
+const uint8_t kProfileFunction[] PROGMEM = {
+  FUNC_LOOP, FUNC_EVERY_50_MSECOND, FUNC_EVERY_100_MSECOND, FUNC_EVERY_200_MSECOND, FUNC_EVERY_250_MSECOND, FUNC_EVERY_SECOND,
+  FUNC_JSON_APPEND, FUNC_WEB_SENSOR, FUNC_COMMAND, FUNC_MQTT_DATA, FUNC_RULES_PROCESS };
+const uint8_t PROFILE_FUNCTIONS = sizeof(kProfileFunction) +1;  // Last slot collects all other functions
+
+const char kProfileFunctions[] PROGMEM = "Loop|50mS|100mS|200mS|250mS|Second|JsonAppend|WebSensor|Command|MqttData|Rules|Other";
+
+typedef struct {
+  uint32_t time;                              // Cumulative time in microseconds
+  uint32_t calls;                             // Number of calls
+  uint32_t max;                               // Worst case time in microseconds
+} ProfileStat;
+
+struct {
+  ProfileStat *stats;                         // Loop phases followed by xdrv and xsns function slots
+  uint32_t start;                             // Uptime when statistics were reset
+  uint16_t slots;                             // Number of allocated slots
+  uint8_t xdrv;                               // Number of xdrv drivers
+} Profiler;
+
+/*********************************************************************************************/
+
+// Always take the start time so a scope still running when the profiler gets enabled records a valid sample
+uint32_t ProfileStart(void)
+{
+  return micros();
+}
+
+void ProfileAdd(uint32_t slot, uint32_t start)
+{
+  if (!Profiler.stats || (slot >= Profiler.slots)) { return; }
+
+  uint32_t elapsed = micros() - start;
+  ProfileStat *stat = &Profiler.stats[slot];
+  stat->time += elapsed;
+  stat->calls++;
+  if (elapsed > stat->max) { stat->max = elapsed; }
+}
+
+void ProfilePhase(uint32_t phase, uint32_t start)
+{
+  ProfileAdd(phase, start);
+}
+
+uint32_t ProfileFunctionIndex(uint32_t function)
+{
+  for (uint32_t i = 0; i < sizeof(kProfileFunction); i++) {
+    if (pgm_read_byte(kProfileFunction + i) == function) { return i; }
+  }
+  return PROFILE_FUNCTIONS -1;
+}
+
+void ProfileXdrv(uint32_t index, uint32_t function, uint32_t start)
+{
+  if (!Profiler.stats) { return; }
+  ProfileAdd(PROFILE_PHASES + (index * PROFILE_FUNCTIONS) + ProfileFunctionIndex(function), start);
+}
+
+void ProfileXsns(uint32_t index, uint32_t function, uint32_t start)
+{
+  if (!Profiler.stats) { return; }
+  ProfileAdd(PROFILE_PHASES + ((Profiler.xdrv + index) * PROFILE_FUNCTIONS) + ProfileFunctionIndex(function), start);
+}
+
+void ProfileReset(void)
+{
+  if (Profiler.stats) {
+    memset(Profiler.stats, 0, Profiler.slots * sizeof(ProfileStat));
+  }
+  Profiler.start = TasmotaGlobal.uptime;
+}
+
+void ProfileEnable(bool enable)
+{
+  if (enable && !Profiler.stats) {
+    Profiler.xdrv = XdrvPresent();
+    uint32_t slots = PROFILE_PHASES + ((Profiler.xdrv + XsnsPresent()) * PROFILE_FUNCTIONS);
+    Profiler.stats = (ProfileStat*)calloc(slots, sizeof(ProfileStat));
+    if (Profiler.stats) {
+      Profiler.slots = slots;
+      ProfileReset();
+    }
+  }
+  else if (!enable && Profiler.stats) {
+    free(Profiler.stats);
+    Profiler.stats = nullptr;
+    Profiler.slots = 0;
+  }
+}
+
+/*********************************************************************************************/
+
+// Driver name like "Xdrv01" or "Xsns05" for a driver slot, returns function index in the slot
+uint32_t ProfileSlotName(uint32_t slot, char* name, uint32_t size)
+{
+  uint32_t driver = (slot - PROFILE_PHASES) / PROFILE_FUNCTIONS;
+  if (driver < Profiler.xdrv) {
+    snprintf_P(name, size, PSTR("Xdrv%02d"), XdrvId(driver));
+  } else {
+    snprintf_P(name, size, PSTR("Xsns%02d"), XsnsId(driver - Profiler.xdrv));
+  }
+  return (slot - PROFILE_PHASES) % PROFILE_FUNCTIONS;
+}
+
+void ProfileShow(void)
+{
+  Response_P(PSTR("{\"Profile\":{\"Enabled\":%d"), (Profiler.stats != nullptr));
+  if (Profiler.stats) {
+    ResponseAppend_P(PSTR(",\"Seconds\":%d,\"Loop\":{"), TasmotaGlobal.uptime - Profiler.start);
+    char stemp[16];
+    for (uint32_t i = 0; i < PROFILE_PHASES; i++) {
+      ProfileStat *stat = &Profiler.stats[i];
+      ResponseAppend_P(PSTR("%s\"%s\":[%u,%u,%u]"), (i) ? "," : "",
+        GetTextIndexed(stemp, sizeof(stemp), i, kProfilePhases), stat->time, stat->calls, stat->max);
+    }
+    ResponseAppend_P(PSTR("},\"Drivers\":{"));
+
+    // Show the driver functions consuming most time, largest first
+    uint32_t last_time = UINT32_MAX;
+    uint32_t last_slot = 0;
+    for (uint32_t shown = 0; shown < PROFILE_MAX_SHOW; shown++) {
+      uint32_t best_slot = 0;
+      uint32_t best_time = 0;
+      for (uint32_t slot = PROFILE_PHASES; slot < Profiler.slots; slot++) {
+        uint32_t time = Profiler.stats[slot].time;
+        if ((time < last_time) || ((time == last_time) && (slot > last_slot))) {
+          if (time > best_time) {
+            best_time = time;
+            best_slot = slot;
+          }
+        }
+      }
+      if (!best_time) { break; }
+      ProfileStat *stat = &Profiler.stats[best_slot];
+      char name[8];
+      uint32_t function = ProfileSlotName(best_slot, name, sizeof(name));
+      ResponseAppend_P(PSTR("%s\"%s%s\":[%u,%u,%u]"), (shown) ? "," : "",
+        name, GetTextIndexed(stemp, sizeof(stemp), function, kProfileFunctions), stat->time, stat->calls, stat->max);
+      last_time = best_time;
+      last_slot = best_slot;
+    }
+    ResponseJsonEnd();
+  }
+  ResponseJsonEndEnd();
+}
+
+#ifdef USE_WEBSERVER
+const char kProfileMetrics[] PROGMEM = "time_microseconds_total|calls_total|max_microseconds";
+const char kProfileMetricTypes[] PROGMEM = "counter|counter|gauge";
+
+void ProfileShowMetrics(void)
+{
+  if (!Profiler.stats) { return; }
+
+  char metric[24];
+  char type[8];
+  char name[8];
+  char stemp[16];
+  for (uint32_t m = 0; m < 3; m++) {
+    GetTextIndexed(metric, sizeof(metric), m, kProfileMetrics);
+    WSContentSend_P(PSTR("# TYPE tasmota_profile_%s %s\n"), metric, GetTextIndexed(type, sizeof(type), m, kProfileMetricTypes));
+    for (uint32_t slot = 0; slot < Profiler.slots; slot++) {
+      ProfileStat *stat = &Profiler.stats[slot];
+      if (slot < PROFILE_PHASES) {
+        strcpy_P(name, PSTR("Loop"));
+        GetTextIndexed(stemp, sizeof(stemp), slot, kProfilePhases);
+      } else {
+        if (!stat->calls) { continue; }
+        GetTextIndexed(stemp, sizeof(stemp), ProfileSlotName(slot, name, sizeof(name)), kProfileFunctions);
+      }
+      uint32_t value = (0 == m) ? stat->time : (1 == m) ? stat->calls : stat->max;
+      WSContentSend_P(PSTR("tasmota_profile_%s{driver=\"%s\",function=\"%s\"} %u\n"), metric, name, stemp, value);
+    }
+  }
+}
+#endif  // USE_WEBSERVER
+
+/*********************************************************************************************\
+ * Commands
+\*********************************************************************************************/
+
+void CmndProfile(void)
+{
+  if (XdrvMailbox.data_len > 0) {
+    switch (XdrvMailbox.payload) {
+      case 0:
+      case 1:
+        ProfileEnable(XdrvMailbox.payload);
+        break;
+      case 2:
+        ProfileReset();
+        break;
+    }
+  }
+  ProfileShow();
+}
+
+#endif  // USE_PROFILER
@@ -133,7 +133,7 @@ const uint8_t OTA_ATTEMPTS = 5;             // Number of times to try fetching t
 
 const uint16_t INPUT_BUFFER_SIZE = 520;     // Max number of characters in serial command buffer
 const uint16_t FLOATSZ = 16;                // Max number of characters in float result from dtostrfd (max 32)
-const uint16_t CMDSZ = 24;                  // Max number of characters in command
+const uint16_t CMDSZ = 25;                  // Max number of characters in command
 const uint16_t TOPSZ = 151;                 // Max number of characters in topic string
 const uint16_t LOGSZ = 700;                 // Max number of characters in log
 const uint16_t MIN_MESSZ = 1040;            // Min number of characters in MQTT message (1200 - TOPSZ - 9 header bytes)
@@ -255,6 +255,7 @@ enum SettingsParamIndex { P_HOLD_TIME, P_MAX_POWER_RETRY, P_BACKLOG_DELAY, P_MDN
                           P_CSE7766_INVALID_POWER, P_HOLD_IGNORE, P_ARP_GRATUITOUS, P_OVER_TEMP,  // SetOption39 .. SetOption42
                           P_ex_DIMMER_MAX, P_ex_TUYA_VOLTAGE_ID, P_ex_TUYA_CURRENT_ID, P_ex_TUYA_POWER_ID,  // SetOption43 .. SetOption46
                           P_ex_ENERGY_TARIFF1, P_ex_ENERGY_TARIFF2,  // SetOption47 .. SetOption48
+                          P_MQTT_QUEUE_BUDGET,  // SetOption49
                           P_MAX_PARAM8 };  // Max is PARAM8_SIZE (18) - SetOption32 until SetOption49
 
 enum DomoticzSensors {DZ_TEMP, DZ_TEMP_HUM, DZ_TEMP_HUM_BARO, DZ_POWER_ENERGY, DZ_ILLUMINANCE, DZ_COUNT, DZ_VOLTAGE, DZ_CURRENT,
@@ -278,6 +279,15 @@ enum XsnsFunctions {FUNC_SETTINGS_OVERRIDE, FUNC_PIN_STATE, FUNC_MODULE_INIT, FU
                     FUNC_WEB_ADD_BUTTON, FUNC_WEB_ADD_MAIN_BUTTON, FUNC_WEB_ADD_HANDLER, FUNC_SET_CHANNELS, FUNC_SET_SCHEME, FUNC_HOTPLUG_SCAN,
                     FUNC_DEVICE_GROUP_ITEM };
 
+// Periodic functions FUNC_LOOP up to FUNC_EVERY_SECOND are only dispatched to drivers having them in XDRV_xx_FUNCS / XSNS_xx_FUNCS
+const uint8_t FUNC_DISPATCH_FIRST = FUNC_LOOP;
+const uint8_t FUNC_DISPATCH_LAST = FUNC_EVERY_SECOND;
+const uint8_t FUNC_DISPATCH_MAX = FUNC_DISPATCH_LAST - FUNC_DISPATCH_FIRST +1;
+const uint8_t FUNC_DISPATCH_ALL = (1 << FUNC_DISPATCH_MAX) -1;
+#define FUNC_MASK(f)  (1 << ((f) - FUNC_DISPATCH_FIRST))
+
+enum ProfilePhases { PROFILE_BUTTON, PROFILE_SWITCH, PROFILE_BACKLOG, PROFILE_SERIAL, PROFILE_PHASES };
+
 enum AddressConfigSteps { ADDR_IDLE, ADDR_RECEIVE, ADDR_SEND };
 
 enum SettingsTextIndex { SET_OTAURL,
@@ -110,6 +110,8 @@ struct {
   uint16_t syslog_timer;                    // Timer to re-enable syslog_level
   uint16_t tele_period;                     // Tele period timer
   int16_t save_data_counter;                // Counter and flag for config save to Flash
+  uint16_t log_buffer_head;                 // Offset in log buffer for next log line
+  uint16_t log_buffer_used;                 // Number of log buffer bytes in use
   RulesBitfield rules_flag;                 // Rule state flags (16 bits)
 
   bool serial_local;                        // Handle serial locally
@@ -155,6 +157,8 @@ struct {
   uint8_t module_type;                      // Current copy of Settings.module or user template type
   uint8_t last_source;                      // Last command source
   uint8_t shutters_present;                 // Number of actual define shutters
+  uint8_t log_index_first;                  // Log index slot of oldest log line
+  uint8_t log_index_count;                  // Number of log lines in log buffer
 //  uint8_t prepped_loglevel;                 // Delayed log level message
 
 #ifndef SUPPORT_IF_STATEMENT
@@ -171,6 +175,7 @@ struct {
   char mqtt_topic[TOPSZ];                   // Composed MQTT topic
   char mqtt_data[MESSZ];                    // MQTT publish buffer and web page ajax buffer
   char log_buffer[LOG_BUFFER_SIZE];         // Web log buffer
+  LogIndex log_index[LOG_INDEX_SIZE];       // Web log buffer line index
 } TasmotaGlobal;
 
 #ifdef SUPPORT_IF_STATEMENT
@@ -383,12 +388,27 @@ void loop(void) {
 
   OsWatchLoop();
 
+#ifdef USE_PROFILER
+  uint32_t profile_start = ProfileStart();
   ButtonLoop();
+  ProfilePhase(PROFILE_BUTTON, profile_start);
+  profile_start = ProfileStart();
   SwitchLoop();
+  ProfilePhase(PROFILE_SWITCH, profile_start);
+#else
+  ButtonLoop();
+  SwitchLoop();
+#endif  // USE_PROFILER
 #ifdef USE_DEVICE_GROUPS
   DeviceGroupsLoop();
 #endif  // USE_DEVICE_GROUPS
+#ifdef USE_PROFILER
+  profile_start = ProfileStart();
   BacklogLoop();
+  ProfilePhase(PROFILE_BACKLOG, profile_start);
+#else
+  BacklogLoop();
+#endif  // USE_PROFILER
 
   static uint32_t state_50msecond = 0;               // State 50msecond timer
   if (TimeReached(state_50msecond)) {
@@ -424,7 +444,13 @@ void loop(void) {
     XsnsCall(FUNC_EVERY_SECOND);
   }
 
+#ifdef USE_PROFILER
+  profile_start = ProfileStart();
+  if (!TasmotaGlobal.serial_local) { SerialInput(); }
+  ProfilePhase(PROFILE_SERIAL, profile_start);
+#else
   if (!TasmotaGlobal.serial_local) { SerialInput(); }
+#endif  // USE_PROFILER
 
 #ifdef USE_ARDUINO_OTA
   ArduinoOtaLoop();
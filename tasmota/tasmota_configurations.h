@@ -749,6 +749,11 @@
 #undef USE_TIMERS_WEB                            // Disable support for timer webpage
 #undef USE_SUNRISE                               // Disable support for Sunrise and sunset tools
 #undef USE_PING                                  // Disable Ping command (+2k code)
+#undef USE_PROFILER                              // Disable Profile command (+2k code)
+#undef USE_COMMAND_INDEX                         // Disable hash index on command tables
+#undef USE_MQTT_QUEUE                            // Disable MQTT publish queue
+#undef USE_WEBSOCKET                             // Disable WebSocket push for web console and main page
+#undef USE_SETTINGS_JOURNAL                      // Disable settings flash journal
 #undef USE_UNISHOX_COMPRESSION                   // Disable support for string compression in Rules or Scripts
 #undef USE_RULES                                 // Disable support for rules
 #undef USE_SCRIPT                                // Disable support for script
@@ -819,6 +824,7 @@
 #undef USE_AS608                                 // Disable support for AS608 optical and R503 capacitive fingerprint sensor (+3k4 code)
 
 #undef USE_ENERGY_SENSOR                         // Disable energy sensors
+#undef USE_ENERGY_HISTORY                        // Disable energy history
 #undef USE_PZEM004T                              // Disable PZEM004T energy sensor
 #undef USE_PZEM_AC                               // Disable PZEM014,016 Energy monitor
 #undef USE_PZEM_DC                               // Disable PZEM003,017 Energy monitor
@@ -26,12 +26,17 @@
 \*********************************************************************************************/
 
 #define XDRV_01                               1
+#ifdef USE_WEBSOCKET
+#define XDRV_01_FUNCS                         (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_50_MSECOND))
+#else
+#define XDRV_01_FUNCS                         (FUNC_MASK(FUNC_LOOP))
+#endif  // USE_WEBSOCKET
 
 #ifndef WIFI_SOFT_AP_CHANNEL
 #define WIFI_SOFT_AP_CHANNEL                  1          // Soft Access Point Channel number between 1 and 11 as used by WifiManager web GUI
 #endif
 
-const uint16_t CHUNKED_BUFFER_SIZE = (MESSZ / 2) - 100;  // Chunk buffer size (should be smaller than half mqtt_data size = MESSZ)
+const uint16_t CHUNKED_BUFFER_SIZE = MESSZ;               // Chunk buffer size (holds any content fitting mqtt_data size = MESSZ)
 
 const uint16_t HTTP_REFRESH_TIME = 2345;                 // milliseconds
 const uint16_t HTTP_RESTART_RECONNECT_TIME = 10000;      // milliseconds - Allow time for restart and wifi reconnect
@@ -815,7 +820,8 @@ DNSServer *DnsServer;
 ESP8266WebServer *Webserver;
 
 struct WEB {
-  String chunk_buffer = "";                         // Could be max 2 * CHUNKED_BUFFER_SIZE
+  char *chunk = nullptr;                            // Chunk buffer of CHUNKED_BUFFER_SIZE allocated once with the web server
+  uint16_t chunk_len = 0;                           // Content length in chunk buffer
   uint16_t upload_progress_dot_count;
   uint16_t upload_error = 0;
   uint8_t state = HTTP_OFF;
@@ -824,6 +830,9 @@ struct WEB {
   uint8_t config_xor_on = 0;
   uint8_t config_xor_on_set = CONFIG_FILE_XOR;
   bool reset_web_log_flag = false;                  // Reset web console log
+#ifdef USE_WEBSOCKET
+  String *capture = nullptr;                        // Collect content instead of sending it
+#endif  // USE_WEBSOCKET
 } Web;
 
 // Helper function to avoid code duplication (saves 4k Flash)
@@ -898,6 +907,7 @@ void StartWebserver(int type, IPAddress ipweb)
   if (!Web.state) {
     if (!Webserver) {
       Webserver = new ESP8266WebServer((HTTP_MANAGER == type || HTTP_MANAGER_RESET_ONLY == type) ? 80 : WEB_PORT);
+      Web.chunk = (char*)malloc(CHUNKED_BUFFER_SIZE);  // Fall back to sending each content on its own if not available
       // call `Webserver->on()` on each entry
       for (uint32_t i=0; i<ARRAY_SIZE(WebServerDispatch); i++) {
         const WebServerDispatch_t & line = WebServerDispatch[i];
@@ -920,6 +930,9 @@ void StartWebserver(int type, IPAddress ipweb)
     Web.reset_web_log_flag = false;
 
     Webserver->begin(); // Web server start
+#ifdef USE_WEBSOCKET
+    WebSocketBegin();
+#endif  // USE_WEBSOCKET
   }
   if (Web.state != type) {
 #if LWIP_IPV6
@@ -944,6 +957,9 @@ void StopWebserver(void)
 {
   if (Web.state) {
     Webserver->close();
+#ifdef USE_WEBSOCKET
+    WebSocketStop();
+#endif  // USE_WEBSOCKET
     Web.state = HTTP_OFF;
     AddLog_P(LOG_LEVEL_INFO, PSTR(D_LOG_HTTP D_WEBSERVER_STOPPED));
   }
@@ -1044,48 +1060,93 @@ void WSContentBegin(int code, int ctype)
   WSHeaderSend();
   Webserver->setContentLength(CONTENT_LENGTH_UNKNOWN);
   WSSend(code, ctype, "");                        // Signal start of chunked content
-  Web.chunk_buffer = "";
+  Web.chunk_len = 0;
 }
 
 void _WSContentSend(const String& content)        // Low level sendContent for all core versions
 {
   size_t len = content.length();
+#ifdef USE_WEBSOCKET
+  if (Web.capture) {
+    *Web.capture += content;
+    return;
+  }
+#endif  // USE_WEBSOCKET
   Webserver->sendContent(content);
 
 #ifdef USE_DEBUG_DRIVER
   ShowFreeMem(PSTR("WSContentSend"));
 #endif
-  DEBUG_CORE_LOG(PSTR("WEB: Chunk size %d/%d"), len, sizeof(TasmotaGlobal.mqtt_data));
+  DEBUG_CORE_LOG(PSTR("WEB: Chunk size %d/%d"), len, CHUNKED_BUFFER_SIZE);
+}
+
+void _WSContentSend(const char* content, size_t len)  // Low level sendContent of zero terminated buffer without String copy
+{
+#ifdef USE_WEBSOCKET
+  if (Web.capture) {
+    *Web.capture += content;
+    return;
+  }
+#endif  // USE_WEBSOCKET
+  Webserver->sendContent_P(content, len);
+
+#ifdef USE_DEBUG_DRIVER
+  ShowFreeMem(PSTR("WSContentSend"));
+#endif
+  DEBUG_CORE_LOG(PSTR("WEB: Chunk size %d/%d"), len, CHUNKED_BUFFER_SIZE);
 }
 
 void WSContentFlush(void)
 {
-  if (Web.chunk_buffer.length() > 0) {
-    _WSContentSend(Web.chunk_buffer);                  // Flush chunk buffer
-    Web.chunk_buffer = "";
+  if (Web.chunk_len > 0) {
+    Web.chunk[Web.chunk_len] = '\0';                 // Remove any content not fitting the buffer
+    _WSContentSend(Web.chunk, Web.chunk_len);        // Flush chunk buffer
+    Web.chunk_len = 0;
   }
 }
 
-void _WSContentSendBuffer(void)
+void _WSContentSendFormat(bool decimal, const char* formatP, va_list arg)
 {
-  int len = strlen(TasmotaGlobal.mqtt_data);
+  // Format directly behind buffered content and send full chunks only
+  char* content = TasmotaGlobal.mqtt_data;         // No chunk buffer so send each content on its own
+  size_t size = sizeof(TasmotaGlobal.mqtt_data);
+  if (Web.chunk) {
+    content = Web.chunk + Web.chunk_len;
+    size = CHUNKED_BUFFER_SIZE - Web.chunk_len;
+  } else {
+    ResponseInvalidate();                          // Content is formatted directly into mqtt_data
+  }
 
-  if (0 == len) {                                  // No content
-    return;
+  va_list arg_copy;
+  va_copy(arg_copy, arg);
+  size_t len = vsnprintf_P(content, size, formatP, arg_copy);
+  va_end(arg_copy);
+  if ((len >= size) && (Web.chunk_len > 0)) {      // Content does not fit behind buffered content
+    WSContentFlush();
+    content = Web.chunk;
+    size = CHUNKED_BUFFER_SIZE;
+    len = vsnprintf_P(content, size, formatP, arg);
   }
-  else if (len == sizeof(TasmotaGlobal.mqtt_data)) {
+  if (len >= size) {
     AddLog_P(LOG_LEVEL_INFO, PSTR("HTP: Content too large"));
-  }
-  else if (len < CHUNKED_BUFFER_SIZE) {            // Append chunk buffer with small content
-    Web.chunk_buffer += TasmotaGlobal.mqtt_data;
-    len = Web.chunk_buffer.length();
+    len = size -1;
   }
 
-  if (len >= CHUNKED_BUFFER_SIZE) {                // Either content or chunk buffer is oversize
-    WSContentFlush();                              // Send chunk buffer before possible content oversize
+  if (decimal && (D_DECIMAL_SEPARATOR[0] != '.')) {
+    for (uint32_t i = 0; i < len; i++) {
+      if ('.' == content[i]) {
+        content[i] = D_DECIMAL_SEPARATOR[0];
+      }
+    }
   }
-  if (strlen(TasmotaGlobal.mqtt_data) >= CHUNKED_BUFFER_SIZE) {  // Content is oversize
-    _WSContentSend(TasmotaGlobal.mqtt_data);                     // Send content
+
+  if (Web.chunk) {
+    Web.chunk_len += len;
+    if (Web.chunk_len >= CHUNKED_BUFFER_SIZE -1) {  // Chunk buffer is full
+      WSContentFlush();
+    }
+  } else if (len > 0) {
+    _WSContentSend(content, len);
   }
 }
 
@@ -1094,17 +1155,8 @@ void WSContentSend_P(const char* formatP, ...)     // Content send snprintf_P ch
   // This uses char strings. Be aware of sending %% if % is needed
   va_list arg;
   va_start(arg, formatP);
-  int len = vsnprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), formatP, arg);
+  _WSContentSendFormat(false, formatP, arg);
   va_end(arg);
-
-#ifdef DEBUG_TASMOTA_CORE
-  if (len > (sizeof(TasmotaGlobal.mqtt_data) -1)) {
-    TasmotaGlobal.mqtt_data[33] = '\0';
-    DEBUG_CORE_LOG(PSTR("ERROR: WSContentSend_P size %d > mqtt_data size %d. Start of data [%s...]"), len, sizeof(TasmotaGlobal.mqtt_data), TasmotaGlobal.mqtt_data);
-  }
-#endif
-
-  _WSContentSendBuffer();
 }
 
 void WSContentSend_PD(const char* formatP, ...)    // Content send snprintf_P char data checked for decimal separator
@@ -1112,25 +1164,8 @@ void WSContentSend_PD(const char* formatP, ...)    // Content send snprintf_P ch
   // This uses char strings. Be aware of sending %% if % is needed
   va_list arg;
   va_start(arg, formatP);
-  int len = vsnprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), formatP, arg);
+  _WSContentSendFormat(true, formatP, arg);
   va_end(arg);
-
-#ifdef DEBUG_TASMOTA_CORE
-  if (len > (sizeof(TasmotaGlobal.mqtt_data) -1)) {
-    TasmotaGlobal.mqtt_data[33] = '\0';
-    DEBUG_CORE_LOG(PSTR("ERROR: WSContentSend_PD size %d > mqtt_data size %d. Start of data [%s...]"), len, sizeof(TasmotaGlobal.mqtt_data), TasmotaGlobal.mqtt_data);
-  }
-#endif
-
-  if (D_DECIMAL_SEPARATOR[0] != '.') {
-    for (uint32_t i = 0; i < len; i++) {
-      if ('.' == TasmotaGlobal.mqtt_data[i]) {
-        TasmotaGlobal.mqtt_data[i] = D_DECIMAL_SEPARATOR[0];
-      }
-    }
-  }
-
-  _WSContentSendBuffer();
 }
 
 void WSContentStart_P(const char* title, bool auth)
@@ -1176,17 +1211,8 @@ void WSContentSendStyle_P(const char* formatP, ...)
     // This uses char strings. Be aware of sending %% if % is needed
     va_list arg;
     va_start(arg, formatP);
-    int len = vsnprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), formatP, arg);
+    _WSContentSendFormat(false, formatP, arg);
     va_end(arg);
-
-#ifdef DEBUG_TASMOTA_CORE
-  if (len > (sizeof(TasmotaGlobal.mqtt_data) -1)) {
-    TasmotaGlobal.mqtt_data[33] = '\0';
-    DEBUG_CORE_LOG(PSTR("ERROR: WSContentSendStyle_P size %d > mqtt_data size %d. Start of data [%s...]"), len, sizeof(TasmotaGlobal.mqtt_data), TasmotaGlobal.mqtt_data);
-  }
-#endif
-
-    _WSContentSendBuffer();
   }
   WSContentSend_P(HTTP_HEAD_STYLE3, WebColor(COL_TEXT),
 #ifdef FIRMWARE_MINIMAL
@@ -1370,6 +1396,9 @@ void HandleRoot(void)
   WSContentSend_P(HTTP_SCRIPT_ROOT, Settings.web_refresh);
 #endif
   WSContentSend_P(HTTP_SCRIPT_ROOT_PART2);
+#ifdef USE_WEBSOCKET
+  WebSocketScript(false);
+#endif  // USE_WEBSOCKET
 
   WSContentSendStyle();
 
@@ -1674,6 +1703,14 @@ bool HandleRootStatusRefresh(void)
   }
 #endif // USE_ZIGBEE
   WSContentBegin(200, CT_HTML);
+  WebRootStatusContent();
+  WSContentEnd();
+
+  return true;
+}
+
+void WebRootStatusContent(void)
+{
   WSContentSend_P(PSTR("{t}"));
   XsnsCall(FUNC_WEB_SENSOR);
   XdrvCall(FUNC_WEB_SENSOR);
@@ -1685,6 +1722,7 @@ bool HandleRootStatusRefresh(void)
     uint32_t fsize = (TasmotaGlobal.devices_present < 5) ? 70 - (TasmotaGlobal.devices_present * 8) : 32;
 #ifdef USE_SONOFF_IFAN
     if (IsModuleIfan()) {
+      char svalue[8];
       WSContentSend_P(HTTP_DEVICE_STATE, 36, (bitRead(TasmotaGlobal.power, 0)) ? "bold" : "normal", 54, GetStateText(bitRead(TasmotaGlobal.power, 0)));
       uint32_t fanspeed = GetFanspeed();
       snprintf_P(svalue, sizeof(svalue), PSTR("%d"), fanspeed);
@@ -1692,6 +1730,7 @@ bool HandleRootStatusRefresh(void)
     } else {
 #endif  // USE_SONOFF_IFAN
       for (uint32_t idx = 1; idx <= TasmotaGlobal.devices_present; idx++) {
+        char svalue[8];
         snprintf_P(svalue, sizeof(svalue), PSTR("%d"), bitRead(TasmotaGlobal.power, idx -1));
         WSContentSend_P(HTTP_DEVICE_STATE, 100 / TasmotaGlobal.devices_present, (bitRead(TasmotaGlobal.power, idx -1)) ? "bold" : "normal", fsize, (TasmotaGlobal.devices_present < 5) ? GetStateText(bitRead(TasmotaGlobal.power, idx -1)) : svalue);
       }
@@ -1709,9 +1748,6 @@ bool HandleRootStatusRefresh(void)
     }
   }
 #endif  // USE_TUYA_MCU
-  WSContentEnd();
-
-  return true;
 }
 
 #ifdef USE_SHUTTER
@@ -3062,6 +3098,9 @@ void HandleConsole(void)
 
   WSContentStart_P(PSTR(D_CONSOLE));
   WSContentSend_P(HTTP_SCRIPT_CONSOL, Settings.web_refresh);
+#ifdef USE_WEBSOCKET
+  WebSocketScript(true);
+#endif  // USE_WEBSOCKET
   WSContentSendStyle();
   WSContentSend_P(HTTP_FORM_CMND);
   WSContentSpaceButton(BUTTON_MAIN);
@@ -3228,6 +3267,7 @@ int WebSend(char *buffer)
           const char* read = http.getString().c_str();  // File found at server - may need lot of ram or trigger out of memory!
           uint32_t j = 0;
           char text = '.';
+          ResponseClear();
           while (text != '\0') {
             text = *read++;
             if (text > 31) {                  // Remove control characters like linefeed
@@ -3236,6 +3276,7 @@ int WebSend(char *buffer)
             }
           }
           TasmotaGlobal.mqtt_data[j] = '\0';
+          ResponseInvalidate();
           MqttPublishPrefixTopic_P(RESULT_OR_STAT, PSTR(D_CMND_WEBSEND));
 #ifdef USE_SCRIPT
 extern uint8_t tasm_cmd_activ;
@@ -3461,6 +3502,11 @@ bool Xdrv01(uint8_t function)
       if (Settings.flag2.emulation) { PollUdp(); }
 #endif  // USE_EMULATION
       break;
+#ifdef USE_WEBSOCKET
+    case FUNC_EVERY_50_MSECOND:
+      WebSocketLoop();
+      break;
+#endif  // USE_WEBSOCKET
     case FUNC_COMMAND:
       result = DecodeCommand(kWebCommands, WebCommand);
       break;
@@ -0,0 +1,756 @@
+/*
+  xdrv_01_websocket.ino - WebSocket push channel for web console and main page
+
+  Copyright (C) 2020  Theo Arends
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef USE_WEBSERVER
+#ifdef USE_WEBSOCKET
+/*********************************************************************************************\
+ * WebSocket push channel (RFC 6455)
+ *
+ * The web console receives new log lines as soon as they are logged and the main page receives
+ * only the sensor rows that changed since the previous update. The main page content is rendered
+ * once per refresh interval for all connected pages and not at all when no page is connected.
+ *
+ * Pages connect to ws://<host>:WEBSOCKET_PORT/<token> where the token is a random number issued
+ * for each served page. Pages are only served after the web admin credentials are checked so the
+ * token is bound to the address of that client, can be used once and expires after
+ * WEBSOCKET_TOKEN_TIME. The handshake must come from a page of the same host (Origin matches Host)
+ * and credentials sent along must match the web password. Pages fall back to polling when no
+ * WebSocket can be opened.
+ *
+ * Messages are sent from a per client buffer as far as the TCP send buffer allows so a stalled
+ * browser never blocks the main loop. New pushes to that client are skipped while a message is
+ * pending and the client is closed when a message can not be sent within WEBSOCKET_SEND_TIMEOUT.
+ * Fragmented frames are not supported and close the connection.
+ *
+ * Main page messages: F<content> full content, P<row>\x01<content>[\x02<row>\x01<content>]
+ * changed rows where rows are the content parts separated by {e}.
+\*********************************************************************************************/
+
+#ifdef ESP8266
+#include <Hash.h>
+#endif  // ESP8266
+#ifdef ESP32
+#include "mbedtls/sha1.h"
+#include <lwip/sockets.h>
+#endif  // ESP32
+#include <base64.h>
+
+#ifndef WEBSOCKET_PORT
+#define WEBSOCKET_PORT         81                    // WebSocket server port
+#endif
+#ifndef WEBSOCKET_CLIENTS
+#define WEBSOCKET_CLIENTS      3                     // Max number of connected pages
+#endif
+#define WEBSOCKET_ROWS         32                    // Max number of main page rows tracked for changes
+#define WEBSOCKET_LOG_CHUNK    1000                  // Max log text size per console message
+#define WEBSOCKET_TIMEOUT      2000                  // Max mSec to receive a handshake or a frame
+#define WEBSOCKET_SEND_TIMEOUT 5000                  // Max mSec to send a message before the client is closed
+#define WEBSOCKET_TOKENS       4                     // Max number of issued tokens not yet used
+#define WEBSOCKET_TOKEN_TIME   10000                 // mSec a page has to open its WebSocket
+#define WEBSOCKET_HEADERS      32                    // Max number of handshake header lines
+#define WEBSOCKET_HEADER_SIZE  2048                  // Max handshake size
+#define WEBSOCKET_LINE_SIZE    80                    // Stored start of a handshake line, longer Host, Origin or Authorization lines are rejected
+#define WEBSOCKET_KEY_SIZE     25                    // Sec-WebSocket-Key, base64 of 16 bytes
+#define WEBSOCKET_HOST_SIZE    64                    // Host or Origin header value
+#define WEBSOCKET_REQUEST_LEN  14                    // "GET /<token> "
+#define WEBSOCKET_FRAME_SIZE   INPUT_BUFFER_SIZE     // Max received payload, same as a serial command
+
+enum WebSocketModes { WEBSOCKET_FREE, WEBSOCKET_ROOT, WEBSOCKET_CONSOLE, WEBSOCKET_HANDSHAKE };
+
+const char kWebSocketGuid[] PROGMEM = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+const char HTTP_SCRIPT_WEBSOCKET_ROOT[] PROGMEM =
+  "var ws,lo,sg=[];"
+  "wl(function(){"
+    "if(!window.WebSocket){return;}"
+    "ws=new WebSocket('ws://'+location.hostname+':%d/%08X');"
+    "ws.onopen=function(){"
+      "lo=la;"
+      "la=function(p){if(p){lo(p);}};"                     // Keep button actions but stop polling
+    "};"
+    "ws.onmessage=function(e){"
+      "var d=e.data;"
+      "if(d.charAt(0)=='F'){"
+        "sg=d.substr(1).split('{e}');"
+      "}else{"
+        "d.substr(1).split('\\x02').forEach(function(r){"
+          "var i=r.indexOf('\\x01');"
+          "sg[+r.substr(0,i)]=r.substr(i+1);"
+        "});"
+      "}"
+      "eb('l1').innerHTML=sg.join('{e}').replace(/{t}/g,\"<table style='width:100%%'>\")"
+        ".replace(/{s}/g,\"<tr><th>\")"
+        ".replace(/{m}/g,\"</th><td style='width:20px;white-space:nowrap'>\")"
+        ".replace(/{e}/g,\"</td></tr>\")"
+        ".replace(/{c}/g,\"%%'><div style='text-align:center;font-weight:\");"
+    "};"
+    "ws.onclose=function(){"
+      "if(lo){la=lo;lo=0;la();}"                           // Fall back to polling
+    "};"
+  "});";
+
+const char HTTP_SCRIPT_WEBSOCKET_CONSOL[] PROGMEM =
+  "var ws,lo;"
+  "wl(function(){"
+    "if(!window.WebSocket){return;}"
+    "ws=new WebSocket('ws://'+location.hostname+':%d/%08X');"
+    "ws.onopen=function(){"
+      "clearTimeout(lt);"
+      "if(x!=null){x.abort();}"
+      "eb('t1').value='';"                                 // Full log follows
+      "lo=l;"
+      "l=function(p){"
+        "if(p==1){"
+          "var c=eb('c1'),t=eb('t1');"
+          "ws.send(c.value);"
+          "c.value='';"
+          "t.scrollTop=99999;"
+          "sn=t.scrollTop;"
+        "}"
+        "return false;"
+      "};"
+    "};"
+    "ws.onmessage=function(e){"
+      "var t=eb('t1'),b=(t.scrollTop>=sn);"                // User scrolled back so no autoscroll
+      "t.value+=(t.value.length?'\\n':'')+e.data;"
+      "if(b){t.scrollTop=99999;sn=t.scrollTop;}"
+    "};"
+    "ws.onclose=function(){"
+      "if(lo){l=lo;lo=0;l();}"                             // Fall back to polling
+    "};"
+  "});";
+
+struct WEBSOCKET {
+  WiFiServer *server = nullptr;
+  WiFiClient client[WEBSOCKET_CLIENTS];
+  uint32_t row_hash[WEBSOCKET_CLIENTS][WEBSOCKET_ROWS];  // Main page row hashes as known by client
+  uint32_t log_index[WEBSOCKET_CLIENTS];              // Console log position
+  struct {
+    uint32_t token;                                   // 0 is unused
+    uint32_t address;                                 // Client that received the page
+    uint32_t expire;
+    uint8_t mode;
+  } tokens[WEBSOCKET_TOKENS];
+  uint32_t refresh_time = 0;
+  uint32_t deadline[WEBSOCKET_CLIENTS];               // Handshake or frame being received is dropped when reached
+  uint32_t send_deadline[WEBSOCKET_CLIENTS];          // Client is closed when pending message is not sent when reached
+  char *buffer[WEBSOCKET_CLIENTS] = { nullptr };      // Handshake line, key, host and origin, or payload of frame being received
+  char *out[WEBSOCKET_CLIENTS] = { nullptr };         // Message being sent
+  uint16_t out_len[WEBSOCKET_CLIENTS];
+  uint16_t out_sent[WEBSOCKET_CLIENTS];
+  uint16_t received[WEBSOCKET_CLIENTS];               // Handshake bytes, or frame payload bytes received
+  uint16_t frame_len[WEBSOCKET_CLIENTS];              // Payload length of frame being received
+  uint8_t header[WEBSOCKET_CLIENTS][8];               // Frame header with optional 16-bit length and mask
+  uint8_t header_len[WEBSOCKET_CLIENTS];
+  uint8_t line_len[WEBSOCKET_CLIENTS];                // Stored length of handshake line being received
+  uint8_t headers[WEBSOCKET_CLIENTS];                 // Handshake lines received
+  uint8_t request[WEBSOCKET_CLIENTS];                 // Mode requested by handshake token
+  uint8_t rows[WEBSOCKET_CLIENTS];                    // Main page rows known by client, 0 forces full content
+  uint8_t mode[WEBSOCKET_CLIENTS];
+} WebSocket;
+
+/*********************************************************************************************/
+
+void WebSocketBegin(void)
+{
+  if (WebSocket.server) { return; }
+
+  WebSocket.server = new WiFiServer(WEBSOCKET_PORT);
+  WebSocket.server->begin();
+  WebSocket.server->setNoDelay(true);
+}
+
+void WebSocketClose(uint32_t index)
+{
+  if (WebSocket.client[index]) {
+    WebSocket.client[index].stop();
+  }
+  if (WebSocket.buffer[index]) {
+    free(WebSocket.buffer[index]);
+    WebSocket.buffer[index] = nullptr;
+  }
+  if (WebSocket.out[index]) {
+    free(WebSocket.out[index]);
+    WebSocket.out[index] = nullptr;
+  }
+  WebSocket.header_len[index] = 0;
+  WebSocket.mode[index] = WEBSOCKET_FREE;
+}
+
+void WebSocketStop(void)
+{
+  if (!WebSocket.server) { return; }
+
+  for (uint32_t i = 0; i < WEBSOCKET_CLIENTS; i++) {
+    WebSocketClose(i);
+  }
+  memset(WebSocket.tokens, 0, sizeof(WebSocket.tokens));
+  WebSocket.server->stop();
+  delete WebSocket.server;
+  WebSocket.server = nullptr;
+}
+
+// Called while serving a page that passed HttpCheckPriviledgedAccess()
+void WebSocketScript(bool console)
+{
+  if (!WebSocket.server) { return; }
+
+  uint32_t slot = 0;                                  // Replace unused, expired or oldest token
+  for (uint32_t i = 0; i < WEBSOCKET_TOKENS; i++) {
+    if (!WebSocket.tokens[i].token || TimeReached(WebSocket.tokens[i].expire)) {
+      slot = i;
+      break;
+    }
+    if (TimePassedSince(WebSocket.tokens[i].expire) > TimePassedSince(WebSocket.tokens[slot].expire)) {
+      slot = i;
+    }
+  }
+  uint32_t token;
+  do {
+    token = HwRandom();
+  } while (!token);
+  WebSocket.tokens[slot].token = token;
+  WebSocket.tokens[slot].address = (uint32_t)Webserver->client().remoteIP();
+  WebSocket.tokens[slot].expire = millis() + WEBSOCKET_TOKEN_TIME;
+  WebSocket.tokens[slot].mode = (console) ? WEBSOCKET_CONSOLE : WEBSOCKET_ROOT;
+
+  WSContentSend_P((console) ? HTTP_SCRIPT_WEBSOCKET_CONSOL : HTTP_SCRIPT_WEBSOCKET_ROOT, WEBSOCKET_PORT, token);
+}
+
+uint32_t WebSocketHash(const char* data, size_t len)
+{
+  uint32_t hash = 2166136261;                         // FNV-1a
+  while (len--) {
+    hash ^= (uint8_t)*data++;
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+// Browsers drop the connection on invalid UTF-8 in text frames so replace offending bytes
+void WebSocketValidUtf8(char* data, size_t len)
+{
+  size_t i = 0;
+  while (i < len) {
+    uint8_t c = data[i];
+    uint32_t follow = (c < 0x80) ? 0 : (c < 0xC2) ? 4 : (c < 0xE0) ? 1 : (c < 0xF0) ? 2 : (c < 0xF5) ? 3 : 4;
+    bool valid = (follow < 4) && (i + follow < len);
+    for (uint32_t j = 1; valid && (j <= follow); j++) {
+      valid = ((data[i + j] & 0xC0) == 0x80);
+    }
+    if (valid) {
+      i += follow +1;
+    } else {
+      data[i++] = '?';
+    }
+  }
+}
+
+// Send pending message as far as the TCP send buffer allows without blocking
+void WebSocketFlush(uint32_t index)
+{
+  char *out = WebSocket.out[index];
+  if (!out) { return; }
+
+  WiFiClient &client = WebSocket.client[index];
+  uint32_t sent = WebSocket.out_sent[index];
+  size_t remaining = WebSocket.out_len[index] - sent;
+#ifdef ESP8266
+  size_t room = client.availableForWrite();
+  if (room > remaining) { room = remaining; }
+  int written = (room) ? client.write((const uint8_t*)out + sent, room) : 0;
+  if (room && !written) { written = -1; }
+#endif  // ESP8266
+#ifdef ESP32
+  int written = send(client.fd(), out + sent, remaining, MSG_DONTWAIT);
+  if ((written < 0) && ((EAGAIN == errno) || (EWOULDBLOCK == errno))) { written = 0; }
+#endif  // ESP32
+  if (written < 0) {
+    WebSocketClose(index);
+    return;
+  }
+  sent += written;
+  WebSocket.out_sent[index] = sent;
+  if (sent >= WebSocket.out_len[index]) {
+    free(out);
+    WebSocket.out[index] = nullptr;
+  }
+  else if (TimeReached(WebSocket.send_deadline[index])) {
+    WebSocketClose(index);                            // Client stopped reading
+  }
+}
+
+// Queue a message, false if the previous message is still being sent or no memory is available
+bool WebSocketSend(uint32_t index, uint8_t opcode, char prefix, const char* data, size_t len)
+{
+  if (WebSocket.out[index]) { return false; }
+
+  size_t size = len + ((prefix) ? 1 : 0);
+  if (size > 0xFFFF) { size = 0xFFFF; len = size - ((prefix) ? 1 : 0); }
+
+  uint8_t header[5];
+  uint32_t header_len = 2;
+  header[0] = 0x80 | opcode;                          // Final fragment
+  if (size < 126) {
+    header[1] = size;
+  } else {
+    header[1] = 126;                                  // 16-bit extended payload length
+    header[2] = size >> 8;
+    header[3] = size;
+    header_len = 4;
+  }
+  if (prefix) { header[header_len++] = prefix; }
+
+  char *out = (char*)malloc(header_len + len);
+  if (!out) { return false; }
+  memcpy(out, header, header_len);
+  if (len) { memcpy(out + header_len, data, len); }
+  WebSocket.out[index] = out;
+  WebSocket.out_len[index] = header_len + len;
+  WebSocket.out_sent[index] = 0;
+  WebSocket.send_deadline[index] = millis() + WEBSOCKET_SEND_TIMEOUT;
+  WebSocketFlush(index);
+  return true;
+}
+
+void WebSocketAccept(void)
+{
+  WiFiClient client = WebSocket.server->available();
+  if (!client) { return; }
+
+  uint32_t index;
+  for (index = 0; index < WEBSOCKET_CLIENTS; index++) {
+    if (WEBSOCKET_FREE == WebSocket.mode[index]) { break; }
+  }
+  char *buffer = (index < WEBSOCKET_CLIENTS) ? (char*)malloc(WEBSOCKET_LINE_SIZE + WEBSOCKET_KEY_SIZE + 2 * WEBSOCKET_HOST_SIZE) : nullptr;
+  if (!buffer) {
+    client.stop();
+    return;
+  }
+
+  // Handshake is received in the next loops as data arrives
+  buffer[WEBSOCKET_LINE_SIZE] = '\0';                 // No key
+  buffer[WEBSOCKET_LINE_SIZE + WEBSOCKET_KEY_SIZE] = '\0';  // No host
+  buffer[WEBSOCKET_LINE_SIZE + WEBSOCKET_KEY_SIZE + WEBSOCKET_HOST_SIZE] = '\0';  // No origin
+  WebSocket.client[index] = client;
+  WebSocket.buffer[index] = buffer;
+  WebSocket.deadline[index] = millis() + WEBSOCKET_TIMEOUT;
+  WebSocket.received[index] = 0;
+  WebSocket.line_len[index] = 0;
+  WebSocket.headers[index] = 0;
+  WebSocket.request[index] = WEBSOCKET_FREE;
+  WebSocket.mode[index] = WEBSOCKET_HANDSHAKE;
+}
+
+// Mode requested by "GET /<token> " or WEBSOCKET_FREE if the token is unknown, expired or issued to another client
+uint32_t WebSocketRequestMode(const char* line, uint32_t address)
+{
+  char request[WEBSOCKET_REQUEST_LEN +1];
+  for (uint32_t i = 0; i < WEBSOCKET_TOKENS; i++) {
+    if (!WebSocket.tokens[i].token) { continue; }
+    if (TimeReached(WebSocket.tokens[i].expire)) {
+      WebSocket.tokens[i].token = 0;
+      continue;
+    }
+    snprintf_P(request, sizeof(request), PSTR("GET /%08X "), WebSocket.tokens[i].token);
+    if (strncmp(line, request, WEBSOCKET_REQUEST_LEN)) { continue; }
+    WebSocket.tokens[i].token = 0;                    // Used once
+    return (WebSocket.tokens[i].address == address) ? WebSocket.tokens[i].mode : WEBSOCKET_FREE;
+  }
+  return WEBSOCKET_FREE;
+}
+
+// Length of host name in "host[:port]" or "[ipv6][:port]"
+size_t WebSocketHostLen(const char* host)
+{
+  return ('[' == *host) ? strcspn(host, "]") +1 : strcspn(host, ":");
+}
+
+// Origin must be the page of the Host this WebSocket is opened on
+bool WebSocketSameOrigin(const char* host, const char* origin)
+{
+  if (strncasecmp_P(origin, PSTR("http://"), 7)) { return false; }
+  origin += 7;
+  size_t len = WebSocketHostLen(host);
+  return (len && (WebSocketHostLen(origin) == len) && !strncasecmp(host, origin, len));
+}
+
+// Credentials sent with the handshake must be the web admin credentials
+bool WebSocketValidAuthorization(const char* value)
+{
+  if (!strlen(SettingsText(SET_WEBPWD))) { return true; }
+  if (strncasecmp_P(value, PSTR("Basic "), 6)) { return false; }
+  value += 6;
+  while (' ' == *value) { value++; }
+  char credentials[64];
+  snprintf_P(credentials, sizeof(credentials), PSTR(WEB_USERNAME ":%s"), SettingsText(SET_WEBPWD));
+  String expected = base64::encode((const uint8_t*)credentials, strlen(credentials));
+  return !strcmp(value, expected.c_str());
+}
+
+// Store header value without leading and trailing spaces, a truncated line stores no value
+void WebSocketHeaderValue(char* dest, const char* value, size_t size, bool truncated)
+{
+  *dest = '\0';
+  if (truncated) { return; }
+  while (' ' == *value) { value++; }
+  strlcpy(dest, value, size);
+  char *end = dest + strlen(dest);
+  while ((end > dest) && (' ' == *(end -1))) { *--end = '\0'; }
+}
+
+void WebSocketHandshakeDone(uint32_t index)
+{
+  WiFiClient &client = WebSocket.client[index];
+  char *key = WebSocket.buffer[index] + WEBSOCKET_LINE_SIZE;
+  char *host = key + WEBSOCKET_KEY_SIZE;
+  char *origin = host + WEBSOCKET_HOST_SIZE;
+  if (!strlen(key) || !WebSocketSameOrigin(host, origin)) {
+    client.print(F("HTTP/1.1 403 Forbidden\r\nConnection: close\r\n\r\n"));
+    WebSocketClose(index);
+    return;
+  }
+
+  char source[WEBSOCKET_KEY_SIZE + sizeof(kWebSocketGuid)];
+  strlcpy(source, key, sizeof(source));
+  strcat_P(source, kWebSocketGuid);
+  uint8_t hash[20];
+#ifdef ESP8266
+  sha1((uint8_t*)source, strlen(source), hash);
+#endif  // ESP8266
+#ifdef ESP32
+  mbedtls_sha1_ret((const unsigned char*)source, strlen(source), hash);
+#endif  // ESP32
+  String accept = base64::encode(hash, sizeof(hash));
+
+  char response[160];
+  snprintf_P(response, sizeof(response), PSTR("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n"),
+    accept.c_str());
+  client.write((const uint8_t*)response, strlen(response));
+  client.setNoDelay(true);
+
+  free(WebSocket.buffer[index]);
+  WebSocket.buffer[index] = nullptr;
+  uint32_t mode = WebSocket.request[index];
+  WebSocket.mode[index] = mode;
+  WebSocket.header_len[index] = 0;
+  WebSocket.rows[index] = 0;
+  WebSocket.log_index[index] = 0;                     // Dump all
+  if (WEBSOCKET_ROOT == mode) { WebSocket.refresh_time = millis(); }
+
+  AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_HTTP "WebSocket %d %s connected"), index +1, (WEBSOCKET_ROOT == mode) ? D_MAIN_MENU : D_CONSOLE);
+}
+
+// Receive handshake lines as far as available without blocking
+void WebSocketHandshake(uint32_t index)
+{
+  WiFiClient &client = WebSocket.client[index];
+  char *line = WebSocket.buffer[index];
+  uint8_t data[64];
+  int available;
+  while ((available = client.available()) > 0) {
+    int read = client.read(data, ((uint32_t)available < sizeof(data)) ? available : sizeof(data));
+    if (read <= 0) { break; }
+    uint32_t len = read;
+    WebSocket.received[index] += len;
+    if (WebSocket.received[index] > WEBSOCKET_HEADER_SIZE) {
+      WebSocketClose(index);
+      return;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+      char c = data[i];
+      uint32_t line_len = WebSocket.line_len[index];
+      if (c != '\n') {
+        if (('\r' == c) || (line_len >= WEBSOCKET_LINE_SIZE -1)) { continue; }  // Only the start of a line is needed
+        line[line_len++] = c;
+        WebSocket.line_len[index] = line_len;
+        if (!WebSocket.headers[index] && (WEBSOCKET_REQUEST_LEN == line_len)) {
+          line[line_len] = '\0';
+          WebSocket.request[index] = WebSocketRequestMode(line, (uint32_t)client.remoteIP());  // GET /<token> HTTP/1.1
+          if (WEBSOCKET_FREE == WebSocket.request[index]) {
+            WebSocketClose(index);                    // Unknown token
+            return;
+          }
+        }
+        continue;
+      }
+
+      line[line_len] = '\0';
+      bool truncated = (line_len >= WEBSOCKET_LINE_SIZE -1);
+      WebSocket.line_len[index] = 0;
+      if (WEBSOCKET_FREE == WebSocket.request[index]) {
+        WebSocketClose(index);                        // Request line too short for a token
+        return;
+      }
+      if (WebSocket.headers[index] && !line_len) {    // End of headers
+        WebSocketHandshakeDone(index);
+        return;
+      }
+      char *key = WebSocket.buffer[index] + WEBSOCKET_LINE_SIZE;
+      if (!strncasecmp_P(line, PSTR("Sec-WebSocket-Key:"), 18)) {
+        WebSocketHeaderValue(key, line +18, WEBSOCKET_KEY_SIZE, false);
+      }
+      else if (!strncasecmp_P(line, PSTR("Host:"), 5)) {
+        WebSocketHeaderValue(key + WEBSOCKET_KEY_SIZE, line +5, WEBSOCKET_HOST_SIZE, truncated);
+      }
+      else if (!strncasecmp_P(line, PSTR("Origin:"), 7)) {
+        WebSocketHeaderValue(key + WEBSOCKET_KEY_SIZE + WEBSOCKET_HOST_SIZE, line +7, WEBSOCKET_HOST_SIZE, truncated);
+      }
+      else if (!strncasecmp_P(line, PSTR("Authorization:"), 14)) {
+        char *value = line +14;
+        while (' ' == *value) { value++; }
+        if (truncated || !WebSocketValidAuthorization(value)) {
+          client.print(F("HTTP/1.1 401 Unauthorized\r\nConnection: close\r\n\r\n"));
+          WebSocketClose(index);
+          return;
+        }
+      }
+      WebSocket.headers[index]++;
+      if (WebSocket.headers[index] > WEBSOCKET_HEADERS) {
+        WebSocketClose(index);
+        return;
+      }
+    }
+  }
+  if (TimeReached(WebSocket.deadline[index])) {
+    WebSocketClose(index);
+  }
+}
+
+// Receive frame as far as available without blocking, process it when complete
+void WebSocketReceive(uint32_t index)
+{
+  WiFiClient &client = WebSocket.client[index];
+  uint8_t *header = WebSocket.header[index];
+  uint32_t header_size = 6;                           // Two bytes and mask
+  while (!WebSocket.buffer[index]) {
+    if (client.available() <= 0) {
+      if (WebSocket.header_len[index] && TimeReached(WebSocket.deadline[index])) {
+        WebSocketClose(index);
+      }
+      return;
+    }
+    header[WebSocket.header_len[index]++] = client.read();
+    uint32_t header_len = WebSocket.header_len[index];
+    if (header_len < 2) {
+      WebSocket.deadline[index] = millis() + WEBSOCKET_TIMEOUT;
+      continue;
+    }
+    if ((header[0] & 0xF0) != 0x80 || !(header[0] & 0x0F)) {  // Fragments, continuation frames and extensions not supported
+      WebSocketClose(index);
+      return;
+    }
+    uint32_t len = header[1] & 0x7F;
+    if (!(header[1] & 0x80) || (127 == len)) {        // Client frames must be masked, 64-bit length not supported
+      WebSocketClose(index);
+      return;
+    }
+    if (126 == len) { header_size = 8; }              // 16-bit extended payload length
+    if (header_len < header_size) { continue; }
+    if (126 == len) { len = (header[2] << 8) | header[3]; }
+    if (len >= WEBSOCKET_FRAME_SIZE) {
+      WebSocketClose(index);
+      return;
+    }
+    WebSocket.buffer[index] = (char*)malloc(len +1);
+    if (!WebSocket.buffer[index]) {
+      WebSocketClose(index);
+      return;
+    }
+    WebSocket.frame_len[index] = len;
+    WebSocket.received[index] = 0;
+  }
+
+  char *data = WebSocket.buffer[index];
+  uint32_t len = WebSocket.frame_len[index];
+  uint32_t received = WebSocket.received[index];
+  int available = client.available();
+  if ((available > 0) && (received < len)) {
+    int read = client.read((uint8_t*)data + received, ((uint32_t)available < len - received) ? available : len - received);
+    if (read > 0) { received += read; }
+    WebSocket.received[index] = received;
+  }
+  if (received < len) {
+    if (TimeReached(WebSocket.deadline[index])) {
+      WebSocketClose(index);
+    }
+    return;
+  }
+
+  if (126 == (header[1] & 0x7F)) { header_size = 8; }
+  uint8_t *mask = header + header_size -4;
+  for (uint32_t i = 0; i < len; i++) {
+    data[i] ^= mask[i & 3];
+  }
+  data[len] = '\0';
+  uint32_t opcode = header[0] & 0x0F;
+  WebSocket.buffer[index] = nullptr;                  // Ready for next frame
+  WebSocket.header_len[index] = 0;
+
+  switch (opcode) {
+    case 0x1:                                         // Text
+      if ((WEBSOCKET_CONSOLE == WebSocket.mode[index]) && len) {
+        AddLog_P(LOG_LEVEL_INFO, PSTR(D_LOG_COMMAND "%s"), data);
+        ExecuteWebCommand(data, SRC_WEBCONSOLE);
+      }
+      break;
+    case 0x8:                                         // Close
+      WebSocketSend(index, 0x8, 0, nullptr, 0);
+      WebSocketClose(index);
+      break;
+    case 0x9:                                         // Ping
+      WebSocketSend(index, 0xA, 0, data, len);        // Pong
+      break;
+  }
+  free(data);
+}
+
+void WebSocketConsolePush(uint32_t index)
+{
+  if (WebSocket.out[index]) { return; }               // Lines follow when previous message is sent
+
+  uint32_t log_index = WebSocket.log_index[index];
+  String lines = "";
+  char* line;
+  size_t len;
+  while (GetLog(Settings.weblog_level, &WebSocket.log_index[index], &line, &len)) {
+    if (lines.length()) { lines += '\n'; }
+    char stemp[len];
+    strlcpy(stemp, line, len);
+    lines += stemp;
+    if (lines.length() > WEBSOCKET_LOG_CHUNK) { break; }  // Remaining lines follow in next loop
+  }
+  if (lines.length()) {
+    WebSocketValidUtf8((char*)lines.c_str(), lines.length());
+    if (!WebSocketSend(index, 0x1, 0, lines.c_str(), lines.length())) {
+      WebSocket.log_index[index] = log_index;         // Retry in next loop
+    }
+  }
+}
+
+void WebSocketRootPush(void)
+{
+  // Render main page content once into a string for all clients
+  String content = "";
+  Web.chunk_len = 0;                                  // No page is being sent from the main loop
+  Web.capture = &content;
+  WebRootStatusContent();
+  WSContentFlush();
+  Web.capture = nullptr;
+
+  char* text = (char*)content.c_str();
+  size_t text_len = content.length();
+  WebSocketValidUtf8(text, text_len);
+
+  // Split content in rows separated by {e} as done by the page script
+  uint16_t row_start[WEBSOCKET_ROWS +1];
+  uint32_t row_hash[WEBSOCKET_ROWS];
+  uint32_t rows = 0;
+  bool tracked = true;
+  char* row = text;
+  while (true) {
+    if (WEBSOCKET_ROWS == rows) {
+      tracked = false;                                // Too many rows so send full content on any change
+      break;
+    }
+    char* end = strstr_P(row, PSTR("{e}"));
+    size_t row_len = (end) ? end - row : strlen(row);
+    row_start[rows] = row - text;
+    row_hash[rows] = WebSocketHash(row, row_len);
+    rows++;
+    if (!end) { break; }
+    row = end +3;
+  }
+  row_start[rows] = text_len +3;                      // Virtual start of row following last row
+
+  for (uint32_t index = 0; index < WEBSOCKET_CLIENTS; index++) {
+    if (WEBSOCKET_ROOT != WebSocket.mode[index]) { continue; }
+    if (WebSocket.out[index]) { continue; }           // Changes follow in next refresh when previous message is sent
+
+    if (!tracked) {
+      uint32_t hash = WebSocketHash(text, text_len);
+      if ((WebSocket.rows[index] != 0xFF) || (WebSocket.row_hash[index][0] != hash)) {
+        WebSocket.rows[index] = 0xFF;
+        WebSocket.row_hash[index][0] = hash;
+        if (!WebSocketSend(index, 0x1, 'F', text, text_len)) { WebSocket.rows[index] = 0; }
+      }
+      continue;
+    }
+    if (WebSocket.rows[index] != rows) {
+      WebSocket.rows[index] = rows;
+      memcpy(WebSocket.row_hash[index], row_hash, rows * sizeof(uint32_t));
+      if (!WebSocketSend(index, 0x1, 'F', text, text_len)) { WebSocket.rows[index] = 0; }
+      continue;
+    }
+
+    String patch = "";
+    for (uint32_t i = 0; i < rows; i++) {
+      if (WebSocket.row_hash[index][i] == row_hash[i]) { continue; }
+      WebSocket.row_hash[index][i] = row_hash[i];
+      char* row_end = text + row_start[i +1] -3;
+      char saved = *row_end;
+      *row_end = '\0';                                 // Temporary terminate row
+      patch += (patch.length()) ? '\x02' : 'P';
+      patch += i;
+      patch += '\x01';
+      patch += text + row_start[i];
+      *row_end = saved;
+    }
+    if (patch.length() && !WebSocketSend(index, 0x1, 0, patch.c_str(), patch.length())) {
+      WebSocket.rows[index] = 0;                      // Full content in next refresh
+    }
+  }
+}
+
+void WebSocketLoop(void)
+{
+  if (!WebSocket.server) { return; }
+
+  WebSocketAccept();
+
+  bool root = false;
+  for (uint32_t index = 0; index < WEBSOCKET_CLIENTS; index++) {
+    if (WEBSOCKET_FREE == WebSocket.mode[index]) { continue; }
+    if (!WebSocket.client[index].connected()) {
+      WebSocketClose(index);
+      continue;
+    }
+    if (WEBSOCKET_HANDSHAKE == WebSocket.mode[index]) {
+      WebSocketHandshake(index);
+      continue;
+    }
+    WebSocketFlush(index);
+    if (WEBSOCKET_FREE == WebSocket.mode[index]) { continue; }
+    WebSocketReceive(index);
+    if (WEBSOCKET_CONSOLE == WebSocket.mode[index]) {
+      WebSocketConsolePush(index);
+    }
+    else if (WEBSOCKET_ROOT == WebSocket.mode[index]) {
+      root = true;
+    }
+  }
+
+  if (root && TimeReached(WebSocket.refresh_time)) {
+    SetNextTimeInterval(WebSocket.refresh_time, Settings.web_refresh);
+    WebSocketRootPush();
+  }
+}
+
+#endif  // USE_WEBSOCKET
+#endif  // USE_WEBSERVER
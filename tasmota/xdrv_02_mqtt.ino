@@ -18,6 +18,11 @@
 */
 
 #define XDRV_02                    2
+#ifdef USE_MQTT_QUEUE
+#define XDRV_02_FUNCS              (FUNC_MASK(FUNC_LOOP)|FUNC_MASK(FUNC_EVERY_50_MSECOND))
+#else
+#define XDRV_02_FUNCS              (FUNC_MASK(FUNC_EVERY_50_MSECOND))
+#endif
 
 #ifndef MQTT_WIFI_CLIENT_TIMEOUT
 #define MQTT_WIFI_CLIENT_TIMEOUT   200    // Wifi TCP connection timeout (default is 5000 mSec)
@@ -41,7 +46,11 @@ const char kMqttCommands[] PROGMEM = "|"  // No prefix
 #endif
   D_CMND_MQTTHOST "|" D_CMND_MQTTPORT "|" D_CMND_MQTTRETRY "|" D_CMND_STATETEXT "|" D_CMND_MQTTCLIENT "|"
   D_CMND_FULLTOPIC "|" D_CMND_PREFIX "|" D_CMND_GROUPTOPIC "|" D_CMND_TOPIC "|" D_CMND_PUBLISH "|" D_CMND_MQTTLOG "|"
-  D_CMND_BUTTONTOPIC "|" D_CMND_SWITCHTOPIC "|" D_CMND_BUTTONRETAIN "|" D_CMND_SWITCHRETAIN "|" D_CMND_POWERRETAIN "|" D_CMND_SENSORRETAIN ;
+  D_CMND_BUTTONTOPIC "|" D_CMND_SWITCHTOPIC "|" D_CMND_BUTTONRETAIN "|" D_CMND_SWITCHRETAIN "|" D_CMND_POWERRETAIN "|" D_CMND_SENSORRETAIN
+#ifdef USE_MQTT_QUEUE
+  "|" D_CMND_MQTTQUEUE
+#endif
+  ;
 
 void (* const MqttCommand[])(void) PROGMEM = {
 #if defined(USE_MQTT_TLS) && !defined(USE_MQTT_TLS_CA_CERT)
@@ -53,7 +62,11 @@ void (* const MqttCommand[])(void) PROGMEM = {
 #endif
   &CmndMqttHost, &CmndMqttPort, &CmndMqttRetry, &CmndStateText, &CmndMqttClient,
   &CmndFullTopic, &CmndPrefix, &CmndGroupTopic, &CmndTopic, &CmndPublish, &CmndMqttlog,
-  &CmndButtonTopic, &CmndSwitchTopic, &CmndButtonRetain, &CmndSwitchRetain, &CmndPowerRetain, &CmndSensorRetain };
+  &CmndButtonTopic, &CmndSwitchTopic, &CmndButtonRetain, &CmndSwitchRetain, &CmndPowerRetain, &CmndSensorRetain
+#ifdef USE_MQTT_QUEUE
+  , &CmndMqttQueue
+#endif
+  };
 
 struct MQTT {
   uint16_t connect_count = 0;            // MQTT re-connect count
@@ -63,6 +76,9 @@ struct MQTT {
   bool connected = false;                // MQTT virtual connection status
   bool allowed = false;                  // MQTT enabled and parameters valid
   bool mqtt_tls = false;                 // MQTT TLS is enabled
+  bool rx_busy = false;                  // Receive buffer in use by MqttDataHandler
+  uint16_t rx_size = 0;                  // Allocated size of receive buffer
+  char *rx_buffer = nullptr;             // Copy of received topic and payload
 } Mqtt;
 
 #ifdef USE_MQTT_TLS
@@ -190,6 +206,9 @@ bool MqttIsConnected(void) {
 }
 
 void MqttDisconnect(void) {
+#ifdef USE_MQTT_QUEUE
+  MqttQueueFlush();
+#endif
   MqttClient.disconnect();
 }
 
@@ -203,6 +222,166 @@ void MqttUnsubscribeLib(const char *topic) {
   MqttClient.loop();  // Solve LmacRxBlk:1 messages
 }
 
+#ifdef USE_MQTT_QUEUE
+/*********************************************************************************************\
+ * Outbound message queue
+ *
+ * Messages are copied into a bounded queue and published from the main loop with at most
+ * SetOption49 (default MQTT_QUEUE_BUDGET) messages per loop. A queued retained or tele STATE
+ * message is replaced by a newer message for the same topic. When the queue is full the
+ * oldest message is dropped and counted, so queueing never waits for the network.
+\*********************************************************************************************/
+
+typedef struct {
+  char *topic;                           // Topic followed by payload in one allocation
+  char *payload;
+  uint32_t time;                         // millis() when queued
+  uint16_t size;                         // Allocated size
+  bool retained;
+} MqttQueueItem;
+
+struct {
+  MqttQueueItem item[MQTT_QUEUE_SIZE];
+  uint32_t queued;                       // Messages queued
+  uint32_t sent;                         // Messages published
+  uint32_t coalesced;                    // Messages replaced by a newer one for the same topic
+  uint32_t dropped;                      // Messages not published
+  uint32_t latency_total;                // Sum of queue time of published messages in mSec
+  uint32_t latency_max;                  // Worst queue time in mSec
+  uint16_t memory;                       // Bytes used by queued messages
+  uint8_t head;                          // Oldest message
+  uint8_t count;                         // Queued messages
+} MqttQueue;
+
+MqttQueueItem* MqttQueueAt(uint32_t index);   // declare to prevent errors related to ino files
+void MqttQueueFree(MqttQueueItem* item);
+
+MqttQueueItem* MqttQueueAt(uint32_t index) {
+  return &MqttQueue.item[(MqttQueue.head + index) % MQTT_QUEUE_SIZE];
+}
+
+void MqttQueueFree(MqttQueueItem* item) {
+  MqttQueue.memory -= item->size;
+  free(item->topic);
+  item->topic = nullptr;
+}
+
+void MqttQueueRemoveOldest(void) {
+  MqttQueueFree(MqttQueueAt(0));
+  MqttQueue.head = (MqttQueue.head +1) % MQTT_QUEUE_SIZE;
+  MqttQueue.count--;
+}
+
+void MqttQueueClear(void) {
+  MqttQueue.dropped += MqttQueue.count;
+  while (MqttQueue.count) {
+    MqttQueueRemoveOldest();
+  }
+}
+
+bool MqttQueueSendOldest(void) {
+  MqttQueueItem *item = MqttQueueAt(0);
+  bool result = MqttClient.publish(item->topic, item->payload, item->retained);
+  yield();  // #3313
+  if (result) {
+    uint32_t latency = millis() - item->time;
+    MqttQueue.latency_total += latency;
+    if (latency > MqttQueue.latency_max) { MqttQueue.latency_max = latency; }
+    MqttQueue.sent++;
+  } else {
+    MqttQueue.dropped++;
+  }
+  MqttQueueRemoveOldest();
+  return result;
+}
+
+void MqttQueueFlush(void) {
+  while (MqttQueue.count && MqttClient.connected()) {
+    MqttQueueSendOldest();
+  }
+  MqttQueueClear();
+}
+
+void MqttQueueLoop(void) {
+  if (!MqttQueue.count) { return; }
+  if (!MqttClient.connected()) {
+    MqttQueueClear();
+    return;
+  }
+  uint32_t budget = (Settings.param[P_MQTT_QUEUE_BUDGET]) ? Settings.param[P_MQTT_QUEUE_BUDGET] : MQTT_QUEUE_BUDGET;  // SetOption49
+  while (MqttQueue.count && budget--) {
+    MqttQueueSendOldest();
+  }
+}
+
+bool MqttQueueSupersedes(const char* topic, bool retained) {
+  // The broker only keeps the last retained message and a tele STATE is fully replaced by the next one
+  if (retained) { return true; }
+  const char *subtopic = strrchr(topic, '/');
+  return (subtopic && !strcmp_P(subtopic +1, PSTR(D_RSLT_STATE)));
+}
+
+// Queue a message for publishing in order from MqttQueueLoop()
+// A retained or tele STATE message replaces a queued one with the same topic and takes over its position.
+// It is then sent before messages queued after the one it replaced, so publish order is not kept for it.
+bool MqttQueueAdd(const char* topic, const char* payload, bool retained) {
+  uint32_t topic_size = strlen(topic) +1;
+  uint32_t size = topic_size + strlen(payload) +1;
+  if (size > MQTT_QUEUE_MEMORY) {
+    // Too large to queue so publish now, ahead of queued messages
+    bool result = MqttClient.publish(topic, payload, retained);
+    yield();  // #3313
+    return result;
+  }
+
+  MqttQueueItem *item = nullptr;
+  if (MqttQueueSupersedes(topic, retained)) {
+    for (uint32_t i = 0; i < MqttQueue.count; i++) {
+      MqttQueueItem *queued = MqttQueueAt(i);
+      if ((queued->retained == retained) && !strcmp(queued->topic, topic)) {
+        MqttQueueFree(queued);           // Keep position and queue time of the superseded message
+        MqttQueue.coalesced++;
+        item = queued;
+        break;
+      }
+    }
+  }
+  if (!item) {
+    while (MqttQueue.count && ((MqttQueue.count >= MQTT_QUEUE_SIZE) || (MqttQueue.memory + size > MQTT_QUEUE_MEMORY))) {
+      MqttQueueRemoveOldest();           // Full so drop the oldest instead of publishing from the caller
+      MqttQueue.dropped++;
+    }
+    item = MqttQueueAt(MqttQueue.count);
+    MqttQueue.count++;
+    item->time = millis();
+  }
+
+  item->topic = (char*)malloc(size);
+  if (!item->topic) {
+    // Out of memory so remove the slot again, it is either the newest or a superseded one
+    for (uint32_t i = 0; i < MqttQueue.count; i++) {
+      if (MqttQueueAt(i) == item) {
+        for (uint32_t j = i; j < MqttQueue.count -1; j++) {
+          *MqttQueueAt(j) = *MqttQueueAt(j +1);
+        }
+        break;
+      }
+    }
+    MqttQueue.count--;
+    MqttQueue.dropped++;
+    return false;
+  }
+  item->payload = item->topic + topic_size;
+  strcpy(item->topic, topic);
+  strcpy(item->payload, payload);
+  item->size = size;
+  item->retained = retained;
+  MqttQueue.memory += size;
+  MqttQueue.queued++;
+  return true;
+}
+#endif  // USE_MQTT_QUEUE
+
 bool MqttPublishLib(const char* topic, bool retained) {
   // If Prefix1 equals Prefix2 disable next MQTT subscription to prevent loop
   if (!strcmp(SettingsText(SET_MQTTPREFIX1), SettingsText(SET_MQTTPREFIX2))) {
@@ -213,25 +392,38 @@ bool MqttPublishLib(const char* topic, bool retained) {
     }
   }
 
+#ifdef USE_MQTT_QUEUE
+  if (!MqttClient.connected()) { return false; }
+  return MqttQueueAdd(topic, TasmotaGlobal.mqtt_data, retained);
+#endif  // USE_MQTT_QUEUE
   bool result = MqttClient.publish(topic, TasmotaGlobal.mqtt_data, retained);
   yield();  // #3313
   return result;
 }
 
 void MqttDumpData(char* topic, char* data, uint32_t data_len) {
-  char dump_data[data_len +1];
-  memcpy(dump_data, data, sizeof(dump_data));  // Make another copy for removing optional control characters
+  if (!NeedLog(LOG_LEVEL_DEBUG_MORE)) { return; }
+
+  uint32_t dump_len = (data_len < LOGSZ) ? data_len : LOGSZ -1;  // Log line will be truncated anyway
+  char dump_data[dump_len +1];
+  strlcpy(dump_data, data, sizeof(dump_data));  // Make another copy for removing optional control characters
   AddLog_P(LOG_LEVEL_DEBUG_MORE, PSTR(D_LOG_MQTT D_DATA_SIZE " %d, \"%s %s\""), data_len, topic, RemoveControlCharacter(dump_data));
 }
 
+/*********************************************************************************************\
+ * Received topic and payload are copied once from the PubSubClient buffer, which is reused by
+ * the next publish, into a heap buffer owned by MqttDataHandler. FUNC_MQTT_DATA drivers and
+ * CommandHandler get pointers into this buffer which stay valid, and may be modified in place,
+ * until MqttDataHandler returns.
+\*********************************************************************************************/
+
+#define MQTT_RX_KEEP_SIZE      256       // Keep receive buffers up to this size allocated between messages
+
 void MqttDataHandler(char* mqtt_topic, uint8_t* mqtt_data, unsigned int data_len) {
 #ifdef USE_DEBUG_DRIVER
   ShowFreeMem(PSTR("MqttDataHandler"));
 #endif
 
-  // Do not allow more data than would be feasable within stack space
-  if (data_len >= MQTT_MAX_PACKET_SIZE) { return; }
-
   // Do not execute multiple times if Prefix1 equals Prefix2
   if (!strcmp(SettingsText(SET_MQTTPREFIX1), SettingsText(SET_MQTTPREFIX2))) {
     char *str = strstr(mqtt_topic, SettingsText(SET_MQTTPREFIX1));
@@ -242,26 +434,59 @@ void MqttDataHandler(char* mqtt_topic, uint8_t* mqtt_data, unsigned int data_len
   }
 
   // Save MQTT data ASAP as it's data is discarded by PubSubClient with next publish as used in MQTTlog
-  char topic[TOPSZ];
-  strlcpy(topic, mqtt_topic, sizeof(topic));
-  mqtt_data[data_len] = 0;
-  char data[data_len +1];
-  memcpy(data, mqtt_data, sizeof(data));
+  uint32_t topic_len = strlen(mqtt_topic);
+  if (topic_len >= TOPSZ) { topic_len = TOPSZ -1; }
+  uint32_t size = topic_len + data_len +2;
+
+  char *buffer;
+  bool nested = Mqtt.rx_busy;            // Called again from MqttClient.loop() while handling a message
+  if (nested) {
+    buffer = (char*)malloc(size);
+  } else {
+    if (size > Mqtt.rx_size) {
+      free(Mqtt.rx_buffer);
+      Mqtt.rx_size = (size + 63) & ~63;
+      Mqtt.rx_buffer = (char*)malloc(Mqtt.rx_size);
+      if (!Mqtt.rx_buffer) { Mqtt.rx_size = 0; }
+    }
+    buffer = Mqtt.rx_buffer;
+  }
+  if (!buffer) {
+    AddLog_P(LOG_LEVEL_ERROR, PSTR(D_LOG_MQTT "No memory for %d bytes received"), data_len);
+    return;
+  }
+  Mqtt.rx_busy = true;
 
-//  AddLog_P(LOG_LEVEL_DEBUG_MORE, PSTR(D_LOG_MQTT D_DATA_SIZE " %d, \"%s %s\""), data_len, topic, data);
-//  if (LOG_LEVEL_DEBUG_MORE <= TasmotaGlobal.seriallog_level) { Serial.println(data); }
-  MqttDumpData(topic, data, data_len);  // Use a function to save stack space used by dump_data
+  char *topic = buffer;
+  memcpy(topic, mqtt_topic, topic_len);
+  topic[topic_len] = '\0';
+  char *data = buffer + topic_len +1;
+  memcpy(data, mqtt_data, data_len);
+  data[data_len] = '\0';
+
+  MqttDumpData(topic, data, data_len);
 
   // MQTT pre-processing
-  XdrvMailbox.index = strlen(topic);
+  XdrvMailbox.index = topic_len;
   XdrvMailbox.data_len = data_len;
   XdrvMailbox.topic = topic;
-  XdrvMailbox.data = (char*)data;
-  if (XdrvCall(FUNC_MQTT_DATA)) { return; }
+  XdrvMailbox.data = data;
+  if (!XdrvCall(FUNC_MQTT_DATA)) {
+    ShowSource(SRC_MQTT);
 
-  ShowSource(SRC_MQTT);
+    CommandHandler(topic, data, data_len);
+  }
 
-  CommandHandler(topic, data, data_len);
+  if (nested) {
+    free(buffer);
+  } else {
+    Mqtt.rx_busy = false;
+    if (Mqtt.rx_size > MQTT_RX_KEEP_SIZE) {
+      free(Mqtt.rx_buffer);
+      Mqtt.rx_buffer = nullptr;
+      Mqtt.rx_size = 0;
+    }
+  }
 }
 
 /*********************************************************************************************/
@@ -289,7 +514,7 @@ void MqttPublishLoggingAsync(bool refresh) {
   char* line;
   size_t len;
   while (GetLog(Settings.mqttlog_level, &index, &line, &len)) {
-    strlcpy(TasmotaGlobal.mqtt_data, line, len);  // No JSON and ugly!!
+    Response_P(PSTR("%s"), line);  // No JSON and ugly!!
     char stopic[TOPSZ];
     GetTopic_P(stopic, STAT, TasmotaGlobal.mqtt_topic, PSTR("LOGGING"));
     MqttPublishLib(stopic, false);
@@ -327,6 +552,9 @@ void MqttPublish(const char* topic, bool retained) {
   }
   snprintf_P(log_data, sizeof(log_data), PSTR("%s%s"), log_data, sretained);
   AddLogData(LOG_LEVEL_INFO, log_data);
+  if (ResponseOverflow()) {
+    AddLog_P(LOG_LEVEL_ERROR, PSTR(D_LOG_MQTT "Message truncated by %d characters"), ResponseOverflow());
+  }
 
   if (Settings.ledstate &0x04) {
     TasmotaGlobal.blinks++;
@@ -372,15 +600,20 @@ void MqttPublishPrefixTopic_P(uint32_t prefix, const char* subtopic, bool retain
     snprintf_P(romram, sizeof(romram), PSTR("$aws/things/%s/shadow/update"), topic2);
 
     // copy buffer
-    char *mqtt_save = (char*) malloc(strlen(TasmotaGlobal.mqtt_data)+1);
+    char *mqtt_save = (char*) malloc(ResponseLength() +1);
     if (!mqtt_save) { return; }    // abort
     strcpy(mqtt_save, TasmotaGlobal.mqtt_data);
-    snprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"state\":{\"reported\":%s}}"), mqtt_save);
+    Response_P(PSTR("{\"state\":{\"reported\":%s}}"), mqtt_save);
     free(mqtt_save);
 
+#ifdef USE_MQTT_QUEUE
+    MqttQueueAdd(romram, TasmotaGlobal.mqtt_data, false);
+    AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Updated shadow: %s"), romram);
+#else
     bool result = MqttClient.publish(romram, TasmotaGlobal.mqtt_data, false);
     AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_MQTT "Updated shadow: %s"), romram);
     yield();  // #3313
+#endif  // USE_MQTT_QUEUE
   }
 #endif // USE_MQTT_AWS_IOT
 }
@@ -472,6 +705,9 @@ void MqttDisconnected(int state) {
   }
 
   MqttClient.disconnect();
+#ifdef USE_MQTT_QUEUE
+  MqttQueueClear();
+#endif
 
   AddLog_P(LOG_LEVEL_INFO, PSTR(D_LOG_MQTT D_CONNECT_FAILED_TO " %s:%d, rc %d. " D_RETRY_IN " %d " D_UNIT_SECOND), SettingsText(SET_MQTT_HOST), Settings.mqtt_port, state, Mqtt.retry_counter);
   TasmotaGlobal.rules_flag.mqtt_disconnected = 1;
@@ -803,6 +1039,24 @@ void CmndMqttlog(void) {
   ResponseCmndNumber(Settings.mqttlog_level);
 }
 
+#ifdef USE_MQTT_QUEUE
+void CmndMqttQueue(void) {
+  // MqttQueue   - Show queue statistics
+  // MqttQueue 0 - Reset queue statistics
+  if ((XdrvMailbox.data_len > 0) && (0 == XdrvMailbox.payload)) {
+    MqttQueue.queued = 0;
+    MqttQueue.sent = 0;
+    MqttQueue.coalesced = 0;
+    MqttQueue.dropped = 0;
+    MqttQueue.latency_total = 0;
+    MqttQueue.latency_max = 0;
+  }
+  Response_P(PSTR("{\"%s\":{\"Queued\":%u,\"Sent\":%u,\"Coalesced\":%u,\"Dropped\":%u,\"Pending\":%u,\"Memory\":%u,\"LatencyAvg\":%u,\"LatencyMax\":%u}}"),
+    XdrvMailbox.command, MqttQueue.queued, MqttQueue.sent, MqttQueue.coalesced, MqttQueue.dropped, MqttQueue.count, MqttQueue.memory,
+    (MqttQueue.sent) ? MqttQueue.latency_total / MqttQueue.sent : 0, MqttQueue.latency_max);
+}
+#endif  // USE_MQTT_QUEUE
+
 void CmndMqttHost(void) {
   if (XdrvMailbox.data_len > 0) {
     SettingsUpdateText(SET_MQTT_HOST, (SC_CLEAR == Shortcut()) ? "" : (SC_DEFAULT == Shortcut()) ? MQTT_HOST : XdrvMailbox.data);
@@ -894,7 +1148,7 @@ void CmndPublish(void) {
       strlcpy(stemp1, mqtt_part, sizeof(stemp1));
       ReplaceChar(stemp1, '#', ' ');
       if ((payload_part != nullptr) && strlen(payload_part)) {
-        strlcpy(TasmotaGlobal.mqtt_data, payload_part, sizeof(TasmotaGlobal.mqtt_data));
+        Response_P(PSTR("%s"), payload_part);
       } else {
         ResponseClear();
       }
@@ -1334,6 +1588,11 @@ bool Xdrv02(uint8_t function)
       case FUNC_PRE_INIT:
         MqttInit();
         break;
+#ifdef USE_MQTT_QUEUE
+      case FUNC_LOOP:
+        MqttQueueLoop();
+        break;
+#endif  // USE_MQTT_QUEUE
       case FUNC_EVERY_50_MSECOND:  // https://github.com/knolleary/pubsubclient/issues/556
         MqttClient.loop();
         break;
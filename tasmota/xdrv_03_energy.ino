@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_03                3
+#define XDRV_03_FUNCS          (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_250_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 #define XSNS_03                3
 
 //#define USE_ENERGY_MARGIN_DETECTION
@@ -38,6 +39,7 @@
 #define D_CMND_CURRENTCAL "CurrentCal"
 #define D_CMND_TARIFF "Tariff"
 #define D_CMND_MODULEADDRESS "ModuleAddress"
+#define D_CMND_ENERGYHISTORY "EnergyHistory"
 
 enum EnergyCommands {
   CMND_POWERCAL, CMND_VOLTAGECAL, CMND_CURRENTCAL,
@@ -54,7 +56,11 @@ const char kEnergyCommands[] PROGMEM = "|"  // No prefix
   D_CMND_SAFEPOWER "|" D_CMND_SAFEPOWERHOLD "|"  D_CMND_SAFEPOWERWINDOW "|"
 #endif  // USE_ENERGY_POWER_LIMIT
 #endif  // USE_ENERGY_MARGIN_DETECTION
-  D_CMND_ENERGYRESET "|" D_CMND_TARIFF ;
+  D_CMND_ENERGYRESET "|" D_CMND_TARIFF
+#ifdef USE_ENERGY_HISTORY
+  "|" D_CMND_ENERGYHISTORY
+#endif  // USE_ENERGY_HISTORY
+  ;
 
 void (* const EnergyCommand[])(void) PROGMEM = {
   &CmndPowerCal, &CmndVoltageCal, &CmndCurrentCal,
@@ -67,7 +73,11 @@ void (* const EnergyCommand[])(void) PROGMEM = {
   &CmndSafePower, &CmndSafePowerHold, &CmndSafePowerWindow,
 #endif  // USE_ENERGY_POWER_LIMIT
 #endif  // USE_ENERGY_MARGIN_DETECTION
-  &CmndEnergyReset, &CmndTariff };
+  &CmndEnergyReset, &CmndTariff,
+#ifdef USE_ENERGY_HISTORY
+  &CmndEnergyHistory,
+#endif  // USE_ENERGY_HISTORY
+  };
 
 const char kEnergyPhases[] PROGMEM = "|%s / %s|%s / %s / %s||[%s,%s]|[%s,%s,%s]";
 
@@ -544,8 +554,331 @@ void EnergyEverySecond(void)
 #ifdef USE_ENERGY_MARGIN_DETECTION
   EnergyMarginCheck();
 #endif  // USE_ENERGY_MARGIN_DETECTION
+#ifdef USE_ENERGY_HISTORY
+  EnergyHistoryEverySecond();
+#endif  // USE_ENERGY_HISTORY
 }
 
+#ifdef USE_ENERGY_HISTORY
+/*********************************************************************************************\
+ * Energy history
+ *
+ * Records min, average and max of active power (sum of phases), voltage (first valid phase) and
+ * current (sum of phases) per minute in fixed point, rolled up from minutes per hour (UTC) and
+ * per day (local time) into three rings. Phases without valid data are left out and seconds without
+ * any valid phase are not sampled. When the filesystem is available (ESP32 with USE_TFS) the
+ * rings and the periods in progress are saved every ENERGY_HISTORY_SAVE minutes and before
+ * restart, so history survives network outages and restarts.
+ *
+ * EnergyHistory            - Show number of records per ring
+ * EnergyHistory1 <n>       - Show last <n> minute records (as many as fit in the response)
+ * EnergyHistory2 <n>       - Show last <n> hour records
+ * EnergyHistory3 <n>       - Show last <n> day records
+ * /energy?t=m|h|d&n=<records>&f=csv|json - Stream history, oldest first (default all minute records as CSV)
+\*********************************************************************************************/
+
+#ifndef ENERGY_HISTORY_MINUTES
+#define ENERGY_HISTORY_MINUTES 120                  // Number of minute records (28 bytes each)
+#endif
+#ifndef ENERGY_HISTORY_HOURS
+#define ENERGY_HISTORY_HOURS   72                   // Number of hour records
+#endif
+#ifndef ENERGY_HISTORY_DAYS
+#define ENERGY_HISTORY_DAYS    31                   // Number of day records
+#endif
+#ifndef ENERGY_HISTORY_SAVE
+#define ENERGY_HISTORY_SAVE    60                   // Minutes between saves to filesystem
+#endif
+
+#define ENERGY_HISTORY_VERSION 1
+#define ENERGY_HISTORY_ROW     80                   // Max length of a formatted record
+
+const char ENERGY_HISTORY_FILE[] = "/energyhist";
+const char ENERGY_HISTORY_TEMP[] = "/energyhist.tmp";  // Written first so a save interrupted by restart keeps the previous file
+
+enum EnergyHistoryRings { ENERGY_HIST_MINUTE, ENERGY_HIST_HOUR, ENERGY_HIST_DAY, ENERGY_HIST_RINGS };
+
+const char kEnergyHistoryRings[] PROGMEM = "Minutes|Hours|Days";
+const char kEnergyHistoryColumns[] PROGMEM = "Time,PowerMin,PowerAvg,PowerMax,VoltageMin,VoltageAvg,VoltageMax,CurrentMin,CurrentAvg,CurrentMax";
+
+const uint16_t kEnergyHistorySize[ENERGY_HIST_RINGS] = { ENERGY_HISTORY_MINUTES, ENERGY_HISTORY_HOURS, ENERGY_HISTORY_DAYS };
+const uint32_t kEnergyHistoryPeriod[ENERGY_HIST_RINGS] = { 60, 3600, 86400 };
+
+typedef struct {
+  uint32_t time;                                    // UTC start of the period
+  int32_t power[3];                                 // W min, avg, max
+  uint16_t voltage[3];                              // 0.1 V min, avg, max
+  uint16_t current[3];                              // 0.01 A min, avg, max
+} EnergyHistoryRecord;
+
+typedef struct {
+  uint32_t time;                                    // UTC start of the period
+  uint32_t count;                                   // Number of samples or records accumulated
+  int32_t min[3];                                   // Power, voltage and current in record units
+  int32_t max[3];
+  int32_t sum[3];                                   // Sum of samples or of averages
+} EnergyHistoryPeriod;
+
+typedef struct {
+  uint16_t version;
+  uint16_t size[ENERGY_HIST_RINGS];                 // Ring sizes, history is discarded if they change
+  uint16_t head[ENERGY_HIST_RINGS];                 // Next record to write
+  uint16_t count[ENERGY_HIST_RINGS];                // Number of valid records
+  EnergyHistoryPeriod period[ENERGY_HIST_RINGS];    // Periods in progress
+  EnergyHistoryRecord record[ENERGY_HISTORY_MINUTES + ENERGY_HISTORY_HOURS + ENERGY_HISTORY_DAYS];
+} EnergyHistoryData;
+
+struct {
+  EnergyHistoryData *data;                          // Allocated at init, saved as is to filesystem
+  uint16_t save_minutes;                            // Minutes since last save
+} EnergyHistory;
+
+/*********************************************************************************************/
+
+// Index in record array of a record by age in ring, 0 is the newest
+uint32_t EnergyHistoryIndex(uint32_t ring, uint32_t age)
+{
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < ring; i++) { offset += kEnergyHistorySize[i]; }
+  uint32_t size = kEnergyHistorySize[ring];
+  return offset + ((EnergyHistory.data->head[ring] + size - 1 - age) % size);
+}
+
+// Start of the period containing utc, days follow local time
+uint32_t EnergyHistoryPeriodStart(uint32_t ring, uint32_t utc)
+{
+  uint32_t offset = (ENERGY_HIST_DAY == ring) ? LocalTime() - UtcTime() : 0;  // Wraps if negative, still correct modulo 2^32
+  return utc - ((utc + offset) % kEnergyHistoryPeriod[ring]);
+}
+
+int32_t EnergyHistoryFixed(float value, uint32_t scale)
+{
+  value *= scale;
+  return (int32_t)((value < 0) ? value - 0.5f : value + 0.5f);
+}
+
+uint16_t EnergyHistoryClamp(int32_t value)
+{
+  return (value < 0) ? 0 : (value > 0xFFFF) ? 0xFFFF : value;
+}
+
+void EnergyHistoryAccumulate(uint32_t ring, uint32_t utc, int32_t* min, int32_t* avg, int32_t* max)
+{
+  EnergyHistoryPeriod *period = &EnergyHistory.data->period[ring];
+  if (!period->count) {
+    period->time = EnergyHistoryPeriodStart(ring, utc);
+    for (uint32_t i = 0; i < 3; i++) {
+      period->min[i] = min[i];
+      period->max[i] = max[i];
+      period->sum[i] = 0;
+    }
+  }
+  for (uint32_t i = 0; i < 3; i++) {
+    if (min[i] < period->min[i]) { period->min[i] = min[i]; }
+    if (max[i] > period->max[i]) { period->max[i] = max[i]; }
+    period->sum[i] += avg[i];
+  }
+  period->count++;
+}
+
+// Store the period in progress if utc is past it and roll it up into the next ring
+void EnergyHistoryRoll(uint32_t ring, uint32_t utc)
+{
+  EnergyHistoryData *data = EnergyHistory.data;
+  EnergyHistoryPeriod *period = &data->period[ring];
+  if (!period->count || (EnergyHistoryPeriodStart(ring, utc) == period->time)) { return; }
+
+  int32_t avg[3];
+  for (uint32_t i = 0; i < 3; i++) {
+    int32_t half = (period->sum[i] < 0) ? -(int32_t)(period->count / 2) : period->count / 2;
+    avg[i] = (period->sum[i] + half) / (int32_t)period->count;
+  }
+  data->head[ring] = (data->head[ring] +1) % kEnergyHistorySize[ring];
+  if (data->count[ring] < kEnergyHistorySize[ring]) { data->count[ring]++; }
+  EnergyHistoryRecord *record = &data->record[EnergyHistoryIndex(ring, 0)];
+  record->time = period->time;
+  record->power[0] = period->min[0];
+  record->power[1] = avg[0];
+  record->power[2] = period->max[0];
+  record->voltage[0] = EnergyHistoryClamp(period->min[1]);
+  record->voltage[1] = EnergyHistoryClamp(avg[1]);
+  record->voltage[2] = EnergyHistoryClamp(period->max[1]);
+  record->current[0] = EnergyHistoryClamp(period->min[2]);
+  record->current[1] = EnergyHistoryClamp(avg[2]);
+  record->current[2] = EnergyHistoryClamp(period->max[2]);
+  period->count = 0;
+
+  if (ENERGY_HIST_MINUTE == ring) {
+    // Days are built from minutes as local midnight is not on a UTC hour with half hour time zones
+    EnergyHistoryAccumulate(ENERGY_HIST_HOUR, record->time, period->min, avg, period->max);
+    EnergyHistoryAccumulate(ENERGY_HIST_DAY, record->time, period->min, avg, period->max);
+    EnergyHistory.save_minutes++;
+    if (EnergyHistory.save_minutes >= ENERGY_HISTORY_SAVE) {
+      EnergyHistorySave();
+    }
+  }
+}
+
+void EnergyHistoryEverySecond(void)
+{
+  if (!EnergyHistory.data || !RtcTime.valid) { return; }
+
+  uint32_t utc = UtcTime();
+  // Minutes first so the last minute of an hour or day is rolled into it before it is stored
+  for (uint32_t ring = 0; ring < ENERGY_HIST_RINGS; ring++) {
+    EnergyHistoryRoll(ring, utc);
+  }
+
+  float power = 0;
+  float current = 0;
+  float voltage = 0;
+  uint32_t valid = 0;
+  for (uint32_t i = 0; i < Energy.phase_count; i++) {
+    if (Energy.data_valid[i] > ENERGY_WATCHDOG) { continue; }  // No data from this phase within ENERGY_WATCHDOG seconds
+    if (!valid) { voltage = Energy.voltage[i]; }
+    power += Energy.active_power[i];
+    current += Energy.current[i];
+    valid++;
+  }
+  if (!valid) { return; }                           // Skip the sample instead of recording zeros for a silent meter
+  int32_t value[3] = { EnergyHistoryFixed(power, 1), EnergyHistoryFixed(voltage, 10), EnergyHistoryFixed(current, 100) };
+  EnergyHistoryAccumulate(ENERGY_HIST_MINUTE, utc, value, value, value);
+}
+
+void EnergyHistorySave(void)
+{
+  EnergyHistory.save_minutes = 0;
+#if defined(ESP32) && defined(USE_TFS)
+  if (EnergyHistory.data) {
+    if (TfsSaveFile(ENERGY_HISTORY_TEMP, (const uint8_t*)EnergyHistory.data, sizeof(EnergyHistoryData)) &&
+        TfsDeleteFile(ENERGY_HISTORY_FILE)) {   // Rename does not replace an existing file on all filesystems
+      TfsRenameFile(ENERGY_HISTORY_TEMP, ENERGY_HISTORY_FILE);
+    }
+  }
+#endif  // ESP32 and USE_TFS
+}
+
+bool EnergyHistoryLoad(const char *fname)
+{
+#if defined(ESP32) && defined(USE_TFS)
+  EnergyHistoryData *data = EnergyHistory.data;
+  if ((TfsFileSize(fname) != sizeof(EnergyHistoryData)) || !TfsLoadFile(fname, (uint8_t*)data, sizeof(EnergyHistoryData))) {
+    return false;                                   // Missing, truncated or from a build with other ring sizes
+  }
+  bool valid = (ENERGY_HISTORY_VERSION == data->version);
+  for (uint32_t ring = 0; ring < ENERGY_HIST_RINGS; ring++) {
+    valid &= (data->size[ring] == kEnergyHistorySize[ring]) && (data->head[ring] < kEnergyHistorySize[ring]) && (data->count[ring] <= kEnergyHistorySize[ring]);
+  }
+  if (!valid) {
+    memset(data, 0, sizeof(EnergyHistoryData));
+  }
+  return valid;
+#else
+  return false;
+#endif  // ESP32 and USE_TFS
+}
+
+void EnergyHistoryInit(void)
+{
+  EnergyHistory.data = (EnergyHistoryData*)calloc(1, sizeof(EnergyHistoryData));
+  if (!EnergyHistory.data) {
+    AddLog_P(LOG_LEVEL_INFO, PSTR("NRG: Not enough memory for history"));
+    return;
+  }
+  if (!EnergyHistoryLoad(ENERGY_HISTORY_FILE)) {
+    EnergyHistoryLoad(ENERGY_HISTORY_TEMP);         // Restart between delete and rename of last save
+  }
+  EnergyHistory.data->version = ENERGY_HISTORY_VERSION;
+  memcpy(EnergyHistory.data->size, kEnergyHistorySize, sizeof(EnergyHistory.data->size));
+}
+
+// Format record as comma separated time, power in W, voltage in V and current in A
+char* EnergyHistoryFormat(char* out, size_t size, uint32_t ring, uint32_t age)
+{
+  EnergyHistoryRecord *record = &EnergyHistory.data->record[EnergyHistoryIndex(ring, age)];
+  snprintf_P(out, size, PSTR("%u,%d,%d,%d,%u.%u,%u.%u,%u.%u,%u.%02u,%u.%02u,%u.%02u"),
+    record->time, record->power[0], record->power[1], record->power[2],
+    record->voltage[0] / 10, record->voltage[0] % 10, record->voltage[1] / 10, record->voltage[1] % 10, record->voltage[2] / 10, record->voltage[2] % 10,
+    record->current[0] / 100, record->current[0] % 100, record->current[1] / 100, record->current[1] % 100, record->current[2] / 100, record->current[2] % 100);
+  return out;
+}
+
+void CmndEnergyHistory(void)
+{
+  if (!EnergyHistory.data) {
+    ResponseCmndChar_P(PSTR(D_JSON_MEMORY_ERROR));
+    return;
+  }
+
+  char name[8];
+  if (!XdrvMailbox.usridx || (XdrvMailbox.index < 1) || (XdrvMailbox.index > ENERGY_HIST_RINGS)) {  // EnergyHistory without index sets index 1
+    Response_P(PSTR("{\"%s\":{"), XdrvMailbox.command);
+    for (uint32_t ring = 0; ring < ENERGY_HIST_RINGS; ring++) {
+      ResponseAppend_P(PSTR("%s\"%s\":[%d,%d]"), (ring) ? "," : "",
+        GetTextIndexed(name, sizeof(name), ring, kEnergyHistoryRings), EnergyHistory.data->count[ring], kEnergyHistorySize[ring]);
+    }
+    ResponseJsonEndEnd();
+    return;
+  }
+
+  uint32_t ring = XdrvMailbox.index -1;
+  uint32_t count = EnergyHistory.data->count[ring];
+  if ((XdrvMailbox.data_len > 0) && (XdrvMailbox.payload >= 0) && ((uint32_t)XdrvMailbox.payload < count)) {
+    count = XdrvMailbox.payload;
+  }
+  Response_P(PSTR("{\"%s%d\":{\"Columns\":\"%s\",\"Data\":["), XdrvMailbox.command, XdrvMailbox.index, kEnergyHistoryColumns);
+  uint32_t fit = (sizeof(TasmotaGlobal.mqtt_data) - ResponseLength() - 4) / (ENERGY_HISTORY_ROW +3);
+  if (count > fit) { count = fit; }                     // Keep the newest records
+  char row[ENERGY_HISTORY_ROW];
+  for (uint32_t age = count; age > 0; age--) {          // Oldest first
+    ResponseAppend_P(PSTR("%s[%s]"), (age < count) ? "," : "", EnergyHistoryFormat(row, sizeof(row), ring, age -1));
+  }
+  ResponseAppend_P(PSTR("]}}"));
+}
+
+#ifdef USE_WEBSERVER
+void HandleEnergyHistory(void)
+{
+  if (!HttpCheckPriviledgedAccess()) { return; }
+  if (!EnergyHistory.data) { return; }
+
+  AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_HTTP "Energy history"));
+
+  char tmp[8];
+  WebGetArg("t", tmp, sizeof(tmp));
+  uint32_t ring = ('h' == tmp[0]) ? ENERGY_HIST_HOUR : ('d' == tmp[0]) ? ENERGY_HIST_DAY : ENERGY_HIST_MINUTE;
+  WebGetArg("f", tmp, sizeof(tmp));
+  bool json = ('j' == tmp[0]);
+  uint32_t count = EnergyHistory.data->count[ring];
+  WebGetArg("n", tmp, sizeof(tmp));
+  if (strlen(tmp) && ((uint32_t)atoi(tmp) < count)) {
+    count = atoi(tmp);
+  }
+
+  // Records are sent one by one through the chunk buffer, the full response is never in memory
+  WSContentBegin(200, (json) ? CT_JSON : CT_PLAIN);
+  char row[ENERGY_HISTORY_ROW];
+  if (json) {
+    WSContentSend_P(PSTR("{\"%s\":{\"Columns\":\"%s\",\"Data\":["), GetTextIndexed(row, sizeof(row), ring, kEnergyHistoryRings), kEnergyHistoryColumns);
+  } else {
+    WSContentSend_P(PSTR("%s\n"), kEnergyHistoryColumns);
+  }
+  for (uint32_t age = count; age > 0; age--) {          // Oldest first
+    EnergyHistoryFormat(row, sizeof(row), ring, age -1);
+    if (json) {
+      WSContentSend_P(PSTR("%s[%s]"), (age < count) ? "," : "", row);
+    } else {
+      WSContentSend_P(PSTR("%s\n"), row);
+    }
+  }
+  if (json) {
+    WSContentSend_P(PSTR("]}}"));
+  }
+  WSContentEnd();
+}
+#endif  // USE_WEBSERVER
+#endif  // USE_ENERGY_HISTORY
+
 /*********************************************************************************************\
  * Commands
 \*********************************************************************************************/
@@ -909,6 +1242,9 @@ void EnergySnsInit(void)
     Energy.kWhtoday_delta = 0;
     Energy.period = Energy.kWhtoday_offset;
     EnergyUpdateToday();
+#ifdef USE_ENERGY_HISTORY
+    EnergyHistoryInit();
+#endif  // USE_ENERGY_HISTORY
     ticker_energy.attach_ms(200, Energy200ms);
   }
 }
@@ -1207,6 +1543,11 @@ bool Xdrv03(uint8_t function)
       case FUNC_COMMAND:
         result = DecodeCommand(kEnergyCommands, EnergyCommand);
         break;
+#if defined(USE_ENERGY_HISTORY) && defined(USE_WEBSERVER)
+      case FUNC_WEB_ADD_HANDLER:
+        WebServer_on(PSTR("/energy"), HandleEnergyHistory);
+        break;
+#endif  // USE_ENERGY_HISTORY and USE_WEBSERVER
     }
   }
   return result;
@@ -1231,6 +1572,9 @@ bool Xsns03(uint8_t function)
 #endif  // USE_WEBSERVER
       case FUNC_SAVE_BEFORE_RESTART:
         EnergySaveState();
+#ifdef USE_ENERGY_HISTORY
+        EnergyHistorySave();
+#endif  // USE_ENERGY_HISTORY
         break;
       case FUNC_INIT:
         EnergySnsInit();
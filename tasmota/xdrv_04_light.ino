@@ -122,6 +122,7 @@
 \*********************************************************************************************/
 
 #define XDRV_04              4
+#define XDRV_04_FUNCS        (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_50_MSECOND))
 // #define DEBUG_LIGHT
 
 enum LightSchemes { LS_POWER, LS_WAKEUP, LS_CYCLEUP, LS_CYCLEDN, LS_RANDOM, LS_MAX };
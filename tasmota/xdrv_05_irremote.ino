@@ -58,6 +58,7 @@ def ir_expand(ir_compact):
 \*********************************************************************************************/
 
 #define XDRV_05             5
+#define XDRV_05_FUNCS       (FUNC_MASK(FUNC_EVERY_50_MSECOND))
 
 #include <IRremoteESP8266.h>
 #include <IRutils.h>
@@ -58,6 +58,7 @@ def ir_expand(ir_compact):
 \*********************************************************************************************/
 
 #define XDRV_05             5
+#define XDRV_05_FUNCS       (FUNC_MASK(FUNC_EVERY_50_MSECOND))
 
 #include <IRremoteESP8266.h>
 #include <IRsend.h>
@@ -397,6 +398,7 @@ uint32_t IrRemoteCmndIrHvacJson(void)
   JsonParser parser(XdrvMailbox.data);
   JsonParserObject root = parser.getRootObject();
   if (!root) { return IE_INVALID_JSON; }
+  JsonParserIndex index(root);    // about 20 keys are looked up below
 
   // from: https://github.com/crankyoldgit/IRremoteESP8266/blob/master/examples/CommonAcControl/CommonAcControl.ino
   state.protocol = decode_type_t::UNKNOWN;
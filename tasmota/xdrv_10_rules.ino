@@ -66,6 +66,7 @@
 \*********************************************************************************************/
 
 #define XDRV_10             10
+#define XDRV_10_FUNCS       (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_100_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 //#define DEBUG_RULES
 
@@ -176,6 +177,40 @@ struct RULES {
   char event_data[100];
 } Rules;
 
+/*
+ * Compiled rules
+ *
+ * Each rule set is compiled once into a table of triggers with pre-parsed JSON path, compare
+ * operator and constant compare value followed by the rule text fields. The hash of the first
+ * JSON level acts as trigger index so an event only evaluates rules that can match.
+ */
+#define RULES_MAX_EVENT_KEYS     16       // Max number of top level event keys used for trigger index
+
+typedef struct {
+  float value;                            // Compare value if constant parameter
+  uint16_t trigger;                       // Offset of trigger text, like "INA219#CURRENT>0.100"
+  uint16_t name;                          // Offset of first JSON level, levels are zero separated
+  uint16_t param;                         // Offset of compare parameter
+  uint16_t commands;                      // Offset of commands
+  uint16_t key_hash;                      // Hash of first JSON level or 0 if any level (wildcard ?)
+  int8_t compare;                         // Compare operator
+  uint8_t levels;                         // Number of JSON levels before the last one
+  uint16_t full_hash;                     // Hash of first JSON level including TELE- used outside teleperiod
+  uint8_t name_index;                     // Array index 1..6 or 0 if none
+  uint8_t tele : 1;                       // Trigger starts with TELE-
+  uint8_t dynamic : 1;                    // Parameter contains a variable like %VAR1%
+  uint8_t legacy : 1;                     // Uncommon trigger syntax evaluated by RulesRuleMatch
+  uint8_t stop : 1;                       // Rule ends with BREAK
+} RuleCompiled;
+
+struct {
+  RuleCompiled *rule[MAX_RULE_SETS];      // Compiled rules followed by text in same allocation
+  uint8_t count[MAX_RULE_SETS];           // Number of compiled rules
+  uint8_t valid;                          // Bitmask of compiled rule sets
+  uint8_t pending;                        // Bitmask of rule sets changed while being processed
+  int8_t active = -1;                     // Rule set being processed
+} RulesCompiled;
+
 char rules_vars[MAX_RULE_VARS][33] = {{ 0 }};
 
 #if (MAX_RULE_VARS>16)
@@ -323,6 +358,7 @@ int32_t SetRule_compress(uint32_t idx, const char *in, size_t in_len, char *out,
 //   >= 0 : the actual stored size
 //   <0 : not enough space
 int32_t SetRule(uint32_t idx, const char *content, bool append = false) {
+  RulesCompiledFree(idx);
   if (nullptr == content) { content = ""; }   // if nullptr, use empty string
   size_t len_in = strlen(content);
   bool needsCompress = false;
@@ -404,15 +440,138 @@ int32_t SetRule(uint32_t idx, const char *content, bool append = false) {
 
 /*******************************************************************************************/
 
+// Resolve variables in rule_param and return its string and numeric value
+void RulesParamValue(String &rule_param, char *rule_svalue, uint32_t rule_svalue_size, float &rule_value)
+{
+  char stemp[10];
+
+  for (uint32_t i = 0; i < MAX_RULE_VARS; i++) {
+    snprintf_P(stemp, sizeof(stemp), PSTR("%%VAR%d%%"), i +1);
+    if (rule_param.startsWith(stemp)) {
+      rule_param = rules_vars[i];
+      break;
+    }
+  }
+  for (uint32_t i = 0; i < MAX_RULE_MEMS; i++) {
+    snprintf_P(stemp, sizeof(stemp), PSTR("%%MEM%d%%"), i +1);
+    if (rule_param.startsWith(stemp)) {
+      rule_param = SettingsText(SET_MEM1 + i);
+      break;
+    }
+  }
+  if (rule_param.startsWith(F("%TIME%"))) {
+    rule_param = String(MinutesPastMidnight());
+  }
+  if (rule_param.startsWith(F("%UPTIME%"))) {
+    rule_param = String(MinutesUptime());
+  }
+  if (rule_param.startsWith(F("%TIMESTAMP%"))) {
+    rule_param = GetDateAndTime(DT_LOCAL).c_str();
+  }
+#if defined(USE_TIMERS) && defined(USE_SUNRISE)
+  if (rule_param.startsWith(F("%SUNRISE%"))) {
+    rule_param = String(SunMinutes(0));
+  }
+  if (rule_param.startsWith(F("%SUNSET%"))) {
+    rule_param = String(SunMinutes(1));
+  }
+#endif  // USE_TIMERS and USE_SUNRISE
+// #ifdef USE_ZIGBEE
+//     if (rule_param.startsWith(F("%ZBDEVICE%"))) {
+//       snprintf_P(stemp, sizeof(stemp), PSTR("0x%04X"), Z_GetLastDevice());
+//       rule_param = String(stemp);
+//     }
+//     if (rule_param.startsWith(F("%ZBGROUP%"))) {
+//       rule_param = String(Z_GetLastGroup());
+//     }
+//     if (rule_param.startsWith(F("%ZBCLUSTER%"))) {
+//       rule_param = String(Z_GetLastCluster());
+//     }
+//     if (rule_param.startsWith(F("%ZBENDPOINT%"))) {
+//       rule_param = String(Z_GetLastEndpoint());
+//     }
+// #endif
+  rule_param.toUpperCase();
+  strlcpy(rule_svalue, rule_param.c_str(), rule_svalue_size);
+  rule_value = RulesParamNumber(rule_svalue);
+}
+
+float RulesParamNumber(const char *rule_svalue)
+{
+  int temp_value = GetStateNumber(rule_svalue);
+  if (temp_value > -1) {
+    return temp_value;
+  }
+  return CharToFloat((char*)rule_svalue);              // 0.1      - This saves 9k code over toFLoat()!
+}
+
+bool RulesCompareValue(uint8_t rule_set, const char* str_value, int8_t compareOperator, const char* rule_svalue, float rule_value, bool stop_all_rules)
+{
+  bool match = false;
+
+  // Step 3: Compare rule (value)
+  float value = 0;
+  if (str_value) {
+    value = CharToFloat((char*)str_value);
+    int int_value = int(value);
+    int int_rule_value = int(rule_value);
+    switch (compareOperator) {
+      case COMPARE_OPERATOR_EXACT_DIVISION:
+        match = (int_rule_value && (int_value % int_rule_value) == 0);
+        break;
+      case COMPARE_OPERATOR_EQUAL:
+        match = (!strcasecmp(str_value, rule_svalue));  // Compare strings - this also works for hexadecimals
+        break;
+      case COMPARE_OPERATOR_BIGGER:
+        match = (value > rule_value);
+        break;
+      case COMPARE_OPERATOR_SMALLER:
+        match = (value < rule_value);
+        break;
+      case COMPARE_OPERATOR_NUMBER_EQUAL:
+        match = (value == rule_value);
+        break;
+      case COMPARE_OPERATOR_NOT_EQUAL:
+        match = (value != rule_value);
+        break;
+      case COMPARE_OPERATOR_BIGGER_EQUAL:
+        match = (value >= rule_value);
+        break;
+      case COMPARE_OPERATOR_SMALLER_EQUAL:
+        match = (value <= rule_value);
+        break;
+      default:
+        match = true;
+    }
+  } else match = true;
+
+  if (stop_all_rules) { match = false; }
+
+//AddLog_P(LOG_LEVEL_DEBUG, PSTR("RUL-RM4: Match 1 %d, Triggers %08X, TriggerCount %d"), match, Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
+
+  if (bitRead(Settings.rule_once, rule_set)) {
+    if (match) {                                       // Only allow match state changes
+      if (!bitRead(Rules.triggers[rule_set], Rules.trigger_count[rule_set])) {
+        bitSet(Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
+      } else {
+        match = false;
+      }
+    } else {
+      bitClear(Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
+    }
+  }
+
+//AddLog_P(LOG_LEVEL_DEBUG, PSTR("RUL-RM5: Match 2 %d, Triggers %08X, TriggerCount %d"), match, Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
+
+  return match;
+}
+
 bool RulesRuleMatch(uint8_t rule_set, String &event, String &rule, bool stop_all_rules)
 {
   // event = {"INA219":{"Voltage":4.494,"Current":0.020,"Power":0.089}}
   // event = {"System":{"Boot":1}}
   // rule = "INA219#CURRENT>0.100"
 
-  bool match = false;
-  char stemp[10];
-
   // Step1: Analyse rule
   String rule_expr = rule;                             // "TELE-INA219#CURRENT>0.100"
   if (Rules.teleperiod) {
@@ -434,61 +593,7 @@ bool RulesRuleMatch(uint8_t rule_set, String &event, String &rule, bool stop_all
   char rule_svalue[80] = { 0 };
   float rule_value = 0;
   if (compareOperator != COMPARE_OPERATOR_NONE) {
-    for (uint32_t i = 0; i < MAX_RULE_VARS; i++) {
-      snprintf_P(stemp, sizeof(stemp), PSTR("%%VAR%d%%"), i +1);
-      if (rule_param.startsWith(stemp)) {
-        rule_param = rules_vars[i];
-        break;
-      }
-    }
-    for (uint32_t i = 0; i < MAX_RULE_MEMS; i++) {
-      snprintf_P(stemp, sizeof(stemp), PSTR("%%MEM%d%%"), i +1);
-      if (rule_param.startsWith(stemp)) {
-        rule_param = SettingsText(SET_MEM1 + i);
-        break;
-      }
-    }
-    if (rule_param.startsWith(F("%TIME%"))) {
-      rule_param = String(MinutesPastMidnight());
-    }
-    if (rule_param.startsWith(F("%UPTIME%"))) {
-      rule_param = String(MinutesUptime());
-    }
-    if (rule_param.startsWith(F("%TIMESTAMP%"))) {
-      rule_param = GetDateAndTime(DT_LOCAL).c_str();
-    }
-#if defined(USE_TIMERS) && defined(USE_SUNRISE)
-    if (rule_param.startsWith(F("%SUNRISE%"))) {
-      rule_param = String(SunMinutes(0));
-    }
-    if (rule_param.startsWith(F("%SUNSET%"))) {
-      rule_param = String(SunMinutes(1));
-    }
-#endif  // USE_TIMERS and USE_SUNRISE
-// #ifdef USE_ZIGBEE
-//     if (rule_param.startsWith(F("%ZBDEVICE%"))) {
-//       snprintf_P(stemp, sizeof(stemp), PSTR("0x%04X"), Z_GetLastDevice());
-//       rule_param = String(stemp);
-//     }
-//     if (rule_param.startsWith(F("%ZBGROUP%"))) {
-//       rule_param = String(Z_GetLastGroup());
-//     }
-//     if (rule_param.startsWith(F("%ZBCLUSTER%"))) {
-//       rule_param = String(Z_GetLastCluster());
-//     }
-//     if (rule_param.startsWith(F("%ZBENDPOINT%"))) {
-//       rule_param = String(Z_GetLastEndpoint());
-//     }
-// #endif
-    rule_param.toUpperCase();
-    strlcpy(rule_svalue, rule_param.c_str(), sizeof(rule_svalue));
-
-    int temp_value = GetStateNumber(rule_svalue);
-    if (temp_value > -1) {
-      rule_value = temp_value;
-    } else {
-      rule_value = CharToFloat((char*)rule_svalue);    // 0.1      - This saves 9k code over toFLoat()!
-    }
+    RulesParamValue(rule_param, rule_svalue, sizeof(rule_svalue), rule_value);
   }
 
   // Step2: Search rule_name
@@ -547,61 +652,7 @@ bool RulesRuleMatch(uint8_t rule_set, String &event, String &rule, bool stop_all
 
   Rules.event_value = str_value;                       // Prepare %value%
 
-  // Step 3: Compare rule (value)
-  float value = 0;
-  if (str_value) {
-    value = CharToFloat((char*)str_value);
-    int int_value = int(value);
-    int int_rule_value = int(rule_value);
-    switch (compareOperator) {
-      case COMPARE_OPERATOR_EXACT_DIVISION:
-        match = (int_rule_value && (int_value % int_rule_value) == 0);
-        break;
-      case COMPARE_OPERATOR_EQUAL:
-        match = (!strcasecmp(str_value, rule_svalue));  // Compare strings - this also works for hexadecimals
-        break;
-      case COMPARE_OPERATOR_BIGGER:
-        match = (value > rule_value);
-        break;
-      case COMPARE_OPERATOR_SMALLER:
-        match = (value < rule_value);
-        break;
-      case COMPARE_OPERATOR_NUMBER_EQUAL:
-        match = (value == rule_value);
-        break;
-      case COMPARE_OPERATOR_NOT_EQUAL:
-        match = (value != rule_value);
-        break;
-      case COMPARE_OPERATOR_BIGGER_EQUAL:
-        match = (value >= rule_value);
-        break;
-      case COMPARE_OPERATOR_SMALLER_EQUAL:
-        match = (value <= rule_value);
-        break;
-      default:
-        match = true;
-    }
-  } else match = true;
-
-  if (stop_all_rules) { match = false; }
-
-//AddLog_P(LOG_LEVEL_DEBUG, PSTR("RUL-RM4: Match 1 %d, Triggers %08X, TriggerCount %d"), match, Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
-
-  if (bitRead(Settings.rule_once, rule_set)) {
-    if (match) {                                       // Only allow match state changes
-      if (!bitRead(Rules.triggers[rule_set], Rules.trigger_count[rule_set])) {
-        bitSet(Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
-      } else {
-        match = false;
-      }
-    } else {
-      bitClear(Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
-    }
-  }
-
-//AddLog_P(LOG_LEVEL_DEBUG, PSTR("RUL-RM5: Match 2 %d, Triggers %08X, TriggerCount %d"), match, Rules.triggers[rule_set], Rules.trigger_count[rule_set]);
-
-  return match;
+  return RulesCompareValue(rule_set, str_value, compareOperator, rule_svalue, rule_value, stop_all_rules);
 }
 
 /********************************************************************************************/
@@ -664,10 +715,73 @@ void RulesVarReplace(String &commands, const String &sfind, const String &replac
 
 /*******************************************************************************************/
 
+void RulesPrepareCommands(String &commands)
+{
+  commands.trim();
+  String ucommand = commands;
+  ucommand.toUpperCase();
+
+//      if (!ucommand.startsWith("BACKLOG")) { commands = "backlog " + commands; }  // Always use Backlog to prevent power race exception
+  // Use Backlog with event to prevent rule event loop exception unless IF is used which uses an implicit backlog
+  if ((ucommand.indexOf("IF ") == -1) &&
+      (ucommand.indexOf("EVENT ") != -1) &&
+      (ucommand.indexOf("BACKLOG ") == -1)) {
+    commands = "backlog " + commands;
+  }
+}
+
+void RulesExecuteCommands(String &commands, const char* event_trigger)
+{
+  char stemp[10];
+
+  RulesVarReplace(commands, F("%VALUE%"), Rules.event_value);
+  for (uint32_t i = 0; i < MAX_RULE_VARS; i++) {
+    snprintf_P(stemp, sizeof(stemp), PSTR("%%VAR%d%%"), i +1);
+    RulesVarReplace(commands, stemp, rules_vars[i]);
+  }
+  for (uint32_t i = 0; i < MAX_RULE_MEMS; i++) {
+    snprintf_P(stemp, sizeof(stemp), PSTR("%%MEM%d%%"), i +1);
+    RulesVarReplace(commands, stemp, SettingsText(SET_MEM1 +i));
+  }
+  RulesVarReplace(commands, F("%TIME%"), String(MinutesPastMidnight()));
+  RulesVarReplace(commands, F("%UTCTIME%"), String(UtcTime()));
+  RulesVarReplace(commands, F("%UPTIME%"), String(MinutesUptime()));
+  RulesVarReplace(commands, F("%TIMESTAMP%"), GetDateAndTime(DT_LOCAL));
+  RulesVarReplace(commands, F("%TOPIC%"), TasmotaGlobal.mqtt_topic);
+  snprintf_P(stemp, sizeof(stemp), PSTR("%06X"), ESP_getChipId());
+  RulesVarReplace(commands, F("%DEVICEID%"), stemp);
+  String mac_address = WiFi.macAddress();
+  mac_address.replace(":", "");
+  RulesVarReplace(commands, F("%MACADDR%"), mac_address);
+#if defined(USE_TIMERS) && defined(USE_SUNRISE)
+  RulesVarReplace(commands, F("%SUNRISE%"), String(SunMinutes(0)));
+  RulesVarReplace(commands, F("%SUNSET%"), String(SunMinutes(1)));
+#endif  // USE_TIMERS and USE_SUNRISE
+#ifdef USE_ZIGBEE
+  snprintf_P(stemp, sizeof(stemp), PSTR("0x%04X"), Z_GetLastDevice());
+  RulesVarReplace(commands, F("%ZBDEVICE%"), String(stemp));
+  RulesVarReplace(commands, F("%ZBGROUP%"), String(Z_GetLastGroup()));
+  RulesVarReplace(commands, F("%ZBCLUSTER%"), String(Z_GetLastCluster()));
+  RulesVarReplace(commands, F("%ZBENDPOINT%"), String(Z_GetLastEndpoint()));
+#endif
+
+  char command[commands.length() +1];
+  strlcpy(command, commands.c_str(), sizeof(command));
+
+  AddLog_P(LOG_LEVEL_INFO, PSTR("RUL: %s performs \"%s\""), event_trigger, command);
+
+//      Response_P(S_JSON_COMMAND_SVALUE, D_CMND_RULE, D_JSON_INITIATED);
+//      MqttPublishPrefixTopic_P(RESULT_OR_STAT, PSTR(D_CMND_RULE));
+#ifdef SUPPORT_IF_STATEMENT
+  char *pCmd = command;
+  RulesPreprocessCommand(pCmd);                       // Do pre-process for IF statement
+#endif
+  ExecuteCommand(command, SRC_RULE);
+}
+
 bool RuleSetProcess(uint8_t rule_set, String &event_saved)
 {
   bool serviced = false;
-  char stemp[10];
 
   delay(0);                                               // Prohibit possible loop software watchdog
 
@@ -711,66 +825,263 @@ bool RuleSetProcess(uint8_t rule_set, String &event_saved)
     if (RulesRuleMatch(rule_set, event, event_trigger, stop_all_rules)) {
       if (Rules.no_execute) return true;
       if (plen == plen2) { stop_all_rules = true; }       // If BREAK was used on a triggered rule, Stop execution of this rule set
-      commands.trim();
-      String ucommand = commands;
-      ucommand.toUpperCase();
+      RulesPrepareCommands(commands);
+      RulesExecuteCommands(commands, event_trigger.c_str());
+      serviced = true;
+    }
+    plen += 6;
+    Rules.trigger_count[rule_set]++;
+  }
+  return serviced;
+}
 
-//      if (!ucommand.startsWith("BACKLOG")) { commands = "backlog " + commands; }  // Always use Backlog to prevent power race exception
-      // Use Backlog with event to prevent rule event loop exception unless IF is used which uses an implicit backlog
-      if ((ucommand.indexOf("IF ") == -1) &&
-          (ucommand.indexOf("EVENT ") != -1) &&
-          (ucommand.indexOf("BACKLOG ") == -1)) {
-        commands = "backlog " + commands;
+/*******************************************************************************************/
+
+// Hash of a JSON key as matched by JsonParser (case insensitive), 0 is reserved for wildcard ?
+uint16_t RulesKeyHash(const char *key)
+{
+  if (!strcmp_P(key, PSTR("?"))) { return 0; }
+  uint32_t hash = 2166136261;                             // FNV-1a
+  while (*key) {
+    hash ^= (uint8_t)toupper(*key++);
+    hash *= 16777619;
+  }
+  hash = (hash >> 16) ^ (hash & 0xFFFF);
+  return (hash) ? hash : 1;
+}
+
+// Hash of the first JSON level of a trigger expression like "INA219#CURRENT[1]>0.100"
+uint16_t RulesTriggerHash(String &rule_expr)
+{
+  String rule_name, rule_param;
+  parseCompareExpression(rule_expr, rule_name, rule_param);
+  int pos;
+  if ((pos = rule_name.indexOf("[")) > 0) {
+    rule_name = rule_name.substring(0, pos);
+  }
+  if ((pos = rule_name.indexOf("#")) > 0) {
+    rule_name = rule_name.substring(0, pos);
+  }
+  return RulesKeyHash(rule_name.c_str());
+}
+
+// Store zero terminated str in compiled text block (if any) and return its offset
+uint32_t RulesCompileText(char *text, uint32_t &text_size, const char *str)
+{
+  uint32_t offset = text_size;
+  uint32_t len = strlen(str) +1;
+  if (text) { memcpy(text + offset, str, len); }
+  text_size += len;
+  return offset;
+}
+
+void RulesCompiledFree(uint32_t rule_set)
+{
+  if (rule_set >= MAX_RULE_SETS) { return; }
+  bitClear(RulesCompiled.valid, rule_set);
+  if (RulesCompiled.active == (int8_t)rule_set) {
+    bitSet(RulesCompiled.pending, rule_set);              // Still in use, free when rule set has been processed
+    return;
+  }
+  if (RulesCompiled.rule[rule_set]) {
+    free(RulesCompiled.rule[rule_set]);
+    RulesCompiled.rule[rule_set] = nullptr;
+  }
+  RulesCompiled.count[rule_set] = 0;
+}
+
+/*
+ * Compile rule set using the same parsing as RuleSetProcess. The first pass counts rules and
+ * text size, the second pass fills the allocated table.
+ */
+bool RulesCompile(uint32_t rule_set)
+{
+  RulesCompiledFree(rule_set);
+
+  String rules_text = GetRule(rule_set);
+  RuleCompiled *compiled = nullptr;
+  char *text = nullptr;
+  uint32_t count = 0;
+  uint32_t text_size = 0;
+  for (uint32_t pass = 0; pass < 2; pass++) {
+    if (pass) {
+      if (count) {
+        compiled = (RuleCompiled*)malloc(count * sizeof(RuleCompiled) + text_size);
+        if (!compiled) { return false; }
+        memset(compiled, 0, count * sizeof(RuleCompiled));
+        text = (char*)&compiled[count];
+      }
+      count = 0;
+      text_size = 0;
+    }
+
+    String rules = rules_text;
+    int plen = 0;
+    int plen2 = 0;
+    while (true) {
+      rules = rules.substring(plen);                      // Select relative to last rule
+      rules.trim();
+      if (!rules.length()) { break; }                     // No more rules
+
+      String rule = rules;
+      rule.toUpperCase();                                 // "ON INA219#CURRENT>0.100 DO BACKLOG DIMMER 10;COLOR 100000 ENDON"
+      if (!rule.startsWith("ON ")) { break; }             // Bad syntax - Nothing to start on
+
+      int pevt = rule.indexOf(" DO ");
+      if (pevt == -1) { break; }                          // Bad syntax - Nothing to do
+      String event_trigger = rule.substring(3, pevt);     // "INA219#CURRENT>0.100"
+
+      plen = rule.indexOf(" ENDON");
+      plen2 = rule.indexOf(" BREAK");
+      if ((plen == -1) && (plen2 == -1)) { break; }       // Bad syntax - No ENDON neither BREAK
+
+      if (plen == -1) { plen = 9999; }
+      if (plen2 == -1) { plen2 = 9999; }
+      plen = tmin(plen, plen2);
+
+      String commands = rules.substring(pevt +4, plen);   // "Backlog Dimmer 10;Color 100000"
+      RulesPrepareCommands(commands);
+
+      RuleCompiled dummy;
+      RuleCompiled *entry = (compiled) ? &compiled[count] : &dummy;
+      memset(entry, 0, sizeof(RuleCompiled));
+      entry->stop = (plen == plen2);
+      entry->trigger = RulesCompileText(text, text_size, event_trigger.c_str());
+      entry->commands = RulesCompileText(text, text_size, commands.c_str());
+
+      String rule_expr = event_trigger;                   // "TELE-INA219#CURRENT>0.100"
+      if (event_trigger.indexOf("TELE-") != -1) {
+        entry->tele = 1;
+        entry->legacy = !event_trigger.startsWith("TELE-");
+        entry->full_hash = RulesTriggerHash(event_trigger);
+        rule_expr = event_trigger.substring(5);           // "INA219#CURRENT>0.100"
       }
 
-      RulesVarReplace(commands, F("%VALUE%"), Rules.event_value);
-      for (uint32_t i = 0; i < MAX_RULE_VARS; i++) {
-        snprintf_P(stemp, sizeof(stemp), PSTR("%%VAR%d%%"), i +1);
-        RulesVarReplace(commands, stemp, rules_vars[i]);
+      String rule_name, rule_param;
+      entry->compare = parseCompareExpression(rule_expr, rule_name, rule_param);
+      entry->param = RulesCompileText(text, text_size, rule_param.c_str());
+      entry->dynamic = rule_param.startsWith("%");
+
+      int pos;
+      if ((pos = rule_name.indexOf("[")) > 0) {           // "SUBTYPE1#CURRENT[1]"
+        int rule_name_idx = rule_name.substring(pos +1).toInt();
+        if ((rule_name_idx < 1) || (rule_name_idx > 6)) { // Allow indexes 1 to 6
+          rule_name_idx = 1;
+        }
+        entry->name_index = rule_name_idx;
+        rule_name = rule_name.substring(0, pos);          // "SUBTYPE1#CURRENT"
       }
-      for (uint32_t i = 0; i < MAX_RULE_MEMS; i++) {
-        snprintf_P(stemp, sizeof(stemp), PSTR("%%MEM%d%%"), i +1);
-        RulesVarReplace(commands, stemp, SettingsText(SET_MEM1 +i));
+
+      entry->key_hash = RulesTriggerHash(rule_name);
+      entry->name = text_size;
+      while ((pos = rule_name.indexOf("#")) > 0) {        // "SUBTYPE1#SUBTYPE2#CURRENT"
+        RulesCompileText(text, text_size, rule_name.substring(0, pos).c_str());
+        rule_name = rule_name.substring(pos +1);
+        entry->levels++;
+        if (entry->levels > 11) {                         // Never matches as RulesRuleMatch abandons possible loop
+          entry->legacy = 1;
+          break;
+        }
+      }
+      RulesCompileText(text, text_size, rule_name.c_str());
+      if (entry->legacy) {
+        entry->key_hash = 0;                              // Always evaluate
+        entry->full_hash = 0;
       }
-      RulesVarReplace(commands, F("%TIME%"), String(MinutesPastMidnight()));
-      RulesVarReplace(commands, F("%UTCTIME%"), String(UtcTime()));
-      RulesVarReplace(commands, F("%UPTIME%"), String(MinutesUptime()));
-      RulesVarReplace(commands, F("%TIMESTAMP%"), GetDateAndTime(DT_LOCAL));
-      RulesVarReplace(commands, F("%TOPIC%"), TasmotaGlobal.mqtt_topic);
-      snprintf_P(stemp, sizeof(stemp), PSTR("%06X"), ESP_getChipId());
-      RulesVarReplace(commands, F("%DEVICEID%"), stemp);
-      String mac_address = WiFi.macAddress();
-      mac_address.replace(":", "");
-      RulesVarReplace(commands, F("%MACADDR%"), mac_address);
-#if defined(USE_TIMERS) && defined(USE_SUNRISE)
-      RulesVarReplace(commands, F("%SUNRISE%"), String(SunMinutes(0)));
-      RulesVarReplace(commands, F("%SUNSET%"), String(SunMinutes(1)));
-#endif  // USE_TIMERS and USE_SUNRISE
-#ifdef USE_ZIGBEE
-      snprintf_P(stemp, sizeof(stemp), PSTR("0x%04X"), Z_GetLastDevice());
-      RulesVarReplace(commands, F("%ZBDEVICE%"), String(stemp));
-      RulesVarReplace(commands, F("%ZBGROUP%"), String(Z_GetLastGroup()));
-      RulesVarReplace(commands, F("%ZBCLUSTER%"), String(Z_GetLastCluster()));
-      RulesVarReplace(commands, F("%ZBENDPOINT%"), String(Z_GetLastEndpoint()));
-#endif
 
-      char command[commands.length() +1];
-      strlcpy(command, commands.c_str(), sizeof(command));
+      plen += 6;
+      count++;
+    }
+  }
 
-      AddLog_P(LOG_LEVEL_INFO, PSTR("RUL: %s performs \"%s\""), event_trigger.c_str(), command);
+  RulesCompiled.rule[rule_set] = compiled;
+  RulesCompiled.count[rule_set] = count;
+  bitSet(RulesCompiled.valid, rule_set);
+  return true;
+}
 
-//      Response_P(S_JSON_COMMAND_SVALUE, D_CMND_RULE, D_JSON_INITIATED);
-//      MqttPublishPrefixTopic_P(RESULT_OR_STAT, PSTR(D_CMND_RULE));
-#ifdef SUPPORT_IF_STATEMENT
-      char *pCmd = command;
-      RulesPreprocessCommand(pCmd);                       // Do pre-process for IF statement
-#endif
-      ExecuteCommand(command, SRC_RULE);
+bool RulesKeyCandidate(uint16_t hash, uint16_t *keys, uint32_t key_count)
+{
+  if (!hash || !keys) { return true; }                    // Wildcard or too many event keys
+  for (uint32_t i = 0; i < key_count; i++) {
+    if (keys[i] == hash) { return true; }
+  }
+  return false;
+}
+
+bool RulesRuleMatchCompiled(uint8_t rule_set, uint32_t index, JsonParserObject &root, bool stop_all_rules)
+{
+  RuleCompiled *rule = &RulesCompiled.rule[rule_set][index];
+  const char *text = (const char*)&RulesCompiled.rule[rule_set][RulesCompiled.count[rule_set]];
+
+  char rule_svalue[80] = { 0 };
+  float rule_value = 0;
+  if (rule->compare != COMPARE_OPERATOR_NONE) {
+    if (rule->dynamic) {
+      String rule_param = text + rule->param;
+      RulesParamValue(rule_param, rule_svalue, sizeof(rule_svalue), rule_value);
+    } else {
+      strlcpy(rule_svalue, text + rule->param, sizeof(rule_svalue));
+      rule_value = RulesParamNumber(rule_svalue);
+    }
+  }
+
+  JsonParserObject obj = root;
+  const char *rule_name = text + rule->name;
+  for (uint32_t i = 0; i < rule->levels; i++) {
+    obj = obj[rule_name].getObject();
+    if (!obj) { return false; }                           // not found
+    rule_name += strlen(rule_name) +1;
+  }
+
+  JsonParserToken val = obj[rule_name];
+  if (!val) { return false; }                             // last level not found
+  const char* str_value;
+  if (rule->name_index && val.isArray()) {
+    str_value = (val.getArray())[rule->name_index -1].getStr();
+  } else {
+    str_value = val.getStr();                             // "CURRENT"
+  }
+
+  Rules.event_value = str_value;                          // Prepare %value%
+
+  return RulesCompareValue(rule_set, str_value, rule->compare, rule_svalue, rule_value, stop_all_rules);
+}
+
+bool RuleSetProcessCompiled(uint8_t rule_set, String &event_saved, JsonParserObject &root, uint16_t *keys, uint32_t key_count)
+{
+  bool serviced = false;
+
+  delay(0);                                               // Prohibit possible loop software watchdog
+
+  RuleCompiled *rules = RulesCompiled.rule[rule_set];
+  uint32_t count = RulesCompiled.count[rule_set];
+  const char *text = (const char*)&rules[count];
+  bool stop_all_rules = false;
+  for (uint32_t i = 0; i < count; i++) {
+    RuleCompiled *rule = &rules[i];
+    if (Rules.teleperiod && !rule->tele) { continue; }   // No pre-amble in rule
+    bool full_trigger = (rule->tele && !Rules.teleperiod);  // Outside teleperiod TELE- is part of the first level
+    if (!RulesKeyCandidate((full_trigger) ? rule->full_hash : rule->key_hash, keys, key_count)) { continue; }
+
+    Rules.trigger_count[rule_set] = i;
+    Rules.event_value = "";
+    bool match;
+    if (rule->legacy || full_trigger) {
+      String event_trigger = text + rule->trigger;
+      match = RulesRuleMatch(rule_set, event_saved, event_trigger, stop_all_rules);
+    } else {
+      match = RulesRuleMatchCompiled(rule_set, i, root, stop_all_rules);
+    }
+    if (match) {
+      if (Rules.no_execute) { return true; }
+      if (rule->stop) { stop_all_rules = true; }          // If BREAK was used on a triggered rule, Stop execution of this rule set
+      String commands = text + rule->commands;
+      RulesExecuteCommands(commands, text + rule->trigger);
       serviced = true;
     }
-    plen += 6;
-    Rules.trigger_count[rule_set]++;
   }
+  Rules.trigger_count[rule_set] = count;
   return serviced;
 }
 
@@ -803,9 +1114,40 @@ bool RulesProcessEvent(char *json_event)
 
 //AddLog_P(LOG_LEVEL_DEBUG, PSTR("RUL: Event |%s|"), event_saved.c_str());
 
+  // Parse event once and collect its top level keys as trigger index for compiled rules
+  String buf;
+  if (!Settings.flag4.compress_rules_cpu) {               // SetOption94 - Minimize RAM usage for rules
+    buf = event_saved;                                    // copy the string into a new buffer that will be modified
+  }
+  JsonParser parser((char*)buf.c_str());
+  JsonParserObject root = parser.getRootObject();
+  uint16_t key_hashes[RULES_MAX_EVENT_KEYS];
+  uint16_t *keys = key_hashes;
+  uint32_t key_count = 0;
+  if (root) {
+    for (auto key : root) {
+      if (key_count >= RULES_MAX_EVENT_KEYS) {
+        keys = nullptr;                                   // Too many keys, evaluate all rules
+        break;
+      }
+      key_hashes[key_count++] = RulesKeyHash(key.getStr());
+    }
+  }
+
   for (uint32_t i = 0; i < MAX_RULE_SETS; i++) {
     if (GetRuleLen(i) && bitRead(Settings.rule_enabled, i)) {
-      if (RuleSetProcess(i, event_saved)) { serviced = true; }
+      if (root && (bitRead(RulesCompiled.valid, i) || RulesCompile(i))) {
+        RulesCompiled.active = i;
+        if (RuleSetProcessCompiled(i, event_saved, root, keys, key_count)) { serviced = true; }
+        RulesCompiled.active = -1;
+        if (bitRead(RulesCompiled.pending, i)) {          // Rule set changed while being processed
+          bitClear(RulesCompiled.pending, i);
+          RulesCompiledFree(i);
+        }
+      } else {
+        if (Settings.flag4.compress_rules_cpu) { RulesCompiledFree(i); }
+        if (RuleSetProcess(i, event_saved)) { serviced = true; }
+      }
     }
   }
 
@@ -964,7 +1306,7 @@ void RulesEvery100ms(void)
     TasmotaGlobal.tele_period = 2;                                   // Do not allow HA updates during next function call
     XsnsNextCall(FUNC_JSON_APPEND, rules_xsns_index);  // ,"INA219":{"Voltage":4.494,"Current":0.020,"Power":0.089}
     TasmotaGlobal.tele_period = tele_period_save;
-    if (strlen(TasmotaGlobal.mqtt_data)) {
+    if (ResponseLength()) {
       TasmotaGlobal.mqtt_data[0] = '{';                              // {"INA219":{"Voltage":4.494,"Current":0.020,"Power":0.089}
       ResponseJsonEnd();
       RulesProcessEvent(TasmotaGlobal.mqtt_data);
@@ -2113,7 +2455,7 @@ void CmndRule(void)
     // snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"%s%d\":\"%s\",\"Once\":\"%s\",\"StopOnError\":\"%s\",\"Free\":%d,\"Rules\":\"%s\"}"),
     //   XdrvMailbox.command, index, GetStateText(bitRead(Settings.rule_enabled, index -1)), GetStateText(bitRead(Settings.rule_once, index -1)),
     //   GetStateText(bitRead(Settings.rule_stop, index -1)), sizeof(Settings.rules[index -1]) - strlen(Settings.rules[index -1]) -1, Settings.rules[index -1]);
-    snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"%s%d\":\"%s\",\"Once\":\"%s\",\"StopOnError\":\"%s\",\"Length\":%d,\"Free\":%d,\"Rules\":\"%s\"}"),
+    Response_P(PSTR("{\"%s%d\":\"%s\",\"Once\":\"%s\",\"StopOnError\":\"%s\",\"Length\":%d,\"Free\":%d,\"Rules\":\"%s\"}"),
       XdrvMailbox.command, index, GetStateText(bitRead(Settings.rule_enabled, index -1)), GetStateText(bitRead(Settings.rule_once, index -1)),
       GetStateText(bitRead(Settings.rule_stop, index -1)),
       rule_len, MAX_RULE_SIZE - GetRuleLenStorage(index - 1),
@@ -39,6 +39,7 @@ keywords if then else endif, or, and are better readable for beginners (others m
 \*********************************************************************************************/
 
 #define XDRV_10             10
+#define XDRV_10_FUNCS       (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_100_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_37             37  // See I2CDEVICES.md
 
 #define SCRIPT_DEBUG 0
@@ -67,6 +68,18 @@ keywords if then else endif, or, and are better readable for beginners (others m
 
 #define MAX_SARRAY_NUM 32
 
+#ifndef SCRIPT_VAR_CACHE
+#define SCRIPT_VAR_CACHE 32   // cached variable lookups by script position, 0 disables
+#endif
+
+#ifndef SCRIPT_COMPILE
+#ifdef ESP32
+#define SCRIPT_COMPILE 8192   // max bytes of section code compiled at init, 0 disables
+#else
+#define SCRIPT_COMPILE 2048
+#endif
+#endif
+
 //uint32_t EncodeLightId(uint8_t relay_id);
 //uint32_t DecodeLightId(uint32_t hue_id);
 
@@ -368,6 +381,23 @@ struct M_FILT {
   float rbuff[1];
 };
 
+struct V_CACHE {
+  char *pos;      // script position of variable name
+  uint8_t index;  // variable index or VAR_NV if no script variable
+};
+
+// compiled section code, see Script_CompileSections
+enum {SOP_CONST=1,SOP_VAR,SOP_NVAR,SOP_SYS,SOP_CALC,SOP_CMP,SOP_LOGIC,SOP_STORE,SOP_JMP,SOP_JZ,SOP_FORV,SOP_FOR,SOP_NEXT,SOP_SWITCH,SOP_CASE,SOP_CMD,SOP_SUB,SOP_END};
+
+union S_OP {
+  struct {
+    uint8_t op;     // SOP_xxx
+    uint8_t arg;    // operator, number variable or system variable index
+    uint16_t data;  // jump target, variable type index or script offset
+  };
+  float value;      // constant following SOP_CONST
+};
+
 
 #ifdef LARGE_ARRAYS
 #undef AND_FILT_MASK
@@ -443,6 +473,11 @@ struct SCRIPT_MEM {
     char *scriptptr;
     char *section_ptr;
     char *scriptptr_bu;
+    uint16_t *sections; // offsets of section lines from scriptptr_bu
+    uint16_t numsections;
+    struct V_CACHE *var_cache;
+    union S_OP **code; // compiled code of sections, 0 if interpreted
+    uint8_t code_gen;
     char *script_ram;
     uint16_t script_size;
     uint8_t *script_pram;
@@ -602,6 +637,7 @@ char *script;
 
     glob_script_mem.max_ssize = SCRIPT_SVARSIZE;
     glob_script_mem.scriptptr = 0;
+    Script_FreeIndex();
 
     if (!*script) return -999;
 
@@ -977,6 +1013,7 @@ char *script;
     // store start of actual program here
     glob_script_mem.scriptptr = lp - 1;
     glob_script_mem.scriptptr_bu = glob_script_mem.scriptptr;
+    Script_IndexSections();
 
 #ifdef USE_SCRIPT_GLOBVARS
     if (glob_script_mem.udp_flags.udp_used) {
@@ -989,6 +1026,723 @@ char *script;
 
 }
 
+// index all section and subroutine lines once, walking the lines exactly like Run_script_sub
+// does, so section lookup jumps from header to header instead of parsing every line
+void Script_IndexSections(void) {
+  Script_FreeIndex();
+  for (uint32_t pass = 0; pass<2; pass++) {
+    uint16_t num = 0;
+    char *lp = glob_script_mem.scriptptr;
+    while (1) {
+      SCRIPT_SKIP_SPACES
+      SCRIPT_SKIP_EOL
+      if (!*lp) break;
+      if (*lp=='>' || *lp=='#') {
+        if (pass) glob_script_mem.sections[num] = lp - glob_script_mem.scriptptr_bu;
+        num++;
+      }
+      if (*lp==SCRIPT_EOL) {
+        lp++;
+      } else {
+        lp = strchr(lp, SCRIPT_EOL);
+        if (!lp) break;
+        lp++;
+      }
+    }
+    if (!pass) {
+      if (!num) break;
+      glob_script_mem.sections = (uint16_t*)malloc(num * sizeof(uint16_t));
+      if (!glob_script_mem.sections) break;
+    } else {
+      glob_script_mem.numsections = num;
+    }
+  }
+#if SCRIPT_VAR_CACHE>0
+  glob_script_mem.var_cache = (struct V_CACHE*)calloc(SCRIPT_VAR_CACHE, sizeof(struct V_CACHE));
+#endif //SCRIPT_VAR_CACHE
+#if SCRIPT_COMPILE>0
+  Script_CompileSections();
+#endif //SCRIPT_COMPILE
+}
+
+void Script_FreeIndex(void) {
+  if (glob_script_mem.sections) {
+    free(glob_script_mem.sections);
+    glob_script_mem.sections = 0;
+  }
+#if SCRIPT_COMPILE>0
+  if (glob_script_mem.code) {
+    for (uint32_t sect = 0; sect<glob_script_mem.numsections; sect++) {
+      if (glob_script_mem.code[sect]) free(glob_script_mem.code[sect]);
+    }
+    free(glob_script_mem.code);
+    glob_script_mem.code = 0;
+    // stops a running section
+    glob_script_mem.code_gen++;
+  }
+#endif //SCRIPT_COMPILE
+  glob_script_mem.numsections = 0;
+  if (glob_script_mem.var_cache) {
+    free(glob_script_mem.var_cache);
+    glob_script_mem.var_cache = 0;
+  }
+}
+
+#if SCRIPT_COMPILE>0
+// sections using only numeric variables, constants, time variables, if/then/else, for/next,
+// switch/case, commands and subroutine calls are compiled once to a small stack code, any
+// other section stays interpreted. The code mirrors Run_script_sub line by line, so a
+// compiled section behaves exactly like the interpreted one.
+#define SCRIPT_VM_STACK 16
+#define SCRIPT_CODE_NEST 6
+#define SCRIPT_CODE_SYSVAR 1  // section reads system variables, json names take precedence
+
+const char kScriptSysVars[] PROGMEM = "upsecs|uptime|time|hours|mins|secs|day|wday|month|year";
+// line keywords of Run_script_sub, names starting with these are never compiled
+const char kScriptKeywords[] PROGMEM = "if|then|else|endif|or|and|for|next|switch|case|ends|break|dp|dt|delay|spin|svars|gvr|ws2812|beep|pwm|wcs|print";
+
+struct S_BLOCK {
+  uint8_t type;    // SOP_JZ if, SOP_FOR for, SOP_SWITCH switch
+  uint8_t state;   // if state 1 condition, 2 then, 3 else, for number variable index
+  uint16_t patch;  // jump to patch at the end of the block part, 0 none
+  uint16_t start;  // start of for loop body
+};
+
+struct S_COMPILE {
+  union S_OP *code;
+  uint16_t len;
+  uint16_t size;
+  uint8_t sp;
+  uint8_t flags;
+  uint8_t nest;
+  struct S_BLOCK block[SCRIPT_CODE_NEST];
+};
+
+bool Script_Emit(struct S_COMPILE *sc, uint8_t op, uint8_t arg, uint16_t data) {
+  if (sc->len>=sc->size) return false;
+  union S_OP *cp = &sc->code[sc->len++];
+  cp->op = op;
+  cp->arg = arg;
+  cp->data = data;
+  switch (op) {
+    case SOP_CONST:
+    case SOP_VAR:
+    case SOP_NVAR:
+    case SOP_SYS:
+      if (++sc->sp>SCRIPT_VM_STACK) return false;
+      break;
+    case SOP_CALC:
+    case SOP_CMP:
+    case SOP_LOGIC:
+    case SOP_STORE:
+    case SOP_JZ:
+    case SOP_FORV:
+    case SOP_SWITCH:
+    case SOP_CASE:
+      sc->sp--;
+      break;
+    case SOP_FOR:
+      sc->sp -= 2;
+      break;
+  }
+  return true;
+}
+
+bool Script_EmitConst(struct S_COMPILE *sc, float value) {
+  if (!Script_Emit(sc, SOP_CONST, 0, 0) || sc->len>=sc->size) return false;
+  sc->code[sc->len++].value = value;
+  return true;
+}
+
+// rest of line is empty
+bool Script_Blank(char *lp) {
+  while (*lp==' ' || *lp=='\t' || *lp=='\r') lp++;
+  return (!*lp || *lp==SCRIPT_EOL);
+}
+
+// variable name like isvar, returns 0 if empty, too long, indexed or a line keyword
+uint32_t Script_CompileName(char *lp, char *vname) {
+  const char *term = "\n\r ])=+-/*%><!^&|}{";
+  uint32_t len = 0;
+  while (lp[len] && !strchr(term, lp[len])) {
+    if (len>=31 || lp[len]=='[') return 0;
+    vname[len] = lp[len];
+    len++;
+  }
+  vname[len] = 0;
+  if (!len) return 0;
+  char kw[8];
+  for (uint32_t count = 0; *GetTextIndexed(kw, sizeof(kw), count, kScriptKeywords); count++) {
+    if (!strncmp(vname, kw, strlen(kw))) return 0;
+  }
+  return len;
+}
+
+// plain number variable index, VAR_NV if not found or not compileable
+uint8_t Script_CompileVar(char *lp, char *vname, uint32_t len) {
+  uint32_t count = Script_FindVar(lp, vname, len);
+  if (count>=glob_script_mem.numvars) return VAR_NV;
+  struct T_INDEX *vtp = &glob_script_mem.type[count];
+  if (vtp->bits.is_string || vtp->bits.is_filter) return VAR_NV;
+#ifdef USE_SCRIPT_GLOBVARS
+  if (vtp->bits.global) return VAR_NV;
+#endif
+  return count;
+}
+
+char *Script_CompileExpr(struct S_COMPILE *sc, char *lp);
+
+// one operand of GetNumericArgument
+char *Script_CompileOperand(struct S_COMPILE *sc, char *lp) {
+  if (*lp=='(') {
+    lp = Script_CompileExpr(sc, lp + 1);
+    if (!lp || *lp!=')') return 0;
+    return lp + 1;
+  }
+  if (isdigit(*lp) || (*lp=='-' && isdigit(*(lp+1))) || *lp=='.') {
+    if (*lp=='0' && *(lp+1)=='x') return 0;
+    if (!Script_EmitConst(sc, CharToFloat(lp))) return 0;
+    if (*lp=='-') lp++;
+    while (isdigit(*lp) || *lp=='.') lp++;
+    return lp;
+  }
+  uint8_t nres = 0;
+  if (*lp=='-') {
+    nres = 1;
+    lp++;
+  }
+  char vname[32];
+  uint32_t len = Script_CompileName(lp, vname);
+  if (!len) return 0;
+  uint8_t index = Script_CompileVar(lp, vname, len);
+  if (index!=VAR_NV) {
+    if (!Script_Emit(sc, nres ? SOP_NVAR : SOP_VAR, glob_script_mem.type[index].index, 0)) return 0;
+    return lp + len;
+  }
+  // system variables are not inverted by isvar
+  if (nres) return 0;
+  char sysvar[8];
+  int32_t sys = GetCommandCode(sysvar, sizeof(sysvar), vname, kScriptSysVars);
+  if (sys<0 || strcmp(sysvar, vname)) return 0;
+  sc->flags |= SCRIPT_CODE_SYSVAR;
+  if (!Script_Emit(sc, SOP_SYS, sys, 0)) return 0;
+  return lp + len;
+}
+
+// numeric expression like GetNumericArgument, strictly left to right
+char *Script_CompileExpr(struct S_COMPILE *sc, char *lp) {
+  uint8_t lastop = 0,operand;
+  while (1) {
+    lp = Script_CompileOperand(sc, lp);
+    if (!lp) return 0;
+    if (lastop && !Script_Emit(sc, SOP_CALC, lastop, 0)) return 0;
+    char *slp = lp;
+    lp = getop(lp, &operand);
+    switch (operand) {
+      case 0:
+      case OPER_EQUEQU:
+      case OPER_NOTEQU:
+      case OPER_LOW:
+      case OPER_LOWEQU:
+      case OPER_GRT:
+      case OPER_GRTEQU:
+        return slp;
+      case OPER_PLS:
+      case OPER_MIN:
+      case OPER_MUL:
+      case OPER_DIV:
+      case OPER_PERC:
+      case OPER_XOR:
+      case OPER_AND:
+      case OPER_OR:
+        lastop = operand;
+        break;
+      default:
+        return 0;
+    }
+  }
+}
+
+// numeric condition like Evaluate_expression, leaves 0 or 1 on the stack
+char *Script_CompileCond(struct S_COMPILE *sc, char *lp) {
+  SCRIPT_SKIP_SPACES
+  if (*lp=='(') {
+    uint8_t xand_or = 0;
+    lp++;
+    while (1) {
+      SCRIPT_SKIP_SPACES
+      lp = Script_CompileCond(sc, lp);
+      if (!lp) return 0;
+      if (xand_or && !Script_Emit(sc, SOP_LOGIC, xand_or, 0)) return 0;
+      if (*lp==')') return lp + 1;
+      SCRIPT_SKIP_SPACES
+      if (!strncmp(lp, "or", 2)) {
+        lp += 2;
+        xand_or = 1;
+      } else if (!strncmp(lp, "and", 3)) {
+        lp += 3;
+        xand_or = 2;
+      } else {
+        return 0;
+      }
+    }
+  }
+  lp = Script_CompileExpr(sc, lp);
+  if (!lp) return 0;
+  uint8_t lastop;
+  lp = getop(lp, &lastop);
+  if (lastop<OPER_EQUEQU || lastop>OPER_LOW) return 0;
+  lp = Script_CompileExpr(sc, lp);
+  if (!lp || !Script_Emit(sc, SOP_CMP, lastop, 0)) return 0;
+  return lp;
+}
+
+// command, subroutine call or numeric assignment
+bool Script_CompileStatement(struct S_COMPILE *sc, char *lp) {
+  uint16_t pos = lp - glob_script_mem.scriptptr_bu;
+  if (!strncmp(lp,"=>",2) || !strncmp(lp,"->",2) || !strncmp(lp,"+>",2) || !strncmp(lp,"print",5)) {
+    return Script_Emit(sc, SOP_CMD, 0, pos);
+  }
+  if (!strncmp(lp, "=#", 2)) {
+    return Script_Emit(sc, SOP_SUB, 0, pos);
+  }
+  char vname[32];
+  uint32_t len = Script_CompileName(lp, vname);
+  if (!len) return false;
+  uint8_t index = Script_CompileVar(lp, vname, len);
+  if (index==VAR_NV) return false;
+  uint8_t lastop;
+  lp = getop(lp + len, &lastop);
+  switch (lastop) {
+    case OPER_EQU:
+    case OPER_PLSEQU:
+    case OPER_MINEQU:
+    case OPER_MULEQU:
+    case OPER_DIVEQU:
+    case OPER_PERCEQU:
+    case OPER_ANDEQU:
+    case OPER_OREQU:
+    case OPER_XOREQU:
+      break;
+    default:
+      return false;
+  }
+  // rest of line is ignored like in Run_script_sub
+  if (!Script_CompileExpr(sc, lp)) return false;
+  return Script_Emit(sc, SOP_STORE, lastop, index);
+}
+
+// text after then or else
+bool Script_CompileRest(struct S_COMPILE *sc, char *lp) {
+  if (*lp!=' ' && *lp!='\t' && !Script_Blank(lp)) return false;
+  SCRIPT_SKIP_SPACES
+  if (*lp=='{') return Script_Blank(lp + 1);
+  if (Script_Blank(lp)) return true;
+  return Script_CompileStatement(sc, lp);
+}
+
+bool Script_CompileThen(struct S_COMPILE *sc, struct S_BLOCK *bp) {
+  bp->state = 2;
+  bp->patch = sc->len;
+  return Script_Emit(sc, SOP_JZ, 0, 0);
+}
+
+bool Script_CompileElse(struct S_COMPILE *sc, struct S_BLOCK *bp) {
+  uint16_t jz = bp->patch;
+  bp->state = 3;
+  bp->patch = sc->len;
+  if (!Script_Emit(sc, SOP_JMP, 0, 0)) return false;
+  sc->code[jz].data = sc->len;
+  return true;
+}
+
+void Script_CompileEndif(struct S_COMPILE *sc) {
+  sc->code[sc->block[--sc->nest].patch].data = sc->len;
+}
+
+// condition of if, or and and lines
+bool Script_CompileCondLine(struct S_COMPILE *sc, struct S_BLOCK *bp, char *lp, uint8_t and_or) {
+  if (*lp!=' ' && *lp!='\t' && *lp!='(') return false;
+  SCRIPT_SKIP_SPACES
+  if (Script_Blank(lp)) return false;
+  lp = Script_CompileCond(sc, lp);
+  if (!lp) return false;
+  if (and_or && !Script_Emit(sc, SOP_LOGIC, and_or, 0)) return false;
+  SCRIPT_SKIP_SPACES
+  if (*lp=='{') {
+    // a { on the condition line is not seen in a skipped case part, keep those interpreted
+    for (uint32_t count = 0; count<sc->nest; count++) {
+      if (sc->block[count].type==SOP_SWITCH) return false;
+    }
+    return Script_CompileThen(sc, bp);
+  }
+  return true;
+}
+
+bool Script_CompileLine(struct S_COMPILE *sc, char *lp) {
+  struct S_BLOCK *bp = sc->nest ? &sc->block[sc->nest - 1] : 0;
+  uint8_t state = (bp && bp->type==SOP_JZ) ? bp->state : 0;
+
+  if (!strncmp(lp, "if", 2)) {
+    if (state==1 || sc->nest>=SCRIPT_CODE_NEST) return false;
+    bp = &sc->block[sc->nest++];
+    bp->type = SOP_JZ;
+    bp->state = 1;
+    return Script_CompileCondLine(sc, bp, lp + 2, 0);
+  }
+  if (!strncmp(lp, "then", 4) && state==1) {
+    return Script_CompileThen(sc, bp) && Script_CompileRest(sc, lp + 4);
+  }
+  if (!strncmp(lp, "else", 4) && state==2) {
+    lp += 4;
+    if (*lp=='{') lp++;
+    return Script_CompileElse(sc, bp) && Script_CompileRest(sc, lp);
+  }
+  if (!strncmp(lp, "endif", 5) && state>=2) {
+    Script_CompileEndif(sc);
+    return true;
+  }
+  if (!strncmp(lp, "or", 2) && state==1) {
+    return Script_CompileCondLine(sc, bp, lp + 2, 1);
+  }
+  if (!strncmp(lp, "and", 3) && state==1) {
+    return Script_CompileCondLine(sc, bp, lp + 3, 2);
+  }
+  if (state==1) return false;
+  if (*lp=='}' && state>=2) {
+    // same else search as Run_script_sub, else must be on this line
+    char *eol = strchr(lp, SCRIPT_EOL);
+    lp++;
+    for (uint8_t count = 0; count<8; count++) {
+      if (!*lp || *lp=='}') break;
+      if (!strncmp(lp, "else", 4)) {
+        if (eol && lp>eol) return false;
+        if (state==3) return false;
+        if (!Script_CompileElse(sc, bp)) return false;
+        lp += 4;
+        SCRIPT_SKIP_SPACES
+        if (*lp=='{') lp++;
+        SCRIPT_SKIP_SPACES
+        if (Script_Blank(lp)) return true;
+        return Script_CompileStatement(sc, lp);
+      }
+      lp++;
+    }
+    Script_CompileEndif(sc);
+    return true;
+  }
+
+  if (!strncmp(lp, "for", 3)) {
+    // for is evaluated even in skipped if or case parts, only compile it outside
+    if (sc->nest || (lp[3]!=' ' && lp[3]!='\t')) return false;
+    lp += 3;
+    SCRIPT_SKIP_SPACES
+    char vname[32];
+    uint32_t len = Script_CompileName(lp, vname);
+    if (!len) return false;
+    uint8_t index = Script_CompileVar(lp, vname, len);
+    if (index==VAR_NV) return false;
+    index = glob_script_mem.type[index].index;
+    lp += len;
+    SCRIPT_SKIP_SPACES
+    lp = Script_CompileExpr(sc, lp);
+    if (!lp || !Script_Emit(sc, SOP_FORV, index, 0)) return false;
+    SCRIPT_SKIP_SPACES
+    lp = Script_CompileExpr(sc, lp);
+    if (!lp) return false;
+    SCRIPT_SKIP_SPACES
+    lp = Script_CompileExpr(sc, lp);
+    if (!lp || !Script_Blank(lp) || !Script_Emit(sc, SOP_FOR, 0, 0)) return false;
+    bp = &sc->block[sc->nest++];
+    bp->type = SOP_FOR;
+    bp->state = index;
+    bp->start = sc->len;
+    return true;
+  }
+  if (!strncmp(lp, "next", 4) && bp && bp->type==SOP_FOR) {
+    if (!Script_Blank(lp + 4)) return false;
+    sc->nest--;
+    return Script_Emit(sc, SOP_NEXT, bp->state, bp->start);
+  }
+  if (!strncmp(lp, "switch", 6)) {
+    if (sc->nest>=SCRIPT_CODE_NEST || (lp[6]!=' ' && lp[6]!='\t')) return false;
+    for (uint32_t count = 0; count<sc->nest; count++) {
+      if (sc->block[count].type==SOP_SWITCH) return false;
+    }
+    lp += 6;
+    SCRIPT_SKIP_SPACES
+    lp = Script_CompileExpr(sc, lp);
+    if (!lp || !Script_Blank(lp) || !Script_Emit(sc, SOP_SWITCH, 0, 0)) return false;
+    bp = &sc->block[sc->nest++];
+    bp->type = SOP_SWITCH;
+    bp->patch = 0;
+    return true;
+  }
+  if (!strncmp(lp, "case", 4) && bp && bp->type==SOP_SWITCH) {
+    // a failing case jumps to the next case or ends
+    if (bp->patch) sc->code[bp->patch].data = sc->len;
+    lp += 4;
+    SCRIPT_SKIP_SPACES
+    lp = Script_CompileExpr(sc, lp);
+    if (!lp || !Script_Blank(lp)) return false;
+    bp->patch = sc->len;
+    return Script_Emit(sc, SOP_CASE, 0, 0);
+  }
+  if (!strncmp(lp, "ends", 4) && bp && bp->type==SOP_SWITCH) {
+    if (!Script_Blank(lp + 4)) return false;
+    if (bp->patch) sc->code[bp->patch].data = sc->len;
+    sc->nest--;
+    return true;
+  }
+  if (*lp=='\r' && Script_Blank(lp)) return true;
+  return Script_CompileStatement(sc, lp);
+}
+
+void Script_CompileSections(void) {
+  if (!glob_script_mem.numsections) return;
+  glob_script_mem.code = (union S_OP**)calloc(glob_script_mem.numsections, sizeof(union S_OP*));
+  if (!glob_script_mem.code) return;
+  struct S_COMPILE sc;
+  sc.size = SCRIPT_COMPILE / sizeof(union S_OP);
+  sc.code = (union S_OP*)malloc(SCRIPT_COMPILE);
+  if (!sc.code) return;
+
+  // a walk through the last section ends at the end of the text like in Run_script_sub
+  char *base = glob_script_mem.scriptptr_bu;
+  char *eol = strrchr(base, SCRIPT_EOL);
+  int16_t retval = (eol && Script_Blank(eol + 1) && !strchr(eol + 1, '\r')) ? -1 : 0;
+
+  uint32_t total = 0;
+  for (uint32_t sect = 0; sect<glob_script_mem.numsections; sect++) {
+    char *lp = strchr(base + glob_script_mem.sections[sect], SCRIPT_EOL);
+    char *end = (sect + 1<glob_script_mem.numsections) ? base + glob_script_mem.sections[sect + 1] : base + strlen(base);
+    sc.len = 1;
+    sc.sp = 0;
+    sc.flags = 0;
+    sc.nest = 0;
+    bool ok = true;
+    while (lp && lp<end) {
+      lp++;
+      SCRIPT_SKIP_SPACES
+      if (lp>=end) break;
+      if (*lp!=SCRIPT_EOL && *lp!=';') {
+        ok = Script_CompileLine(&sc, lp);
+        if (!ok) break;
+      }
+      lp = strchr(lp, SCRIPT_EOL);
+    }
+    if (!ok || sc.nest || !Script_Emit(&sc, SOP_END, 0, (sect + 1<glob_script_mem.numsections) ? 0 : retval)) continue;
+    uint32_t size = sc.len * sizeof(union S_OP);
+    if (total + size>SCRIPT_COMPILE) continue;
+    union S_OP *code = (union S_OP*)malloc(size);
+    if (!code) continue;
+    sc.code[0].op = 0;
+    sc.code[0].arg = sc.flags;
+    sc.code[0].data = sc.len;
+    memcpy(code, sc.code, size);
+    glob_script_mem.code[sect] = code;
+    total += size;
+  }
+  free(sc.code);
+}
+
+// run compiled section, returns like Run_script_sub
+int16_t Script_RunCode(union S_OP *code) {
+  float stack[SCRIPT_VM_STACK];
+  float *sp = stack;
+  float swvar = 0,cv_max = 0,cv_inc = 0;
+  uint8_t floop = 0;
+  uint8_t code_gen = glob_script_mem.code_gen;
+  union S_OP *op = code + 1;
+
+  while (1) {
+    switch (op->op) {
+      case SOP_CONST:
+        op++;
+        *sp++ = op->value;
+        break;
+      case SOP_VAR:
+        *sp++ = glob_script_mem.fvars[op->arg];
+        break;
+      case SOP_NVAR:
+        *sp++ = -glob_script_mem.fvars[op->arg];
+        break;
+      case SOP_SYS:
+        switch (op->arg) {
+          case 0: *sp = TasmotaGlobal.uptime; break;
+          case 1: *sp = MinutesUptime(); break;
+          case 2: *sp = MinutesPastMidnight(); break;
+          case 3: *sp = RtcTime.hour; break;
+          case 4: *sp = RtcTime.minute; break;
+          case 5: *sp = RtcTime.second; break;
+          case 6: *sp = RtcTime.day_of_month; break;
+          case 7: *sp = RtcTime.day_of_week; break;
+          case 8: *sp = RtcTime.month; break;
+          default: *sp = RtcTime.year; break;
+        }
+        sp++;
+        break;
+      case SOP_CALC: {
+        float fvar1 = *--sp;
+        float *fvar = sp - 1;
+        switch (op->arg) {
+          case OPER_PLS:
+            *fvar += fvar1;
+            break;
+          case OPER_MIN:
+            *fvar -= fvar1;
+            break;
+          case OPER_MUL:
+            *fvar *= fvar1;
+            break;
+          case OPER_DIV:
+            *fvar /= fvar1;
+            break;
+          case OPER_PERC:
+            *fvar = fmodf(*fvar, fvar1);
+            break;
+          case OPER_XOR:
+            *fvar = (uint32_t)*fvar ^ (uint32_t)fvar1;
+            break;
+          case OPER_AND:
+            *fvar = (uint32_t)*fvar & (uint32_t)fvar1;
+            break;
+          case OPER_OR:
+            *fvar = (uint32_t)*fvar | (uint32_t)fvar1;
+            break;
+        }
+        break;
+      }
+      case SOP_CMP: {
+        float fvar1 = *--sp;
+        float fvar = sp[-1];
+        uint8_t res = 0;
+        switch (op->arg) {
+          case OPER_EQUEQU:
+            res = (fvar==fvar1);
+            break;
+          case OPER_NOTEQU:
+            res = (fvar!=fvar1);
+            break;
+          case OPER_LOW:
+            res = (fvar<fvar1);
+            break;
+          case OPER_LOWEQU:
+            res = (fvar<=fvar1);
+            break;
+          case OPER_GRT:
+            res = (fvar>fvar1);
+            break;
+          case OPER_GRTEQU:
+            res = (fvar>=fvar1);
+            break;
+        }
+        sp[-1] = res;
+        break;
+      }
+      case SOP_LOGIC: {
+        uint8_t res = *--sp;
+        uint8_t result = sp[-1];
+        if (op->arg==1) {
+          result |= res;
+        } else {
+          result &= res;
+        }
+        sp[-1] = result;
+        break;
+      }
+      case SOP_STORE: {
+        float fvar = *--sp;
+        struct T_INDEX *vtp = &glob_script_mem.type[op->data];
+        float *dfvar = &glob_script_mem.fvars[vtp->index];
+        switch (op->arg) {
+          case OPER_EQU:
+            *dfvar = fvar;
+            break;
+          case OPER_PLSEQU:
+            *dfvar += fvar;
+            break;
+          case OPER_MINEQU:
+            *dfvar -= fvar;
+            break;
+          case OPER_MULEQU:
+            *dfvar *= fvar;
+            break;
+          case OPER_DIVEQU:
+            *dfvar /= fvar;
+            break;
+          case OPER_PERCEQU:
+            *dfvar = fmodf(*dfvar, fvar);
+            break;
+          case OPER_ANDEQU:
+            *dfvar = (uint32_t)*dfvar & (uint32_t)fvar;
+            break;
+          case OPER_OREQU:
+            *dfvar = (uint32_t)*dfvar | (uint32_t)fvar;
+            break;
+          case OPER_XOREQU:
+            *dfvar = (uint32_t)*dfvar ^ (uint32_t)fvar;
+            break;
+        }
+        // var was changed
+        vtp->bits.changed = 1;
+        glob_script_mem.glob_error = 0;
+        break;
+      }
+      case SOP_JMP:
+        op = code + op->data;
+        continue;
+      case SOP_JZ:
+        if (!(uint8_t)*--sp) {
+          op = code + op->data;
+          continue;
+        }
+        break;
+      case SOP_FORV:
+        glob_script_mem.fvars[op->arg] = *--sp;
+        break;
+      case SOP_FOR:
+        sp -= 2;
+        cv_max = sp[0];
+        cv_inc = sp[1];
+        floop = (cv_inc>0) ? 1 : 2;
+        break;
+      case SOP_NEXT: {
+        float *cv_count = &glob_script_mem.fvars[op->arg];
+        *cv_count += cv_inc;
+        if ((floop==1) ? (*cv_count<=cv_max) : (*cv_count>=cv_max)) {
+          op = code + op->data;
+          continue;
+        }
+        break;
+      }
+      case SOP_SWITCH:
+        swvar = *--sp;
+        break;
+      case SOP_CASE:
+        if (swvar!=*--sp) {
+          op = code + op->data;
+          continue;
+        }
+        break;
+      case SOP_CMD:
+      case SOP_SUB:
+        if (op->op==SOP_CMD) {
+          Script_Command(glob_script_mem.scriptptr_bu + op->data);
+        } else {
+          scripter_sub(glob_script_mem.scriptptr_bu + op->data, 0);
+        }
+        // script was stopped or loaded again by the command
+        if (code_gen!=glob_script_mem.code_gen) return 0;
+        break;
+      default:
+        return (int16_t)op->data;
+    }
+    op++;
+  }
+}
+#endif //SCRIPT_COMPILE
+
 #ifdef USE_SCRIPT_FATFS
 uint32_t get_fsinfo(uint32_t sel) {
 uint32_t result = 0;
@@ -1583,6 +2337,33 @@ float fvar;
 
 // vtype => ff=nothing found, fe=constant number,fd = constant string else bit 7 => 80 = string, 0 = number
 // no flash strings here for performance reasons!!!
+// find script variable by name, lookups from script text are cached by position as the
+// name at a given position never changes until the script is initialized again
+uint32_t Script_FindVar(char *lp, char *dvnam, uint8_t olen) {
+  struct V_CACHE *vcp = 0;
+#if SCRIPT_VAR_CACHE>0
+  if (glob_script_mem.var_cache && lp>=glob_script_mem.script_ram && lp<glob_script_mem.script_ram + glob_script_mem.script_size) {
+    vcp = &glob_script_mem.var_cache[(uint32_t)(lp - glob_script_mem.script_ram) % SCRIPT_VAR_CACHE];
+    if (vcp->pos==lp) {
+      return (vcp->index==VAR_NV) ? glob_script_mem.numvars : vcp->index;
+    }
+  }
+#endif //SCRIPT_VAR_CACHE
+  uint32_t count;
+  for (count = 0; count<glob_script_mem.numvars; count++) {
+    char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
+    uint8_t slen = strlen(cp);
+    if (slen==olen && *cp==dvnam[0]) {
+      if (!strncmp(cp, dvnam, olen)) break;
+    }
+  }
+  if (vcp) {
+    vcp->pos = lp;
+    vcp->index = (count<glob_script_mem.numvars) ? count : VAR_NV;
+  }
+  return count;
+}
+
 char *isvar(char *lp, uint8_t *vtype, struct T_INDEX *tind, float *fp, char *sp, JsonParserObject *jo) {
     uint16_t count,len = 0;
     uint8_t nres = 0;
@@ -1679,38 +2460,33 @@ char *isvar(char *lp, uint8_t *vtype, struct T_INDEX *tind, float *fp, char *sp,
       ja++;
       olen = strlen(dvnam);
     }
-    for (count = 0; count<glob_script_mem.numvars; count++) {
-        char *cp = glob_script_mem.glob_vnp + glob_script_mem.vnp_offset[count];
-        uint8_t slen = strlen(cp);
-        if (slen==olen && *cp==dvnam[0]) {
-            if (!strncmp(cp, dvnam, olen)) {
-                uint8_t index = vtp[count].index;
-                *tind = vtp[count];
-                tind->index = count; // overwrite with global var index
-                if (vtp[count].bits.is_string==0) {
-                    *vtype = NTYPE | index;
-                    if (vtp[count].bits.is_filter) {
-                      if (ja) {
-                        lp += olen + 1;
-                        lp = GetNumericArgument(lp, OPER_EQU, &fvar, 0);
-                        last_findex = fvar;
-                        fvar = Get_MFVal(index, fvar);
-                        len = 1;
-                      } else {
-                        fvar = Get_MFilter(index);
-                      }
-                    } else {
-                      fvar = glob_script_mem.fvars[index];
-                    }
-                    if (nres) fvar = -fvar;
-                    if (fp) *fp = fvar;
-                } else {
-                    *vtype = STYPE|index;
-                    if (sp) strlcpy(sp, glob_script_mem.glob_snp + (index * glob_script_mem.max_ssize), SCRIPT_MAXSSIZE);
-                }
-                return lp + len;
+    count = Script_FindVar(lp, dvnam, olen);
+    if (count<glob_script_mem.numvars) {
+        uint8_t index = vtp[count].index;
+        *tind = vtp[count];
+        tind->index = count; // overwrite with global var index
+        if (vtp[count].bits.is_string==0) {
+            *vtype = NTYPE | index;
+            if (vtp[count].bits.is_filter) {
+              if (ja) {
+                lp += olen + 1;
+                lp = GetNumericArgument(lp, OPER_EQU, &fvar, 0);
+                last_findex = fvar;
+                fvar = Get_MFVal(index, fvar);
+                len = 1;
+              } else {
+                fvar = Get_MFilter(index);
+              }
+            } else {
+              fvar = glob_script_mem.fvars[index];
             }
+            if (nres) fvar = -fvar;
+            if (fp) *fp = fvar;
+        } else {
+            *vtype = STYPE|index;
+            if (sp) strlcpy(sp, glob_script_mem.glob_snp + (index * glob_script_mem.max_ssize), SCRIPT_MAXSSIZE);
         }
+        return lp + len;
     }
 
     if (jo) {
@@ -3879,6 +4655,65 @@ char *scripter_sub(char *lp, uint8_t fromscriptcmd) {
   return lp;
 }
 
+// execute a command line starting with =>, ->, +> or print
+void Script_Command(char *lp) {
+  uint8_t sflag = 0,pflg = 0,svmqtt,swll;
+  if (*lp=='p') {
+    pflg = 1;
+    lp += 5;
+  }
+  else {
+    if (*lp=='-') sflag = 1;
+    if (*lp=='+') sflag = 2;
+    lp += 2;
+  }
+  SCRIPT_SKIP_SPACES
+  #define SCRIPT_CMDMEM 512
+  char *cmdmem = (char*)malloc(SCRIPT_CMDMEM);
+  if (cmdmem) {
+    char *cmd = cmdmem;
+    uint16_t count;
+    for (count = 0; count<SCRIPT_CMDMEM/2-2; count++) {
+      //if (*lp=='\r' || *lp=='\n' || *lp=='}') {
+      if (!*lp || *lp=='\r' || *lp=='\n') {
+          cmd[count] = 0;
+          break;
+      }
+      cmd[count] = *lp++;
+    }
+    //AddLog_P(LOG_LEVEL_INFO, tmp);
+    // replace vars in cmd
+    char *tmp = cmdmem + SCRIPT_CMDMEM / 2;
+    Replace_Cmd_Vars(cmd, 0, tmp, SCRIPT_CMDMEM / 2);
+    //toSLog(tmp);
+
+    if (!strncmp(tmp, "print", 5) || pflg) {
+      if (pflg) toLog(tmp);
+      else toLog(&tmp[5]);
+    } else {
+      if (!sflag) {
+        tasm_cmd_activ = 1;
+        AddLog_P(glob_script_mem.script_loglevel&0x7f, PSTR("Script: performs \"%s\""), tmp);
+      } else if (sflag==2) {
+        // allow recursive call
+      } else {
+        tasm_cmd_activ = 1;
+        svmqtt = Settings.flag.mqtt_enabled;  // SetOption3 - Enable MQTT
+        swll = Settings.weblog_level;
+        Settings.flag.mqtt_enabled = 0;       // SetOption3 - Enable MQTT
+        Settings.weblog_level = 0;
+      }
+      ExecuteCommand((char*)tmp, SRC_RULE);
+      tasm_cmd_activ = 0;
+      if (sflag==1) {
+        Settings.flag.mqtt_enabled = svmqtt;  // SetOption3  - Enable MQTT
+        Settings.weblog_level = swll;
+      }
+    }
+    if (cmdmem) free(cmdmem);
+  }
+}
+
 #define IF_NEST 8
 // execute section of scripter
 int16_t Run_Scripter(const char *type, int8_t tlen, char *js) {
@@ -3926,6 +4761,13 @@ int16_t Run_script_sub(const char *type, int8_t tlen, JsonParserObject *jo) {
 
     char *lp = glob_script_mem.scriptptr;
 
+    // section lines are indexed for the script in ram, jump directly to them while searching
+    uint16_t sect = 0;
+    uint8_t use_sections = (glob_script_mem.sections && lp==glob_script_mem.scriptptr_bu && tlen>0 && (*type=='>' || *type=='#'));
+    if (use_sections) {
+      lp = glob_script_mem.scriptptr_bu + glob_script_mem.sections[0];
+    }
+
     while (1) {
         // check line
         // skip leading spaces
@@ -4307,63 +5149,7 @@ int16_t Run_script_sub(const char *type, int8_t tlen, JsonParserObject *jo) {
             }
             else if (!strncmp(lp,"=>",2) || !strncmp(lp,"->",2) || !strncmp(lp,"+>",2) || !strncmp(lp,"print",5)) {
                 // execute cmd
-                uint8_t sflag = 0,pflg = 0,svmqtt,swll;
-                if (*lp=='p') {
-                 pflg = 1;
-                 lp += 5;
-                }
-                else {
-                  if (*lp=='-') sflag = 1;
-                  if (*lp=='+') sflag = 2;
-                  lp += 2;
-                }
-                char *slp = lp;
-                SCRIPT_SKIP_SPACES
-                #define SCRIPT_CMDMEM 512
-                char *cmdmem = (char*)malloc(SCRIPT_CMDMEM);
-                if (cmdmem) {
-                  char *cmd = cmdmem;
-                  uint16_t count;
-                  for (count = 0; count<SCRIPT_CMDMEM/2-2; count++) {
-                    //if (*lp=='\r' || *lp=='\n' || *lp=='}') {
-                    if (!*lp || *lp=='\r' || *lp=='\n') {
-                        cmd[count] = 0;
-                        break;
-                    }
-                    cmd[count] = *lp++;
-                  }
-                  //AddLog_P(LOG_LEVEL_INFO, tmp);
-                  // replace vars in cmd
-                  char *tmp = cmdmem + SCRIPT_CMDMEM / 2;
-                  Replace_Cmd_Vars(cmd, 0, tmp, SCRIPT_CMDMEM / 2);
-                  //toSLog(tmp);
-
-                  if (!strncmp(tmp, "print", 5) || pflg) {
-                    if (pflg) toLog(tmp);
-                    else toLog(&tmp[5]);
-                  } else {
-                    if (!sflag) {
-                      tasm_cmd_activ = 1;
-                      AddLog_P(glob_script_mem.script_loglevel&0x7f, PSTR("Script: performs \"%s\""), tmp);
-                    } else if (sflag==2) {
-                      // allow recursive call
-                    } else {
-                      tasm_cmd_activ = 1;
-                      svmqtt = Settings.flag.mqtt_enabled;  // SetOption3 - Enable MQTT
-                      swll = Settings.weblog_level;
-                      Settings.flag.mqtt_enabled = 0;       // SetOption3 - Enable MQTT
-                      Settings.weblog_level = 0;
-                    }
-                    ExecuteCommand((char*)tmp, SRC_RULE);
-                    tasm_cmd_activ = 0;
-                    if (sflag==1) {
-                      Settings.flag.mqtt_enabled = svmqtt;  // SetOption3  - Enable MQTT
-                      Settings.weblog_level = swll;
-                    }
-                  }
-                  if (cmdmem) free(cmdmem);
-                }
-                lp = slp;
+                Script_Command(lp);
                 goto next_line;
             } else if (!strncmp(lp, "=#", 2)) {
                 // subroutine
@@ -4622,10 +5408,27 @@ int16_t Run_script_sub(const char *type, int8_t tlen, JsonParserObject *jo) {
                     }
                   }
                 }
+#if SCRIPT_COMPILE>0
+                // run compiled section, sect is the index of this header
+                if (section && use_sections && glob_script_mem.code && glob_script_mem.code[sect]) {
+                  union S_OP *code = glob_script_mem.code[sect];
+                  if (!jo || !(code->arg & SCRIPT_CODE_SYSVAR)) {
+                    return Script_RunCode(code);
+                  }
+                }
+#endif //SCRIPT_COMPILE
             }
         }
         // next line
     next_line:
+        if (!section && use_sections) {
+          while (sect<glob_script_mem.numsections && glob_script_mem.scriptptr_bu + glob_script_mem.sections[sect]<=lp) sect++;
+          if (sect>=glob_script_mem.numsections) {
+            return -1;
+          }
+          lp = glob_script_mem.scriptptr_bu + glob_script_mem.sections[sect];
+          continue;
+        }
         if (*lp==SCRIPT_EOL) {
           lp++;
         } else {
@@ -4654,9 +5457,9 @@ void ScripterEvery100ms(void) {
     TasmotaGlobal.tele_period = 2;
     XsnsNextCall(FUNC_JSON_APPEND, script_xsns_index);
     TasmotaGlobal.tele_period = script_tele_period_save;
-    if (strlen(TasmotaGlobal.mqtt_data)) {
+    if (ResponseLength()) {
       TasmotaGlobal.mqtt_data[0] = '{';
-      snprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("%s}"), TasmotaGlobal.mqtt_data);
+      ResponseAppend_P(PSTR("}"));
       Run_Scripter(">T", 2, TasmotaGlobal.mqtt_data);
     }
   }
@@ -5357,6 +6160,7 @@ void SaveScriptEnd(void) {
     free(glob_script_mem.script_mem);
     glob_script_mem.script_mem = 0;
     glob_script_mem.script_mem_size = 0;
+    Script_FreeIndex();
   }
 
 #ifdef USE_SCRIPT_COMPRESSION
@@ -5961,7 +6765,7 @@ bool ScriptCommand(void) {
     } else {
       if ('>' == XdrvMailbox.data[0]) {
         // execute script
-        snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"%s\":\"%s\"}"), command,XdrvMailbox.data);
+        Response_P(PSTR("{\"%s\":\"%s\"}"), command,XdrvMailbox.data);
         if (bitRead(Settings.rule_enabled, 0)) {
           for (uint8_t count = 0; count<XdrvMailbox.data_len; count++) {
             if (XdrvMailbox.data[count]==';') XdrvMailbox.data[count] = '\n';
@@ -5980,15 +6784,15 @@ bool ScriptCommand(void) {
         if (glob_script_mem.glob_error==1) {
           // was string, not number
           GetStringArgument(lp, OPER_EQU, str, 0);
-          snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"script\":{\"%s\":\"%s\"}}"), lp, str);
+          Response_P(PSTR("{\"script\":{\"%s\":\"%s\"}}"), lp, str);
         } else {
           dtostrfd(fvar, 6, str);
-          snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"script\":{\"%s\":%s}}"), lp, str);
+          Response_P(PSTR("{\"script\":{\"%s\":%s}}"), lp, str);
         }
       }
       return serviced;
     }
-    snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"%s\":\"%s\",\"Free\":%d}"),command, GetStateText(bitRead(Settings.rule_enabled, 0)), glob_script_mem.script_size - strlen(glob_script_mem.script_ram));
+    Response_P(PSTR("{\"%s\":\"%s\",\"Free\":%d}"),command, GetStateText(bitRead(Settings.rule_enabled, 0)), glob_script_mem.script_size - strlen(glob_script_mem.script_ram));
 #ifdef SUPPORT_MQTT_EVENT
   } else if (CMND_SUBSCRIBE == command_code) {			//MQTT Subscribe command. Subscribe <Event>, <Topic> [, <Key>]
       String result = ScriptSubscribe(XdrvMailbox.data, XdrvMailbox.data_len);
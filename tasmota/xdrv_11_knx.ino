@@ -49,6 +49,7 @@ uint8_t       Settings.knx_CB_param[MAX_KNX_CB]     Type of Output (set relay, t
 \*********************************************************************************************/
 
 #define XDRV_11  11
+#define XDRV_11_FUNCS (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_50_MSECOND))
 
 #include <esp-knx-ip.h>         // KNX Library
 
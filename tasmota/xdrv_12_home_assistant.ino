@@ -20,6 +20,7 @@
 #ifdef USE_HOME_ASSISTANT
 
 #define XDRV_12 12
+#define XDRV_12_FUNCS (FUNC_MASK(FUNC_EVERY_SECOND))
 
 // List of sensors ready for discovery
 const char kHAssJsonSensorTypes[] PROGMEM =
@@ -364,7 +365,7 @@ void TryResponseAppend_P(const char *format, ...)
   char dummy[2];
   int dlen = vsnprintf_P(dummy, 1, format, args);
 
-  int mlen = strlen(TasmotaGlobal.mqtt_data);
+  int mlen = ResponseLength();
   int slen = sizeof(TasmotaGlobal.mqtt_data) - 1 - mlen;
   if (dlen >= slen)
   {
@@ -377,7 +378,7 @@ void TryResponseAppend_P(const char *format, ...)
   else
   {
     va_start(args, format);
-    vsnprintf_P(TasmotaGlobal.mqtt_data + mlen, slen, format, args);
+    ResponseUpdate(mlen, vsnprintf_P(TasmotaGlobal.mqtt_data + mlen, slen, format, args));
   }
   va_end(args);
 }
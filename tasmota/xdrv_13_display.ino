@@ -21,6 +21,7 @@
 #ifdef USE_DISPLAY
 
 #define XDRV_13       13
+#define XDRV_13_FUNCS (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <renderer.h>
 
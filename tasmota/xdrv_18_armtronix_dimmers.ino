@@ -27,6 +27,7 @@
 \*********************************************************************************************/
 
 #define XDRV_18                18
+#define XDRV_18_FUNCS          (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
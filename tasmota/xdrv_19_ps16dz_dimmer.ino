@@ -24,6 +24,7 @@
 \*********************************************************************************************/
 
 #define XDRV_19                19
+#define XDRV_19_FUNCS          (FUNC_MASK(FUNC_LOOP))
 
 #define PS16DZ_BUFFER_SIZE     80
 
@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XDRV_20           20
+#define XDRV_20_FUNCS     0
 
 const char HUE_RESPONSE[] PROGMEM =
   "HTTP/1.1 200 OK\r\n"
@@ -19,6 +19,8 @@
 
 #ifdef USE_ZIGBEE
 
+#include <new>                          // placement new for arena allocations
+
 /*********************************************************************************************\
  * Replacement libs for JSON to output a list of attributes
 \*********************************************************************************************/
@@ -64,6 +66,128 @@ uint16_t Z_GetLastGroup(void) { return gZbLastMessage.groupaddr; }
 uint16_t Z_GetLastCluster(void) { return gZbLastMessage.cluster; }
 uint8_t  Z_GetLastEndpoint(void) { return gZbLastMessage.endpoint; }
 
+/*********************************************************************************************\
+ * 
+ * Arena for attributes built while parsing a frame
+ * 
+ * Attribute lists created with `Z_attribute_list(true)` take their nodes, key and string
+ * values and sub-lists from the arena instead of the heap. Attributes living in the arena
+ * allocate from it, others from the heap, so copies into long lived lists (device pending
+ * attributes) are unaffected. Memory is released in one shot when the last arena list is
+ * destroyed. The first block is kept for the next frame, so a typical frame does no heap
+ * allocation at all. If the arena can't grow, allocations fall back to the heap.
+ * 
+\*********************************************************************************************/
+
+const size_t Z_ARENA_BLOCK_SIZE = 512;      // size of arena blocks, larger requests get their own block
+
+class Z_Arena {
+public:
+  void * alloc(size_t size);
+  bool owns(const void * ptr) const;
+
+  // arena lists register while alive, the arena is released when the last one is gone
+  void acquire(void);
+  void release(void);
+
+  void resetStats(void);
+
+  // statistics
+  uint32_t frames = 0;        // number of frames, i.e. releases of the last arena list
+  uint32_t peak = 0;          // max bytes used by a frame
+  uint32_t blocks = 0;        // number of blocks allocated beyond the first one
+  uint32_t fallbacks = 0;     // allocations served by the heap because the arena couldn't grow
+  uint32_t heap_min_before = 0;   // lowest free heap seen when a frame starts
+  uint32_t heap_min_after = 0;    // lowest free heap seen when a frame is released
+  uint8_t  frag_max_before = 0;   // highest heap fragmentation seen when a frame starts, in %
+  uint8_t  frag_max_after = 0;    // highest heap fragmentation seen when a frame is released, in %
+
+private:
+  typedef struct Z_ArenaBlock {
+    struct Z_ArenaBlock * next;
+    uint16_t size;
+    uint16_t used;
+    inline uint8_t * data(void) { return (uint8_t*) (this + 1); }
+  } Z_ArenaBlock;
+
+  Z_ArenaBlock * _blocks = nullptr;     // current block first, the first block allocated is last and kept
+  uint32_t _used = 0;                   // bytes used by the current frame
+  uint16_t _users = 0;
+
+  static void sampleHeap(uint32_t &heap_min, uint8_t &frag_max);
+};
+
+Z_Arena zigbee_arena;
+
+void * Z_Arena::alloc(size_t size) {
+  size = (size + 3) & ~3;     // keep 32 bits alignment
+  Z_ArenaBlock * block = _blocks;
+  if (!block || (block->used + size > block->size)) {
+    size_t block_size = (size > Z_ARENA_BLOCK_SIZE) ? size : Z_ARENA_BLOCK_SIZE;
+    block = (Z_ArenaBlock*) malloc(sizeof(Z_ArenaBlock) + block_size);
+    if (!block) {
+      fallbacks++;
+      return nullptr;
+    }
+    block->size = block_size;
+    block->used = 0;
+    block->next = _blocks;
+    if (_blocks) { blocks++; }
+    _blocks = block;
+  }
+  void * ptr = block->data() + block->used;
+  block->used += size;
+  _used += size;
+  if (_used > peak) { peak = _used; }
+  return ptr;
+}
+
+bool Z_Arena::owns(const void * ptr) const {
+  for (Z_ArenaBlock * block = _blocks; block; block = block->next) {
+    if (((const uint8_t*) ptr >= block->data()) && ((const uint8_t*) ptr < block->data() + block->size)) { return true; }
+  }
+  return false;
+}
+
+// update the lowest free heap and highest fragmentation with the current heap
+void Z_Arena::sampleHeap(uint32_t &heap_min, uint8_t &frag_max) {
+  uint32_t heap = ESP_getFreeHeap();
+  uint32_t frag = heap ? 100 - (ESP_getMaxAllocHeap() * 100 / heap) : 0;
+  if (!heap_min || (heap < heap_min)) { heap_min = heap; }
+  if (frag > frag_max) { frag_max = frag; }
+}
+
+void Z_Arena::acquire(void) {
+  if (0 == _users) { sampleHeap(heap_min_before, frag_max_before); }    // first list of a frame
+  _users++;
+}
+
+void Z_Arena::release(void) {
+  if (_users) { _users--; }
+  if (_users) { return; }
+  // free all blocks but the first one
+  while (_blocks && _blocks->next) {
+    Z_ArenaBlock * next = _blocks->next;
+    free(_blocks);
+    _blocks = next;
+  }
+  if (_blocks) { _blocks->used = 0; }
+  _used = 0;
+  frames++;
+  sampleHeap(heap_min_after, frag_max_after);     // also when the frame allocated nothing
+}
+
+void Z_Arena::resetStats(void) {
+  frames = 0;
+  peak = 0;
+  blocks = 0;
+  fallbacks = 0;
+  heap_min_before = 0;
+  heap_min_after = 0;
+  frag_max_before = 0;
+  frag_max_after = 0;
+}
+
 /*********************************************************************************************\
  * 
  * Class for single attribute
@@ -204,12 +328,18 @@ public:
   bool equals(const Z_attribute & attr2) const;
 
   String toString(bool prefix_comma = false) const;
+  // write key and value to a JSON stream
+  void toJson(JsonGeneratorStream & json) const;
 
   // copy value from one attribute to another, without changing its type
   void copyVal(const Z_attribute & rhs);
 
 protected:
   void deepCopy(const Z_attribute & rhs);
+
+  // allocate strings from the arena if the attribute lives in it
+  char * newStr(size_t len);
+  static void deleteStr(char * str);
 };
 
 /*********************************************************************************************\
@@ -229,19 +359,31 @@ public:
   uint8_t       lqi;      // linkquality, 0xFF if unknown
   uint16_t      group_id; // group address OxFFFF if inknown
 
-  Z_attribute_list():
+  // arena: allocate attributes from zigbee_arena, use for lists living only while a frame is parsed
+  explicit Z_attribute_list(bool arena = false):
     LList<Z_attribute>(), // call superclass constructor
     src_ep(0xFF),
     lqi(0xFF),
-    group_id(0xFFFF)
-    {};
+    group_id(0xFFFF),
+    _arena(arena)
+    {
+      if (_arena) { zigbee_arena.acquire(); }
+    };
 
-  // we don't define any destructor, the superclass destructor is automatically called
+  // free attributes before the superclass destructor, which doesn't know about the arena
+  ~Z_attribute_list() {
+    reset();
+    if (_arena) { zigbee_arena.release(); }
+  }
 
   // reset object to its initial state
   // free all allocated memory
   void reset(void) {
-    LList<Z_attribute>::reset();
+    while (_head) {
+      LList_elt<Z_attribute> * next = _head->next();
+      freeElt(_head);
+      _head = next;
+    }
     src_ep = 0xFF;
     lqi = 0xFF;
     group_id = 0xFFFF;
@@ -265,12 +407,14 @@ public:
   Z_attribute & addAttributePMEM(const char * name);
 
   // Remove from list by reference, if null or not found, then do nothing
-  inline void removeAttribute(const Z_attribute * attr) { remove(attr); }
+  void removeAttribute(const Z_attribute * attr);
 
   // dump the entire structure as JSON, starting from head (as parameter)
   // does not start not end with a comma
   // do we enclosed in brackets '{' '}'
   String toString(bool enclose_brackets = false) const;
+  // same, written to a JSON stream
+  void toJson(JsonGeneratorStream & json, bool enclose_brackets = false) const;
 
   // find if attribute with same key already exists, return null if not found
   const Z_attribute * findAttribute(uint16_t cluster, uint16_t attr_id, uint8_t suffix = 0) const;
@@ -301,6 +445,13 @@ public:
 
   // merge with secondary list, return true if ok, false if conflict
   bool mergeList(const Z_attribute_list &list2);
+
+protected:
+  bool          _arena;   // nodes are allocated from zigbee_arena
+
+  // replaces LList::addToLast() to allocate from the arena
+  Z_attribute & addToLast(void);
+  static void freeElt(LList_elt<Z_attribute> * elt);
 };
 
 
@@ -316,7 +467,7 @@ Z_attribute & Z_attribute_list::addAttributePMEM(const char * name) {
 
 // free any allocated memoruy for keys
 void Z_attribute::freeKey(void) {
-  if (key_is_str && key.key && !key_is_pmem) { delete[] key.key; }
+  if (key_is_str && key.key && !key_is_pmem) { deleteStr(key.key); }
   key.key = nullptr;
 }
 
@@ -341,7 +492,7 @@ void Z_attribute::setKeyName(const char * _key, const char * _key2) {
     if (_key2) {
       key_len += strlen_P(_key2);
     }
-    key.key = new char[key_len+1];
+    key.key = newStr(key_len+1);
     strcpy_P(key.key, _key);
     if (_key2) {
       strcat_P(key.key, _key2);
@@ -417,7 +568,7 @@ void Z_attribute::setStr(const char * _val) {
   if (_val) {
     size_t len = strlen_P(_val);
     if (len) {
-      val.sval = new char[len+1];
+      val.sval = newStr(len+1);
       strcpy_P(val.sval, _val);
     }
   }
@@ -426,7 +577,8 @@ void Z_attribute::setStr(const char * _val) {
 
 Z_attribute_list & Z_attribute::newAttrList(void) {
   freeVal();
-  val.objval = new Z_attribute_list();
+  void * mem = zigbee_arena.owns(this) ? zigbee_arena.alloc(sizeof(Z_attribute_list)) : nullptr;
+  val.objval = mem ? new (mem) Z_attribute_list(true) : new Z_attribute_list();
   type = Za_type::Za_obj;
   return *val.objval;
 }
@@ -556,94 +708,89 @@ bool Z_attribute::equals(const Z_attribute & attr2) const {
 }
 
 String Z_attribute::toString(bool prefix_comma) const {
-  String res("");
-  if (prefix_comma) { res += ','; }
-  res += '"';
+  JsonGeneratorStream json;
+  toJson(json);
+  String res(prefix_comma ? "," : "");
+  res += json.c_str();
+  return res;
+}
+
+void Z_attribute::toJson(JsonGeneratorStream & json) const {
   // compute the attribute name
+  char suffix[8];
   if (key_is_str) {
-    if (key.key) { res += EscapeJSONString(key.key); }
-    else         { res += F("null"); }   // shouldn't happen
-    if (key_suffix > 1) {
-      res += key_suffix;
-    }
+    snprintf_P(suffix, sizeof(suffix), PSTR("%d"), key_suffix);
+    json.key(key.key ? key.key : PSTR("null"), (key_suffix > 1) ? suffix : nullptr);
   } else {
     char attr_name[12];
     snprintf_P(attr_name, sizeof(attr_name), PSTR("%04X/%04X"), key.id.cluster, key.id.attr_id);
-    res += attr_name;
-    if (key_suffix > 1) {
-      res += '+';
-      res += key_suffix;
-    }
+    snprintf_P(suffix, sizeof(suffix), PSTR("+%d"), key_suffix);
+    json.key(attr_name, (key_suffix > 1) ? suffix : nullptr);
   }
-  res += F("\":");
   // value part
   switch (type) {
   case Za_type::Za_none:
-    res += "null";
+    json.addNull();
     break;
   case Za_type::Za_bool:
-    res += val.uval32 ? F("true") : F("false");
+    json.addBool(val.uval32);
     break;
   case Za_type::Za_uint:
-    res += val.uval32;
+    json.add(val.uval32);
     break;
   case Za_type::Za_int:
-    res += val.ival32;
+    json.add(val.ival32);
     break;
   case Za_type::Za_float:
     {
-      String fstr(val.fval, 2);
-      size_t last = fstr.length() - 1;
+      char fstr[33];
+      dtostrf(val.fval, 1, 2, fstr);
+      size_t last = strlen(fstr) - 1;
       // remove trailing zeros
       while (fstr[last] == '0') {
-        fstr.remove(last--);
+        fstr[last--] = 0;
       }
       // remove trailing dot
       if (fstr[last] == '.') {
-        fstr.remove(last);
+        fstr[last] = 0;
       }
-      res += fstr;
+      json.addStrRaw(fstr);
     }
     break;
   case Za_type::Za_raw:
-    res += '"';
     if (val.bval) {
       size_t blen = val.bval->len();
       // print as HEX
       char hex[2*blen+1];
       ToHex_P(val.bval->getBuffer(), blen, hex, sizeof(hex));
-      res += hex;
+      json.addStr(hex);
+    } else {
+      json.addStr("");
     }
-    res += '"';
     break;
   case Za_type::Za_str:
     if (val_str_raw) {
-      if (val.sval) { res += val.sval; }
+      if (val.sval) { json.addStrRaw(val.sval); }
+      else          { json.addNull(); }
     } else {
-      res += '"';
-      if (val.sval) {
-        res += EscapeJSONString(val.sval);    // escape JSON chars
-      }
-      res += '"';
+      json.addStr(val.sval);    // escape JSON chars
     }
     break;
   case Za_type::Za_obj:
-    res += '{';
+    json.beginObject();
     if (val.objval) {
-      res += val.objval->toString();
+      val.objval->toJson(json);
     }
-    res += '}';
+    json.endObject();
     break;
   case Za_type::Za_arr:
     if (val.arrval) {
-      res += val.arrval->toString();
+      json.addStrRaw(val.arrval->toString().c_str());
     } else {
-      res += "[]";
+      json.addStrRaw("[]");
     }
     break;
   }
-
-  return res;
 }
 
 // copy value from one attribute to another, without changing its type
@@ -662,7 +809,7 @@ void Z_attribute::copyVal(const Z_attribute & rhs) {
   } else if (rhs.type == Za_type::Za_str) {
     if (rhs.val.sval) {
       size_t s_len = strlen_P(rhs.val.sval);
-      val.sval = new char[s_len+1];
+      val.sval = newStr(s_len+1);
       strcpy_P(val.sval, rhs.val.sval);
     }
   }
@@ -676,10 +823,17 @@ void Z_attribute::freeVal(void) {
       if (val.bval) { delete val.bval; val.bval = nullptr; }
       break;
     case Za_type::Za_str:
-      if (val.sval) { delete[] val.sval; val.sval = nullptr; }
+      if (val.sval) { deleteStr(val.sval); val.sval = nullptr; }
       break;
     case Za_type::Za_obj:
-      if (val.objval) { delete val.objval; val.objval = nullptr; }
+      if (val.objval) {
+        if (zigbee_arena.owns(val.objval)) {
+          val.objval->~Z_attribute_list();
+        } else {
+          delete val.objval;
+        }
+        val.objval = nullptr;
+      }
       break;
     case Za_type::Za_arr:
       if (val.arrval) { delete val.arrval; val.arrval = nullptr; }
@@ -689,6 +843,15 @@ void Z_attribute::freeVal(void) {
   }
 }
 
+char * Z_attribute::newStr(size_t len) {
+  char * str = zigbee_arena.owns(this) ? (char*) zigbee_arena.alloc(len) : nullptr;
+  return str ? str : new char[len];
+}
+
+void Z_attribute::deleteStr(char * str) {
+  if (!zigbee_arena.owns(str)) { delete[] str; }
+}
+
 void Z_attribute::deepCopy(const Z_attribute & rhs) {
   // copy key
   if (!rhs.key_is_str) {
@@ -702,7 +865,7 @@ void Z_attribute::deepCopy(const Z_attribute & rhs) {
       if (rhs.key.key) {
         size_t key_len = strlen_P(rhs.key.key);
         if (key_len) {
-          key.key = new char[key_len+1];
+          key.key = newStr(key_len+1);
           strcpy_P(key.key, rhs.key.key);
         }
       }
@@ -723,6 +886,36 @@ void Z_attribute::deepCopy(const Z_attribute & rhs) {
  * Implementation for Z_attribute_list
  * 
 \*********************************************************************************************/
+Z_attribute & Z_attribute_list::addToLast(void) {
+  void * mem = _arena ? zigbee_arena.alloc(sizeof(LList_elt<Z_attribute>)) : nullptr;
+  LList_elt<Z_attribute> * elt = mem ? new (mem) LList_elt<Z_attribute>() : new LList_elt<Z_attribute>();
+  return LList<Z_attribute>::addToLast(elt);
+}
+
+void Z_attribute_list::freeElt(LList_elt<Z_attribute> * elt) {
+  if (zigbee_arena.owns(elt)) {
+    elt->~LList_elt();     // memory is given back when the arena is released
+  } else {
+    delete elt;
+  }
+}
+
+void Z_attribute_list::removeAttribute(const Z_attribute * attr) {
+  if (nullptr == attr) { return; }
+  LList_elt<Z_attribute> * prev = nullptr;
+  for (LList_elt<Z_attribute> * elt = _head; elt; prev = elt, elt = elt->next()) {
+    if (&elt->val() == attr) {
+      if (prev) {
+        prev->next(elt->next());    // update previous pointer to next element
+      } else {
+        _head = elt->next();
+      }
+      freeElt(elt);
+      break;
+    }
+  }
+}
+
 // add a cluster/attr_id attribute at the end of the list
 Z_attribute & Z_attribute_list::addAttribute(uint16_t cluster, uint16_t attr_id, uint8_t suffix) {
   Z_attribute & attr = addToLast();
@@ -752,37 +945,29 @@ Z_attribute & Z_attribute_list::addAttribute(const char * name, const char * nam
 }
 
 String Z_attribute_list::toString(bool enclose_brackets) const {
-  String res = "";
-  if (enclose_brackets) { res += '{'; }
-  bool prefix_comma = false;
+  JsonGeneratorStream json;
+  toJson(json, enclose_brackets);
+  return String(json.c_str());
+}
+
+void Z_attribute_list::toJson(JsonGeneratorStream & json, bool enclose_brackets) const {
+  if (enclose_brackets) { json.beginObject(); }
   for (const auto & attr : *this) {
-    res += attr.toString(prefix_comma);
-    prefix_comma = true;
+    attr.toJson(json);
   }
   // add source endpoint
   if (0xFF != src_ep) {
-    if (prefix_comma) { res += ','; }
-    prefix_comma = true;
-    res += F("\"" D_CMND_ZIGBEE_ENDPOINT "\":");
-    res += src_ep;
+    json.add(PSTR(D_CMND_ZIGBEE_ENDPOINT), (uint32_t) src_ep);
   }
   // add group address
   if (0xFFFF != group_id) {
-    if (prefix_comma) { res += ','; }
-    prefix_comma = true;
-    res += F("\"" D_CMND_ZIGBEE_GROUP "\":");
-    res += group_id;
+    json.add(PSTR(D_CMND_ZIGBEE_GROUP), (uint32_t) group_id);
   }
   // add lqi
   if (0xFF != lqi) {
-    if (prefix_comma) { res += ','; }
-    prefix_comma = true;
-    res += F("\"" D_CMND_ZIGBEE_LINKQUALITY "\":");
-    res += lqi;
+    json.add(PSTR(D_CMND_ZIGBEE_LINKQUALITY), (uint32_t) lqi);
   }
-  if (enclose_brackets) { res += '}'; }
-  // done
-  return res;
+  if (enclose_brackets) { json.endObject(); }
 }
 
 // suffis always count here
@@ -919,8 +919,8 @@ public:
   uint8_t getNextSeqNumber(uint16_t shortaddr);
 
   // Dump json
-  String dumpDevice(uint32_t dump_mode, const Z_Device & device) const;
-  String dumpCoordinator(void) const;
+  void dumpDevice(JsonGeneratorStream & json, uint32_t dump_mode, const Z_Device & device) const;
+  void dumpCoordinator(JsonGeneratorStream & json) const;
   int32_t deviceRestore(JsonParserObject json);
 
   // Hue support
@@ -963,12 +963,23 @@ public:
 
   bool isTuyaProtocol(uint16_t shortaddr, uint8_t ep = 0) const;
 
+  // Any change to shortaddr, longaddr or friendlyName of a device must invalidate the index
+  inline void invalidateIndex(void) { _index_valid = false; }
+
 private:
   LList<Z_Device>           _devices;     // list of devices
   LList<Z_Deferred>         _deferred;    // list of deferred calls
   uint32_t                  _saveTimer = 0;
   uint8_t                   _seqNumber = 0;     // global seqNumber if device is unknown
 
+  // Open addressing hash index on shortaddr, longaddr and friendlyName, rebuilt at first lookup after a change
+  mutable Z_Device **       _index = nullptr;   // 3 consecutive tables of _index_size entries
+  mutable uint16_t          _index_size = 0;    // entries per table, power of 2 and larger than the number of devices
+  mutable bool              _index_valid = false;
+
+  bool checkIndex(void) const;
+  const Z_Device * findFriendlyNameDevice(const char * name) const;
+
   //int32_t findShortAddrIdx(uint16_t shortaddr) const;
   // Create a new entry in the devices list - must be called if it is sure it does not already exist
   Z_Device & createDeviceEntry(uint16_t shortaddr, uint64_t longaddr = 0);
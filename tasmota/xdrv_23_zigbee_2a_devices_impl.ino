@@ -42,6 +42,7 @@ Z_Device & Z_Devices::createDeviceEntry(uint16_t shortaddr, uint64_t longaddr) {
   device.shortaddr = shortaddr;
   device.longaddr = longaddr;
 
+  invalidateIndex();
   dirty();
   return device;
 }
@@ -54,7 +55,73 @@ void Z_Devices::freeDeviceEntry(Z_Device *device) {
 }
 
 //
-// Scan all devices to find a corresponding shortaddr
+// Hash index
+// Three open addressing tables with linear probing map shortaddr, longaddr and friendlyName
+// to devices. When several devices share a key, the first one in _devices wins like a linear
+// scan would. Tables always have empty slots so that probing stops on unknown keys.
+//
+uint32_t Z_HashShortAddr(uint16_t shortaddr) {
+  return (shortaddr * 2654435761U) >> 16;
+}
+
+uint32_t Z_HashLongAddr(uint64_t longaddr) {
+  return Z_HashShortAddr((longaddr >> 48) ^ (longaddr >> 32) ^ (longaddr >> 16) ^ longaddr);
+}
+
+uint32_t Z_HashName(const char * name) {
+  uint32_t hash = 2166136261;                   // FNV-1a, case insensitive like strcasecmp
+  while (*name) {
+    hash ^= (uint8_t) tolower(*name++);
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+// Make sure the index is up to date, returns false if no memory is available for the index
+bool Z_Devices::checkIndex(void) const {
+  if (_index_valid) { return true; }
+
+  size_t count = devicesSize();
+  uint32_t size = 8;
+  while (size < count + (count >> 2) + 1) { size <<= 1; }   // load factor below 80%
+  if (size != _index_size) {
+    if (_index) { free(_index); }
+    _index = (Z_Device**) malloc(3 * size * sizeof(Z_Device*));
+    _index_size = (_index) ? size : 0;
+  }
+  if (!_index) { return false; }
+  memset(_index, 0, 3 * size * sizeof(Z_Device*));
+
+  uint32_t mask = size - 1;
+  Z_Device ** short_index = _index;
+  Z_Device ** long_index = _index + size;
+  Z_Device ** name_index = _index + 2 * size;
+  for (auto & elem : _devices) {
+    Z_Device * device = (Z_Device*) &elem;
+    uint32_t i;
+    for (i = Z_HashShortAddr(device->shortaddr) & mask; short_index[i]; i = (i + 1) & mask) {
+      if (short_index[i]->shortaddr == device->shortaddr) { break; }
+    }
+    if (!short_index[i]) { short_index[i] = device; }
+    if (device->longaddr) {
+      for (i = Z_HashLongAddr(device->longaddr) & mask; long_index[i]; i = (i + 1) & mask) {
+        if (long_index[i]->longaddr == device->longaddr) { break; }
+      }
+      if (!long_index[i]) { long_index[i] = device; }
+    }
+    if (device->friendlyName && device->friendlyName[0]) {
+      for (i = Z_HashName(device->friendlyName) & mask; name_index[i]; i = (i + 1) & mask) {
+        if (strcasecmp(name_index[i]->friendlyName, device->friendlyName) == 0) { break; }
+      }
+      if (!name_index[i]) { name_index[i] = device; }
+    }
+  }
+  _index_valid = true;
+  return true;
+}
+
+//
+// Find the device corresponding to a shortaddr
 // Looks info device.shortaddr entry
 // In:
 //    shortaddr (not BAD_SHORTADDR)
@@ -62,34 +129,42 @@ void Z_Devices::freeDeviceEntry(Z_Device *device) {
 //    reference to device, or to device_unk if not found
 //    (use foundDevice() to check if found)
 Z_Device & Z_Devices::findShortAddr(uint16_t shortaddr) {
-  for (auto & elem : _devices) {
-    if (elem.shortaddr == shortaddr) { return elem; }
-  }
-  return device_unk;
+  return (Z_Device &) ((const Z_Devices*)this)->findShortAddr(shortaddr);
 }
 const Z_Device & Z_Devices::findShortAddr(uint16_t shortaddr) const {
+  if (checkIndex()) {
+    uint32_t mask = _index_size - 1;
+    for (uint32_t i = Z_HashShortAddr(shortaddr) & mask; _index[i]; i = (i + 1) & mask) {
+      if (_index[i]->shortaddr == shortaddr) { return *_index[i]; }
+    }
+    return device_unk;
+  }
   for (const auto & elem : _devices) {
     if (elem.shortaddr == shortaddr) { return elem; }
   }
   return device_unk;
 }
 //
-// Scan all devices to find a corresponding longaddr
+// Find the device corresponding to a longaddr
 // Looks info device.longaddr entry
 // In:
 //    longaddr (non null)
 // Out:
-//    index in _devices of entry, -1 if not found
+//    reference to device, or to device_unk if not found
 //
 Z_Device & Z_Devices::findLongAddr(uint64_t longaddr) {
-  if (!longaddr) { return device_unk; }
-  for (auto &elem : _devices) {
-    if (elem.longaddr == longaddr) { return elem; }
-  }
-  return device_unk;
+  return (Z_Device &) ((const Z_Devices*)this)->findLongAddr(longaddr);
 }
 const Z_Device & Z_Devices::findLongAddr(uint64_t longaddr) const {
   if (!longaddr) { return device_unk; }
+  if (checkIndex()) {
+    uint32_t mask = _index_size - 1;
+    Z_Device ** long_index = _index + _index_size;
+    for (uint32_t i = Z_HashLongAddr(longaddr) & mask; long_index[i]; i = (i + 1) & mask) {
+      if (long_index[i]->longaddr == longaddr) { return *long_index[i]; }
+    }
+    return device_unk;
+  }
   for (const auto &elem : _devices) {
     if (elem.longaddr == longaddr) { return elem; }
   }
@@ -130,11 +205,25 @@ Z_Device & Z_Devices::isKnownIndexDevice(uint32_t index) const {
   }
 }
 
+// Find the device with friendlyName (case insensitive), nullptr if not found
+const Z_Device * Z_Devices::findFriendlyNameDevice(const char * name) const {
+  if (checkIndex()) {
+    uint32_t mask = _index_size - 1;
+    Z_Device ** name_index = _index + 2 * _index_size;
+    for (uint32_t i = Z_HashName(name) & mask; name_index[i]; i = (i + 1) & mask) {
+      if (strcasecmp(name_index[i]->friendlyName, name) == 0) { return name_index[i]; }
+    }
+    return nullptr;
+  }
+  int32_t found = findFriendlyName(name);
+  return (found >= 0) ? &devicesAt(found) : nullptr;
+}
+
 Z_Device & Z_Devices::isKnownFriendlyNameDevice(const char * name) const {
   if ((!name) || (0 == strlen(name))) { return device_unk; }         // Error
-  int32_t found = findFriendlyName(name);
-  if (found >= 0) {
-    return devicesAt(found);
+  const Z_Device * device = findFriendlyNameDevice(name);
+  if (device) {
+    return (Z_Device &) *device;
   } else {
     return device_unk;
   }
@@ -171,6 +260,7 @@ bool Z_Devices::removeDevice(uint16_t shortaddr) {
   Z_Device & device = findShortAddr(shortaddr);
   if (foundDevice(device)) {
     _devices.remove(&device);
+    invalidateIndex();
     dirty();
     return true;
   }
@@ -194,6 +284,7 @@ Z_Device & Z_Devices::updateDevice(uint16_t shortaddr, uint64_t longaddr) {
       // erase the previous shortaddr
       freeDeviceEntry(s_found);
       _devices.remove(s_found);
+      invalidateIndex();
       dirty();
       return *l_found;
     }
@@ -201,11 +292,13 @@ Z_Device & Z_Devices::updateDevice(uint16_t shortaddr, uint64_t longaddr) {
     // shortaddr already exists but longaddr not
     // add the longaddr to the entry
     s_found->longaddr = longaddr;
+    invalidateIndex();
     dirty();
     return *s_found;
   } else if (foundDevice(*l_found)) {
     // longaddr entry exists, update shortaddr
     l_found->shortaddr = shortaddr;
+    invalidateIndex();
     dirty();
     return *l_found;
   } else {
@@ -309,6 +402,7 @@ void Z_Device::setModelId(const char * str) {
 
 void Z_Device::setFriendlyName(const char * str) {
   setStringAttribute(friendlyName, str);
+  zigbee_devices.invalidateIndex();
 }
 
 void Z_Device::setLastSeenNow(void) {
@@ -509,29 +603,28 @@ void Z_Devices::jsonAppend(uint16_t shortaddr, const Z_attribute_list &attr_list
 void Z_Device::jsonPublishAttrList(const char * json_prefix, const Z_attribute_list &attr_list) const {
   bool use_fname = (Settings.flag4.zigbee_use_names) && (friendlyName);    // should we replace shortaddr with friendlyname?
 
-  TasmotaGlobal.mqtt_data[0] = 0; // clear string
+  ResponseClear();
+  // write directly into the response buffer
+  JsonGeneratorStream json(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data));
+  json.beginObject();
   // Do we prefix with `ZbReceived`?
   if (!Settings.flag4.remove_zbreceived) {
-    Response_P(PSTR("{\"%s\":"), json_prefix);
+    json.beginObject(json_prefix);
   }
+  char hex[8];
+  snprintf_P(hex, sizeof(hex), PSTR("0x%04X"), shortaddr);
   // What key do we use, shortaddr or name?
-  if (use_fname) {
-    Response_P(PSTR("%s{\"%s\":{"), TasmotaGlobal.mqtt_data, friendlyName);
-  } else {
-    Response_P(PSTR("%s{\"0x%04X\":{"), TasmotaGlobal.mqtt_data, shortaddr);
-  }
+  json.beginObject(use_fname ? friendlyName : hex);
   // Add "Device":"0x...."
-  ResponseAppend_P(PSTR("\"" D_JSON_ZIGBEE_DEVICE "\":\"0x%04X\","), shortaddr);
+  json.addStr(PSTR(D_JSON_ZIGBEE_DEVICE), hex);
   // Add "Name":"xxx" if name is present
   if (friendlyName) {
-    ResponseAppend_P(PSTR("\"" D_JSON_ZIGBEE_NAME "\":\"%s\","), EscapeJSONString(friendlyName).c_str());
+    json.addStr(PSTR(D_JSON_ZIGBEE_NAME), friendlyName);
   }
   // Add all other attributes
-  ResponseAppend_P(PSTR("%s}}"), attr_list.toString(false).c_str());
-
-  if (!Settings.flag4.remove_zbreceived) {
-    ResponseAppend_P(PSTR("}"));
-  }
+  attr_list.toJson(json);
+  json.end();
+  ResponseWritten(json.length(), json.overflow());    // written outside the Response functions, truncation is logged on publish
 
   if (Settings.flag4.zigbee_distinct_topics) {
     char subtopic[TOPSZ];
@@ -656,13 +749,16 @@ void Z_Device::jsonAddModelManuf(Z_attribute_list & attr_list) const {
 
 // Add "Endpoints":[...]
 void Z_Device::jsonAddEndpoints(Z_attribute_list & attr_list) const {
-  JsonGeneratorArray arr_ep;
+  char buf[4 * endpoints_max + 2];      // "255," per endpoint
+  JsonGeneratorStream arr_ep(buf, sizeof(buf));
+  arr_ep.beginArray();
   for (uint32_t i = 0; i < endpoints_max; i++) {
     uint8_t endpoint = endpoints[i];
     if (0x00 == endpoint) { break; }
-    arr_ep.add(endpoint);
+    arr_ep.add((uint32_t) endpoint);
   }
-  attr_list.addAttributePMEM(PSTR("Endpoints")).setStrRaw(arr_ep.toString().c_str());
+  arr_ep.endArray();
+  attr_list.addAttributePMEM(PSTR("Endpoints")).setStrRaw(arr_ep.c_str());
 }
 // Add "Config":["",""...]
 void Z_Device::jsonAddConfig(Z_attribute_list & attr_list) const {
@@ -745,36 +841,37 @@ void Z_Device::jsonDumpSingleDevice(Z_attribute_list & attr_list, uint32_t dump_
 }
 
 // Dump coordinator specific data
-String Z_Devices::dumpCoordinator(void) const {
-  Z_attribute_list attr_list;
+void Z_Devices::dumpCoordinator(JsonGeneratorStream & json) const {
+  Z_attribute_list attr_list(true);
 
   attr_list.addAttributePMEM(PSTR(D_JSON_ZIGBEE_DEVICE)).setHex32(localShortAddr);
   attr_list.addAttributePMEM(PSTR("IEEEAddr")).setHex64(localIEEEAddr);
   attr_list.addAttributePMEM(PSTR("TotalDevices")).setUInt(zigbee_devices.devicesSize());
 
-  return attr_list.toString();
+  attr_list.toJson(json, true);
 }
 
 // If &device == nullptr, then dump all
-String Z_Devices::dumpDevice(uint32_t dump_mode, const Z_Device & device) const {
-  JsonGeneratorArray json_arr;
+// Each device is written to the stream as soon as its attributes are known, the arena is freed in between
+void Z_Devices::dumpDevice(JsonGeneratorStream & json, uint32_t dump_mode, const Z_Device & device) const {
+  json.beginArray();
 
   if (&device == nullptr) {
     if (dump_mode < 2) {
       // dump light mode for all devices
       for (const auto & device2 : _devices) {
-        Z_attribute_list attr_list;
+        Z_attribute_list attr_list(true);
         device2.jsonDumpSingleDevice(attr_list, dump_mode, true);
-        json_arr.addStrRaw(attr_list.toString(true).c_str());
+        attr_list.toJson(json, true);
       }
     }
   } else {
-    Z_attribute_list attr_list;
+    Z_attribute_list attr_list(true);
     device.jsonDumpSingleDevice(attr_list, dump_mode, true);
-    json_arr.addStrRaw(attr_list.toString(true).c_str());
+    attr_list.toJson(json, true);
   }
 
-  return json_arr.toString();
+  json.endArray();
 }
 
 // Restore a single device configuration based on json export
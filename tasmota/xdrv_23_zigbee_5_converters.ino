@@ -177,6 +177,7 @@ int8_t CmToMultiplier(uint8_t cm) {
 }
 
 // list of post-processing directives
+// Keep sorted by cluster then attribute id, lookups by id use a binary search (see Z_findConverterById)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Winvalid-offsetof"   // avoid warnings since we're using offsetof() in a risky way
 const Z_AttributeConverter Z_PostProcess[] PROGMEM = {
@@ -238,8 +239,8 @@ const Z_AttributeConverter Z_PostProcess[] PROGMEM = {
 
   // Level Control cluster
   { Zuint8,   Cx0008, 0x0000,  Z_(Dimmer),               Cm1 + Z_EXPORT_DATA, Z_MAPPING(Z_Data_Light, dimmer) },
-  { Zmap8,    Cx0008, 0x000F,  Z_(DimmerOptions),        Cm1, 0 },
   { Zuint16,  Cx0008, 0x0001,  Z_(DimmerRemainingTime),  Cm1, 0 },
+  { Zmap8,    Cx0008, 0x000F,  Z_(DimmerOptions),        Cm1, 0 },
   { Zuint16,  Cx0008, 0x0010,  Z_(OnOffTransitionTime),   Cm1, 0 },
   // { Zuint8, Cx0008, 0x0011,  (OnLevel),              Cm1, 0 },
   // { Zuint16, Cx0008, 0x0012,  (OnTransitionTime),     Cm1, 0 },
@@ -284,8 +285,8 @@ const Z_AttributeConverter Z_PostProcess[] PROGMEM = {
   { Zmap8,    Cx000C, 0x006F,  Z_(AnalogInStatusFlags),  Cm1, 0 },
   { Zenum16,  Cx000C, 0x0075,  Z_(AnalogInEngineeringUnits),Cm1, 0 },
   { Zuint32,  Cx000C, 0x0100,  Z_(AnalogInApplicationType),Cm1, 0 },
-  { Zuint16,  Cx000C, 0xFF55,  Z_(AqaraRotate),          Cm1, 0 },
   { Zuint16,  Cx000C, 0xFF05,  Z_(Aqara_FF05),           Cm1, 0 },
+  { Zuint16,  Cx000C, 0xFF55,  Z_(AqaraRotate),          Cm1, 0 },
 
   // Analog Output cluster
   { Zstring,  Cx000D, 0x001C,  Z_(AnalogOutDescription), Cm1, 0 },
@@ -650,6 +651,117 @@ const Z_AttributeConverter Z_PostProcess[] PROGMEM = {
 };
 #pragma GCC diagnostic pop
 
+//
+// Z_PostProcess lookups
+// Ids are found with a binary search since the table is sorted by cluster and attribute id.
+// Names are found with an open addressing hash table (linear probing) of entry indexes built
+// at first use. Entries sharing a name are inserted in table order so the first match is the
+// same as a linear scan. If the table is not sorted or the name index can't be allocated,
+// lookups fall back to a linear scan.
+//
+const uint32_t Z_CONVERTER_NAME_INDEX_SIZE = 512;     // power of 2, load factor below 80%
+static_assert(ARRAY_SIZE(Z_PostProcess) < Z_CONVERTER_NAME_INDEX_SIZE * 4 / 5, "Z_CONVERTER_NAME_INDEX_SIZE too small");
+
+struct {
+  uint16_t * names = nullptr;     // entry index + 1, 0 for an empty slot
+  int8_t sorted = -1;             // -1 not checked yet, 0 not sorted, 1 sorted
+} Z_ConverterIndex;
+
+uint32_t Z_ConverterKey(uint32_t i) {
+  const Z_AttributeConverter *converter = &Z_PostProcess[i];
+  return ((uint32_t)CxToCluster(pgm_read_byte(&converter->cluster_short)) << 16) | pgm_read_word(&converter->attribute);
+}
+
+const char * Z_ConverterName(uint32_t i) {
+  return Z_strings + pgm_read_word(&Z_PostProcess[i].name_offset);
+}
+
+// Same as Z_HashName() for a PROGMEM string
+uint32_t Z_HashName_P(const char * name) {
+  uint32_t hash = 2166136261;
+  uint8_t c;
+  while ((c = pgm_read_byte(name++))) {
+    hash ^= (uint8_t) tolower(c);
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+bool Z_ConverterSorted(void) {
+  if (Z_ConverterIndex.sorted < 0) {
+    Z_ConverterIndex.sorted = 1;
+    for (uint32_t i = 1; i < ARRAY_SIZE(Z_PostProcess); i++) {
+      if (Z_ConverterKey(i - 1) >= Z_ConverterKey(i)) {
+        AddLog_P(LOG_LEVEL_INFO, PSTR(D_LOG_ZIGBEE "Z_PostProcess not sorted at entry %d"), i);
+        Z_ConverterIndex.sorted = 0;
+        break;
+      }
+    }
+  }
+  return Z_ConverterIndex.sorted;
+}
+
+// Find the converter for cluster/attr_id
+// Returns the index in Z_PostProcess, or -1 if not found
+int32_t Z_findConverterById(uint16_t cluster, uint16_t attr_id) {
+  uint32_t key = ((uint32_t)cluster << 16) | attr_id;
+  if (Z_ConverterSorted()) {
+    uint32_t low = 0;
+    uint32_t high = ARRAY_SIZE(Z_PostProcess);
+    while (low < high) {
+      uint32_t mid = (low + high) / 2;
+      uint32_t mid_key = Z_ConverterKey(mid);
+      if (mid_key == key) { return mid; }
+      if (mid_key < key) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return -1;
+  }
+  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    if (Z_ConverterKey(i) == key) { return i; }
+  }
+  return -1;
+}
+
+// Find the first converter with this name (case insensitive) in cluster, or in any cluster if cluster is 0xFFFF
+// Returns the index in Z_PostProcess, or -1 if not found
+int32_t Z_findConverterByName(const char * name, uint16_t cluster = 0xFFFF) {
+  const uint32_t mask = Z_CONVERTER_NAME_INDEX_SIZE - 1;
+  if (!Z_ConverterIndex.names) {
+    Z_ConverterIndex.names = (uint16_t*) calloc(Z_CONVERTER_NAME_INDEX_SIZE, sizeof(uint16_t));
+    if (Z_ConverterIndex.names) {
+      for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+        if (0 == pgm_read_word(&Z_PostProcess[i].name_offset)) { continue; }     // unnamed entries can't be looked up by name
+        uint32_t slot = Z_HashName_P(Z_ConverterName(i)) & mask;
+        while (Z_ConverterIndex.names[slot]) { slot = (slot + 1) & mask; }
+        Z_ConverterIndex.names[slot] = i + 1;
+      }
+    }
+  }
+
+  if (Z_ConverterIndex.names) {
+    for (uint32_t slot = Z_HashName(name) & mask; Z_ConverterIndex.names[slot]; slot = (slot + 1) & mask) {
+      uint32_t i = Z_ConverterIndex.names[slot] - 1;
+      if ((0 == strcasecmp_P(name, Z_ConverterName(i))) &&
+          ((0xFFFF == cluster) || (cluster == (Z_ConverterKey(i) >> 16)))) {
+        return i;
+      }
+    }
+    return -1;
+  }
+  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    if (0 == pgm_read_word(&Z_PostProcess[i].name_offset)) { continue; }         // avoid strcasecmp_P() from crashing
+    if ((0 == strcasecmp_P(name, Z_ConverterName(i))) &&
+        ((0xFFFF == cluster) || (cluster == (Z_ConverterKey(i) >> 16)))) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 typedef union ZCLHeaderFrameControl_t {
   struct {
     uint8_t frame_type : 2;           // 00 = across entire profile, 01 = cluster specific
@@ -667,19 +779,17 @@ typedef union ZCLHeaderFrameControl_t {
 const __FlashStringHelper* zigbeeFindAttributeByName(const char *command,
                                     uint16_t *cluster, uint16_t *attribute, int8_t *multiplier,
                                     uint8_t *zigbee_type = nullptr, Z_Data_Type *data_type = nullptr, uint8_t *map_offset = nullptr) {
-  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-    const Z_AttributeConverter *converter = &Z_PostProcess[i];
-    if (0 == pgm_read_word(&converter->name_offset)) { continue; }         // avoid strcasecmp_P() from crashing
-    if (0 == strcasecmp_P(command, Z_strings + pgm_read_word(&converter->name_offset))) {
-      if (cluster)      { *cluster    = CxToCluster(pgm_read_byte(&converter->cluster_short)); }
-      if (attribute)    { *attribute  = pgm_read_word(&converter->attribute); }
-      if (multiplier)   { *multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx)); }
-      if (zigbee_type)  { *zigbee_type = pgm_read_byte(&converter->type); }
-      uint8_t conv_mapping = pgm_read_byte(&converter->mapping);
-      if (data_type)    { *data_type = (Z_Data_Type) ((conv_mapping & 0xF0)>>4); }
-      if (map_offset)   { *map_offset = (conv_mapping & 0x0F); }
-      return (const __FlashStringHelper*) (Z_strings + pgm_read_word(&converter->name_offset));
-    }
+  int32_t found = Z_findConverterByName(command);
+  if (found >= 0) {
+    const Z_AttributeConverter *converter = &Z_PostProcess[found];
+    if (cluster)      { *cluster    = CxToCluster(pgm_read_byte(&converter->cluster_short)); }
+    if (attribute)    { *attribute  = pgm_read_word(&converter->attribute); }
+    if (multiplier)   { *multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx)); }
+    if (zigbee_type)  { *zigbee_type = pgm_read_byte(&converter->type); }
+    uint8_t conv_mapping = pgm_read_byte(&converter->mapping);
+    if (data_type)    { *data_type = (Z_Data_Type) ((conv_mapping & 0xF0)>>4); }
+    if (map_offset)   { *map_offset = (conv_mapping & 0x0F); }
+    return (const __FlashStringHelper*) (Z_strings + pgm_read_word(&converter->name_offset));
   }
   return nullptr;
 }
@@ -689,16 +799,12 @@ const __FlashStringHelper* zigbeeFindAttributeByName(const char *command,
 //
 const __FlashStringHelper* zigbeeFindAttributeById(uint16_t cluster, uint16_t attr_id,
                                       uint8_t *attr_type, int8_t *multiplier) {
-  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-    const Z_AttributeConverter *converter = &Z_PostProcess[i];
-    uint16_t conv_cluster = CxToCluster(pgm_read_byte(&converter->cluster_short));
-    uint16_t conv_attr_id = pgm_read_word(&converter->attribute);
-
-    if ((conv_cluster == cluster) && (conv_attr_id == attr_id)) {
-      if (multiplier)   { *multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx)); }
-      if (attr_type)    { *attr_type  = pgm_read_byte(&converter->type); }
-      return (const __FlashStringHelper*) (Z_strings + pgm_read_word(&converter->name_offset));
-    }
+  int32_t found = Z_findConverterById(cluster, attr_id);
+  if (found >= 0) {
+    const Z_AttributeConverter *converter = &Z_PostProcess[found];
+    if (multiplier)   { *multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx)); }
+    if (attr_type)    { *attr_type  = pgm_read_byte(&converter->type); }
+    return (const __FlashStringHelper*) (Z_strings + pgm_read_word(&converter->name_offset));
   }
   return nullptr;
 }
@@ -1421,22 +1527,16 @@ void ZCLFrame::parseReadAttributes(Z_attribute_list& attr_list) {
   attr_list.addAttributePMEM(PSTR(D_CMND_ZIGBEE_CLUSTER)).setUInt(_cluster_id);
 
   JsonGeneratorArray attr_numbers;
-  Z_attribute_list attr_names;
+  Z_attribute_list attr_names(true);
   while (len >= 2 + i) {
     uint16_t attrid = _payload.get16(i);
     attr_numbers.add(attrid);
     read_attr_ids[i/2] = attrid;
 
     // find the attribute name
-    for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-      const Z_AttributeConverter *converter = &Z_PostProcess[i];
-      uint16_t conv_cluster = CxToCluster(pgm_read_byte(&converter->cluster_short));
-      uint16_t conv_attribute = pgm_read_word(&converter->attribute);
-
-      if ((conv_cluster == _cluster_id) && (conv_attribute == attrid)) {
-        attr_names.addAttribute(Z_strings + pgm_read_word(&converter->name_offset), true).setBool(true);
-        break;
-      }
+    int32_t found = Z_findConverterById(_cluster_id, attrid);
+    if (found >= 0) {
+      attr_names.addAttribute(Z_ConverterName(found), true).setBool(true);
     }
     i += 2;
   }
@@ -1451,12 +1551,12 @@ void ZCLFrame::parseReadAttributes(Z_attribute_list& attr_list) {
 void ZCLFrame::parseConfigAttributes(Z_attribute_list& attr_list) {
   uint32_t len = _payload.len();
 
-  Z_attribute_list attr_config_list;
+  Z_attribute_list attr_config_list(true);
   for (uint32_t i=0; len >= i+4; i+=4) {
     uint8_t  status = _payload.get8(i);
     uint16_t attr_id = _payload.get8(i+2);
 
-    Z_attribute_list attr_config_response;
+    Z_attribute_list attr_config_response(true);
     attr_config_response.addAttributePMEM(PSTR("Status")).setUInt(status);
     attr_config_response.addAttributePMEM(PSTR("StatusMsg")).setStr(getZigbeeStatusMessage(status).c_str());
 
@@ -1483,31 +1583,24 @@ void ZCLFrame::parseReadConfigAttributes(Z_attribute_list& attr_list) {
   uint32_t len = _payload.len();
 
   Z_attribute &attr_root = attr_list.addAttributePMEM(PSTR("ReadConfig"));
-  Z_attribute_list attr_1;
+  Z_attribute_list attr_1(true);
 
   while (len >= i + 4) {
     uint8_t  status = _payload.get8(i);
     uint8_t  direction = _payload.get8(i+1);
     uint16_t attrid = _payload.get16(i+2);
 
-    Z_attribute_list attr_2;
+    Z_attribute_list attr_2(true);
     if (direction) {
       attr_2.addAttributePMEM(PSTR("DirectionReceived")).setBool(true);
     }
 
     // find the attribute name
     int8_t multiplier = 1;
-    for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-      const Z_AttributeConverter *converter = &Z_PostProcess[i];
-      uint16_t conv_cluster = CxToCluster(pgm_read_byte(&converter->cluster_short));
-      uint16_t conv_attribute = pgm_read_word(&converter->attribute);
-
-      if ((conv_cluster == _cluster_id) && (conv_attribute == attrid)) {
-        const char * attr_name = Z_strings + pgm_read_word(&converter->name_offset);
-        attr_2.addAttribute(attr_name, true).setBool(true);
-        multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx));
-        break;
-      }
+    int32_t found = Z_findConverterById(_cluster_id, attrid);
+    if (found >= 0) {
+      attr_2.addAttribute(Z_ConverterName(found), true).setBool(true);
+      multiplier = CmToMultiplier(pgm_read_byte(&Z_PostProcess[found].multiplier_idx));
     }
     i += 4;
     if (0 != status) {
@@ -1566,7 +1659,7 @@ void ZCLFrame::parseReadAttributesResponse(Z_attribute_list& attr_list) {
 
 
 void ZCLFrame::parseResponse_inner(uint8_t cmd, bool cluster_specific, uint8_t status) {
-  Z_attribute_list attr_list;
+  Z_attribute_list attr_list(true);
 
   // "Device"
   char s[12];
@@ -1593,7 +1686,13 @@ void ZCLFrame::parseResponse_inner(uint8_t cmd, bool cluster_specific, uint8_t s
   // Add linkquality
   attr_list.lqi = _linkquality;
 
-  Response_P(PSTR("{\"" D_JSON_ZIGBEE_RESPONSE "\":%s}"), attr_list.toString(true).c_str());
+  ResponseClear();
+  JsonGeneratorStream json(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data));
+  json.beginObject();
+  json.key(PSTR(D_JSON_ZIGBEE_RESPONSE));
+  attr_list.toJson(json, true);
+  json.end();
+  ResponseWritten(json.length(), json.overflow());    // written outside the Response functions, truncation is logged on publish
   MqttPublishPrefixTopicRulesProcess_P(RESULT_OR_TELE, PSTR(D_JSON_ZIGBEEZCL_RECEIVED));
 }
 
@@ -1915,22 +2014,19 @@ void Z_postProcessAttributes(uint16_t shortaddr, uint16_t src_ep, class Z_attrib
       uint8_t map_offset = 0;
       uint8_t zigbee_type = Znodata;
       int8_t conv_multiplier;
-      for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-        const Z_AttributeConverter *converter = &Z_PostProcess[i];
-        uint16_t conv_cluster = CxToCluster(pgm_read_byte(&converter->cluster_short));
-        uint16_t conv_attribute = pgm_read_word(&converter->attribute);
-
-        if ((conv_cluster == cluster) &&
-            ((conv_attribute == attribute) || (conv_attribute == 0xFFFF)) ) {
-          conv_multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx));
-          zigbee_type = pgm_read_byte(&converter->type);
-          uint8_t mapping = pgm_read_byte(&converter->mapping);
-          map_type = (Z_Data_Type) ((mapping & 0xF0)>>4);
-          map_offset = (mapping & 0x0F);
-          conv_name = Z_strings + pgm_read_word(&converter->name_offset);
-          found = true;
-          break;
-        }
+      int32_t conv_idx = Z_findConverterById(cluster, attribute);
+      if (conv_idx < 0) {
+        conv_idx = Z_findConverterById(cluster, 0xFFFF);      // catch-all entry for the cluster
+      }
+      if (conv_idx >= 0) {
+        const Z_AttributeConverter *converter = &Z_PostProcess[conv_idx];
+        conv_multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx));
+        zigbee_type = pgm_read_byte(&converter->type);
+        uint8_t mapping = pgm_read_byte(&converter->mapping);
+        map_type = (Z_Data_Type) ((mapping & 0xF0)>>4);
+        map_offset = (mapping & 0x0F);
+        conv_name = Z_strings + pgm_read_word(&converter->name_offset);
+        found = true;
       }
 
       float    fval   = attr.getFloat();
@@ -2005,33 +2101,19 @@ void Z_postProcessAttributes(uint16_t shortaddr, uint16_t src_ep, class Z_attrib
 
 // Internal search function
 void Z_parseAttributeKey_inner(class Z_attribute & attr, uint16_t preferred_cluster) {
-  // scan attributes to find by name, and retrieve type
-  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-    const Z_AttributeConverter *converter = &Z_PostProcess[i];
-    uint16_t local_attr_id = pgm_read_word(&converter->attribute);
-    uint16_t local_cluster_id = CxToCluster(pgm_read_byte(&converter->cluster_short));
-    uint8_t  local_type_id = pgm_read_byte(&converter->type);
-    int8_t   local_multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx));
-    // AddLog_P(LOG_LEVEL_DEBUG, PSTR("Try cluster = 0x%04X, attr = 0x%04X, type_id = 0x%02X"), local_cluster_id, local_attr_id, local_type_id);
-
-    if (!attr.key_is_str) {
-      if ((attr.key.id.cluster == local_cluster_id) && (attr.key.id.attr_id == local_attr_id)) {
-        attr.attr_type = local_type_id;
-        break;
-      }
-    } else if (pgm_read_word(&converter->name_offset)) {
-      const char * key = attr.key.key;
-      // AddLog_P(LOG_LEVEL_DEBUG, PSTR("Comparing '%s' with '%s'"), attr_name, converter->name);
-      if (0 == strcasecmp_P(key, Z_strings + pgm_read_word(&converter->name_offset))) {
-        if ((preferred_cluster == 0xFFFF) ||    // any cluster
-            (local_cluster_id == preferred_cluster)) {
-          // match
-          attr.setKeyId(local_cluster_id, local_attr_id);
-          attr.attr_type = local_type_id;
-          attr.attr_multiplier = local_multiplier;
-          break;
-        }
-      }
+  // find by id or by name, and retrieve type
+  if (!attr.key_is_str) {
+    int32_t found = Z_findConverterById(attr.key.id.cluster, attr.key.id.attr_id);
+    if (found >= 0) {
+      attr.attr_type = pgm_read_byte(&Z_PostProcess[found].type);
+    }
+  } else {
+    int32_t found = Z_findConverterByName(attr.key.key, preferred_cluster);
+    if (found >= 0) {
+      const Z_AttributeConverter *converter = &Z_PostProcess[found];
+      attr.setKeyId(CxToCluster(pgm_read_byte(&converter->cluster_short)), pgm_read_word(&converter->attribute));
+      attr.attr_type = pgm_read_byte(&converter->type);
+      attr.attr_multiplier = CmToMultiplier(pgm_read_byte(&converter->multiplier_idx));
     }
   }
 }
@@ -1628,7 +1628,7 @@ void Z_IncomingMessage(class ZCLFrame &zcl_received) {
   char shortaddr[8];
   snprintf_P(shortaddr, sizeof(shortaddr), PSTR("0x%04X"), srcaddr);
 
-  Z_attribute_list attr_list;
+  Z_attribute_list attr_list(true);      // lives while the frame is parsed, allocated from zigbee_arena
   attr_list.lqi = linkquality;
   attr_list.src_ep = srcendpoint;
   if (groupid) {      // TODO we miss the group_id == 0 here
@@ -2071,7 +2071,7 @@ int32_t Z_State_Ready(uint8_t value) {
 // Mostly used for routers/end-devices
 // json: holds the attributes in JSON format
 void ZCLFrame::autoResponder(const uint16_t *attr_list_ids, size_t attr_len) {
-  Z_attribute_list attr_list;
+  Z_attribute_list attr_list(true);
 
   for (uint32_t i=0; i<attr_len; i++) {
     uint16_t attr_id = attr_list_ids[i];
@@ -20,6 +20,7 @@
 #ifdef USE_ZIGBEE
 
 #define XDRV_23                    23
+#define XDRV_23_FUNCS              (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_50_MSECOND))
 
 #include "UnishoxStrings.h"
 
@@ -36,7 +37,7 @@ const char kZbCommands[] PROGMEM = D_PRFX_ZB "|"    // prefix
   D_CMND_ZIGBEE_BIND "|" D_CMND_ZIGBEE_UNBIND "|" D_CMND_ZIGBEE_PING "|" D_CMND_ZIGBEE_MODELID "|"
   D_CMND_ZIGBEE_LIGHT "|" D_CMND_ZIGBEE_OCCUPANCY "|"
   D_CMND_ZIGBEE_RESTORE "|" D_CMND_ZIGBEE_BIND_STATE "|" D_CMND_ZIGBEE_MAP "|" D_CMND_ZIGBEE_LEAVE "|"
-  D_CMND_ZIGBEE_CONFIG "|" D_CMND_ZIGBEE_DATA
+  D_CMND_ZIGBEE_CONFIG "|" D_CMND_ZIGBEE_DATA "|" D_CMND_ZIGBEE_ARENA
   ;
 
 void (* const ZigbeeCommand[])(void) PROGMEM = {
@@ -52,7 +53,7 @@ void (* const ZigbeeCommand[])(void) PROGMEM = {
   &CmndZbBind, &CmndZbUnbind, &CmndZbPing, &CmndZbModelId,
   &CmndZbLight, &CmndZbOccupancy,
   &CmndZbRestore, &CmndZbBindState, &CmndZbMap, CmndZbLeave,
-  &CmndZbConfig, CmndZbData,
+  &CmndZbConfig, CmndZbData, &CmndZbArena,
   };
 
 /********************************************************************************************/
@@ -634,35 +635,33 @@ void ZbSendRead(JsonParserToken val_attr, ZigbeeZCLSendMessage & packet) {
       JsonParserToken value = key.getValue();
 
       bool found = false;
-      // scan attributes to find by name, and retrieve type
-      for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
-        const Z_AttributeConverter *converter = &Z_PostProcess[i];
+      // find attribute by name, and retrieve type
+      int32_t conv_idx = Z_findConverterByName(key.getStr());
+      if (conv_idx >= 0) {
+        const Z_AttributeConverter *converter = &Z_PostProcess[conv_idx];
         uint16_t local_attr_id = pgm_read_word(&converter->attribute);
         uint16_t local_cluster_id = CxToCluster(pgm_read_byte(&converter->cluster_short));
         // uint8_t  local_type_id = pgm_read_byte(&converter->type);
 
-        if ((pgm_read_word(&converter->name_offset)) && (0 == strcasecmp_P(key.getStr(), Z_strings + pgm_read_word(&converter->name_offset)))) {
-          // match name
-          // check if there is a conflict with cluster
-          // TODO
-          if (!(value.getBool()) && attr_item_offset) {
-            // If value is false (non-default) then set direction to 1 (for ReadConfig)
-            attrs[actual_attr_len] = 0x01;
-          }
-          actual_attr_len += attr_item_offset;
-          attrs[actual_attr_len++] = local_attr_id & 0xFF;
-          attrs[actual_attr_len++] = local_attr_id >> 8;
-          actual_attr_len += attr_item_len - 2 - attr_item_offset;    // normally 0
-          found = true;
-          // check cluster
-          if (0xFFFF == packet.cluster) {
-            packet.cluster = local_cluster_id;
-          } else if (packet.cluster != local_cluster_id) {
-            ResponseCmndChar_P(PSTR(D_ZIGBEE_TOO_MANY_CLUSTERS));
-            if (attrs) { free(attrs); }
-            return;
-          }
-          break;    // found, exit loop
+        // match name
+        // check if there is a conflict with cluster
+        // TODO
+        if (!(value.getBool()) && attr_item_offset) {
+          // If value is false (non-default) then set direction to 1 (for ReadConfig)
+          attrs[actual_attr_len] = 0x01;
+        }
+        actual_attr_len += attr_item_offset;
+        attrs[actual_attr_len++] = local_attr_id & 0xFF;
+        attrs[actual_attr_len++] = local_attr_id >> 8;
+        actual_attr_len += attr_item_len - 2 - attr_item_offset;    // normally 0
+        found = true;
+        // check cluster
+        if (0xFFFF == packet.cluster) {
+          packet.cluster = local_cluster_id;
+        } else if (packet.cluster != local_cluster_id) {
+          ResponseCmndChar_P(PSTR(D_ZIGBEE_TOO_MANY_CLUSTERS));
+          if (attrs) { free(attrs); }
+          return;
         }
       }
       if (!found) {
@@ -1284,7 +1283,7 @@ void CmndZbForget(void) {
 // Display all information known about a device, this equivalent to `2bStatus3` with a simpler JSON output
 //
 void CmndZbInfo_inner(const Z_Device & device) {
-    Z_attribute_list attr_list;
+    Z_attribute_list attr_list(true);
     device.jsonDumpSingleDevice(attr_list, 3, false);   // don't add Device/Name
     device.jsonPublishAttrList(PSTR(D_JSON_ZIGBEE_INFO), attr_list);         // publish as ZbReceived
 }
@@ -1303,7 +1302,7 @@ void CmndZbInfo(void) {
 
     // everything is good, we can send the command
 
-    Z_attribute_list attr_list;
+    Z_attribute_list attr_list(true);
     device.jsonDumpSingleDevice(attr_list, 3, false);   // don't add Device/Name
     device.jsonPublishAttrList(PSTR(D_JSON_ZIGBEE_INFO), attr_list);         // publish as ZbReceived
   }
@@ -1533,23 +1532,47 @@ void ZigbeeGlowPermitJoinLight(void) {
 void CmndZbStatus(void) {
   if (ZigbeeSerial) {
     if (zigbee.init_phase) { ResponseCmndChar_P(PSTR(D_ZIGBEE_NOT_STARTED)); return; }
-    String dump;
+    const Z_Device * device = nullptr;      // nullptr means all devices
 
-    if (0 == XdrvMailbox.index) {
-      dump = zigbee_devices.dumpCoordinator();
-    } else {
-      Z_Device & device = zigbee_devices.parseDeviceFromName(XdrvMailbox.data);
+    if (XdrvMailbox.index > 0) {
+      Z_Device & device_found = zigbee_devices.parseDeviceFromName(XdrvMailbox.data);
       if (XdrvMailbox.data_len > 0) {
-        if (!device.valid()) { ResponseCmndChar_P(PSTR(D_ZIGBEE_UNKNOWN_DEVICE)); return; }
-        dump = zigbee_devices.dumpDevice(XdrvMailbox.index, device);
+        if (!device_found.valid()) { ResponseCmndChar_P(PSTR(D_ZIGBEE_UNKNOWN_DEVICE)); return; }
+        device = &device_found;
       } else {
         if (XdrvMailbox.index >= 2) { ResponseCmndChar_P(PSTR(D_ZIGBEE_UNKNOWN_DEVICE)); return; }
-        dump = zigbee_devices.dumpDevice(XdrvMailbox.index, *(Z_Device*)nullptr);
       }
     }
 
-    Response_P(PSTR("{\"%s%d\":%s}"), XdrvMailbox.command, XdrvMailbox.index, dump.c_str());
+    ResponseClear();
+    // write directly into the response buffer
+    JsonGeneratorStream json(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data));
+    char index[4];
+    snprintf_P(index, sizeof(index), PSTR("%d"), XdrvMailbox.index);
+    json.beginObject();
+    json.key(XdrvMailbox.command, index);
+    if (0 == XdrvMailbox.index) {
+      zigbee_devices.dumpCoordinator(json);
+    } else {
+      zigbee_devices.dumpDevice(json, XdrvMailbox.index, *device);
+    }
+    json.end();
+    ResponseWritten(json.length(), json.overflow());    // written outside the Response functions, truncation is logged on publish
+  }
+}
+
+//
+// Command `ZbArena`
+// Show statistics of the arena used for attributes while parsing frames, `ZbArena 0` resets them
+//
+void CmndZbArena(void) {
+  if ((XdrvMailbox.data_len > 0) && (0 == XdrvMailbox.payload)) {
+    zigbee_arena.resetStats();
   }
+  Response_P(PSTR("{\"%s\":{\"Frames\":%u,\"Peak\":%u,\"Blocks\":%u,\"Fallbacks\":%u,"
+                   "\"HeapMin\":{\"Before\":%u,\"After\":%u},\"FragMax\":{\"Before\":%u,\"After\":%u}}}"),
+    XdrvMailbox.command, zigbee_arena.frames, zigbee_arena.peak, zigbee_arena.blocks, zigbee_arena.fallbacks,
+    zigbee_arena.heap_min_before, zigbee_arena.heap_min_after, zigbee_arena.frag_max_before, zigbee_arena.frag_max_after);
 }
 
 //
@@ -24,6 +24,7 @@
 \*********************************************************************************************/
 
 #define XDRV_26              26
+#define XDRV_26_FUNCS        (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 const uint32_t ARILUX_RF_TIME_AVOID_DUPLICATE = 1000;  // Milliseconds
 
@@ -38,6 +38,7 @@
 \*********************************************************************************************/
 
 #define XDRV_33             33
+#define XDRV_33_FUNCS       0
 
 #include <RF24.h>
 
@@ -31,6 +31,7 @@
 \*********************************************************************************************/
 
 #define XDRV_35             35
+#define XDRV_35_FUNCS       (FUNC_MASK(FUNC_EVERY_SECOND))
 #define MAX_PWM_DIMMER_KEYS 3
 
 const char kPWMDimmerCommands[] PROGMEM = "|"  // No prefix
@@ -612,7 +613,7 @@ void PWMDimmerHandleButton(uint32_t button_index, bool pressed)
   // If we need to publish an MQTT trigger, do it.
   if (mqtt_trigger) {
     char topic[TOPSZ];
-    sprintf_P(TasmotaGlobal.mqtt_data, PSTR("Trigger%u"), mqtt_trigger);
+    Response_P(PSTR("Trigger%u"), mqtt_trigger);
 #ifdef USE_PWM_DIMMER_REMOTE
     if (active_remote_pwm_dimmer) {
       snprintf_P(topic, sizeof(topic), PSTR("cmnd/%s/EVENT"), device_groups[power_button_index].group_name);
@@ -790,7 +791,7 @@ bool Xdrv35(uint8_t function)
           // If hold time has arrived and a rule is enabled that handles the button hold, handle it.
           else if (button_hold_time[button_index] <= now) {
 #ifdef USE_RULES
-            sprintf(TasmotaGlobal.mqtt_data, PSTR("{\"Button%u\":{\"State\":3}}"), button_index + 1);
+            Response_P(PSTR("{\"Button%u\":{\"State\":3}}"), button_index + 1);
             Rules.no_execute = true;
             if (!XdrvRulesProcess()) {
 #endif  // USE_RULES
@@ -20,6 +20,7 @@
 #ifdef USE_THERMOSTAT
 
 #define XDRV_39              39
+#define XDRV_39_FUNCS        (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 // Enable/disable debugging
 //#define DEBUG_THERMOSTAT
@@ -39,6 +39,7 @@
 \*********************************************************************************************/
 
 #define XDRV_40                    40
+#define XDRV_40_FUNCS              (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #ifndef TELEGRAM_LOOP_WAIT
 #define TELEGRAM_LOOP_WAIT         10   // Seconds
@@ -404,7 +405,7 @@ void CmndTmState(void) {
       }
     }
   }
-  snprintf_P (TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"%s\":{\"Send\":\"%s\",\"Receive\":\"%s\",\"Echo\":\"%s\"}}"),
+  Response_P(PSTR("{\"%s\":{\"Send\":\"%s\",\"Receive\":\"%s\",\"Echo\":\"%s\"}}"),
     XdrvMailbox.command, GetStateText(Telegram.send_enable), GetStateText(Telegram.recv_enable), GetStateText(Telegram.echo_enable));
 }
 
@@ -20,6 +20,7 @@
 #ifdef USE_TCP_BRIDGE
 
 #define XDRV_41                    41
+#define XDRV_41_FUNCS              (FUNC_MASK(FUNC_LOOP))
 
 #ifndef TCP_BRIDGE_CONNECTIONS
 #define TCP_BRIDGE_CONNECTIONS 2    // number of maximum parallel connections
@@ -36,23 +37,52 @@ WiFiClient   client_tcp[TCP_BRIDGE_CONNECTIONS];
 uint8_t      client_next = 0;
 uint8_t     *tcp_buf = nullptr;     // data transfer buffer
 
+typedef struct {
+  uint32_t connected;               // Uptime at connection
+  uint32_t to_mcu;                  // Bytes received from client and sent to serial
+  uint32_t from_mcu;                // Bytes received from serial and sent to client
+  uint32_t max_latency;             // Longest transfer to or from client in microseconds
+} TCPClientStat;
+
+TCPClientStat tcp_stat[TCP_BRIDGE_CONNECTIONS];
+
 #include <TasmotaSerial.h>
 TasmotaSerial *TCPSerial = nullptr;
 
 const char kTCPCommands[] PROGMEM = "TCP" "|"    // prefix
-  "Start" "|" "Baudrate"
+  "Start" "|" "Baudrate" "|" "Stats"
   ;
 
 void (* const TCPCommand[])(void) PROGMEM = {
-  &CmndTCPStart, &CmndTCPBaudrate
+  &CmndTCPStart, &CmndTCPBaudrate, &CmndTCPStats
   };
 
+void TCPClientStart(uint32_t index)
+{
+  client_tcp[index] = server_tcp->available();
+  memset(&tcp_stat[index], 0, sizeof(TCPClientStat));
+  tcp_stat[index].connected = TasmotaGlobal.uptime;
+}
+
+// Log transferred data with index 0 for data from MCU or client index for data to MCU
+void TCPLogData(uint32_t index, uint32_t buf_len)
+{
+  if (!NeedLog(LOG_LEVEL_DEBUG)) { return; }  // Skip hex conversion if nobody is listening
+
+  char hex_char[(TCP_BRIDGE_BUF_SIZE * 2) +1];
+  ToHex_P(tcp_buf, buf_len, hex_char, sizeof(hex_char));
+  if (index) {
+    AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_TCP "to MCU/%d: %s"), index, hex_char);
+  } else {
+    AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_TCP "from MCU: %s"), hex_char);
+  }
+}
+
 //
 // Called at event loop, checks for incoming data from the CC2530
 //
 void TCPLoop(void)
 {
-  uint8_t c;
   bool busy;    // did we transfer some data?
   int32_t buf_len;
 
@@ -65,7 +95,7 @@ void TCPLoop(void)
     for (i=0; i<ARRAY_SIZE(client_tcp); i++) {
       WiFiClient &client = client_tcp[i];
       if (!client) {
-        client = server_tcp->available();
+        TCPClientStart(i);
         break;
       }
     }
@@ -73,7 +103,7 @@ void TCPLoop(void)
       i = client_next++ % ARRAY_SIZE(client_tcp);
       WiFiClient &client = client_tcp[i];
       client.stop();
-      client = server_tcp->available();
+      TCPClientStart(i);
     }
   }
 
@@ -81,41 +111,37 @@ void TCPLoop(void)
     busy = false;       // exit loop if no data was transferred
 
     // start reading the UART, this buffer can quickly overflow
-    buf_len = 0;
-    while ((buf_len < TCP_BRIDGE_BUF_SIZE) && (TCPSerial->available())) {
-      c = TCPSerial->read();
-      if (c >= 0) {
-        tcp_buf[buf_len++] = c;
-        busy = true;
-      }
-    }
+    buf_len = TCPSerial->read(tcp_buf, TCP_BRIDGE_BUF_SIZE);
     if (buf_len > 0) {
-      char hex_char[TCP_BRIDGE_BUF_SIZE+1];
-  		ToHex_P(tcp_buf, buf_len, hex_char, 256);
-      AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_TCP "from MCU: %s"), hex_char);
+      busy = true;
+      TCPLogData(0, buf_len);
 
       for (uint32_t i=0; i<ARRAY_SIZE(client_tcp); i++) {
         WiFiClient &client = client_tcp[i];
-        if (client) { client.write(tcp_buf, buf_len); }
+        if (client) {
+          uint32_t start = micros();
+          client.write(tcp_buf, buf_len);
+          uint32_t latency = micros() - start;
+          tcp_stat[i].from_mcu += buf_len;
+          if (latency > tcp_stat[i].max_latency) { tcp_stat[i].max_latency = latency; }
+        }
       }
     }
 
     // handle data received from TCP
     for (uint32_t i=0; i<ARRAY_SIZE(client_tcp); i++) {
       WiFiClient &client = client_tcp[i];
-      buf_len = 0;
-      while (client && (buf_len < TCP_BRIDGE_BUF_SIZE) && (client.available())) {
-        c = client.read();
-        if (c >= 0) {
-          tcp_buf[buf_len++] = c;
-          busy = true;
-        }
-      }
+      if (!client || !client.available()) { continue; }
+
+      buf_len = client.read(tcp_buf, TCP_BRIDGE_BUF_SIZE);
       if (buf_len > 0) {
-        char hex_char[TCP_BRIDGE_BUF_SIZE+1];
-        ToHex_P(tcp_buf, buf_len, hex_char, 256);
-        AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_TCP "to MCU/%d: %s"), i+1, hex_char);
+        busy = true;
+        TCPLogData(i+1, buf_len);
+        uint32_t start = micros();
         TCPSerial->write(tcp_buf, buf_len);
+        uint32_t latency = micros() - start;
+        tcp_stat[i].to_mcu += buf_len;
+        if (latency > tcp_stat[i].max_latency) { tcp_stat[i].max_latency = latency; }
       }
     }
 
@@ -180,6 +206,25 @@ void CmndTCPBaudrate(void) {
   ResponseCmndNumber(Settings.tcp_baudrate * 1200);
 }
 
+//
+// Command `TCPStats`
+// Show per client bytes transferred, average throughput in bytes per second and longest transfer in microseconds
+//
+void CmndTCPStats(void) {
+  Response_P(PSTR("{\"%s\":{"), XdrvMailbox.command);
+  bool first = true;
+  for (uint32_t i=0; i<ARRAY_SIZE(client_tcp); i++) {
+    if (!client_tcp[i]) { continue; }
+    TCPClientStat *stat = &tcp_stat[i];
+    uint32_t seconds = TasmotaGlobal.uptime - stat->connected;
+    ResponseAppend_P(PSTR("%s\"%d\":{\"Seconds\":%d,\"ToMCU\":%u,\"FromMCU\":%u,\"Rate\":%u,\"MaxLatency\":%u}"),
+      (first) ? "" : ",", i+1, seconds, stat->to_mcu, stat->from_mcu,
+      (stat->to_mcu + stat->from_mcu) / ((seconds) ? seconds : 1), stat->max_latency);
+    first = false;
+  }
+  ResponseJsonEndEnd();
+}
+
 /*********************************************************************************************\
  * Interface
 \*********************************************************************************************/
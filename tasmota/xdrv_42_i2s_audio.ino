@@ -60,6 +60,7 @@
 #define EXTERNAL_DAC_PLAY   1
 
 #define XDRV_42           42
+#define XDRV_42_FUNCS     0
 
 AudioGeneratorMP3 *mp3 = nullptr;
 AudioFileSourceFS *file;
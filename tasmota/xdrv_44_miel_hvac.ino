@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XDRV_44			44
+#define XDRV_44_FUNCS (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_100_MSECOND) | FUNC_MASK(FUNC_EVERY_200_MSECOND) | FUNC_MASK(FUNC_EVERY_250_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #define nitems(_a)		(sizeof((_a)) / sizeof((_a)[0]))
 
@@ -52,6 +52,7 @@
 \*********************************************************************************************/
 
 #define XDRV_47                   47
+#define XDRV_47_FUNCS             (FUNC_MASK(FUNC_EVERY_50_MSECOND))
 
 #define FTC532_KEYS_MAX           8
 
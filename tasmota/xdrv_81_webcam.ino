@@ -59,6 +59,7 @@
 /*********************************************************************************************/
 
 #define XDRV_81           81
+#define XDRV_81_FUNCS     (FUNC_MASK(FUNC_LOOP))
 
 #include "esp_camera.h"
 #include "sensor.h"
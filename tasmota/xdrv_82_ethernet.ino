@@ -57,6 +57,7 @@
 \*********************************************************************************************/
 
 #define XDRV_82           82
+#define XDRV_82_FUNCS     0
 
 /*
 // Olimex ESP32-PoE
@@ -26,6 +26,7 @@
 #include <soc/rtc.h>
 
 #define XDRV_83           83
+#define XDRV_83_FUNCS     (FUNC_MASK(FUNC_LOOP))
 
 #define AXP202_INT        35
 
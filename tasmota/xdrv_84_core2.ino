@@ -38,6 +38,7 @@ rtc better sync
 #include <soc/rtc.h>
 
 #define XDRV_84          84
+#define XDRV_84_FUNCS    (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 struct CORE2_globs {
   AXP192 Axp;
@@ -21,6 +21,7 @@
 //#ifdef USE_DISPLAY
 
 #define XDRV_90       90
+#define XDRV_90_FUNCS (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #ifndef __cplusplus
 #define __cplusplus
@@ -66,14 +67,15 @@ const uint8_t DISPLAY_LOG_ROWS = 32;           // Number of lines in display log
 #define D_CMND_HASP_JSON "Json"
 #define D_CMND_HASP_JSONL "Jsonl"
 #define D_CMND_HASP_CALIBRATE "Calibrate"
+#define D_CMND_HASP_PERF "Perf"
 
 const char kHaspCommands[] PROGMEM = D_PRFX_HASP "|"  // Prefix
   "|" D_CMND_HASP_PAGE "|" D_CMND_HASP_CLEARPAGE "|" D_CMND_HASP_DIM "|" D_CMND_HASP_LIGHT "|" D_CMND_HASP_WAKEUP "|"
-  D_CMND_HASP_JSON "|" D_CMND_HASP_JSONL "|" D_CMND_HASP_CALIBRATE ;
+  D_CMND_HASP_JSON "|" D_CMND_HASP_JSONL "|" D_CMND_HASP_CALIBRATE "|" D_CMND_HASP_PERF ;
 
 void (* const HaspCommand[])(void) PROGMEM = {
   &CmndHasp, &cmndHaspPage, &cmndHaspClearPage, &cmndHaspDim, &cmndHaspLight, &cmndHaspWakeUp,
-  &cmndHaspJson, &cmndHaspJsonl, &cmndHaspCalibrate };
+  &cmndHaspJson, &cmndHaspJsonl, &cmndHaspCalibrate, &cmndHaspPerf };
 
 /*char *dsp_str;
 
@@ -1266,18 +1268,142 @@ void TempLocalSensor(void)
 
 #endif  // USE_DISPLAY_MODES1TO5
 
+/*********************************************************************************************\
+ * Flush
+ *
+ * LVGL renders into two buffers. On ESP32 a finished buffer is sent to the display by a task on
+ * the other core which calls lv_disp_flush_ready() when done, so LVGL renders the next stripe
+ * into the other buffer while SPI is busy. Without the task the flush is synchronous.
+ *
+ * The display driver and renderer are not thread safe. The flush task and every main loop display
+ * access take the same recursive mutex, only LVGL rendering in lv_task_handler() runs unlocked.
+ * Whoever takes the mutex first draws an area handed to the task, and a flush requested while the
+ * main loop holds the mutex is done synchronously, so LVGL never waits for a flush the lock blocks.
+\*********************************************************************************************/
+
+#define HASP_VDB_SIZE          (8 * 1024u)   // Pixels per render buffer (16 KBytes * 2)
+#define HASP_FLUSH_STACK       3072          // Flush task stack size
+
 const lv_area_t* hasp_area_p;
 uint16_t * hasp_color_p;
 
+struct {
+  lv_disp_drv_t *disp;                       // Display driver waiting for flush ready
+  lv_area_t area;                            // Copy of area being flushed as LVGL reuses its own
+#ifdef ESP32
+  TaskHandle_t task;                         // Background flush task
+  SemaphoreHandle_t lock;                    // Display access by flush task and main loop
+  volatile bool pending;                     // Area handed to the flush task and not yet drawn
+#endif  // ESP32
+  uint32_t frames;                           // Refresh cycles
+  uint32_t frames_second;                    // Refresh cycles at last second
+  uint32_t flushes;                          // Flushed areas
+  uint32_t pixels;                           // Flushed pixels
+  uint32_t flush_time;                       // Cumulative flush time in microseconds
+  uint32_t flush_max;                        // Worst case flush time in microseconds
+  uint32_t render_time;                      // Cumulative refresh cycle time in milliseconds
+  uint16_t fps;                              // Refresh cycles during last second
+  uint8_t buffers;                           // Number of render buffers
+} HaspFlush;
+
+void HaspFlushDraw(void)
+{
+  uint32_t start = micros();
+  XdspCall(FUNC_DISPLAY_DRAW_FRAME);
+  uint32_t elapsed = micros() - start;
+  HaspFlush.flush_time += elapsed;
+  if (elapsed > HaspFlush.flush_max) { HaspFlush.flush_max = elapsed; }
+  HaspFlush.flushes++;
+
+  /* Tell lvgl that flushing is done */
+  lv_disp_flush_ready(HaspFlush.disp);
+}
+
+// Take the display, a flush handed to the task is drawn first so LVGL never waits on a flush blocked by the lock
+bool HaspLock(void)
+{
+#ifdef ESP32
+  if (HaspFlush.lock) {
+    xSemaphoreTakeRecursive(HaspFlush.lock, portMAX_DELAY);
+    if (HaspFlush.pending) {
+      HaspFlush.pending = false;
+      HaspFlushDraw();
+    }
+    return true;
+  }
+#endif  // ESP32
+  return false;
+}
+
+void HaspUnlock(void)
+{
+#ifdef ESP32
+  if (HaspFlush.lock) {
+    xSemaphoreGiveRecursive(HaspFlush.lock);
+  }
+#endif  // ESP32
+}
+
+#ifdef ESP32
+void HaspFlushTask(void *arg)
+{
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    HaspLock();                              // Draws the pending area unless the main loop already did
+    HaspUnlock();
+  }
+}
+#endif  // ESP32
+
 void hasp_flush_cb(lv_disp_drv_t * disp, const lv_area_t * area, lv_color_t * data)
 {
-    hasp_area_p = area;
-    hasp_color_p = (uint16_t *)data;
-    XdspCall(FUNC_DISPLAY_DRAW_FRAME);
-    //AddLog_P(LOG_LEVEL_INFO, PSTR("HSP: Flush Buffer"));
+  HaspFlush.disp = disp;
+  HaspFlush.area = *area;
+  HaspFlush.pixels += lv_area_get_size(area);
+  hasp_area_p = &HaspFlush.area;
+  hasp_color_p = (uint16_t *)data;
+#ifdef ESP32
+  if (HaspFlush.task && (xSemaphoreGetMutexHolder(HaspFlush.lock) != xTaskGetCurrentTaskHandle())) {
+    HaspFlush.pending = true;                // LVGL waits for lv_disp_flush_ready() before reusing this buffer
+    xTaskNotifyGive(HaspFlush.task);
+    return;
+  }
+#endif  // ESP32
+  HaspFlushDraw();                           // Without task or with the display locked by this task
+}
+
+void hasp_monitor_cb(lv_disp_drv_t * disp, uint32_t time, uint32_t px)
+{
+  HaspFlush.frames++;
+  HaspFlush.render_time += time;
+}
+
+void HaspFlushInit(lv_disp_drv_t * disp_drv)
+{
+  static lv_disp_buf_t disp_buf;
+
+  lv_color_t * buffer1 = (lv_color_t *)heap_caps_malloc(sizeof(lv_color_t) * HASP_VDB_SIZE, MALLOC_CAP_8BIT);
+  lv_color_t * buffer2 = (lv_color_t *)heap_caps_malloc(sizeof(lv_color_t) * HASP_VDB_SIZE, MALLOC_CAP_8BIT);
+  lv_disp_buf_init(&disp_buf, buffer1, buffer2, HASP_VDB_SIZE);  // buffer2 nullptr falls back to single buffer
+  HaspFlush.buffers = (buffer2) ? 2 : 1;
+#ifdef ESP32
+  if (buffer2) {
+    HaspFlush.lock = xSemaphoreCreateRecursiveMutex();
+  }
+  if (HaspFlush.lock) {
+    xTaskCreatePinnedToCore(HaspFlushTask, "HaspFlush", HASP_FLUSH_STACK, nullptr, 1, &HaspFlush.task, 0);
+  }
+#endif  // ESP32
 
-    /* Tell lvgl that flushing is done */
-    lv_disp_flush_ready(disp);
+  disp_drv->flush_cb = hasp_flush_cb;
+  disp_drv->monitor_cb = hasp_monitor_cb;
+  disp_drv->buffer = &disp_buf;
+}
+
+void HaspFlushEverySecond(void)
+{
+  HaspFlush.fps = HaspFlush.frames - HaspFlush.frames_second;
+  HaspFlush.frames_second = HaspFlush.frames;
 }
 
 /*
@@ -1319,14 +1445,7 @@ void HaspInitDriver(void)
   AddLog_P(LOG_LEVEL_INFO, PSTR("HSP: Init Hasp Driver"));
   XdspCall(FUNC_DISPLAY_INIT_DRIVER);
 
-      /* Initialize the Virtual Device Buffers */
-    size_t guiVDBsize = 0;
     lv_init();
-        static lv_disp_buf_t disp_buf;
- static lv_color_t * guiVdbBuffer1;
-    guiVDBsize    = 16 * 1024u; // 32 KBytes * 2
-    guiVdbBuffer1 = (lv_color_t *)heap_caps_malloc(sizeof(lv_color_t) * guiVDBsize, MALLOC_CAP_8BIT);
-    lv_disp_buf_init(&disp_buf, guiVdbBuffer1, NULL, guiVDBsize);
 
         AddLog_P(LOG_LEVEL_INFO, PSTR("Version  : %u.%u.%u %s"), LVGL_VERSION_MAJOR, LVGL_VERSION_MINOR, LVGL_VERSION_PATCH,
                 PSTR(LVGL_VERSION_INFO));
@@ -1335,9 +1454,8 @@ void HaspInitDriver(void)
     lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv);
 
-    disp_drv.flush_cb = hasp_flush_cb;
+    HaspFlushInit(&disp_drv);          /* Render buffers and flush */
 
-    disp_drv.buffer = &disp_buf;
     disp_drv.hor_res = 240;
     disp_drv.ver_res = 320;
     lv_disp_drv_register(&disp_drv);
@@ -1488,6 +1606,31 @@ void cmndHaspJsonl(void)
   dispatch_topic_payload(XdrvMailbox.command+4,XdrvMailbox.data);
 }
 
+void cmndHaspPerf(void)
+{
+  if ((XdrvMailbox.data_len > 0) && (0 == XdrvMailbox.payload)) {  // Reset statistics
+    HaspFlush.frames = 0;
+    HaspFlush.frames_second = 0;
+    HaspFlush.flushes = 0;
+    HaspFlush.pixels = 0;
+    HaspFlush.flush_time = 0;
+    HaspFlush.flush_max = 0;
+    HaspFlush.render_time = 0;
+  }
+  uint32_t flushes = (HaspFlush.flushes) ? HaspFlush.flushes : 1;
+  uint32_t frames = (HaspFlush.frames) ? HaspFlush.frames : 1;
+  Response_P(PSTR("{\"" D_PRFX_HASP D_CMND_HASP_PERF "\":{\"Buffers\":%d,\"Background\":%d,\"FPS\":%d,\"Frames\":%u,\"FrameAvg\":%u,"
+                  "\"Flushes\":%u,\"Pixels\":%u,\"FlushAvg\":%u,\"FlushMax\":%u}}"),
+    HaspFlush.buffers,
+#ifdef ESP32
+    (HaspFlush.task != nullptr),
+#else
+    0,
+#endif  // ESP32
+    HaspFlush.fps, HaspFlush.frames, HaspFlush.render_time / frames,
+    HaspFlush.flushes, HaspFlush.pixels, HaspFlush.flush_time / flushes, HaspFlush.flush_max);
+}
+
 void cmndHaspCalibrate(void)
 {
   if ((XdrvMailbox.payload >= 0) && (XdrvMailbox.payload < 4)) {
@@ -2187,6 +2330,9 @@ bool Xdrv90(uint8_t function)
 {
   bool result = false;
 
+  // Everything but LVGL rendering may access the display so wait for a background flush
+  bool locked = (function != FUNC_EVERY_50_MSECOND) && HaspLock();
+
 //  if ((TasmotaGlobal.i2c_enabled || TasmotaGlobal.spi_enabled || TasmotaGlobal.soft_spi_enabled) && XdspPresent()) {
     switch (function) {
       case FUNC_WEB_SENSOR:
@@ -2196,12 +2342,14 @@ bool Xdrv90(uint8_t function)
         HaspInitDriver();
         break;
       case FUNC_EVERY_50_MSECOND:
+        dispatchLoop();    // end an unterminated batch update
         lv_task_handler(); // handle lvgl animation tasks
         break;
       case FUNC_SET_POWER:
         HaspSetPower();
         break;
       case FUNC_EVERY_SECOND:
+        HaspFlushEverySecond();
         break;
 #ifdef USE_DISPLAY_MODES1TO5
       case FUNC_MQTT_SUBSCRIBE:
@@ -2219,6 +2367,7 @@ bool Xdrv90(uint8_t function)
         break;
     }
 //  }
+  if (locked) { HaspUnlock(); }
   return result;
 }
 
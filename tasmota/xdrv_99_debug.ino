@@ -33,6 +33,7 @@
 \*********************************************************************************************/
 
 #define XDRV_99             99
+#define XDRV_99_FUNCS       (FUNC_MASK(FUNC_LOOP))
 
 #ifndef CPU_LOAD_CHECK
 #define CPU_LOAD_CHECK      1                 // Seconds between each CPU_LOAD log
@@ -180,6 +181,9 @@ void CpuLoadLoop(void)
       CPU_loops = CPU_loops / CPU_load_check;
       AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_DEBUG "FreeRam %d, CPU %d%%(80MHz), Loops/sec %d"), ESP.getFreeHeap(), CPU_load, CPU_loops);
 #endif
+      uint32_t calls = (XdrvCalls(false) + XsnsCalls(false)) / CPU_load_check;
+      uint32_t skipped = (XdrvCalls(true) + XsnsCalls(true)) / CPU_load_check;
+      AddLog_P(LOG_LEVEL_DEBUG, PSTR(D_LOG_DEBUG "Driver calls/sec %d, skipped %d"), calls, skipped);
       CPU_last_millis = CPU_last_loop_time;
       CPU_loops = 0;
     }
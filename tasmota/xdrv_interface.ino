@@ -829,6 +829,812 @@ const uint8_t kXdrvList[] = {
 #endif
 };
 
+/*********************************************************************************************\
+ * Xdrv periodic function mask list
+ *
+ * A driver declares the periodic functions (FUNC_LOOP up to FUNC_EVERY_SECOND) it handles with
+ * #define XDRV_xx_FUNCS FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_SECOND). Undeclared drivers get all.
+\*********************************************************************************************/
+
+#ifdef XFUNC_PTR_IN_ROM
+const uint8_t kXdrvFuncMask[] PROGMEM = {
+#else
+const uint8_t kXdrvFuncMask[] = {
+#endif
+
+#ifdef XDRV_01
+#ifdef XDRV_01_FUNCS
+  XDRV_01_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_02
+#ifdef XDRV_02_FUNCS
+  XDRV_02_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_03
+#ifdef XDRV_03_FUNCS
+  XDRV_03_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_04
+#ifdef XDRV_04_FUNCS
+  XDRV_04_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_05
+#ifdef XDRV_05_FUNCS
+  XDRV_05_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_06
+#ifdef XDRV_06_FUNCS
+  XDRV_06_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_07
+#ifdef XDRV_07_FUNCS
+  XDRV_07_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_08
+#ifdef XDRV_08_FUNCS
+  XDRV_08_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_09
+#ifdef XDRV_09_FUNCS
+  XDRV_09_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_10
+#ifdef XDRV_10_FUNCS
+  XDRV_10_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_11
+#ifdef XDRV_11_FUNCS
+  XDRV_11_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_12
+#ifdef XDRV_12_FUNCS
+  XDRV_12_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_13
+#ifdef XDRV_13_FUNCS
+  XDRV_13_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_14
+#ifdef XDRV_14_FUNCS
+  XDRV_14_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_15
+#ifdef XDRV_15_FUNCS
+  XDRV_15_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_16
+#ifdef XDRV_16_FUNCS
+  XDRV_16_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_17
+#ifdef XDRV_17_FUNCS
+  XDRV_17_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_18
+#ifdef XDRV_18_FUNCS
+  XDRV_18_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_19
+#ifdef XDRV_19_FUNCS
+  XDRV_19_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_20
+#ifdef XDRV_20_FUNCS
+  XDRV_20_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_21
+#ifdef XDRV_21_FUNCS
+  XDRV_21_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_22
+#ifdef XDRV_22_FUNCS
+  XDRV_22_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_23
+#ifdef XDRV_23_FUNCS
+  XDRV_23_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_24
+#ifdef XDRV_24_FUNCS
+  XDRV_24_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_25
+#ifdef XDRV_25_FUNCS
+  XDRV_25_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_26
+#ifdef XDRV_26_FUNCS
+  XDRV_26_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_27
+#ifdef XDRV_27_FUNCS
+  XDRV_27_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_28
+#ifdef XDRV_28_FUNCS
+  XDRV_28_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_29
+#ifdef XDRV_29_FUNCS
+  XDRV_29_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_30
+#ifdef XDRV_30_FUNCS
+  XDRV_30_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_31
+#ifdef XDRV_31_FUNCS
+  XDRV_31_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_32
+#ifdef XDRV_32_FUNCS
+  XDRV_32_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_33
+#ifdef XDRV_33_FUNCS
+  XDRV_33_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_34
+#ifdef XDRV_34_FUNCS
+  XDRV_34_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_35
+#ifdef XDRV_35_FUNCS
+  XDRV_35_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_36
+#ifdef XDRV_36_FUNCS
+  XDRV_36_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_37
+#ifdef XDRV_37_FUNCS
+  XDRV_37_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_38
+#ifdef XDRV_38_FUNCS
+  XDRV_38_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_39
+#ifdef XDRV_39_FUNCS
+  XDRV_39_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_40
+#ifdef XDRV_40_FUNCS
+  XDRV_40_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_41
+#ifdef XDRV_41_FUNCS
+  XDRV_41_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_42
+#ifdef XDRV_42_FUNCS
+  XDRV_42_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_43
+#ifdef XDRV_43_FUNCS
+  XDRV_43_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_44
+#ifdef XDRV_44_FUNCS
+  XDRV_44_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_45
+#ifdef XDRV_45_FUNCS
+  XDRV_45_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_46
+#ifdef XDRV_46_FUNCS
+  XDRV_46_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_47
+#ifdef XDRV_47_FUNCS
+  XDRV_47_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_48
+#ifdef XDRV_48_FUNCS
+  XDRV_48_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_49
+#ifdef XDRV_49_FUNCS
+  XDRV_49_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_50
+#ifdef XDRV_50_FUNCS
+  XDRV_50_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_51
+#ifdef XDRV_51_FUNCS
+  XDRV_51_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_52
+#ifdef XDRV_52_FUNCS
+  XDRV_52_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_53
+#ifdef XDRV_53_FUNCS
+  XDRV_53_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_54
+#ifdef XDRV_54_FUNCS
+  XDRV_54_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_55
+#ifdef XDRV_55_FUNCS
+  XDRV_55_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_56
+#ifdef XDRV_56_FUNCS
+  XDRV_56_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_57
+#ifdef XDRV_57_FUNCS
+  XDRV_57_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_58
+#ifdef XDRV_58_FUNCS
+  XDRV_58_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_59
+#ifdef XDRV_59_FUNCS
+  XDRV_59_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_60
+#ifdef XDRV_60_FUNCS
+  XDRV_60_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_61
+#ifdef XDRV_61_FUNCS
+  XDRV_61_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_62
+#ifdef XDRV_62_FUNCS
+  XDRV_62_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_63
+#ifdef XDRV_63_FUNCS
+  XDRV_63_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_64
+#ifdef XDRV_64_FUNCS
+  XDRV_64_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_65
+#ifdef XDRV_65_FUNCS
+  XDRV_65_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_66
+#ifdef XDRV_66_FUNCS
+  XDRV_66_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_67
+#ifdef XDRV_67_FUNCS
+  XDRV_67_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_68
+#ifdef XDRV_68_FUNCS
+  XDRV_68_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_69
+#ifdef XDRV_69_FUNCS
+  XDRV_69_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_70
+#ifdef XDRV_70_FUNCS
+  XDRV_70_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_71
+#ifdef XDRV_71_FUNCS
+  XDRV_71_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_72
+#ifdef XDRV_72_FUNCS
+  XDRV_72_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_73
+#ifdef XDRV_73_FUNCS
+  XDRV_73_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_74
+#ifdef XDRV_74_FUNCS
+  XDRV_74_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_75
+#ifdef XDRV_75_FUNCS
+  XDRV_75_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_76
+#ifdef XDRV_76_FUNCS
+  XDRV_76_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_77
+#ifdef XDRV_77_FUNCS
+  XDRV_77_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_78
+#ifdef XDRV_78_FUNCS
+  XDRV_78_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_79
+#ifdef XDRV_79_FUNCS
+  XDRV_79_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_80
+#ifdef XDRV_80_FUNCS
+  XDRV_80_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_81
+#ifdef XDRV_81_FUNCS
+  XDRV_81_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_82
+#ifdef XDRV_82_FUNCS
+  XDRV_82_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_83
+#ifdef XDRV_83_FUNCS
+  XDRV_83_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_84
+#ifdef XDRV_84_FUNCS
+  XDRV_84_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_85
+#ifdef XDRV_85_FUNCS
+  XDRV_85_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_86
+#ifdef XDRV_86_FUNCS
+  XDRV_86_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_87
+#ifdef XDRV_87_FUNCS
+  XDRV_87_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_88
+#ifdef XDRV_88_FUNCS
+  XDRV_88_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_89
+#ifdef XDRV_89_FUNCS
+  XDRV_89_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_90
+#ifdef XDRV_90_FUNCS
+  XDRV_90_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_91
+#ifdef XDRV_91_FUNCS
+  XDRV_91_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_92
+#ifdef XDRV_92_FUNCS
+  XDRV_92_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_93
+#ifdef XDRV_93_FUNCS
+  XDRV_93_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_94
+#ifdef XDRV_94_FUNCS
+  XDRV_94_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_95
+#ifdef XDRV_95_FUNCS
+  XDRV_95_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_96
+#ifdef XDRV_96_FUNCS
+  XDRV_96_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_97
+#ifdef XDRV_97_FUNCS
+  XDRV_97_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_98
+#ifdef XDRV_98_FUNCS
+  XDRV_98_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XDRV_99
+#ifdef XDRV_99_FUNCS
+  XDRV_99_FUNCS
+#else
+  FUNC_DISPATCH_ALL
+#endif
+#endif
+};
+
 /*********************************************************************************************/
 
 void XsnsDriverState(void)
@@ -845,6 +1651,20 @@ void XsnsDriverState(void)
   ResponseAppend_P(PSTR("\""));
 }
 
+uint32_t XdrvPresent(void)
+{
+  return xdrv_present;
+}
+
+uint32_t XdrvId(uint32_t index)
+{
+#ifdef XFUNC_PTR_IN_ROM
+  return pgm_read_byte(kXdrvList + index);
+#else
+  return kXdrvList[index];
+#endif
+}
+
 /*********************************************************************************************/
 
 bool XdrvRulesProcess(void)
@@ -875,12 +1695,64 @@ bool XdrvCallDriver(uint32_t driver, uint8_t Function)
     uint32_t listed = kXdrvList[x];
 #endif
     if (driver == listed) {
+#ifdef USE_PROFILER
+      uint32_t profile_start = ProfileStart();
+      bool result = xdrv_func_ptr[x](Function);
+      ProfileXdrv(x, Function, profile_start);
+      return result;
+#else
       return xdrv_func_ptr[x](Function);
+#endif  // USE_PROFILER
     }
   }
   return false;
 }
 
+/*********************************************************************************************\
+ * Periodic function dispatch lists
+\*********************************************************************************************/
+
+struct {
+#ifdef USE_DEBUG_DRIVER
+  uint32_t calls;                             // Number of driver calls
+  uint32_t skipped;                           // Number of driver calls saved by dispatch lists
+#endif  // USE_DEBUG_DRIVER
+  uint8_t count[FUNC_DISPATCH_MAX];           // Number of drivers per periodic function
+  uint8_t list[FUNC_DISPATCH_MAX][xdrv_present];  // Driver indexes per periodic function
+  bool ready;
+} XdrvDispatch;
+
+void XdrvDispatchInit(void)
+{
+  memset(XdrvDispatch.count, 0, sizeof(XdrvDispatch.count));
+  for (uint32_t x = 0; x < xdrv_present; x++) {
+#ifdef XFUNC_PTR_IN_ROM
+    uint32_t mask = pgm_read_byte(kXdrvFuncMask + x);
+#else
+    uint32_t mask = kXdrvFuncMask[x];
+#endif
+    for (uint32_t i = 0; i < FUNC_DISPATCH_MAX; i++) {
+      if (bitRead(mask, i)) {
+        XdrvDispatch.list[i][XdrvDispatch.count[i]++] = x;
+      }
+    }
+  }
+  XdrvDispatch.ready = true;
+}
+
+#ifdef USE_DEBUG_DRIVER
+uint32_t XdrvCalls(bool skipped)
+{
+  uint32_t calls = (skipped) ? XdrvDispatch.skipped : XdrvDispatch.calls;
+  if (skipped) {
+    XdrvDispatch.skipped = 0;
+  } else {
+    XdrvDispatch.calls = 0;
+  }
+  return calls;
+}
+#endif  // USE_DEBUG_DRIVER
+
 /*********************************************************************************************\
  * Function call to all xdrv
 \*********************************************************************************************/
@@ -891,8 +1763,41 @@ bool XdrvCall(uint8_t Function)
 
   DEBUG_TRACE_LOG(PSTR("DRV: %d"), Function);
 
+  if (FUNC_PRE_INIT == Function) {
+    XdrvDispatchInit();
+  }
+
+  if (XdrvDispatch.ready && (Function >= FUNC_DISPATCH_FIRST) && (Function <= FUNC_DISPATCH_LAST)) {
+    uint32_t index = Function - FUNC_DISPATCH_FIRST;
+    uint32_t count = XdrvDispatch.count[index];
+#ifdef USE_DEBUG_DRIVER
+    XdrvDispatch.calls += count;
+    XdrvDispatch.skipped += xdrv_present - count;
+#endif  // USE_DEBUG_DRIVER
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t x = XdrvDispatch.list[index][i];
+#ifdef USE_PROFILER
+      uint32_t profile_start = ProfileStart();
+#endif  // USE_PROFILER
+      xdrv_func_ptr[x](Function);              // Periodic functions never break the chain
+#ifdef USE_PROFILER
+      ProfileXdrv(x, Function, profile_start);
+#endif  // USE_PROFILER
+    }
+    return false;
+  }
+
   for (uint32_t x = 0; x < xdrv_present; x++) {
+#ifdef USE_DEBUG_DRIVER
+    XdrvDispatch.calls++;
+#endif  // USE_DEBUG_DRIVER
+#ifdef USE_PROFILER
+    uint32_t profile_start = ProfileStart();
+#endif  // USE_PROFILER
     result = xdrv_func_ptr[x](Function);
+#ifdef USE_PROFILER
+    ProfileXdrv(x, Function, profile_start);
+#endif  // USE_PROFILER
 
     if (result && ((FUNC_COMMAND == Function) ||
                    (FUNC_COMMAND_DRIVER == Function) ||
@@ -164,6 +164,7 @@ uint8_t kWsRepeat[5] = {
     1 };   // All
 
 struct WS2812 {
+  uint8_t *gamma = nullptr;              // ledGamma() lookup table applied to the strip buffer
   uint8_t show_next = 1;
   uint8_t scheme_offset = 0;
   bool suspend_update = false;
@@ -171,6 +172,21 @@ struct WS2812 {
 
 /********************************************************************************************/
 
+uint8_t* Ws2812GammaTable(void)
+{
+#if (USE_WS2812_HARDWARE != NEO_HW_P9813)  // P9813 buffer holds a color dependent flag byte per pixel
+  if (!Ws2812.gamma) {
+    Ws2812.gamma = (uint8_t*)malloc(256);
+    if (Ws2812.gamma) {
+      for (uint32_t i = 0; i < 256; i++) {
+        Ws2812.gamma[i] = ledGamma(i);
+      }
+    }
+  }
+#endif  // NEO_HW_P9813
+  return Ws2812.gamma;
+}
+
 void Ws2812StripShow(void)
 {
 #if (USE_WS2812_CTYPE > NEO_3LED)
@@ -180,15 +196,26 @@ void Ws2812StripShow(void)
 #endif
 
   if (Settings.light_correction) {
-    for (uint32_t i = 0; i < Settings.light_pixels; i++) {
-      c = strip->GetPixelColor(i);
-      c.R = ledGamma(c.R);
-      c.G = ledGamma(c.G);
-      c.B = ledGamma(c.B);
+    uint8_t *gamma = Ws2812GammaTable();
+    if (gamma) {
+      // Gamma is the same for every channel so correct the strip buffer bytes in place regardless of color order
+      uint8_t *pixels = strip->Pixels();
+      uint32_t size = Settings.light_pixels * strip->PixelSize();
+      for (uint32_t i = 0; i < size; i++) {
+        pixels[i] = gamma[pixels[i]];
+      }
+      strip->Dirty();
+    } else {
+      for (uint32_t i = 0; i < Settings.light_pixels; i++) {
+        c = strip->GetPixelColor(i);
+        c.R = ledGamma(c.R);
+        c.G = ledGamma(c.G);
+        c.B = ledGamma(c.B);
 #if (USE_WS2812_CTYPE > NEO_3LED)
-      c.W = ledGamma(c.W);
+        c.W = ledGamma(c.W);
 #endif
-      strip->SetPixelColor(i, c);
+        strip->SetPixelColor(i, c);
+      }
     }
   }
   strip->Show();
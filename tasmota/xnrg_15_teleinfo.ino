@@ -152,7 +152,7 @@ void ADPSCallback(uint8_t phase)
     }
 
     Response_P(PSTR("{"));
-    ResponseAppend_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("{\"%s\":{\"ADPS\":%i}}"), serialNumber, phase );
+    ResponseAppend_P(PSTR("\"%s\":{\"ADPS\":%i}"), serialNumber, phase );
     ResponseJsonEnd();
 
     // Publish adding ADCO serial number into the topic
@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XSNS_01             1
+#define XSNS_01_FUNCS       (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #define USE_AC_ZERO_CROSS_DIMMER 1
 
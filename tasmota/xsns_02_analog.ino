@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XSNS_02                       2
+#define XSNS_02_FUNCS                 (FUNC_MASK(FUNC_EVERY_250_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #ifdef ESP8266
 #define ANALOG_RESOLUTION             10               // 12 = 4095, 11 = 2047, 10 = 1023
@@ -55,6 +55,7 @@
 \*********************************************************************************************/
 
 #define XSNS_04             4
+#define XSNS_04_FUNCS       0
 
 uint16_t sc_value[5] = { 0 };
 
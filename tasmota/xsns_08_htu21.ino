@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_08             8
+#define XSNS_08_FUNCS       (FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_09             9       // See I2CDEVICES.md
 
 #define HTU21_ADDR          0x40
@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_09              9
+#define XSNS_09_FUNCS        (FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_10              10  // See I2CDEVICES.md
 
 #define BMP_ADDR1            0x76
@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_14             14
+#define XSNS_14_FUNCS       0
 #define XI2C_15             15         // See I2CDEVICES.md
 
 #define SHT3X_ADDR_GND      0x44       // address pin low (GND)
@@ -31,6 +31,7 @@
 \*********************************************************************************************/
 
 #define XSNS_15                      15
+#define XSNS_15_FUNCS                (FUNC_MASK(FUNC_EVERY_SECOND))
 
 enum MhzFilterOptions {MHZ19_FILTER_OFF, MHZ19_FILTER_OFF_ALLSAMPLES, MHZ19_FILTER_FAST, MHZ19_FILTER_MEDIUM, MHZ19_FILTER_SLOW};
 
@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_18             18
+#define XSNS_18_FUNCS       (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_20             20
+#define XSNS_20_FUNCS       (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
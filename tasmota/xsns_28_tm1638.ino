@@ -25,6 +25,7 @@
 \*********************************************************************************************/
 
 #define XSNS_28             28
+#define XSNS_28_FUNCS       (FUNC_MASK(FUNC_EVERY_50_MSECOND))
 
 #define TM1638_COLOR_NONE   0
 #define TM1638_COLOR_RED    1
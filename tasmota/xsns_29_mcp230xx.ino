@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_29                   29
+#define XSNS_29_FUNCS             (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_22                   22  // See I2CDEVICES.md
 
 /*
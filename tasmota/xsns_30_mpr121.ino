@@ -51,6 +51,7 @@
  * Assign Tasmota sensor model ID
  */
 #define XSNS_30          30
+#define XSNS_30_FUNCS    (FUNC_MASK(FUNC_EVERY_50_MSECOND))
 #define XI2C_23          23  // See I2CDEVICES.md
 
 /** @defgroup group1 MPR121
@@ -28,6 +28,7 @@
 \*********************************************************************************************/
 
 #define XSNS_32                          32
+#define XSNS_32_FUNCS                    (FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_25                          25  // See I2CDEVICES.md
 
 #define D_SENSOR_MPU6050                 "MPU6050"
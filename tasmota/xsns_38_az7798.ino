@@ -20,6 +20,7 @@
 #ifdef USE_AZ7798
 
 #define XSNS_38 38
+#define XSNS_38_FUNCS (FUNC_MASK(FUNC_EVERY_SECOND))
 
 /*********************************************************************************************\
  * CO2, temperature and humidity meter and data logger
@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_39              39
+#define XSNS_39_FUNCS        (FUNC_MASK(FUNC_EVERY_SECOND))
 
 const char kMax31855Types[] PROGMEM = "MAX31855|MAX6675";
 
@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_41			           41
+#define XSNS_41_FUNCS        (FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_28                28  // See I2CDEVICES.md
 
 #define MAX44009_ADDR1         0x4A
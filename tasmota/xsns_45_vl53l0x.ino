@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_45     45
+#define XSNS_45_FUNCS (FUNC_MASK(FUNC_EVERY_250_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_31     31  // See I2CDEVICES.md
 
 #include <Wire.h>
@@ -21,6 +21,7 @@
 #ifdef USE_MLX90614
 
 #define XSNS_46         46
+#define XSNS_46_FUNCS   (FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_32         32  // See I2CDEVICES.md
 
 #define I2_ADR_IRT      0x5a
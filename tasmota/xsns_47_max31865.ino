@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XSNS_47              47
+#define XSNS_47_FUNCS        (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #if MAX31865_PTD_WIRES == 4
   #define PTD_WIRES MAX31865_4WIRE
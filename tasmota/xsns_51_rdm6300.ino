@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_51            51
+#define XSNS_51_FUNCS      (FUNC_MASK(FUNC_EVERY_100_MSECOND))
 
 #define RDM6300_BAUDRATE   9600
 #define RDM_TIMEOUT        100
@@ -20,6 +20,7 @@
 #ifdef USE_IBEACON
 
 #define XSNS_52                       52
+#define XSNS_52_FUNCS                 (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_250_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 // keyfob expires after N seconds
 #define IB_TIMEOUT_INTERVAL 30
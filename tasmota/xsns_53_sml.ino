@@ -24,6 +24,7 @@
 #ifdef USE_SML_M
 
 #define XSNS_53 53
+#define XSNS_53_FUNCS (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_100_MSECOND))
 
 // default baudrate of D0 output
 #define SML_BAUDRATE 9600
@@ -468,6 +469,20 @@ uint8_t meters_used;
 
 struct METER_DESC const *meter_desc_p;
 const uint8_t *meter_p;
+
+// compiled meter definition, entries grouped per meter
+struct SML_ENTRY {
+  const char *mp;         // entry text after meter number
+  uint16_t pattern;       // offset of sml pattern bytes in sml_patterns
+  uint8_t pattern_len;    // precompiled compare length, 0 = interpret entry text
+  uint8_t value;          // offset of @ in entry text
+  uint8_t vindex;         // meter variable index
+  uint8_t dindex;         // delta variable index
+};
+struct SML_ENTRY *sml_entries;
+uint8_t *sml_patterns;
+const uint8_t *sml_compiled_p;
+uint16_t sml_entry_start[MAX_METERS+1];
 uint8_t meter_spos[MAX_METERS];
 
 // software serial pointers
@@ -482,6 +497,11 @@ HardwareSerial *meter_ss[MAX_METERS];
 #ifndef SML_BSIZ
 #define SML_BSIZ 48
 #endif
+
+// bytes read from the serial port at once in SML_Poll
+#ifndef SML_PBSIZ
+#define SML_PBSIZ 32
+#endif
 uint8_t smltbuf[MAX_METERS][SML_BSIZ];
 
 // meter nr as string
@@ -960,7 +980,7 @@ uint8_t *skip_sml(uint8_t *cp,int16_t *res) {
 // get sml binary value
 // not defined for unsigned >0x7fff ffff ffff ffff (should never happen)
 double sml_getvalue(unsigned char *cp,uint8_t index) {
-uint8_t len,unit,type;
+uint8_t len,type;
 int16_t scaler,result;
 int64_t value;
 double dval;
@@ -1199,15 +1219,12 @@ void sml_empty_receiver(uint32_t meters) {
 }
 
 
-void sml_shift_in(uint32_t meters,uint32_t shard) {
-  uint32_t count;
+// shift in one received byte, returns false when the rest of the input was discarded
+bool sml_shift_in(uint32_t meters,uint8_t iob) {
   if (meter_desc_p[meters].type!='e' && meter_desc_p[meters].type!='m' && meter_desc_p[meters].type!='M' && meter_desc_p[meters].type!='p' && meter_desc_p[meters].type!='R') {
     // shift in
-    for (count=0; count<SML_BSIZ-1; count++) {
-      smltbuf[meters][count]=smltbuf[meters][count+1];
-    }
+    memmove(&smltbuf[meters][0],&smltbuf[meters][1],SML_BSIZ-1);
   }
-  uint8_t iob=(uint8_t)meter_ss[meters]->read();
 
   if (meter_desc_p[meters].type=='o') {
     smltbuf[meters][SML_BSIZ-1]=iob&0x7f;
@@ -1228,6 +1245,7 @@ void sml_shift_in(uint32_t meters,uint32_t shard) {
         SML_Decode(meters);
         sml_empty_receiver(meters);
         meter_spos[meters]=0;
+        return false;
       }
     }
   } else if (meter_desc_p[meters].type=='p') {
@@ -1237,6 +1255,7 @@ void sml_shift_in(uint32_t meters,uint32_t shard) {
       SML_Decode(meters);
       sml_empty_receiver(meters);
       meter_spos[meters]=0;
+      return false;
     }
   } else if (meter_desc_p[meters].type=='R') {
     smltbuf[meters][meter_spos[meters]] = iob;
@@ -1262,7 +1281,7 @@ void sml_shift_in(uint32_t meters,uint32_t shard) {
         }
       }
       meter_spos[meters]=0;
-      return;
+      return true;
     }
 		smltbuf[meters][meter_spos[meters]] = iob;
 		meter_spos[meters]++;
@@ -1272,38 +1291,62 @@ void sml_shift_in(uint32_t meters,uint32_t shard) {
   }
   sb_counter++;
   if (meter_desc_p[meters].type!='e' && meter_desc_p[meters].type!='m' && meter_desc_p[meters].type!='M' && meter_desc_p[meters].type!='p' && meter_desc_p[meters].type!='R') SML_Decode(meters);
+  return true;
 }
 
 
 // polled every 50 ms
 void SML_Poll(void) {
 uint32_t meters;
+uint8_t iob[SML_PBSIZ];
 
     for (meters=0; meters<meters_used; meters++) {
       if (meter_desc_p[meters].type!='c') {
-        // poll for serial input
+        // poll for serial input, read what is available in blocks
         if (!meter_ss[meters]) continue;
-        while (meter_ss[meters]->available()) {
-          sml_shift_in(meters,0);
+        uint32_t avail;
+        while ((avail=meter_ss[meters]->available())) {
+          if (avail>sizeof(iob)) avail=sizeof(iob);
+#ifdef ESP8266
+          uint32_t len=meter_ss[meters]->read(iob,avail);
+#endif  // ESP8266
+#ifdef ESP32
+          uint32_t len=meter_ss[meters]->readBytes(iob,avail);
+#endif  // ESP32
+          if (!len) break;
+          for (uint32_t cnt=0; cnt<len; cnt++) {
+            if (!sml_shift_in(meters,iob[cnt])) break;
+          }
         }
       }
     }
 }
 
 
-void SML_Decode(uint8_t index) {
+// compile meter definition text once into entries grouped per meter
+void SML_FreeEntries(void) {
+  if (sml_entries) {
+    free(sml_entries);
+    sml_entries=0;
+  }
+  if (sml_patterns) {
+    free(sml_patterns);
+    sml_patterns=0;
+  }
+  sml_compiled_p=0;
+}
+
+// walk definition like the decoder did, count entries or fill them if allocated
+uint32_t SML_WalkEntries(uint16_t *count, uint32_t *pattern_bytes) {
   const char *mp=(const char*)meter_p;
-  int8_t mindex;
-  uint8_t *cp;
-  uint8_t dindex=0,vindex=0;
-  delay(0);
+  uint16_t filled[MAX_METERS]={0};
+  uint8_t dcount[MAX_METERS]={0};
+  uint32_t pattern_pos=0;
+  uint32_t entries=0;
+  uint8_t vindex=0;
   while (mp != NULL) {
-    // check list of defines
     if (*mp==0) break;
-
-    // new section
-    mindex=((*mp)&7)-1;
-
+    int8_t mindex=((*mp)&7)-1;
     if (mindex<0 || mindex>=meters_used) mindex=0;
     mp+=2;
     if (*mp=='=' && *(mp+1)=='h') {
@@ -1312,315 +1355,391 @@ void SML_Decode(uint8_t index) {
       continue;
     }
 
-    if (index!=mindex) goto nextsect;
+    // sml hex and obis text compares are matched with memcmp
+    uint8_t value=0;
+    uint8_t pattern_len=0;
+    uint8_t type=meter_desc_p[mindex].type;
+    if (*mp!='=' && (type=='s' || type=='o' || type=='c')) {
+      const char *ep=mp;
+      while (*ep && *ep!='@' && *ep!='|') ep++;
+      uint32_t len=ep-mp;
+      if (*ep=='@' && len<256 && !(type=='s' && (len&1))) {
+        value=len;
+        pattern_len=(type=='s') ? len/2 : len;
+      }
+    }
+    if (sml_entries) {
+      struct SML_ENTRY *entry=&sml_entries[sml_entry_start[mindex]+filled[mindex]];
+      entry->mp=mp;
+      entry->vindex=vindex;
+      entry->dindex=dcount[mindex];
+      entry->value=value;
+      entry->pattern_len=pattern_len;
+      entry->pattern=pattern_pos;
+      if (pattern_len && type=='s') {
+        for (uint32_t cnt=0; cnt<pattern_len; cnt++) {
+          sml_patterns[pattern_pos++]=(hexnibble(mp[cnt*2])<<4)|hexnibble(mp[cnt*2+1]);
+        }
+      }
+    } else if (type=='s') {
+      *pattern_bytes+=pattern_len;
+    }
+    if (*mp=='=' && *(mp+1)=='d') dcount[mindex]++;
+    filled[mindex]++;
+    entries++;
+
+    if (vindex<SML_MAX_VARS-1) {
+      vindex++;
+    }
+    mp = strchr(mp, '|');
+    if (mp) mp++;
+  }
+  if (count) {
+    for (uint32_t cnt=0; cnt<MAX_METERS; cnt++) count[cnt]=filled[cnt];
+  }
+  return entries;
+}
+
+void SML_Compile(void) {
+  SML_FreeEntries();
+  if (!meter_p) return;
+
+  uint16_t count[MAX_METERS];
+  uint32_t pattern_bytes=0;
+  uint32_t entries=SML_WalkEntries(count,&pattern_bytes);
+  sml_entry_start[0]=0;
+  for (uint32_t cnt=0; cnt<MAX_METERS; cnt++) {
+    sml_entry_start[cnt+1]=sml_entry_start[cnt]+count[cnt];
+  }
+  sml_entries=(struct SML_ENTRY*)calloc(entries+1,sizeof(struct SML_ENTRY));
+  sml_patterns=(uint8_t*)malloc(pattern_bytes+1);
+  if (!sml_entries || !sml_patterns) {
+    SML_FreeEntries();
+    AddLog_P(LOG_LEVEL_ERROR, PSTR("SML: not enough memory for meter definition"));
+    return;
+  }
+  SML_WalkEntries(0,0);
+  sml_compiled_p=meter_p;
+}
 
-    // start of serial source buffer
-    cp=&smltbuf[mindex][0];
+void SML_Decode(uint8_t index) {
+  if (sml_compiled_p!=meter_p) SML_Compile();
+  if (!sml_entries || index>=MAX_METERS) return;
+  delay(0);
+  for (uint32_t cnt=sml_entry_start[index]; cnt<sml_entry_start[index+1]; cnt++) {
+    SML_DecodeEntry(index,cnt);
+  }
+}
 
-    // compare
-    if (*mp=='=') {
-      // calculated entry, check syntax
+void SML_DecodeEntry(uint8_t mindex, uint32_t entry_index) {
+  struct SML_ENTRY *entry=&sml_entries[entry_index];
+  const char *mp=entry->mp;
+  uint8_t vindex=entry->vindex;
+  uint8_t dindex=entry->dindex;
+
+  // start of serial source buffer
+  uint8_t *cp=&smltbuf[mindex][0];
+
+  // compare
+  if (*mp=='=') {
+    // calculated entry, check syntax
+    mp++;
+    // do math m 1+2+3
+    if (*mp=='m' && !sb_counter) {
+      // only every 256 th byte
+      // else it would be calculated every single serial byte
       mp++;
-      // do math m 1+2+3
-      if (*mp=='m' && !sb_counter) {
-        // only every 256 th byte
-        // else it would be calculated every single serial byte
+      while (*mp==' ') mp++;
+      // 1. index
+      double dvar;
+      uint8_t opr;
+      uint32_t ind;
+      ind=atoi(mp);
+      while (*mp>='0' && *mp<='9') mp++;
+      if (ind<1 || ind>SML_MAX_VARS) ind=1;
+      dvar=meter_vars[ind-1];
+      for (uint8_t p=0;p<5;p++) {
+        if (*mp=='@') {
+          // store result
+          meter_vars[vindex]=dvar;
+          mp++;
+          SML_Immediate_MQTT((const char*)mp,vindex,mindex);
+          break;
+        }
+        opr=*mp;
         mp++;
-        while (*mp==' ') mp++;
-        // 1. index
-        double dvar;
-        uint8_t opr;
-        uint32_t ind;
+        uint8_t iflg=0;
+        if (*mp=='#') {
+          iflg=1;
+          mp++;
+        }
         ind=atoi(mp);
         while (*mp>='0' && *mp<='9') mp++;
         if (ind<1 || ind>SML_MAX_VARS) ind=1;
-        dvar=meter_vars[ind-1];
-        for (uint8_t p=0;p<5;p++) {
-          if (*mp=='@') {
-            // store result
-            meter_vars[vindex]=dvar;
-            mp++;
-            SML_Immediate_MQTT((const char*)mp,vindex,mindex);
-            break;
-          }
-          opr=*mp;
+        switch (opr) {
+            case '+':
+              if (iflg) dvar+=ind;
+              else dvar+=meter_vars[ind-1];
+              break;
+            case '-':
+              if (iflg) dvar-=ind;
+              else dvar-=meter_vars[ind-1];
+              break;
+            case '*':
+              if (iflg) dvar*=ind;
+              else dvar*=meter_vars[ind-1];
+              break;
+            case '/':
+              if (iflg) dvar/=ind;
+              else dvar/=meter_vars[ind-1];
+              break;
+        }
+        while (*mp==' ') mp++;
+        if (*mp=='@') {
+          // store result
+          meter_vars[vindex]=dvar;
           mp++;
-          uint8_t iflg=0;
-          if (*mp=='#') {
-            iflg=1;
-            mp++;
-          }
-          ind=atoi(mp);
-          while (*mp>='0' && *mp<='9') mp++;
-          if (ind<1 || ind>SML_MAX_VARS) ind=1;
-          switch (opr) {
-              case '+':
-                if (iflg) dvar+=ind;
-                else dvar+=meter_vars[ind-1];
-                break;
-              case '-':
-                if (iflg) dvar-=ind;
-                else dvar-=meter_vars[ind-1];
-                break;
-              case '*':
-                if (iflg) dvar*=ind;
-                else dvar*=meter_vars[ind-1];
-                break;
-              case '/':
-                if (iflg) dvar/=ind;
-                else dvar/=meter_vars[ind-1];
-                break;
-          }
-          while (*mp==' ') mp++;
-          if (*mp=='@') {
-            // store result
-            meter_vars[vindex]=dvar;
+          SML_Immediate_MQTT((const char*)mp,vindex,mindex);
+          break;
+        }
+      }
+    } else if (*mp=='d') {
+      // calc deltas d ind 10 (eg every 10 secs)
+      if (dindex<MAX_DVARS) {
+        // only n indexes
+        mp++;
+        while (*mp==' ') mp++;
+        uint8_t ind=atoi(mp);
+        while (*mp>='0' && *mp<='9') mp++;
+        if (ind<1 || ind>SML_MAX_VARS) ind=1;
+        uint32_t delay=atoi(mp)*1000;
+        uint32_t dtime=millis()-dtimes[dindex];
+        if (dtime>delay) {
+          // calc difference
+          dtimes[dindex]=millis();
+          double vdiff = meter_vars[ind-1]-dvalues[dindex];
+          dvalues[dindex]=meter_vars[ind-1];
+          meter_vars[vindex]=(double)360000.0*vdiff/((double)dtime/10000.0);
+
+          mp=strchr(mp,'@');
+          if (mp) {
             mp++;
             SML_Immediate_MQTT((const char*)mp,vindex,mindex);
-            break;
-          }
-        }
-      } else if (*mp=='d') {
-        // calc deltas d ind 10 (eg every 10 secs)
-        if (dindex<MAX_DVARS) {
-          // only n indexes
-          mp++;
-          while (*mp==' ') mp++;
-          uint8_t ind=atoi(mp);
-          while (*mp>='0' && *mp<='9') mp++;
-          if (ind<1 || ind>SML_MAX_VARS) ind=1;
-          uint32_t delay=atoi(mp)*1000;
-          uint32_t dtime=millis()-dtimes[dindex];
-          if (dtime>delay) {
-            // calc difference
-            dtimes[dindex]=millis();
-            double vdiff = meter_vars[ind-1]-dvalues[dindex];
-            dvalues[dindex]=meter_vars[ind-1];
-            meter_vars[vindex]=(double)360000.0*vdiff/((double)dtime/10000.0);
-
-            mp=strchr(mp,'@');
-            if (mp) {
-              mp++;
-              SML_Immediate_MQTT((const char*)mp,vindex,mindex);
-            }
           }
-          dindex++;
         }
-      } else if (*mp=='h') {
-        // skip html tag line
-        mp = strchr(mp, '|');
-        if (mp) mp++;
-        continue;
       }
-    } else {
-      // compare value
-      uint8_t found=1;
-      uint32_t ebus_dval=99;
-      float mbus_dval=99;
-      while (*mp!='@') {
-        if (meter_desc_p[mindex].type=='o' || meter_desc_p[mindex].type=='c') {
-          if (*mp++!=*cp++) {
+    } else if (*mp=='h') {
+      // skip html tag line
+      return;
+    }
+  } else {
+    // compare value
+    uint8_t found=1;
+    uint32_t ebus_dval=99;
+    float mbus_dval=99;
+    if (entry->pattern_len) {
+      // precompiled pattern, sml hex bytes or literal obis text
+      const uint8_t *pattern=(meter_desc_p[mindex].type=='s') ? &sml_patterns[entry->pattern] : (const uint8_t*)mp;
+      if (memcmp(cp,pattern,entry->pattern_len)) return;
+      cp+=entry->pattern_len;
+      mp+=entry->value;
+    }
+    while (*mp!='@') {
+      if (meter_desc_p[mindex].type=='o' || meter_desc_p[mindex].type=='c') {
+        if (*mp++!=*cp++) {
+          found=0;
+        }
+      } else {
+        if (meter_desc_p[mindex].type=='s') {
+          // sml
+          uint8_t val = hexnibble(*mp++) << 4;
+          val |= hexnibble(*mp++);
+          if (val!=*cp++) {
             found=0;
           }
         } else {
-          if (meter_desc_p[mindex].type=='s') {
-            // sml
+          // ebus mbus pzem or raw
+          // XXHHHHSSUU
+          if (*mp=='x' && *(mp+1)=='x') {
+            //ignore
+            mp+=2;
+            cp++;
+          } else if (!strncmp(mp,"UUuuUUuu",8)) {
+            uint32_t val= (cp[0]<<24)|(cp[1]<<16)|(cp[2]<<8)|(cp[3]<<0);
+            ebus_dval=val;
+            mbus_dval=val;
+            mp+=8;
+            cp+=4;
+          } else if (*mp=='U' && *(mp+1)=='U' && *(mp+2)=='u' && *(mp+3)=='u'){
+            uint16_t val = cp[1]|(cp[0]<<8);
+            mbus_dval=val;
+            ebus_dval=val;
+            mp+=4;
+            cp+=2;
+          } else if (!strncmp(mp,"SSssSSss",8)) {
+            int32_t val= (cp[0]<<24)|(cp[1]<<16)|(cp[2]<<8)|(cp[3]<<0);
+            ebus_dval=val;
+            mbus_dval=val;
+            mp+=8;
+            cp+=4;
+          } else if (*mp=='u' && *(mp+1)=='u' && *(mp+2)=='U' && *(mp+3)=='U'){
+            uint16_t val = cp[0]|(cp[1]<<8);
+            mbus_dval=val;
+            ebus_dval=val;
+            mp+=4;
+            cp+=2;
+          } else if (*mp=='u' && *(mp+1)=='u') {
+            uint8_t val = *cp++;
+            mbus_dval=val;
+            ebus_dval=val;
+            mp+=2;
+          } else if (*mp=='s' && *(mp+1)=='s' && *(mp+2)=='S' && *(mp+3)=='S') {
+            int16_t val = *cp|(*(cp+1)<<8);
+            mbus_dval=val;
+            ebus_dval=val;
+            mp+=4;
+            cp+=2;
+          } else if (*mp=='S' && *(mp+1)=='S' && *(mp+2)=='s' && *(mp+3)=='s') {
+            int16_t val = cp[1]|(cp[0]<<8);
+            mbus_dval=val;
+            ebus_dval=val;
+            mp+=4;
+            cp+=2;
+          }
+          else if (*mp=='s' && *(mp+1)=='s') {
+            int8_t val = *cp++;
+            mbus_dval=val;
+            ebus_dval=val;
+            mp+=2;
+          }
+          else if (!strncmp(mp,"ffffffff",8)) {
+            uint32_t val= (cp[0]<<24)|(cp[1]<<16)|(cp[2]<<8)|(cp[3]<<0);
+            float *fp=(float*)&val;
+            ebus_dval=*fp;
+            mbus_dval=*fp;
+            mp+=8;
+            cp+=4;
+          }
+          else if (!strncmp(mp,"FFffFFff",8)) {
+            // reverse word float
+            uint32_t val= (cp[1]<<0)|(cp[0]<<8)|(cp[3]<<16)|(cp[2]<<24);
+            float *fp=(float*)&val;
+            ebus_dval=*fp;
+            mbus_dval=*fp;
+            mp+=8;
+            cp+=4;
+          }
+          else if (!strncmp(mp,"eeeeee",6)) {
+            uint32_t val=(cp[0]<<16)|(cp[1]<<8)|(cp[2]<<0);
+            mbus_dval=val;
+            mp+=6;
+            cp+=3;
+          }
+          else if (!strncmp(mp,"vvvvvv",6)) {
+            mbus_dval=(float)((cp[0]<<8)|(cp[1])) + ((float)cp[2]/10.0);
+            mp+=6;
+            cp+=3;
+          }
+          else if (!strncmp(mp,"cccccc",6)) {
+            mbus_dval=(float)((cp[0]<<8)|(cp[1])) + ((float)cp[2]/100.0);
+            mp+=6;
+            cp+=3;
+          }
+          else if (!strncmp(mp,"pppp",4)) {
+            mbus_dval=(float)((cp[0]<<8)|cp[1]);
+            mp+=4;
+            cp+=2;
+          }
+          else {
             uint8_t val = hexnibble(*mp++) << 4;
             val |= hexnibble(*mp++);
             if (val!=*cp++) {
               found=0;
             }
-          } else {
-            // ebus mbus pzem or raw
-            // XXHHHHSSUU
-            if (*mp=='x' && *(mp+1)=='x') {
-              //ignore
-              mp+=2;
-              cp++;
-            } else if (!strncmp(mp,"UUuuUUuu",8)) {
-              uint32_t val= (cp[0]<<24)|(cp[1]<<16)|(cp[2]<<8)|(cp[3]<<0);
-              ebus_dval=val;
-              mbus_dval=val;
-              mp+=8;
-              cp+=4;
-            } else if (*mp=='U' && *(mp+1)=='U' && *(mp+2)=='u' && *(mp+3)=='u'){
-              uint16_t val = cp[1]|(cp[0]<<8);
-              mbus_dval=val;
-              ebus_dval=val;
-              mp+=4;
-              cp+=2;
-            } else if (!strncmp(mp,"SSssSSss",8)) {
-              int32_t val= (cp[0]<<24)|(cp[1]<<16)|(cp[2]<<8)|(cp[3]<<0);
-              ebus_dval=val;
-              mbus_dval=val;
-              mp+=8;
-              cp+=4;
-            } else if (*mp=='u' && *(mp+1)=='u' && *(mp+2)=='U' && *(mp+3)=='U'){
-              uint16_t val = cp[0]|(cp[1]<<8);
-              mbus_dval=val;
-              ebus_dval=val;
-              mp+=4;
-              cp+=2;
-            } else if (*mp=='u' && *(mp+1)=='u') {
-              uint8_t val = *cp++;
-              mbus_dval=val;
-              ebus_dval=val;
-              mp+=2;
-            } else if (*mp=='s' && *(mp+1)=='s' && *(mp+2)=='S' && *(mp+3)=='S') {
-              int16_t val = *cp|(*(cp+1)<<8);
-              mbus_dval=val;
-              ebus_dval=val;
-              mp+=4;
-              cp+=2;
-            } else if (*mp=='S' && *(mp+1)=='S' && *(mp+2)=='s' && *(mp+3)=='s') {
-              int16_t val = cp[1]|(cp[0]<<8);
-              mbus_dval=val;
-              ebus_dval=val;
-              mp+=4;
-              cp+=2;
-            }
-            else if (*mp=='s' && *(mp+1)=='s') {
-              int8_t val = *cp++;
-              mbus_dval=val;
-              ebus_dval=val;
-              mp+=2;
-            }
-            else if (!strncmp(mp,"ffffffff",8)) {
-              uint32_t val= (cp[0]<<24)|(cp[1]<<16)|(cp[2]<<8)|(cp[3]<<0);
-              float *fp=(float*)&val;
-              ebus_dval=*fp;
-              mbus_dval=*fp;
-              mp+=8;
-              cp+=4;
-            }
-            else if (!strncmp(mp,"FFffFFff",8)) {
-              // reverse word float
-              uint32_t val= (cp[1]<<0)|(cp[0]<<8)|(cp[3]<<16)|(cp[2]<<24);
-              float *fp=(float*)&val;
-              ebus_dval=*fp;
-              mbus_dval=*fp;
-              mp+=8;
-              cp+=4;
-            }
-            else if (!strncmp(mp,"eeeeee",6)) {
-              uint32_t val=(cp[0]<<16)|(cp[1]<<8)|(cp[2]<<0);
-              mbus_dval=val;
-              mp+=6;
-              cp+=3;
-            }
-            else if (!strncmp(mp,"vvvvvv",6)) {
-              mbus_dval=(float)((cp[0]<<8)|(cp[1])) + ((float)cp[2]/10.0);
-              mp+=6;
-              cp+=3;
-            }
-            else if (!strncmp(mp,"cccccc",6)) {
-              mbus_dval=(float)((cp[0]<<8)|(cp[1])) + ((float)cp[2]/100.0);
-              mp+=6;
-              cp+=3;
-            }
-            else if (!strncmp(mp,"pppp",4)) {
-              mbus_dval=(float)((cp[0]<<8)|cp[1]);
-              mp+=4;
-              cp+=2;
-            }
-            else {
-              uint8_t val = hexnibble(*mp++) << 4;
-              val |= hexnibble(*mp++);
-              if (val!=*cp++) {
-                found=0;
-              }
-            }
           }
         }
       }
-      if (found) {
-        // matches, get value
-        mp++;
+    }
+    if (found) {
+      // matches, get value
+      mp++;
 #ifdef ED300L
-        g_mindex=mindex;
+      g_mindex=mindex;
 #endif
-        if (*mp=='#') {
-          // get string value
-          mp++;
-          if (meter_desc_p[mindex].type=='o') {
-            for (uint8_t p=0;p<METER_ID_SIZE;p++) {
-              if (*cp==*mp) {
-                meter_id[mindex][p]=0;
-                break;
-              }
-              meter_id[mindex][p]=*cp++;
+      if (*mp=='#') {
+        // get string value
+        mp++;
+        if (meter_desc_p[mindex].type=='o') {
+          for (uint8_t p=0;p<METER_ID_SIZE;p++) {
+            if (*cp==*mp) {
+              meter_id[mindex][p]=0;
+              break;
             }
+            meter_id[mindex][p]=*cp++;
+          }
+        } else {
+          sml_getvalue(cp,mindex);
+        }
+      } else {
+        double dval;
+        if (meter_desc_p[mindex].type!='e' && meter_desc_p[mindex].type!='r' && meter_desc_p[mindex].type!='m' && meter_desc_p[mindex].type!='M' && meter_desc_p[mindex].type!='p') {
+          // get numeric values
+          if (meter_desc_p[mindex].type=='o' || meter_desc_p[mindex].type=='c') {
+            dval=CharToDouble((char*)cp);
           } else {
-            sml_getvalue(cp,mindex);
+            dval=sml_getvalue(cp,mindex);
           }
         } else {
-          double dval;
-          if (meter_desc_p[mindex].type!='e' && meter_desc_p[mindex].type!='r' && meter_desc_p[mindex].type!='m' && meter_desc_p[mindex].type!='M' && meter_desc_p[mindex].type!='p') {
-            // get numeric values
-            if (meter_desc_p[mindex].type=='o' || meter_desc_p[mindex].type=='c') {
-              dval=CharToDouble((char*)cp);
-            } else {
-              dval=sml_getvalue(cp,mindex);
+          // ebus pzem or mbus or raw
+          if (*mp=='b') {
+            mp++;
+            uint8_t shift=*mp&7;
+            ebus_dval>>=shift;
+            ebus_dval&=1;
+            mp+=2;
+          }
+          if (*mp=='i') {
+            // mbus index
+            mp++;
+            uint8_t mb_index=strtol((char*)mp,(char**)&mp,10);
+            if (mb_index!=meter_desc_p[mindex].index) {
+              return;
             }
+            uint16_t pos = smltbuf[mindex][2]+3;
+            if (pos>32) pos=32;
+            uint16_t crc = MBUS_calculateCRC(&smltbuf[mindex][0],pos);
+            if (lowByte(crc)!=smltbuf[mindex][pos]) return;
+            if (highByte(crc)!=smltbuf[mindex][pos+1]) return;
+            dval=mbus_dval;
+            //AddLog_P(LOG_LEVEL_INFO, PSTR(">> %s"),mp);
+            mp++;
           } else {
-            // ebus pzem or mbus or raw
-            if (*mp=='b') {
-              mp++;
-              uint8_t shift=*mp&7;
-              ebus_dval>>=shift;
-              ebus_dval&=1;
-              mp+=2;
-            }
-            if (*mp=='i') {
-              // mbus index
-              mp++;
-              uint8_t mb_index=strtol((char*)mp,(char**)&mp,10);
-              if (mb_index!=meter_desc_p[mindex].index) {
-                goto nextsect;
-              }
-              uint16_t pos = smltbuf[mindex][2]+3;
-              if (pos>32) pos=32;
-              uint16_t crc = MBUS_calculateCRC(&smltbuf[mindex][0],pos);
-              if (lowByte(crc)!=smltbuf[mindex][pos]) goto nextsect;
-              if (highByte(crc)!=smltbuf[mindex][pos+1]) goto nextsect;
+            if (meter_desc_p[mindex].type=='p') {
+              uint8_t crc = SML_PzemCrc(&smltbuf[mindex][0],6);
+              if (crc!=smltbuf[mindex][6]) return;
               dval=mbus_dval;
-              //AddLog_P(LOG_LEVEL_INFO, PSTR(">> %s"),mp);
-              mp++;
             } else {
-              if (meter_desc_p[mindex].type=='p') {
-                uint8_t crc = SML_PzemCrc(&smltbuf[mindex][0],6);
-                if (crc!=smltbuf[mindex][6]) goto nextsect;
-                dval=mbus_dval;
-              } else {
-                dval=ebus_dval;
-              }
+              dval=ebus_dval;
             }
-
           }
+
+        }
 #ifdef USE_SML_MEDIAN_FILTER
-          if (meter_desc_p[mindex].flag&16) {
-            meter_vars[vindex]=sml_median(&sml_mf[vindex],dval);
-          } else {
-            meter_vars[vindex]=dval;
-          }
-#else
+        if (meter_desc_p[mindex].flag&16) {
+          meter_vars[vindex]=sml_median(&sml_mf[vindex],dval);
+        } else {
           meter_vars[vindex]=dval;
+        }
+#else
+        meter_vars[vindex]=dval;
 #endif
 //AddLog_P(LOG_LEVEL_INFO, PSTR(">> %s"),mp);
-          // get scaling factor
-          double fac=CharToDouble((char*)mp);
-          meter_vars[vindex]/=fac;
-          SML_Immediate_MQTT((const char*)mp,vindex,mindex);
-        }
+        // get scaling factor
+        double fac=CharToDouble((char*)mp);
+        meter_vars[vindex]/=fac;
+        SML_Immediate_MQTT((const char*)mp,vindex,mindex);
       }
     }
-nextsect:
-    // next section
-    if (vindex<SML_MAX_VARS-1) {
-      vindex++;
-    }
-    mp = strchr(mp, '|');
-    if (mp) mp++;
   }
 }
 
@@ -1933,6 +2052,7 @@ void SML_Init(void) {
   meters_used=METERS_USED;
   meter_desc_p=meter_desc;
   meter_p=meter;
+  SML_FreeEntries();
 
   sml_desc_cnt=0;
 
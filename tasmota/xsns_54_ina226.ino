@@ -68,6 +68,7 @@
 // Define driver ID
 
 #define XSNS_54                                 54
+#define XSNS_54_FUNCS                           (FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_35                                 35  // See I2CDEVICES.md
 
 #define INA226_MAX_ADDRESSES                    4
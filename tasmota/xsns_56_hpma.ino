@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_56             56
+#define XSNS_56_FUNCS       (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <hpma115S0.h>
 #include <TasmotaSerial.h>
@@ -71,6 +71,7 @@
 \*********************************************************************************************/
 
 #define XSNS_61             61
+#define XSNS_61_FUNCS       (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <vector>
 #ifdef USE_MI_DECRYPTION
@@ -50,6 +50,7 @@
 #ifdef USE_MI_ESP32
 
 #define XSNS_62                    62
+#define XSNS_62_FUNCS              (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_250_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 #define USE_MI_DECRYPTION
 
 #include <NimBLEDevice.h>
@@ -638,6 +639,7 @@ void MI32nullifyEndOfMQTT_DATA(){
       break;
     }
   }
+  ResponseInvalidate();
   ResponseAppend_P(PSTR("null"));
 }
 #endif // USE_HOME_ASSISTANT
@@ -1607,6 +1609,7 @@ void MI32showScanResults(){
     ResponseAppend_P(PSTR("{\"MAC\":\"%s\",\"CID\":\"0x%04x\",\"SVC\":\"0x%04x\",\"UUID\":\"0x%04x\",\"RSSI\":%d},"), _MAC, _scanResult.CID, _scanResult.SVC, _scanResult.UUID, _scanResult.RSSI);
   }
   if(_size != 0)TasmotaGlobal.mqtt_data[strlen(TasmotaGlobal.mqtt_data)-1] = 0; // delete last comma
+  ResponseInvalidate();
   ResponseAppend_P(PSTR("]}"));
   MIBLEscanResult.clear();
   MI32.mode.shallShowScanResult = 0;
@@ -1620,6 +1623,7 @@ void MI32showBlockList(){
     ResponseAppend_P(PSTR("\"%s\","), _MAC);
   }
   if(MIBLEBlockList.size()!=0) TasmotaGlobal.mqtt_data[strlen(TasmotaGlobal.mqtt_data)-1] = 0; // delete last comma
+  ResponseInvalidate();
   ResponseAppend_P(PSTR("]"));
   MI32.mode.shallShowBlockList = 0;
 }
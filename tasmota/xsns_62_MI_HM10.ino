@@ -48,6 +48,7 @@
 #ifdef USE_HM10
 
 #define XSNS_62                    62
+#define XSNS_62_FUNCS              (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_100_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 #include <vector>
@@ -467,6 +468,7 @@ void HM10nullifyEndOfMQTT_DATA(){
       break;
     }
   }
+  ResponseInvalidate();
   ResponseAppend_P(PSTR("null"));
 }
 #endif // USE_HOME_ASSISTANT
@@ -1058,6 +1060,7 @@ void HM10showScanResults(){
     ResponseAppend_P(PSTR("{\"MAC\":\"%s\",\"CID\":\"0x%04x\",\"SVC\":\"0x%04x\",\"UUID\":\"0x%04x\",\"RSSI\":%d},"), _MAC, _scanResult.CID, _scanResult.SVC, _scanResult.UUID, _scanResult.RSSI);
   }
   if(_size != 0)TasmotaGlobal.mqtt_data[strlen(TasmotaGlobal.mqtt_data)-1] = 0; // delete last comma
+  ResponseInvalidate();
   ResponseAppend_P(PSTR("]}"));
   MIBLEscanResult.clear();
   HM10.mode.shallShowScanResult = 0;
@@ -1071,6 +1074,7 @@ void HM10showBlockList(){
     ResponseAppend_P(PSTR("\"%s\","), _MAC);
   }
   if(MIBLEBlockList.size()!=0) TasmotaGlobal.mqtt_data[strlen(TasmotaGlobal.mqtt_data)-1] = 0; // delete last comma
+  ResponseInvalidate();
   ResponseAppend_P(PSTR("]"));
   HM10.mode.shallShowBlockList = 0;
 }
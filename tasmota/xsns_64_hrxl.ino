@@ -26,6 +26,7 @@
 \*********************************************************************************************/
 
 #define XSNS_64                      64
+#define XSNS_64_FUNCS                (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
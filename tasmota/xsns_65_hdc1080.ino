@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_65             65
+#define XSNS_65_FUNCS       (FUNC_MASK(FUNC_EVERY_50_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 #define XI2C_45             45      // See I2CDEVICES.md
 
 #define HDC1080_ADDR        0x40
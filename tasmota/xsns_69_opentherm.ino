@@ -20,6 +20,7 @@
 #ifdef USE_OPENTHERM
 
 #define XSNS_69 69
+#define XSNS_69_FUNCS (FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_100_MSECOND) | FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <OpenTherm.h>
 
@@ -511,7 +512,7 @@ void sns_opentherm_flags_cmd(void)
         sns_opentherm_init_boiler_status();
     }
     bool addComma = false;
-    TasmotaGlobal.mqtt_data[0] = 0;
+    ResponseClear();
     for (int pos = 0; pos < OT_FLAGS_COUNT; ++pos)
     {
         int mask = 1 << pos;
@@ -520,9 +521,9 @@ void sns_opentherm_flags_cmd(void)
         {
             if (addComma)
             {
-                snprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("%s,"), TasmotaGlobal.mqtt_data);
+                ResponseAppend_P(PSTR(","));
             }
-            snprintf_P(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), PSTR("%s%s"), TasmotaGlobal.mqtt_data, sns_opentherm_flag_text(mode));
+            ResponseAppend_P(PSTR("%s"), sns_opentherm_flag_text(mode));
             addComma = true;
         }
     }
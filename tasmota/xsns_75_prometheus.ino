@@ -23,6 +23,7 @@
 \*********************************************************************************************/
 
 #define XSNS_75                    75
+#define XSNS_75_FUNCS              0
 
 const char *UnitfromType(const char *type)  // find unit for measurment type
 {
@@ -163,6 +164,10 @@ void HandleMetrics(void) {
     }
   }
 
+#ifdef USE_PROFILER
+  ProfileShowMetrics();
+#endif  // USE_PROFILER
+
   WSContentEnd();
 }
 
@@ -32,6 +32,7 @@
 \*********************************************************************************************/
 
 #define XSNS_76 76
+#define XSNS_76_FUNCS (FUNC_MASK(FUNC_EVERY_SECOND))
 
 #include <TasmotaSerial.h>
 
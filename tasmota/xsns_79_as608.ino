@@ -29,6 +29,7 @@
 \*********************************************************************************************/
 
 #define XSNS_79               79
+#define XSNS_79_FUNCS         (FUNC_MASK(FUNC_EVERY_250_MSECOND))
 
 //#define USE_AS608_MESSAGES
 
@@ -829,6 +829,812 @@ const uint8_t kXsnsList[] = {
 #endif
 };
 
+/*********************************************************************************************\
+ * Xsns periodic function mask list
+ *
+ * A driver declares the periodic functions (FUNC_LOOP up to FUNC_EVERY_SECOND) it handles with
+ * #define XSNS_xx_FUNCS FUNC_MASK(FUNC_LOOP) | FUNC_MASK(FUNC_EVERY_SECOND). Undeclared drivers get all.
+\*********************************************************************************************/
+
+#ifdef XFUNC_PTR_IN_ROM
+const uint8_t kXsnsFuncMask[] PROGMEM = {
+#else
+const uint8_t kXsnsFuncMask[] = {
+#endif
+
+#ifdef XSNS_01
+#ifdef XSNS_01_FUNCS
+  XSNS_01_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_02
+#ifdef XSNS_02_FUNCS
+  XSNS_02_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_03
+#ifdef XSNS_03_FUNCS
+  XSNS_03_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_04
+#ifdef XSNS_04_FUNCS
+  XSNS_04_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_05
+#ifdef XSNS_05_FUNCS
+  XSNS_05_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_06
+#ifdef XSNS_06_FUNCS
+  XSNS_06_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_07
+#ifdef XSNS_07_FUNCS
+  XSNS_07_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_08
+#ifdef XSNS_08_FUNCS
+  XSNS_08_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_09
+#ifdef XSNS_09_FUNCS
+  XSNS_09_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_10
+#ifdef XSNS_10_FUNCS
+  XSNS_10_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_11
+#ifdef XSNS_11_FUNCS
+  XSNS_11_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_12
+#ifdef XSNS_12_FUNCS
+  XSNS_12_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_13
+#ifdef XSNS_13_FUNCS
+  XSNS_13_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_14
+#ifdef XSNS_14_FUNCS
+  XSNS_14_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_15
+#ifdef XSNS_15_FUNCS
+  XSNS_15_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_16
+#ifdef XSNS_16_FUNCS
+  XSNS_16_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_17
+#ifdef XSNS_17_FUNCS
+  XSNS_17_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_18
+#ifdef XSNS_18_FUNCS
+  XSNS_18_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_19
+#ifdef XSNS_19_FUNCS
+  XSNS_19_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_20
+#ifdef XSNS_20_FUNCS
+  XSNS_20_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_21
+#ifdef XSNS_21_FUNCS
+  XSNS_21_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_22
+#ifdef XSNS_22_FUNCS
+  XSNS_22_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_23
+#ifdef XSNS_23_FUNCS
+  XSNS_23_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_24
+#ifdef XSNS_24_FUNCS
+  XSNS_24_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_25
+#ifdef XSNS_25_FUNCS
+  XSNS_25_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_26
+#ifdef XSNS_26_FUNCS
+  XSNS_26_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_27
+#ifdef XSNS_27_FUNCS
+  XSNS_27_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_28
+#ifdef XSNS_28_FUNCS
+  XSNS_28_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_29
+#ifdef XSNS_29_FUNCS
+  XSNS_29_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_30
+#ifdef XSNS_30_FUNCS
+  XSNS_30_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_31
+#ifdef XSNS_31_FUNCS
+  XSNS_31_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_32
+#ifdef XSNS_32_FUNCS
+  XSNS_32_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_33
+#ifdef XSNS_33_FUNCS
+  XSNS_33_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_34
+#ifdef XSNS_34_FUNCS
+  XSNS_34_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_35
+#ifdef XSNS_35_FUNCS
+  XSNS_35_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_36
+#ifdef XSNS_36_FUNCS
+  XSNS_36_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_37
+#ifdef XSNS_37_FUNCS
+  XSNS_37_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_38
+#ifdef XSNS_38_FUNCS
+  XSNS_38_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_39
+#ifdef XSNS_39_FUNCS
+  XSNS_39_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_40
+#ifdef XSNS_40_FUNCS
+  XSNS_40_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_41
+#ifdef XSNS_41_FUNCS
+  XSNS_41_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_42
+#ifdef XSNS_42_FUNCS
+  XSNS_42_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_43
+#ifdef XSNS_43_FUNCS
+  XSNS_43_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_44
+#ifdef XSNS_44_FUNCS
+  XSNS_44_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_45
+#ifdef XSNS_45_FUNCS
+  XSNS_45_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_46
+#ifdef XSNS_46_FUNCS
+  XSNS_46_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_47
+#ifdef XSNS_47_FUNCS
+  XSNS_47_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_48
+#ifdef XSNS_48_FUNCS
+  XSNS_48_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_49
+#ifdef XSNS_49_FUNCS
+  XSNS_49_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_50
+#ifdef XSNS_50_FUNCS
+  XSNS_50_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_51
+#ifdef XSNS_51_FUNCS
+  XSNS_51_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_52
+#ifdef XSNS_52_FUNCS
+  XSNS_52_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_53
+#ifdef XSNS_53_FUNCS
+  XSNS_53_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_54
+#ifdef XSNS_54_FUNCS
+  XSNS_54_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_55
+#ifdef XSNS_55_FUNCS
+  XSNS_55_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_56
+#ifdef XSNS_56_FUNCS
+  XSNS_56_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_57
+#ifdef XSNS_57_FUNCS
+  XSNS_57_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_58
+#ifdef XSNS_58_FUNCS
+  XSNS_58_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_59
+#ifdef XSNS_59_FUNCS
+  XSNS_59_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_60
+#ifdef XSNS_60_FUNCS
+  XSNS_60_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_61
+#ifdef XSNS_61_FUNCS
+  XSNS_61_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_62
+#ifdef XSNS_62_FUNCS
+  XSNS_62_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_63
+#ifdef XSNS_63_FUNCS
+  XSNS_63_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_64
+#ifdef XSNS_64_FUNCS
+  XSNS_64_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_65
+#ifdef XSNS_65_FUNCS
+  XSNS_65_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_66
+#ifdef XSNS_66_FUNCS
+  XSNS_66_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_67
+#ifdef XSNS_67_FUNCS
+  XSNS_67_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_68
+#ifdef XSNS_68_FUNCS
+  XSNS_68_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_69
+#ifdef XSNS_69_FUNCS
+  XSNS_69_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_70
+#ifdef XSNS_70_FUNCS
+  XSNS_70_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_71
+#ifdef XSNS_71_FUNCS
+  XSNS_71_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_72
+#ifdef XSNS_72_FUNCS
+  XSNS_72_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_73
+#ifdef XSNS_73_FUNCS
+  XSNS_73_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_74
+#ifdef XSNS_74_FUNCS
+  XSNS_74_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_75
+#ifdef XSNS_75_FUNCS
+  XSNS_75_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_76
+#ifdef XSNS_76_FUNCS
+  XSNS_76_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_77
+#ifdef XSNS_77_FUNCS
+  XSNS_77_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_78
+#ifdef XSNS_78_FUNCS
+  XSNS_78_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_79
+#ifdef XSNS_79_FUNCS
+  XSNS_79_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_80
+#ifdef XSNS_80_FUNCS
+  XSNS_80_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_81
+#ifdef XSNS_81_FUNCS
+  XSNS_81_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_82
+#ifdef XSNS_82_FUNCS
+  XSNS_82_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_83
+#ifdef XSNS_83_FUNCS
+  XSNS_83_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_84
+#ifdef XSNS_84_FUNCS
+  XSNS_84_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_85
+#ifdef XSNS_85_FUNCS
+  XSNS_85_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_86
+#ifdef XSNS_86_FUNCS
+  XSNS_86_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_87
+#ifdef XSNS_87_FUNCS
+  XSNS_87_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_88
+#ifdef XSNS_88_FUNCS
+  XSNS_88_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_89
+#ifdef XSNS_89_FUNCS
+  XSNS_89_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_90
+#ifdef XSNS_90_FUNCS
+  XSNS_90_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_91
+#ifdef XSNS_91_FUNCS
+  XSNS_91_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_92
+#ifdef XSNS_92_FUNCS
+  XSNS_92_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_93
+#ifdef XSNS_93_FUNCS
+  XSNS_93_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_94
+#ifdef XSNS_94_FUNCS
+  XSNS_94_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_95
+#ifdef XSNS_95_FUNCS
+  XSNS_95_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_96
+#ifdef XSNS_96_FUNCS
+  XSNS_96_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_97
+#ifdef XSNS_97_FUNCS
+  XSNS_97_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_98
+#ifdef XSNS_98_FUNCS
+  XSNS_98_FUNCS,
+#else
+  FUNC_DISPATCH_ALL,
+#endif
+#endif
+
+#ifdef XSNS_99
+#ifdef XSNS_99_FUNCS
+  XSNS_99_FUNCS
+#else
+  FUNC_DISPATCH_ALL
+#endif
+#endif
+};
+
 /*********************************************************************************************/
 
 bool XsnsEnabled(uint32_t sns_index)
@@ -862,6 +1668,65 @@ void XsnsSensorState(void)
   ResponseAppend_P(PSTR("\""));
 }
 
+uint32_t XsnsPresent(void)
+{
+  return xsns_present;
+}
+
+uint32_t XsnsId(uint32_t index)
+{
+#ifdef XFUNC_PTR_IN_ROM
+  return pgm_read_byte(kXsnsList + index);
+#else
+  return kXsnsList[index];
+#endif
+}
+
+/*********************************************************************************************\
+ * Periodic function dispatch lists
+\*********************************************************************************************/
+
+struct {
+#ifdef USE_DEBUG_DRIVER
+  uint32_t calls;                             // Number of sensor calls
+  uint32_t skipped;                           // Number of sensor calls saved by dispatch lists
+#endif  // USE_DEBUG_DRIVER
+  uint8_t count[FUNC_DISPATCH_MAX];           // Number of sensors per periodic function
+  uint8_t list[FUNC_DISPATCH_MAX][xsns_present];  // Sensor indexes per periodic function
+  bool ready;
+} XsnsDispatch;
+
+void XsnsDispatchInit(void)
+{
+  memset(XsnsDispatch.count, 0, sizeof(XsnsDispatch.count));
+  for (uint32_t x = 0; x < xsns_present; x++) {
+#ifdef XFUNC_PTR_IN_ROM
+    uint32_t mask = pgm_read_byte(kXsnsFuncMask + x);
+#else
+    uint32_t mask = kXsnsFuncMask[x];
+#endif
+    for (uint32_t i = 0; i < FUNC_DISPATCH_MAX; i++) {
+      if (bitRead(mask, i)) {
+        XsnsDispatch.list[i][XsnsDispatch.count[i]++] = x;
+      }
+    }
+  }
+  XsnsDispatch.ready = true;
+}
+
+#ifdef USE_DEBUG_DRIVER
+uint32_t XsnsCalls(bool skipped)
+{
+  uint32_t calls = (skipped) ? XsnsDispatch.skipped : XsnsDispatch.calls;
+  if (skipped) {
+    XsnsDispatch.skipped = 0;
+  } else {
+    XsnsDispatch.calls = 0;
+  }
+  return calls;
+}
+#endif  // USE_DEBUG_DRIVER
+
 /*********************************************************************************************\
  * Function call to all xsns
 \*********************************************************************************************/
@@ -888,7 +1753,14 @@ bool XsnsNextCall(uint8_t Function, uint8_t &xsns_index)
   }
 #endif
 
+#ifdef USE_PROFILER
+  uint32_t profile_start = ProfileStart();
+  bool result = xsns_func_ptr[xsns_index](Function);
+  ProfileXsns(xsns_index, Function, profile_start);
+  return result;
+#else
   return xsns_func_ptr[xsns_index](Function);
+#endif  // USE_PROFILER
 }
 
 bool XsnsCall(uint8_t Function)
@@ -901,8 +1773,21 @@ bool XsnsCall(uint8_t Function)
   uint32_t profile_start_millis = millis();
 #endif  // PROFILE_XSNS_EVERY_SECOND
 
-  for (uint32_t x = 0; x < xsns_present; x++) {
+  if (FUNC_PRE_INIT == Function) {
+    XsnsDispatchInit();
+  }
+
+  uint32_t index = Function - FUNC_DISPATCH_FIRST;
+  bool dispatch = (XsnsDispatch.ready && (Function >= FUNC_DISPATCH_FIRST) && (Function <= FUNC_DISPATCH_LAST));
+  uint32_t count = (dispatch) ? XsnsDispatch.count[index] : xsns_present;
+#ifdef USE_DEBUG_DRIVER
+  XsnsDispatch.skipped += xsns_present - count;
+#endif  // USE_DEBUG_DRIVER
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t x = (dispatch) ? XsnsDispatch.list[index][i] : i;
 #ifdef USE_DEBUG_DRIVER
+    XsnsDispatch.calls++;
     if (XsnsEnabled(x)) {  // Skip disabled sensor in debug mode
 #endif
 
@@ -911,7 +1796,13 @@ bool XsnsCall(uint8_t Function)
 #ifdef PROFILE_XSNS_SENSOR_EVERY_SECOND
       uint32_t profile_start_millis = millis();
 #endif  // PROFILE_XSNS_SENSOR_EVERY_SECOND
+#ifdef USE_PROFILER
+      uint32_t profile_start = ProfileStart();
+#endif  // USE_PROFILER
       result = xsns_func_ptr[x](Function);
+#ifdef USE_PROFILER
+      ProfileXsns(x, Function, profile_start);
+#endif  // USE_PROFILER
 
 #ifdef PROFILE_XSNS_SENSOR_EVERY_SECOND
       uint32_t profile_millis = millis() - profile_start_millis;
@@ -0,0 +1,115 @@
+/*
+  Arduino.h - Minimal host replacement of the Arduino core for tests that build library sources
+
+  Provides flash string macros and a String class backed by std::string with the members
+  used by the sources under test. Add members as tests need them.
+*/
+
+#ifndef _TEST_ARDUINO_H_
+#define _TEST_ARDUINO_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <string>
+
+#define PROGMEM
+#define PSTR(x) (x)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define strcasecmp_P strcasecmp
+#define strncasecmp_P strncasecmp
+#define strcmp_P strcmp
+#define memmove_P memmove
+#define snprintf_P snprintf
+
+class __FlashStringHelper;
+#define F(x) ((const __FlashStringHelper*)(x))
+#define FPSTR(x) ((const __FlashStringHelper*)(x))
+
+inline size_t TestStrlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t copy = (len < size -1) ? len : size -1;
+    memcpy(dst, src, copy);
+    dst[copy] = 0;
+  }
+  return len;
+}
+#define strlcpy TestStrlcpy                   // Not in every host libc
+
+class String {
+  std::string s;
+  size_t reserved = 0;
+ public:
+  String(const char *str = "") : s(str ? str : "") {}
+  String(const __FlashStringHelper *str) : s((const char*)str) {}
+  String(const std::string &str) : s(str) {}
+  explicit String(int value) : s(std::to_string(value)) {}
+  explicit String(unsigned int value) : s(std::to_string(value)) {}
+  explicit String(long value) : s(std::to_string(value)) {}
+  explicit String(unsigned long value) : s(std::to_string(value)) {}
+  const char *c_str(void) const { return s.c_str(); }
+  unsigned int length(void) const { return s.size(); }
+  String &operator=(const char *str) { s = str ? str : ""; return *this; }
+  String &operator+=(const String &str) { s += str.s; return *this; }
+  String &operator+=(const char *str) { s += str; return *this; }
+  String &operator+=(const __FlashStringHelper *str) { s += (const char*)str; return *this; }
+  String &operator+=(char c) { s += c; return *this; }
+  String &operator+=(int value) { s += std::to_string(value); return *this; }
+  String &operator+=(unsigned int value) { s += std::to_string(value); return *this; }
+  String &operator+=(long value) { s += std::to_string(value); return *this; }
+  String &operator+=(unsigned long value) { s += std::to_string(value); return *this; }
+  bool equals(const String &str) const { return s == str.s; }
+  bool equals(const char *str) const { return s == (str ? str : ""); }
+  bool operator==(const String &str) const { return s == str.s; }
+  bool operator!=(const String &str) const { return s != str.s; }
+  friend bool operator==(const char *a, const String &b) { return b.equals(a); }    // nullptr equals ""
+  friend bool operator!=(const char *a, const String &b) { return !b.equals(a); }
+  friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+  friend String operator+(const char *a, const String &b) { return String(std::string(a) + b.s); }
+  int indexOf(const String &str, unsigned int from = 0) const {
+    size_t pos = s.find(str.s, from);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+  }
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = s.find(c, from);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+  }
+  String substring(unsigned int from) const { return (from >= s.size()) ? String() : String(s.substr(from)); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (to > s.size()) { to = s.size(); }
+    return (from >= to) ? String() : String(s.substr(from, to - from));
+  }
+  bool startsWith(const String &str) const { return s.compare(0, str.s.size(), str.s) == 0; }
+  void remove(unsigned int index) { if (index < s.size()) { s.resize(index); } }
+  void remove(unsigned int index, unsigned int count) { if (index < s.size()) { s.erase(index, count); } }
+  void reserve(unsigned int size) { s.reserve(size); reserved = size; }
+  char *begin(void) {                         // Buffer of reserve() size for direct writes
+    if (s.size() < reserved) { s.resize(reserved); }
+    return &s[0];
+  }
+  void toUpperCase(void) { for (auto &c : s) { c = toupper(c); } }
+  void toLowerCase(void) { for (auto &c : s) { c = tolower(c); } }
+  void trim(void) {
+    size_t first = s.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) { s.clear(); return; }
+    s = s.substr(first, s.find_last_not_of(" \t\r\n") - first + 1);
+  }
+  long toInt(void) const { return atol(s.c_str()); }
+  void replace(const String &find, const String &replace) {
+    if (find.s.empty()) { return; }
+    size_t pos = 0;
+    while ((pos = s.find(find.s, pos)) != std::string::npos) {
+      s.replace(pos, find.s.size(), replace.s);
+      pos += replace.s.size();
+    }
+  }
+};
+
+inline void delay(uint32_t) {}
+inline void yield(void) {}
+
+#endif  // _TEST_ARDUINO_H_
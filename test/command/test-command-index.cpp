@@ -0,0 +1,172 @@
+/*
+  test-command-index.cpp - Host test of the command index in support.ino
+
+  Decodes every command of the default build command tables, in lower case, with the table
+  prefix missing or doubled, and with a character added or removed, against every table through
+  DecodeCommand() once with the command index and once with the linear GetCommandCode() scan,
+  and checks that both find the same command or none.
+
+  Build and run with: make test
+  Time a 1000 command backlog with and without the index with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#define USE_COMMAND_INDEX
+#define USE_I2C
+#define USE_TIMERS
+#define USE_SUNRISE
+#define USE_RULES
+#define USE_SHUTTER
+#define USE_ZIGBEE_ZNP
+#define USE_MQTT_QUEUE
+#define USE_DEVICE_GROUPS
+#define PROGMEM
+#define PSTR(x) x
+#define pgm_read_byte(x) (*(const uint8_t*)(x))
+#define snprintf_P snprintf
+#define LOG_LEVEL_DEBUG 3
+#define MQTT_LWT_OFFLINE "Offline"
+#define MQTT_LWT_ONLINE "Online"
+
+#include "i18n.h"
+#include "command_size.h"
+
+struct {
+  char *topic;
+  char *command;
+  uint32_t command_code;
+} XdrvMailbox;
+
+void AddLog_P(uint32_t loglevel, const char *formatP, ...) {}
+
+#include "command.h"
+#include "tables.h"
+#include "tables_mqtt.h"
+#include "tables_energy.h"
+#include "tables_light.h"
+#include "tables_timers.h"
+#include "tables_rules.h"
+#include "tables_zigbee.h"
+#include "tables_shutter.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+// Tables in the order ExecuteCommand offers a command to them
+const char *kTables[] = {
+  kTasmotaCommands, kMqttCommands, kEnergyCommands, kLightCommands, kTimerCommands,
+  kRulesCommands, kZbCommands, kShutterCommands
+};
+const uint32_t kTableCount = sizeof(kTables) / sizeof(kTables[0]);
+
+int32_t executed = -1;                     // Command code of the executed command
+void Execute(void) { executed = XdrvMailbox.command_code; }
+void (* const kExecute[256])(void) = {
+#define EXECUTE16 Execute, Execute, Execute, Execute, Execute, Execute, Execute, Execute, \
+                  Execute, Execute, Execute, Execute, Execute, Execute, Execute, Execute
+  EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16,
+  EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16, EXECUTE16
+};
+
+char topic[64];                            // Part of the received topic before any index
+char command[CMDSZ];
+
+// Returns table and command code as table * 256 + code or -1 if no table has the command
+int32_t Decode(const char *cmnd, bool indexed) {
+  CommandIndex.failed = !indexed;            // Makes DecodeCommand use the linear scan
+  snprintf(topic, sizeof(topic), "%s", cmnd);
+  XdrvMailbox.topic = topic;
+  XdrvMailbox.command = command;
+  for (uint32_t table = 0; table < kTableCount; table++) {
+    executed = -1;
+    if (DecodeCommand(kTables[table], kExecute)) {
+      if (executed < 0) { return -2; }       // Returned true without executing
+      return table * 256 + executed;
+    }
+  }
+  return -1;
+}
+
+std::vector<std::string> Commands(void) {
+  std::vector<std::string> commands;
+  for (uint32_t table = 0; table < kTableCount; table++) {
+    char prefix[CMDSZ];
+    GetTextIndexed(prefix, sizeof(prefix), 0, kTables[table]);
+    for (uint32_t code = 1; ; code++) {
+      char name[CMDSZ];
+      GetTextIndexed(name, sizeof(name), code, kTables[table]);
+      if (!name[0]) { break; }
+      commands.push_back(std::string(prefix) + name);
+    }
+  }
+  return commands;
+}
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> commands = Commands();
+
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    // Backlog of 1000 commands picked from all tables plus some unknown ones
+    std::vector<std::string> backlog;
+    for (uint32_t i = 0; i < 1000; i++) {
+      backlog.push_back((i % 50) ? commands[(i * 37) % commands.size()] : "NoSuchCommand");
+    }
+    Decode(backlog[0].c_str(), true);        // Register all tables
+    double best[2] = { 1e30, 1e30 };
+    volatile int32_t sink = 0;
+    for (uint32_t round = 0; round < 20; round++) {
+      for (uint32_t indexed = 0; indexed < 2; indexed++) {
+        auto start = std::chrono::steady_clock::now();
+        for (auto &cmnd : backlog) { sink += Decode(cmnd.c_str(), indexed); }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        if (us < best[indexed]) { best[indexed] = us; }
+      }
+    }
+    printf("%u tables, %u commands, 1000 command backlog: linear %.0f us, indexed %.0f us, %.1fx\n",
+      kTableCount, (uint32_t)commands.size(), best[0], best[1], best[0] / best[1]);
+    return 0;
+  }
+
+  CHECK(commands.size() > 180, "only %u commands", (uint32_t)commands.size());
+  uint32_t found = 0;
+  uint32_t checked = 0;
+  for (auto &cmnd : commands) {
+    std::string lower = cmnd;
+    for (auto &c : lower) { c = tolower(c); }
+    std::string variants[] = {
+      cmnd, lower, cmnd + "X", cmnd.substr(0, cmnd.size() -1), cmnd.substr(1), "Zb" + cmnd, "Shutter" + cmnd
+    };
+    for (auto &variant : variants) {
+      int32_t linear = Decode(variant.c_str(), false);
+      int32_t indexed = Decode(variant.c_str(), true);
+      CHECK(linear == indexed, "%s: linear %d, indexed %d", variant.c_str(), linear, indexed);
+      if (indexed >= 0) { found++; }
+      checked++;
+    }
+    CHECK(cmnd.size() < CMDSZ, "%s does not fit CMDSZ", cmnd.c_str());
+    CHECK(Decode(cmnd.c_str(), true) >= 0, "%s not found", cmnd.c_str());
+  }
+  CHECK(CommandIndex.table_count == kTableCount, "%u tables indexed", CommandIndex.table_count);
+  CHECK(!CommandIndex.failed, "command index disabled");
+
+  // Decoded command is returned with the prefix and command as in the table
+  Decode("zbsend", true);
+  CHECK(!strcmp(command, "ZbSend"), "command %s", command);
+
+  printf("%u commands in %u tables, %u of %u variants found\n", (uint32_t)commands.size(), kTableCount, found, checked);
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
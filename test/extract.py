@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+extract.py - Copy top level definitions from a sensor .ino into a header for a host test
+
+  extract.py <source.ino> <output.h> <name> [<name> ...]
+
+Each name is looked up as a struct, union, function, global variable or macro defined at file scope,
+an unnamed enum is found by its first enumerator. Variable initializers may span several lines.
+Global variables of an unnamed struct type are copied with their struct definition.
+Names not present in the source are skipped so the same list works on older revisions.
+"""
+
+import re
+import sys
+
+
+def scan(lines):
+  """Return brace depth at the start of each line, ignoring comments, literals and alternate #if branches"""
+  depth = 0
+  result = []
+  comment = False
+  branches = []                           # Per open #if, True once in an #else or #elif branch
+  for line in lines:
+    result.append(depth)
+    directive = line.strip()
+    if not comment and directive.startswith("#"):
+      directive = directive[1:].strip()
+      if directive.startswith("if"):
+        branches.append(False)
+      elif directive.startswith(("else", "elif")) and branches:
+        branches[-1] = True
+      elif directive.startswith("endif") and branches:
+        branches.pop()
+      continue
+    if any(branches):
+      continue                            # Count braces of the first branch only
+    i = 0
+    while i < len(line):
+      c = line[i]
+      if comment:
+        if line.startswith("*/", i):
+          comment = False
+          i += 1
+      elif line.startswith("//", i):
+        break
+      elif line.startswith("/*", i):
+        comment = True
+        i += 1
+      elif c in "\"'":
+        i += 1
+        while i < len(line) and line[i] != c:
+          if line[i] == "\\":
+            i += 1
+          i += 1
+      elif c == "{":
+        depth += 1
+      elif c == "}":
+        depth -= 1
+      i += 1
+  result.append(depth)
+  return result
+
+
+def extract(lines, depths, name):
+  struct = re.compile(r"^(struct|union)\s+" + name + r"\s*\{")
+  function = re.compile(r"^[A-Za-z_][\w\s\*]*\b" + name + r"\s*\([^;]*$")
+  variable = re.compile(r"^[A-Za-z_][\w\s\*]*\b" + name + r"\s*(\[[^\]]*\])*(\s+PROGMEM)?\s*(=.*)?;")
+  initializer = re.compile(r"^[A-Za-z_][\w\s\*]*\b" + name + r"\s*(\[[^\]]*\])*(\s+PROGMEM)?\s*=")
+  unnamed = re.compile(r"^\}\s*" + name + r"\s*;")
+  enum = re.compile(r"^enum\s*\{\s*" + name + r"\b")
+  macro = re.compile(r"^#define\s+" + name + r"\b")
+  for i, line in enumerate(lines):
+    if depths[i]:
+      if (1 == depths[i]) and unnamed.match(line):
+        start = i
+        while depths[start]:              # Variable of an unnamed struct type
+          start -= 1
+        return lines[start:i + 1]
+      continue
+    if struct.match(line) or function.match(line):
+      j = i
+      while depths[j + 1] == 0:           # Opening brace may be on a following line
+        j += 1
+      end = j + 1
+      while depths[end] > 0:
+        end += 1
+      return lines[i:end]
+    if variable.match(line) and not line.startswith("struct " + name):
+      return [line]
+    if initializer.match(line):
+      j = i
+      while not lines[j].split("//")[0].rstrip().endswith(";"):
+        j += 1                            # Initializer continued on following lines
+      return lines[i:j + 1]
+    if enum.match(line):
+      return [line]
+    if macro.match(line):
+      j = i
+      while lines[j].rstrip().endswith("\\"):
+        j += 1
+      return lines[i:j + 1]
+  return None
+
+
+def main(argv):
+  if len(argv) < 4:
+    print(__doc__.strip())
+    return 1
+  with open(argv[1], encoding="utf-8", errors="replace") as f:
+    lines = f.read().replace("\r\n", "\n").split("\n")
+  lines = [line + "\n" for line in lines]
+  depths = scan(lines)
+  out = ["// Generated by extract.py from %s, do not edit\n" % argv[1]]
+  for name in argv[3:]:
+    block = extract(lines, depths, name)
+    if block is None:
+      sys.stderr.write("extract.py: %s not found, skipped\n" % name)
+      continue
+    out.append("\n")
+    out.extend(block)
+  with open(argv[2], "w", encoding="utf-8") as f:
+    f.writelines(out)
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv))
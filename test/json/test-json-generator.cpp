@@ -0,0 +1,211 @@
+/*
+  test-json-generator.cpp - Host test of JsonGeneratorStream in jsmn-shadinger
+
+  Writes nested objects and arrays, escaped and PROGMEM strings and fragments, and checks the
+  output against the expected JSON and that it parses back with JsonParser. Checks truncation
+  into a caller buffer at every size, heap growth, and that levels deeper than 31 are left out
+  with their key and content, leaving valid JSON with overflow() set.
+  Compares a 12 attribute ZbReceived payload against the String generators it replaces.
+
+  Build and run with: make test
+  Time the ZbReceived payload against JsonGeneratorObject with: make bench
+*/
+
+#include <chrono>
+#include <string>
+#include "JsonGenerator.h"
+#include "JsonParser.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+bool Parses(const char * json) {
+  std::string copy = json;
+  JsonParser parser(&copy[0]);
+  return (bool)parser;
+}
+
+// ZbReceived payload of 12 attributes
+void WriteReport(JsonGeneratorStream & json) {
+  json.beginObject();
+  json.beginObject(PSTR("ZbReceived"));
+  json.beginObject(PSTR("0x9C33"));
+  json.addStr(PSTR("Device"), PSTR("0x9C33"));
+  json.addStr(PSTR("Name"), "Kitchen \"sensor\"");
+  json.add(PSTR("Temperature"), (int32_t)-215);
+  json.add(PSTR("Humidity"), (uint32_t)6000);
+  json.add(PSTR("Pressure"), (uint32_t)1013);
+  json.addBool(PSTR("Occupancy"), true);
+  json.add(PSTR("Illuminance"), (uint32_t)42);
+  json.addStrRaw(PSTR("BatteryVoltage"), "3.005");
+  json.add(PSTR("BatteryPercentage"), (uint32_t)100);
+  json.beginArray(PSTR("Endpoints"));
+  json.add((uint32_t)1);
+  json.add((uint32_t)2);
+  json.endArray();
+  json.add(PSTR("Endpoint"), (uint32_t)1);
+  json.add(PSTR("LinkQuality"), (uint32_t)59);
+  json.end();
+}
+
+const char kReport[] = "{\"ZbReceived\":{\"0x9C33\":{\"Device\":\"0x9C33\",\"Name\":\"Kitchen \\\"sensor\\\"\",\"Temperature\":-215,"
+  "\"Humidity\":6000,\"Pressure\":1013,\"Occupancy\":true,\"Illuminance\":42,\"BatteryVoltage\":3.005,\"BatteryPercentage\":100,"
+  "\"Endpoints\":[1,2],\"Endpoint\":1,\"LinkQuality\":59}}}";
+
+// Same payload with the String generators, each level serialized and copied into its parent
+String WriteReportString(void) {
+  JsonGeneratorObject device;
+  device.addStr(PSTR("Device"), PSTR("0x9C33"));
+  device.addStr(PSTR("Name"), "Kitchen \"sensor\"");
+  device.add(PSTR("Temperature"), (int32_t)-215);
+  device.add(PSTR("Humidity"), (uint32_t)6000);
+  device.add(PSTR("Pressure"), (uint32_t)1013);
+  device.addStrRaw(PSTR("Occupancy"), "true");
+  device.add(PSTR("Illuminance"), (uint32_t)42);
+  device.addStrRaw(PSTR("BatteryVoltage"), "3.005");
+  device.add(PSTR("BatteryPercentage"), (uint32_t)100);
+  JsonGeneratorArray endpoints;
+  endpoints.add((uint32_t)1);
+  endpoints.add((uint32_t)2);
+  device.addStrRaw(PSTR("Endpoints"), endpoints.toString().c_str());
+  device.add(PSTR("Endpoint"), (uint32_t)1);
+  device.add(PSTR("LinkQuality"), (uint32_t)59);
+  JsonGeneratorObject received;
+  received.addStrRaw(PSTR("0x9C33"), device.toString().c_str());
+  JsonGeneratorObject root;
+  root.addStrRaw(PSTR("ZbReceived"), received.toString().c_str());
+  return root.toString();
+}
+
+void TestValues(void) {
+  JsonGeneratorStream json;
+  WriteReport(json);
+  CHECK(!strcmp(json.c_str(), kReport), "report %s", json.c_str());
+  CHECK(json.length() == strlen(kReport) && !json.overflow(), "length %u overflow %u", (uint32_t)json.length(), json.overflow());
+  CHECK(WriteReportString() == kReport, "String generators %s", WriteReportString().c_str());
+  CHECK(Parses(json.c_str()), "report does not parse");
+
+  // Fragment of keys and values at top level, nulls, escapes, 32 bit limits, hex
+  JsonGeneratorStream frag;
+  frag.add(PSTR("A"), (uint32_t)4294967295U);
+  frag.add(PSTR("B"), (int32_t)-2147483647 - 1);
+  frag.key(PSTR("C"));
+  frag.addNull();
+  frag.addStr(PSTR("D\t"), "\\\n");
+  frag.key(PSTR("E"), PSTR("_1"));
+  frag.addStr(nullptr);
+  frag.addHex32(PSTR("F"), 0xBEEF);
+  CHECK(!strcmp(frag.c_str(), "\"A\":4294967295,\"B\":-2147483648,\"C\":null,\"D\\t\":\"\\\\\\n\",\"E_1\":\"\",\"F\":\"0x0000BEEF\""),
+    "fragment %s", frag.c_str());
+
+  // Empty containers and arrays of objects
+  JsonGeneratorStream nested;
+  nested.beginArray();
+  nested.beginObject();
+  nested.endObject();
+  nested.beginArray();
+  nested.endArray();
+  nested.beginObject();
+  nested.beginObject(PSTR("a"));
+  nested.endObject();
+  nested.add(PSTR("b"), (uint32_t)1);
+  nested.endObject();
+  nested.end();
+  nested.endObject();                         // Nothing left to close
+  CHECK(!strcmp(nested.c_str(), "[{},[],{\"a\":{},\"b\":1}]"), "nested %s", nested.c_str());
+
+  JsonGeneratorStream empty;
+  CHECK(!strcmp(empty.c_str(), "") && !empty.length(), "empty stream");
+}
+
+void TestTruncation(void) {
+  size_t len = strlen(kReport);
+  for (size_t size = 0; size <= len + 1; size++) {
+    char buf[sizeof(kReport) + 8];
+    memset(buf, 'x', sizeof(buf));
+    JsonGeneratorStream json(size ? buf : nullptr, size);
+    WriteReport(json);
+    size_t expected = size ? size - 1 : 0;
+    if (size > len) { expected = len; }
+    if ((json.length() != expected) || (size && strncmp(buf, kReport, expected)) || (size && buf[expected]) || ('x' != buf[size])) {
+      CHECK(false, "size %u: length %u \"%s\"", (uint32_t)size, (uint32_t)json.length(), json.c_str());
+      break;
+    }
+    uint32_t lost = len - json.length();
+    if (json.overflow() != lost) {
+      CHECK(false, "size %u: overflow %u, %u characters lost", (uint32_t)size, json.overflow(), lost);
+      break;
+    }
+  }
+}
+
+void TestDepth(void) {
+  // 31 levels fit
+  JsonGeneratorStream json;
+  std::string expected;
+  for (uint32_t i = 0; i < 31; i++) { json.beginObject(i ? PSTR("k") : nullptr); expected += i ? "\"k\":{" : "{"; }
+  json.add(PSTR("v"), (uint32_t)1);
+  json.end();
+  expected += "\"v\":1" + std::string(31, '}');
+  CHECK(expected == json.c_str() && !json.overflow(), "31 levels %s", json.c_str());
+
+  // Deeper levels are left out with their key and content, siblings stay
+  JsonGeneratorStream deep;
+  expected.clear();
+  for (uint32_t i = 0; i < 31; i++) { deep.beginObject(i ? PSTR("k") : nullptr); expected += i ? "\"k\":{" : "{"; }
+  deep.add(PSTR("a"), (uint32_t)1);
+  deep.beginObject(PSTR("too_deep"));
+  deep.add(PSTR("x"), (uint32_t)2);
+  deep.beginArray(PSTR("deeper"));
+  deep.addStr("y");
+  deep.endArray();
+  deep.endObject();
+  deep.add(PSTR("b"), (uint32_t)3);
+  deep.endObject();                           // Closes level 31
+  deep.add(PSTR("c"), (uint32_t)4);
+  deep.end();
+  expected += "\"a\":1,\"b\":3},\"c\":4" + std::string(30, '}');
+  CHECK(expected == deep.c_str(), "too deep %s", deep.c_str());
+  CHECK(2 == deep.overflow(), "overflow %u", deep.overflow());
+  CHECK(Parses(deep.c_str()), "too deep output does not parse");
+
+  // end() also closes levels left out
+  JsonGeneratorStream unclosed;
+  for (uint32_t i = 0; i < 40; i++) { unclosed.beginArray(); }
+  unclosed.end();
+  CHECK((std::string(31, '[') + std::string(31, ']')) == unclosed.c_str(), "unclosed %s", unclosed.c_str());
+  unclosed.beginObject();
+  unclosed.end();
+  CHECK((std::string(31, '[') + std::string(31, ']') + ",{}") == unclosed.c_str(), "after end %s", unclosed.c_str());
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    const uint32_t loops = 200000;
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < loops; i++) { sink += WriteReportString().length(); }
+    double strings = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / loops;
+    char buf[512];
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < loops; i++) {
+      JsonGeneratorStream json(buf, sizeof(buf));
+      WriteReport(json);
+      sink += json.length();
+    }
+    double stream = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / loops;
+    printf("12 attribute ZbReceived: String generators %.2f us, stream into buffer %.2f us\n", strings, stream);
+    return 0;
+  }
+
+  TestValues();
+  TestTruncation();
+  TestDepth();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,271 @@
+/*
+  test-json-parser.cpp - Host test of the single pass JsonParser in jsmn-shadinger
+
+  Parses seven documents with the single pass parser, with a 3 token caller buffer that has to
+  grow, and with a parser nested in one that holds the shared token buffer, and checks that the
+  token dumps and key lookups with and without JsonParserIndex are the same as with the previous
+  two pass parser. Checks that the shared token buffer is reused, released and freed when large.
+
+  Build and run with: make test
+  Time parsing and key lookups of an IRHVAC payload against the previous parser with: make bench
+*/
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "JsonParser.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+/*********************************************************************************************\
+ * Previous implementation as reference and timing baseline
+ *
+ * Counts the tokens in a first pass, allocates them and parses again
+\*********************************************************************************************/
+
+class JsonParserPrevious : public JsonParser {
+public:
+  JsonParserPrevious(char * json_in) : JsonParser() {
+    k_current_json_buffer = "";
+    if (nullptr == json_in) { return; }
+    _json = json_in;
+    k_current_json_buffer = _json;
+    size_t json_len = strlen(json_in);
+    jsmn_init(&this->_parser);
+    int32_t token_len = jsmn_parse(&this->_parser, json_in, json_len, nullptr, 0);
+    if (token_len <= 0) { return; }
+    _size = token_len + 1;
+    _tokens = new jsmntok_t[_size];
+    jsmn_init(&this->_parser);
+    _token_len = jsmn_parse(&this->_parser, json_in, json_len, _tokens, _size);
+    if (_token_len >= 0) {
+      postProcess(json_len);
+    }
+  }
+  ~JsonParserPrevious() {
+    delete[] _tokens;
+    _tokens = nullptr;
+    _size = 0;
+  }
+};
+
+// Access to the shared token buffer
+class JsonParserPool : public JsonParser {
+public:
+  static const jsmntok_t * tokens(void) { return _pool; }
+  static uint32_t size(void) { return _pool_size; }
+  static bool busy(void) { return _pool_busy; }
+};
+
+/*********************************************************************************************/
+
+const char * kDocuments[] = {
+  // Zigbee report
+  "{\"ZbReceived\":{\"0x9C33\":{\"Device\":\"0x9C33\",\"Illuminance\":42,\"Occupancy\":1,\"Endpoint\":1,\"LinkQuality\":59}}}",
+  // Nested arrays and objects, negative and float numbers, escaped tab
+  "{\"ZbStatus3\":[{\"Device\":\"0x7869\",\"INT\":-3,\"Name\":\"Tilt\",\"IEEEAddr\":\"0x00158D00031310F4\",\"ModelId\":\"lumi.vibration.aq1\","
+  "\"Manufacturer\":\"LUMI\",\"Endpoints\":{\"0x01\":{\"ProfileId\":\"0x0104\",\"ClustersIn\":[\"0x0000\",\"0x0003\",\"0x0019\",\"0x0101\"],"
+  "\"ClustersOut\":[\"0x0000\",\"0x0004\",\"0x0003\",\"0x0005\",\"0x0019\",\"0x0101\"]},\"0x02\":{\"ProfileId\":\"0x0000\\ta\",\"ClustersIn\":[2],"
+  "\"ClustersOut\":[-3,0.4,5.8]}}}]}",
+  // IRHVAC command with 21 keys
+  "{\"Vendor\":\"Mitsubishi_Heavy_152\",\"Model\":-1,\"Mode\":\"Cool\",\"Power\":\"On\",\"Celsius\":\"On\",\"Temp\":22.5,\"FanSpeed\":\"Auto\","
+  "\"SwingV\":\"Auto\",\"SwingH\":\"Auto\",\"Quiet\":\"Off\",\"Turbo\":\"Off\",\"Econo\":\"Off\",\"Light\":\"Off\",\"Filter\":\"Off\",\"Clean\":\"Off\","
+  "\"Beep\":\"Off\",\"Sleep\":-1,\"Clock\":-1,\"StateMode\":\"SendStore\",\"Weather\":\"Off\",\"iFeel\":\"Off\"}",
+  // Escapes, literals and an empty object and array
+  "{\"Text\":\"a\\\"b\\\\c\\/d\\u0041\\n\",\"True\":true,\"False\":false,\"Null\":null,\"Big\":18446744073709551615,\"Empty\":{},\"List\":[]}",
+  // Duplicate keys differing in case, the first one wins
+  "{\"Power\":1,\"power\":2,\"POWER\":3,\"Dimmer\":{\"Dimmer\":50},\"dimmer\":60}",
+  // Invalid JSON
+  "{\"Power\":1,\"Dimmer\":",
+  // Empty string
+  "",
+};
+
+std::string Dump(const JsonParserToken & token) {
+  char line[64];
+  snprintf(line, sizeof(line), "%d:%u:%u:%u", token.t->type, token.t->start, token.t->len, token.t->size);
+  std::string dump = line;
+  if (token.isObject()) {
+    dump += "{";
+    for (const auto key : JsonParserObject(token)) {
+      dump += std::string(key.getStr()) + "=" + Dump(key.getValue()) + ",";
+    }
+    dump += "}";
+  } else if (token.isArray()) {
+    dump += "[";
+    for (const auto elt : JsonParserArray(token)) {
+      dump += Dump(elt) + ",";
+    }
+    dump += "]";
+  } else {
+    dump += std::string("'") + token.getStr() + "'";
+  }
+  return dump;
+}
+
+// Results of looking up every key of every object, in upper case, with a suffix and "?"
+std::string Lookups(const JsonParserToken & token, bool indexed) {
+  std::string dump;
+  if (token.isObject()) {
+    JsonParserObject obj(token);
+    JsonParserIndex * index = indexed ? new JsonParserIndex(obj) : nullptr;
+    for (const auto key : obj) {
+      std::string name = key.getStr();
+      std::string upper = name;
+      for (auto &c : upper) { c = toupper(c); }
+      for (auto &needle : { name, upper, name + "x", std::string("?") }) {
+        JsonParserToken value = obj[needle.c_str()];
+        dump += needle + "=" + (value ? std::to_string(value.t->start) + value.getStr() : "-") + ",";
+      }
+    }
+    delete index;
+    for (const auto key : obj) { dump += Lookups(key.getValue(), indexed); }
+  } else if (token.isArray()) {
+    for (const auto elt : JsonParserArray(token)) { dump += Lookups(elt, indexed); }
+  }
+  return dump;
+}
+
+void TestDocuments(void) {
+  for (uint32_t d = 0; d < ARRAY_SIZE(kDocuments); d++) {
+    std::string previous_json = kDocuments[d];
+    JsonParserPrevious previous(&previous_json[0]);
+    std::string expected = Dump(previous.getRootObject());
+    std::string expected_lookups = Lookups(previous.getRootObject(), false);
+    CHECK((d < 5) == (bool)previous, "document %u: previous parser %s", d, previous ? "succeeded" : "failed");
+
+    std::string json = kDocuments[d];
+    JsonParser parser(&json[0]);
+    CHECK((bool)parser == (bool)previous, "document %u: parser %s", d, parser ? "succeeded" : "failed");
+    CHECK(Dump(parser.getRootObject()) == expected, "document %u: tokens %s", d, Dump(parser.getRootObject()).c_str());
+    CHECK(Lookups(parser.getRootObject(), false) == expected_lookups, "document %u: lookups differ", d);
+    CHECK(Lookups(parser.getRootObject(), true) == expected_lookups, "document %u: indexed lookups differ", d);
+
+    // Caller buffer of 3 tokens grows on the heap, the caller buffer is left as it was
+    std::string small_json = kDocuments[d];
+    jsmntok_t small[4] = { {}, {}, {}, { JSMN_STRING, 42, 0, 0 } };
+    {
+      JsonParser small_parser(&small_json[0], small, 3);
+      CHECK((bool)small_parser == (bool)previous, "document %u: 3 token parser %s", d, small_parser ? "succeeded" : "failed");
+      CHECK(Dump(small_parser.getRootObject()) == expected, "document %u: 3 token parser tokens %s", d, Dump(small_parser.getRootObject()).c_str());
+      CHECK(Lookups(small_parser.getRootObject(), true) == expected_lookups, "document %u: 3 token parser lookups differ", d);
+    }
+    CHECK(42 == small[3].size, "document %u: caller buffer overrun", d);
+
+    // Reused parser instance
+    JsonParser reused;
+    std::string reused_json = kDocuments[(d + 1) % ARRAY_SIZE(kDocuments)];
+    reused.parse(&reused_json[0]);
+    reused_json = kDocuments[d];
+    CHECK(reused.parse(&reused_json[0]) == (bool)previous, "document %u: reused parser", d);
+    CHECK(Dump(reused.getRootObject()) == expected, "document %u: reused parser tokens %s", d, Dump(reused.getRootObject()).c_str());
+  }
+}
+
+void TestPool(void) {
+  CHECK(!JsonParserPool::busy(), "shared buffer busy before parsing");
+  std::string json = kDocuments[0];
+  const jsmntok_t * pool;
+  {
+    JsonParser parser(&json[0]);
+    CHECK(JsonParserPool::busy(), "shared buffer not used");
+    pool = JsonParserPool::tokens();
+    CHECK(pool && (JsonParserPool::size() <= JSON_PARSER_POOL_MAX), "shared buffer of %u tokens", JsonParserPool::size());
+
+    // Nested parse while the shared buffer is in use gets its own buffer
+    std::string nested_json = kDocuments[2];
+    std::string previous_json = kDocuments[2];
+    JsonParserPrevious previous(&previous_json[0]);
+    std::string expected = Dump(previous.getRootObject());
+    {
+      JsonParser nested(&nested_json[0]);
+      CHECK(nested && (Dump(nested.getRootObject()) == expected), "nested parser tokens %s", Dump(nested.getRootObject()).c_str());
+      CHECK(JsonParserPool::tokens() == pool, "nested parser changed the shared buffer");
+    }
+    CHECK(JsonParserPool::busy(), "nested parser released the shared buffer");
+
+    // Tokens of the outer parser are intact after the nested parse
+    parser.setCurrent();
+    previous_json = kDocuments[0];
+    JsonParserPrevious outer(&previous_json[0]);
+    expected = Dump(outer.getRootObject());
+    parser.setCurrent();
+    CHECK(Dump(parser.getRootObject()) == expected, "outer parser tokens %s", Dump(parser.getRootObject()).c_str());
+  }
+  CHECK(!JsonParserPool::busy(), "shared buffer not released");
+  CHECK(JsonParserPool::tokens() == pool, "shared buffer not kept");
+
+  // Next parser reuses the shared buffer
+  json = kDocuments[4];
+  {
+    JsonParser parser(&json[0]);
+    CHECK(parser && (JsonParserPool::tokens() == pool), "shared buffer not reused");
+  }
+
+  // Shared buffer grown above JSON_PARSER_POOL_MAX is freed, arrays of 3 tokens as jsmn allows 63 items per level
+  std::string large = "[[0,0]";
+  for (uint32_t i = 1; i < JSON_PARSER_POOL_MAX / 2; i++) { large += ",[" + std::to_string(i) + "," + std::to_string(i) + "]"; }
+  large += "]";
+  {
+    JsonParser parser(&large[0]);
+    CHECK(parser && (JsonParserArray(parser.getRoot()).size() == JSON_PARSER_POOL_MAX / 2), "large array");
+    CHECK(JsonParserPool::size() > JSON_PARSER_POOL_MAX, "shared buffer of %u tokens", JsonParserPool::size());
+  }
+  CHECK(!JsonParserPool::busy() && !JsonParserPool::tokens() && !JsonParserPool::size(), "large shared buffer kept");
+
+  // Failed parse returns the Invalid Token and not stale tokens of the previous parse
+  json = kDocuments[0];
+  std::string invalid = kDocuments[5];
+  JsonParser parser(&json[0]);
+  CHECK(!parser.parse(&invalid[0]) && !parser.getRoot() && !parser.getRootObject(), "stale tokens after failed parse");
+}
+
+/*********************************************************************************************/
+
+// IRHVAC keys looked up by CmndIrHvac()
+const char * kIrHvacKeys[] = {
+  "Vendor", "Protocol", "FanSpeed", "Model", "Mode", "SwingV", "SwingH", "Temp", "StateMode", "Power", "Celsius",
+  "Light", "Beep", "Econo", "Filter", "Turbo", "Quiet", "Clean", "Sleep", "Clock", "iFeel"
+};
+
+template <class P>
+double TimeParse(uint32_t lookups, bool indexed) {
+  const uint32_t loops = 200000;
+  std::string json;
+  volatile int32_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < loops; i++) {
+    json = kDocuments[2];
+    P parser(&json[0]);
+    JsonParserObject root = parser.getRootObject();
+    JsonParserIndex * index = indexed ? new JsonParserIndex(root) : nullptr;
+    for (uint32_t k = 0; k < lookups; k++) { sink += root[kIrHvacKeys[k]].size(); }
+    delete index;
+  }
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / loops;
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    uint32_t lookups = ARRAY_SIZE(kIrHvacKeys);
+    double previous = TimeParse<JsonParserPrevious>(0, false);
+    double single = TimeParse<JsonParser>(0, false);
+    printf("parse IRHVAC payload: previous %.2f us, single pass %.2f us\n", previous, single);
+    previous = TimeParse<JsonParserPrevious>(lookups, false);
+    single = TimeParse<JsonParser>(lookups, false);
+    double indexed = TimeParse<JsonParser>(lookups, true);
+    printf("parse and %u key lookups: previous %.2f us, single pass %.2f us, with index %.2f us\n", lookups, previous, single, indexed);
+    return 0;
+  }
+
+  TestDocuments();
+  TestPool();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
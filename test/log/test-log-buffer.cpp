@@ -0,0 +1,257 @@
+/*
+  test-log-buffer.cpp - Host test of the indexed log buffer in support.ino
+
+  Appends 200000 log lines of random length and loglevel through AddLogData() and checks after
+  each line that every stored line is intact and addressed by its own index, that GetLog() of
+  a reader returns the lines in order without gaps unless they were removed, and that the
+  buffer accounting matches the index.
+
+  Build and run with: make test
+  Time appending a DEBUG_MORE line against the previous implementation with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+
+#define PSTR(x) x
+#define snprintf_P snprintf
+#define D_HOUR_MINUTE_SEPARATOR ":"
+#define D_MINUTE_SECOND_SEPARATOR ":"
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_DEBUG_MORE 4
+
+#include "log_config.h"
+#include "log_globals.h"
+#include "log_index.h"
+
+struct {
+  uint32_t log_buffer_pointer;
+  uint32_t uptime = 10;
+  uint16_t log_buffer_head;
+  uint16_t log_buffer_used;
+  uint8_t log_index_first;
+  uint8_t log_index_count;
+  uint8_t seriallog_level;
+  uint8_t syslog_level;
+  uint8_t templog_level;
+  uint8_t masterlog_level;
+  char log_buffer[LOG_BUFFER_SIZE];
+  LogIndex log_index[LOG_INDEX_SIZE];
+} TasmotaGlobal;
+
+struct {
+  uint8_t weblog_level = LOG_LEVEL_DEBUG_MORE;
+  uint8_t mqttlog_level;
+} Settings;
+
+struct {
+  int hour, minute, second;
+} RtcTime;
+
+int RtcMillis(void) { return 0; }
+
+struct {
+  void printf(const char *format, ...) {}
+} Serial;
+
+#include "log_buffer.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+/*********************************************************************************************\
+ * Previous implementation as timing baseline
+ *
+ * Zero terminated buffer of [index][loglevel][log data]['\1'] entries, oldest first
+\*********************************************************************************************/
+
+char scan_buffer[LOG_BUFFER_SIZE];
+uint32_t scan_pointer = 0;
+
+size_t strchrspn(const char *str1, int character) {
+  size_t ret = 0;
+  char c = (char)character;
+  while (*str1) {
+    if (*str1 == c) { break; }
+    str1++;
+    ret++;
+  }
+  return ret;
+}
+
+void AddLogDataScan(uint32_t loglevel, const char* log_data) {
+  char mxtime[14];  // "13:45:21.999 "
+  snprintf_P(mxtime, sizeof(mxtime), PSTR("%02d" D_HOUR_MINUTE_SEPARATOR "%02d" D_MINUTE_SECOND_SEPARATOR "%02d.%03d "), RtcTime.hour, RtcTime.minute, RtcTime.second, RtcMillis());
+
+  scan_pointer &= 0xFF;
+  if (!scan_pointer) { scan_pointer++; }
+  while (scan_pointer == (uint8_t)scan_buffer[0] ||
+         strlen(scan_buffer) + strlen(log_data) + strlen(mxtime) + 4 > LOG_BUFFER_SIZE) {
+    char* it = scan_buffer;
+    it++;                                  // Skip log_buffer_pointer
+    it += strchrspn(it, '\1');             // Skip log line
+    it++;                                  // Skip delimiting "\1"
+    memmove(scan_buffer, it, LOG_BUFFER_SIZE -(it-scan_buffer));
+  }
+  size_t len = strlen(scan_buffer);
+  snprintf_P(scan_buffer + len, sizeof(scan_buffer) - len, PSTR("%c%c%s%s\1"), scan_pointer++, '0'+loglevel, mxtime, log_data);
+  scan_pointer &= 0xFF;
+  if (!scan_pointer) { scan_pointer++; }
+}
+
+/*********************************************************************************************/
+
+std::string appended[256];                   // Last line appended per index including time
+
+void Append(uint32_t loglevel, const std::string &data) {
+  uint32_t index = TasmotaGlobal.log_buffer_pointer;
+  if (!index) { index = 1; }
+  AddLogData(loglevel, data.c_str());
+  appended[index] = std::string("00:00:00.000 ") + data;
+  if (appended[index].size() > LOGSZ -1u) { appended[index].resize(LOGSZ -1); }
+}
+
+// Oldest stored line index
+uint32_t OldestIndex(void) {
+  return (TasmotaGlobal.log_buffer_pointer + 255 - TasmotaGlobal.log_index_count -1) % 255 +1;
+}
+
+bool CheckBuffer(uint32_t n) {
+  uint32_t used = 0;
+  uint32_t index = OldestIndex();
+  for (uint32_t rank = 0; rank < TasmotaGlobal.log_index_count; rank++) {
+    LogIndex *entry = &TasmotaGlobal.log_index[LogIndexSlot(rank)];
+    const char *line = TasmotaGlobal.log_buffer + entry->offset;
+    if ((entry->offset + entry->length > LOG_BUFFER_SIZE) || (strlen(line) +1 != entry->length) || (appended[index] != line)) {
+      CHECK(false, "line %u: stored line %u of %u corrupt", n, rank, TasmotaGlobal.log_index_count);
+      return false;
+    }
+    if (rank) {                              // Lines do not overlap
+      LogIndex *previous = &TasmotaGlobal.log_index[LogIndexSlot(rank -1)];
+      if ((entry->offset < previous->offset + previous->length) && (entry->offset + entry->length > previous->offset)) {
+        CHECK(false, "line %u: stored lines %u and %u overlap", n, rank -1, rank);
+        return false;
+      }
+    }
+    used += entry->length;
+    index = index % 255 +1;
+  }
+  if (used != TasmotaGlobal.log_buffer_used) {
+    CHECK(false, "line %u: %u bytes used, index holds %u", n, TasmotaGlobal.log_buffer_used, used);
+    return false;
+  }
+  return true;
+}
+
+void TestReplay(void) {
+  srand(1);
+  uint32_t reader = 0;                       // Index of next line for a reader at loglevel 2
+  uint32_t read = 0;
+  int32_t last = -1;                         // Number of last line read
+  for (uint32_t n = 0; n < 200000; n++) {
+    uint32_t len = (rand() % 20) ? rand() % 80 : rand() % 900;
+    std::string data(len, 'a' + n % 26);
+    if (len > 6) { snprintf(&data[0], 7, "%06u", n); data[6] = '-'; }
+    uint32_t loglevel = 1 + rand() % 4;
+    Append(loglevel, data);
+
+    // Newest line is always available
+    uint32_t index = (TasmotaGlobal.log_buffer_pointer + 253) % 255 +1;
+    char *line;
+    size_t line_len;
+    if (!GetLog(LOG_LEVEL_DEBUG_MORE, &index, &line, &line_len)) {
+      CHECK(false, "line %u: newest line missing", n);
+      return;
+    }
+    if ((appended[(TasmotaGlobal.log_buffer_pointer + 253) % 255 +1] != line) || (index != TasmotaGlobal.log_buffer_pointer)) {
+      CHECK(false, "line %u: newest line wrong", n);
+      return;
+    }
+    if (!CheckBuffer(n)) { return; }
+
+    if (0 == rand() % 5) {
+      // Without refresh the line the reader stopped at is still available
+      if (reader && (reader != TasmotaGlobal.log_buffer_pointer) && !NeedLogRefresh(2, reader)) {
+        CHECK(LogIndexRank(reader) >= 0, "line %u: line %u removed without refresh", n, reader);
+      }
+      while (GetLog(2, &reader, &line, &line_len)) {
+        if (strlen(line) +1 != line_len) {
+          CHECK(false, "line %u: GetLog length %u of \"%s\"", n, (uint32_t)line_len, line);
+          return;
+        }
+        if (line_len > 20) {                   // Lines start with their number after the time
+          int32_t number = atoi(line + 13);
+          CHECK(number > last, "line %u: read line %d after %d", n, number, last);
+          last = number;
+        }
+        read++;
+      }
+      CHECK(reader == TasmotaGlobal.log_buffer_pointer, "line %u: reader at %u, pointer %u", n, reader, TasmotaGlobal.log_buffer_pointer);
+    }
+  }
+  CHECK(read > 50000, "only %u lines read", read);
+}
+
+void TestLoglevel(void) {
+  // GetLog skips lines above the requested loglevel and returns the next index
+  TasmotaGlobal.log_buffer_pointer = 0;
+  TasmotaGlobal.log_buffer_head = 0;
+  TasmotaGlobal.log_buffer_used = 0;
+  TasmotaGlobal.log_index_first = 0;
+  TasmotaGlobal.log_index_count = 0;
+  Append(1, "error");
+  Append(4, "debug more");
+  Append(2, "info");
+  uint32_t index = 0;
+  char *line;
+  size_t len;
+  CHECK(GetLog(2, &index, &line, &len) && !strcmp(line, "00:00:00.000 error") && (2 == index), "first line");
+  CHECK(GetLog(2, &index, &line, &len) && !strcmp(line, "00:00:00.000 info") && (4 == index), "skipped line");
+  CHECK(!GetLog(2, &index, &line, &len) && (4 == index), "no more lines");
+  index = 0;
+  CHECK(!GetLog(0, &index, &line, &len), "loglevel none");
+
+  // Too long lines are cut at LOGSZ
+  std::string data(LOGSZ + 100, 'x');
+  Append(1, data);
+  index = 4;
+  CHECK(GetLog(1, &index, &line, &len) && (LOGSZ == len) && (LOGSZ -1u == strlen(line)), "long line %u", (uint32_t)len);
+
+  // Index wraps from 255 to 1
+  for (uint32_t i = 0; i < 300; i++) { Append(1, "wrap"); }
+  CHECK(TasmotaGlobal.log_buffer_pointer && (TasmotaGlobal.log_buffer_pointer < 256), "pointer %u", TasmotaGlobal.log_buffer_pointer);
+  CHECK(TasmotaGlobal.log_index_count <= LOG_INDEX_SIZE, "count %u", TasmotaGlobal.log_index_count);
+  CheckBuffer(0);
+}
+
+double TimeAppend(void (*add)(uint32_t, const char*)) {
+  const uint32_t loops = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < loops; i++) {
+    add(LOG_LEVEL_DEBUG_MORE, "DBG: some debug more line with a typical length of data 1234567890");
+  }
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / loops;
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    double scan = TimeAppend(AddLogDataScan);
+    double indexed = TimeAppend(AddLogData);
+    printf("append DEBUG_MORE line to full buffer: previous %.0f ns, indexed %.0f ns, %.1fx\n", scan, indexed, scan / indexed);
+    return 0;
+  }
+
+  TestReplay();
+  TestLoglevel();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
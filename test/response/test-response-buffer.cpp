@@ -0,0 +1,196 @@
+/*
+  test-response-buffer.cpp - Host test of the response length tracking in support.ino
+
+  Builds responses in mqtt_data with Response_P, ResponseTime_P and ResponseAppend_P and checks
+  after each call that the tracked length matches the buffer and that characters dropped on
+  overflow are counted. Checks the resync after direct writes to mqtt_data, with and without
+  ResponseInvalidate(), and with DEBUG_TASMOTA_CORE that a write shortening the response by more
+  than one character without ResponseInvalidate() is found and logged.
+
+  Build and run with: make test
+  Time a teleperiod message against the previous strlen on every append with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+
+#define PSTR(x) x
+#define vsnprintf_P vsnprintf
+#define LOG_LEVEL_ERROR 1
+#define MESSZ (1200 -151 -7)                  // MQTT_MAX_PACKET_SIZE -TOPSZ -7
+
+struct {
+  char mqtt_data[MESSZ];
+} TasmotaGlobal;
+
+struct {
+  struct {
+    uint32_t time_format;
+  } flag2;
+} Settings;
+
+char * ResponseGetTime(uint32_t format, char * time_str) {
+  strcpy(time_str, "{\"Time\":\"2026-10-17T12:00:00\"");
+  return time_str;
+}
+
+uint32_t log_errors = 0;
+void AddLog_P(uint32_t loglevel, const char * format, ...) {
+  if (LOG_LEVEL_ERROR == loglevel) { log_errors++; }
+}
+
+#include "response_buffer.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+#define CHECK_LENGTH(what) CHECK(ResponseLength() == strlen(TasmotaGlobal.mqtt_data), "%s: length %u, strlen %u", what, ResponseLength(), (uint32_t)strlen(TasmotaGlobal.mqtt_data))
+
+// Previous ResponseAppend_P as timing baseline
+int ResponseAppendStrlen_P(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int mlen = strlen(TasmotaGlobal.mqtt_data);
+  int len = vsnprintf_P(TasmotaGlobal.mqtt_data + mlen, sizeof(TasmotaGlobal.mqtt_data) - mlen, format, args);
+  va_end(args);
+  return len + mlen;
+}
+
+// Teleperiod SENSOR message of 18 temperature and humidity sensors, about 950 characters
+template <int (*Append)(const char*, ...)>
+void Teleperiod(void) {
+  ResponseTime_P(PSTR(""));
+  for (uint32_t i = 0; i < 18; i++) {
+    Append(PSTR(",\"AM2301-%02u\":{"), i);
+    Append(PSTR("\"Temperature\":%s,\"Humidity\":%s"), "21.5", "45.0");
+    Append(PSTR("}"));
+  }
+  Append(PSTR(",\"TempUnit\":\"C\"}"));
+}
+
+void TestAppend(void) {
+  Response_P(PSTR("{\"POWER\":\"%s\""), "ON");
+  CHECK_LENGTH("Response_P");
+  std::string expected = "{\"POWER\":\"ON\"";
+  for (uint32_t i = 0; i < 20; i++) {
+    int len = ResponseAppend_P(PSTR(",\"Key%u\":%u"), i, i * 1000);
+    expected += ",\"Key" + std::to_string(i) + "\":" + std::to_string(i * 1000);
+    CHECK(len == (int)expected.size(), "append %u returns %d", i, len);
+    CHECK_LENGTH("ResponseAppend_P");
+  }
+  ResponseJsonEnd();
+  expected += "}";
+  CHECK(expected == TasmotaGlobal.mqtt_data, "response %s", TasmotaGlobal.mqtt_data);
+  CHECK(!ResponseOverflow(), "overflow %u", ResponseOverflow());
+
+  ResponseTime_P(PSTR(",\"Uptime\":%u}"), 10);
+  CHECK(!strcmp(TasmotaGlobal.mqtt_data, "{\"Time\":\"2026-10-17T12:00:00\",\"Uptime\":10}"), "time %s", TasmotaGlobal.mqtt_data);
+  CHECK_LENGTH("ResponseTime_P");
+
+  ResponseClear();
+  CHECK(!ResponseLength() && !TasmotaGlobal.mqtt_data[0], "clear");
+  ResponseAppend_P(PSTR("{}"));
+  CHECK_LENGTH("append after clear");
+}
+
+void TestOverflow(void) {
+  std::string filler(100, 'x');
+  Response_P(PSTR("{"));
+  uint32_t total = 1;
+  for (uint32_t i = 0; i < 15; i++) {
+    int len = ResponseAppend_P(PSTR("\"%s\","), filler.c_str());
+    if (total < sizeof(TasmotaGlobal.mqtt_data) -1) { CHECK(len == (int)(total + filler.size() + 3), "append %u returns %d", i, len); }
+    total += filler.size() + 3;
+    CHECK_LENGTH("overflow append");
+  }
+  CHECK(ResponseLength() == sizeof(TasmotaGlobal.mqtt_data) -1, "length %u", ResponseLength());
+  CHECK(ResponseOverflow() == total - (sizeof(TasmotaGlobal.mqtt_data) -1), "overflow %u, %u lost", ResponseOverflow(), (uint32_t)(total - (sizeof(TasmotaGlobal.mqtt_data) -1)));
+  ResponseJsonEnd();                          // Full buffer drops all
+  CHECK(ResponseOverflow() == total +1 - (sizeof(TasmotaGlobal.mqtt_data) -1), "overflow %u after full", ResponseOverflow());
+
+  Response_P(PSTR("{}"));
+  CHECK(!ResponseOverflow(), "overflow %u after Response_P", ResponseOverflow());
+  Response_P(PSTR("%s"), std::string(MESSZ + 10, 'y').c_str());
+  CHECK(11 == ResponseOverflow(), "Response_P overflow %u", ResponseOverflow());
+  ResponseTime_P(PSTR("}"));
+  CHECK(!ResponseOverflow(), "overflow %u after ResponseTime_P", ResponseOverflow());
+
+  ResponseWritten(10, 0x12345);
+  CHECK(10 == ResponseBuffer.length && 0xFFFF == ResponseOverflow(), "written %u %u", ResponseBuffer.length, ResponseOverflow());
+}
+
+void TestDirectWrite(void) {
+  // Written in place and invalidated
+  Response_P(PSTR("{\"Sensor\":{\"Temperature\":21.5,\"Humidity\":45.0}"));
+  snprintf(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), "{\"A\":1");
+  ResponseInvalidate();
+  ResponseJsonEnd();
+  CHECK(!strcmp(TasmotaGlobal.mqtt_data, "{\"A\":1}"), "invalidated %s", TasmotaGlobal.mqtt_data);
+  CHECK_LENGTH("invalidated");
+
+  // Missed invalidate caught without strlen: lengthened, emptied, last character removed
+  Response_P(PSTR("{\"A\":1"));
+  strcat(TasmotaGlobal.mqtt_data, ",\"B\":2");
+  CHECK_LENGTH("lengthened");
+  Response_P(PSTR("{\"A\":1"));
+  TasmotaGlobal.mqtt_data[0] = '\0';
+  CHECK_LENGTH("emptied");
+  Response_P(PSTR("{\"A\":1,"));
+  TasmotaGlobal.mqtt_data[strlen(TasmotaGlobal.mqtt_data) -1] = '\0';
+  CHECK_LENGTH("last comma removed");
+
+  // Missed invalidate shortening by more than one is only caught with DEBUG_TASMOTA_CORE
+  Response_P(PSTR("{\"Sensor\":{\"Temperature\":21.5"));
+  snprintf(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), "{\"A\":1");
+  uint32_t errors = log_errors;
+#ifdef DEBUG_TASMOTA_CORE
+  CHECK_LENGTH("shortened");
+  CHECK(errors +1 == log_errors, "shortened response not logged");
+  ResponseJsonEnd();
+  CHECK(!strcmp(TasmotaGlobal.mqtt_data, "{\"A\":1}"), "shortened %s", TasmotaGlobal.mqtt_data);
+#else
+  CHECK(ResponseLength() > strlen(TasmotaGlobal.mqtt_data), "shortened response detected without strlen");
+  CHECK(errors == log_errors, "shortened response logged");
+#endif  // DEBUG_TASMOTA_CORE
+
+  // Same teleperiod message as the strlen appends
+  errors = log_errors;
+  Teleperiod<ResponseAppendStrlen_P>();
+  std::string expected = TasmotaGlobal.mqtt_data;
+  Teleperiod<ResponseAppend_P>();
+  CHECK(expected == TasmotaGlobal.mqtt_data, "teleperiod %s", TasmotaGlobal.mqtt_data);
+  CHECK_LENGTH("teleperiod");
+  CHECK(!ResponseOverflow() && (expected.size() > 900), "teleperiod %u characters, overflow %u", (uint32_t)expected.size(), ResponseOverflow());
+  CHECK(errors == log_errors, "teleperiod logged an error");
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    const uint32_t loops = 100000;
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < loops; i++) { Teleperiod<ResponseAppendStrlen_P>(); sink += TasmotaGlobal.mqtt_data[1]; }
+    double strlen_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / loops;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < loops; i++) { Teleperiod<ResponseAppend_P>(); sink += TasmotaGlobal.mqtt_data[1]; }
+    double tracked_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / loops;
+    printf("Teleperiod of %u characters in 55 appends: strlen %.2f us, tracked length %.2f us\n", (uint32_t)strlen(TasmotaGlobal.mqtt_data), strlen_us, tracked_us);
+    return 0;
+  }
+
+  TestAppend();
+  TestOverflow();
+  TestDirectWrite();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
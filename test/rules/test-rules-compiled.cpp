@@ -0,0 +1,213 @@
+/*
+  test-rules-compiled.cpp - Host test of the compiled rule sets in xdrv_10_rules.ino
+
+  Feeds 1000 telemetry events through RulesProcessEvent() against three full rule sets, once
+  with compiled rules and once with the per rule parsing used by SetOption94 1, and checks that
+  both execute the same commands in the same order. Checks that a changed rule set is compiled
+  again before its next event.
+
+  Build and run with: make test
+  Time both paths with: make bench
+*/
+
+#include <Arduino.h>
+#include <JsonParser.h>
+#include <stdarg.h>
+#include <chrono>
+
+#define MAX_RULE_SETS 3
+#define MAX_RULE_SIZE 512
+#define MAX_RULE_TIMERS 8
+#define MAX_RULE_VARS 16
+#define MAX_RULE_MEMS 16
+#define SET_MEM1 0
+#define SRC_RULE 0
+#define DT_LOCAL 0
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+#define tmin(a, b) (((a) < (b)) ? (a) : (b))
+
+struct {
+  char rules[MAX_RULE_SETS][MAX_RULE_SIZE];
+  uint8_t rule_enabled;
+  uint8_t rule_once;
+  struct { uint32_t compress_rules_cpu : 1; } flag4;
+} Settings;
+
+struct {
+  char mqtt_topic[33] = "test";
+  char mqtt_data[1040];
+} TasmotaGlobal;
+
+struct {
+  String macAddress(void) { return String("AA:BB:CC:DD:EE:FF"); }
+} WiFi;
+
+std::string trace;                            // Executed commands, one per line
+uint32_t commands = 0;
+
+void ExecuteCommand(const char *cmnd, uint32_t source) {
+  commands++;
+  trace += cmnd;
+  trace += '\n';
+}
+void AddLog_P(uint32_t loglevel, const char *formatP, ...) {}
+const char *SettingsText(uint32_t index) { return ""; }
+uint32_t MinutesPastMidnight(void) { return 600; }
+uint32_t MinutesUptime(void) { return 100; }
+uint32_t UtcTime(void) { return 1606816800; }
+uint32_t ESP_getChipId(void) { return 0x123456; }
+String GetDateAndTime(uint32_t time_type) { return String("2020-12-01T10:00:00"); }
+float CharToFloat(const char *str) { return atof(str); }
+int GetStateNumber(const char *state_text) {
+  if (!strcasecmp(state_text, "OFF")) { return 0; }
+  if (!strcasecmp(state_text, "ON")) { return 1; }
+  if (!strcasecmp(state_text, "TOGGLE")) { return 2; }
+  return -1;
+}
+
+#include "rules.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+// Three full rule sets close to the 511 character limit with 36 rules
+const char *kRuleSets[MAX_RULE_SETS] = {
+  "ON ENERGY#POWER>2000 DO Power1 off ENDON ON ENERGY#POWER<5 DO Var1 idle ENDON ON ENERGY#VOLTAGE<210 DO Publish stat/test/alarm undervoltage %value% ENDON "
+  "ON ENERGY#VOLTAGE>250 DO Publish stat/test/alarm overvoltage %value% ENDON ON ENERGY#CURRENT>8 DO Power1 off ENDON ON ENERGY#FACTOR<0.5 DO Var2 %value% ENDON "
+  "ON ENERGY#TODAY>10 DO Publish stat/test/today %value% ENDON ON SI7021#TEMPERATURE>30 DO Power2 on ENDON ON SI7021#TEMPERATURE<18 DO Power2 off ENDON "
+  "ON SI7021#HUMIDITY>75 DO Power3 on ENDON ON SI7021#HUMIDITY<=40 DO Power3 off ENDON",
+  "ON SYSTEM#BOOT DO Var3 0 ENDON ON POWER1#STATE=1 DO RuleTimer1 600 ENDON ON POWER1#STATE=0 DO RuleTimer1 0 ENDON ON RULES#TIMER=1 DO Power1 off ENDON "
+  "ON BUTTON1#STATE=2 DO Power2 toggle ENDON ON SWITCH1#STATE DO Var4 %value% ENDON ON MQTT#CONNECTED DO Publish stat/test/online 1 ENDON "
+  "ON WIFI#DISCONNECTED DO Var5 1 ENDON ON TIME#MINUTE|15 DO Publish stat/test/tick %value% ENDON ON DS18B20#TEMPERATURE>%VAR6% DO Power4 on ENDON "
+  "ON DS18B20#TEMPERATURE<%VAR7% DO Power4 off ENDON ON ANALOG#A0>800 DO Var8 high ENDON",
+  "ON TELE-ENERGY#POWER>1500 DO Publish stat/test/tele_power %value% ENDON ON TELE-SI7021#DEWPOINT>20 DO Var9 %value% ENDON "
+  "ON TELE-DS18B20#TEMPERATURE DO Var10 %value% ENDON ON INA219#CURRENT>0.100 DO Dimmer 10 ENDON ON INA219#VOLTAGE<4.5 DO Dimmer 50 ENDON "
+  "ON BME280#PRESSURE<990 DO Publish stat/test/weather rain ENDON ON BME280#TEMPERATURE>28 DO Power5 on ENDON ON PMS5003#PM2.5>35 DO Power6 on ENDON "
+  "ON EVENT#MODE=NIGHT DO Dimmer 5 ENDON ON EVENT#MODE=DAY DO Dimmer 100 ENDON ON TELE-ANALOG#A0<100 DO Var11 low ENDON",
+};
+
+#define EVENTS 1000
+char events[EVENTS][400];
+
+// 500 tele SENSOR messages in teleperiod and 500 state and sensor events outside it
+void MakeEvents(void) {
+  for (uint32_t e = 0; e < EVENTS; e++) {
+    if (e & 1) {
+      snprintf(events[e], sizeof(events[e]), "{\"Time\":\"2020-12-01T10:%02u:00\",\"ENERGY\":{\"TotalStartTime\":\"2020-11-01T00:00:00\",\"Total\":12.345,\"Yesterday\":4.321,"
+        "\"Today\":%u.%03u,\"Period\":%u,\"Power\":%u,\"ApparentPower\":%u,\"ReactivePower\":50,\"Factor\":0.%02u,\"Voltage\":%u,\"Current\":%u.%03u},"
+        "\"SI7021\":{\"Temperature\":%u.%u,\"Humidity\":%u.%u,\"DewPoint\":%u.%u},\"DS18B20\":{\"Id\":\"0316A27941FF\",\"Temperature\":%u.%u},\"TempUnit\":\"C\"}",
+        e % 60, e % 12, e % 1000, e % 7, e * 7 % 2500, e * 7 % 2500 + 40, 40 + e % 60, 200 + e % 60, e % 10, e % 1000,
+        15 + e % 20, e % 10, 30 + e % 50, e % 10, 5 + e % 20, e % 10, 15 + e % 15, e % 10);
+    } else {
+      switch ((e / 2) % 5) {
+        case 0: snprintf(events[e], sizeof(events[e]), "{\"POWER1\":{\"State\":%u}}", (e / 10) & 1); break;
+        case 1: snprintf(events[e], sizeof(events[e]), "{\"INA219\":{\"Voltage\":4.%03u,\"Current\":0.%03u,\"Power\":0.089}}", e % 1000, e * 3 % 1000); break;
+        case 2: snprintf(events[e], sizeof(events[e]), "{\"Time\":{\"Minute\":%u}}", e % 1440); break;
+        case 3: snprintf(events[e], sizeof(events[e]), "{\"ANALOG\":{\"A0\":%u}}", e % 1024); break;
+        case 4: snprintf(events[e], sizeof(events[e]), "{\"Event\":{\"Mode\":\"%s\"}}", (e & 4) ? "Night" : "Day"); break;
+      }
+    }
+  }
+}
+
+void LoadRules(uint32_t rule_once, bool minimize_ram) {
+  for (uint32_t i = 0; i < MAX_RULE_SETS; i++) {
+    strlcpy(Settings.rules[i], kRuleSets[i], sizeof(Settings.rules[i]));
+    RulesCompiledFree(i);
+  }
+  Settings.rule_enabled = 7;
+  Settings.rule_once = rule_once;
+  Settings.flag4.compress_rules_cpu = minimize_ram;
+  memset(Rules.triggers, 0, sizeof(Rules.triggers));
+  Rules.teleperiod = false;
+  strlcpy(rules_vars[5], "25", sizeof(rules_vars[5]));
+  strlcpy(rules_vars[6], "20", sizeof(rules_vars[6]));
+}
+
+// Returns microseconds used to process all events
+double Run(void) {
+  trace.clear();
+  commands = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t e = 0; e < EVENTS; e++) {
+    Rules.teleperiod = (e & 1);
+    strlcpy(TasmotaGlobal.mqtt_data, events[e], sizeof(TasmotaGlobal.mqtt_data));
+    RulesProcessEvent(TasmotaGlobal.mqtt_data);
+  }
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Compare(const char *name, uint32_t rule_once) {
+  LoadRules(rule_once, true);
+  Run();
+  std::string expected = trace;
+  uint32_t expected_commands = commands;
+
+  LoadRules(rule_once, false);
+  Run();
+  CHECK(RulesCompiled.valid == 7, "%s: rule sets not compiled (0x%02X)", name, RulesCompiled.valid);
+  CHECK(expected_commands > 0, "%s: no commands executed", name);
+  CHECK(commands == expected_commands, "%s: %u commands, expected %u", name, commands, expected_commands);
+  CHECK(trace == expected, "%s: executed commands differ", name);
+}
+
+int main(int argc, char *argv[]) {
+  MakeEvents();
+
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    for (uint32_t rule_once = 0; rule_once < 8; rule_once += 7) {
+      double best[2] = { 1e30, 1e30 };
+      for (uint32_t round = 0; round < 20; round++) {
+        for (uint32_t compiled = 0; compiled < 2; compiled++) {
+          LoadRules(rule_once, !compiled);
+          double us = Run();
+          if (us < best[compiled]) { best[compiled] = us; }
+        }
+      }
+      printf("%u events, Once 0x%02X, %u commands: per rule parsing %.0f us, compiled %.0f us, %.1fx\n",
+        EVENTS, rule_once, commands, best[0], best[1], best[0] / best[1]);
+    }
+    return 0;
+  }
+
+  Compare("all rules", 0);
+  Compare("once", 7);
+
+  // Rule set changed between events is compiled again before it is used
+  LoadRules(0, false);
+  char event[] = "{\"Event\":{\"Mode\":\"Night\"}}";
+  trace.clear();
+  RulesProcessEvent(event);
+  CHECK(trace == "Dimmer 5\n", "first rule set: %s", trace.c_str());
+  strlcpy(Settings.rules[2], "ON EVENT#MODE=NIGHT DO Dimmer 1 ENDON", sizeof(Settings.rules[2]));
+  RulesCompiledFree(2);
+  strlcpy(event, "{\"Event\":{\"Mode\":\"Night\"}}", sizeof(event));
+  trace.clear();
+  RulesProcessEvent(event);
+  CHECK(trace == "Dimmer 1\n", "changed rule set: %s", trace.c_str());
+
+  // BREAK stops the rule set on both paths
+  for (uint32_t minimize_ram = 0; minimize_ram < 2; minimize_ram++) {
+    LoadRules(0, minimize_ram);
+    strlcpy(Settings.rules[2], "ON EVENT#MODE=NIGHT DO Dimmer 1 BREAK ON EVENT#MODE DO Dimmer 2 ENDON", sizeof(Settings.rules[2]));
+    RulesCompiledFree(2);
+    strlcpy(event, "{\"Event\":{\"Mode\":\"Night\"}}", sizeof(event));
+    trace.clear();
+    RulesProcessEvent(event);
+    CHECK(trace == "Dimmer 1\n", "break with SetOption94 %u: %s", minimize_ram, trace.c_str());
+  }
+
+  for (uint32_t i = 0; i < MAX_RULE_SETS; i++) {
+    RulesCompiledFree(i);
+  }
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,555 @@
+/*
+  test-scripter-compile.cpp - Host test of the section compiler in xdrv_10_scripter.ino
+
+  Runs script sections through Run_script_sub() once interpreted and once as compiled code
+  and checks that variables, changed flags, commands and return values are identical. Checks
+  that unsupported sections stay interpreted.
+
+  Build and run with: make test
+  Time interpreted against compiled sections with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <time.h>
+#include <string>
+
+#define SCRIPT_COMPILE 2048
+#define SCRIPT_VAR_CACHE 32
+#define PROGMEM
+#define PSTR(x) x
+#define pgm_read_byte(x) (*(const uint8_t*)(x))
+#define LOG_LEVEL_INFO 2
+#define LOGSZ 128
+#define SRC_RULE 1
+#define EPOCH_OFFSET 1546300800
+#define MAX_COUNTERS 4
+#define PMEM_SIZE 50
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define SET_MQTTPREFIX1 0
+#define SET_MQTTPREFIX2 1
+#define SET_MQTTPREFIX3 2
+#define SET_MQTT_GRP_TOPIC 3
+#define SET_MQTT_TOPIC 4
+#define SET_FRIENDLYNAME1 5
+#define MAXFILT 5
+#define AND_FILT_MASK 0x7f
+#define OR_FILT_MASK 0x80
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
+#define DT_LOCAL 1
+
+size_t TestStrlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t copy = (len < size -1) ? len : size -1;
+    memcpy(dst, src, copy);
+    dst[copy] = 0;
+  }
+  return len;
+}
+#define strlcpy TestStrlcpy                   // Not in every host libc
+
+class String {
+  std::string s;
+ public:
+  String(void) {}
+  String(const char *str) : s(str) {}
+  String(int value) : s(std::to_string(value)) {}
+  const char *c_str(void) const { return s.c_str(); }
+  String toString(void) const { return *this; }
+};
+
+// Json input is not tested here, every lookup fails
+class JsonParserObject;
+class JsonParserToken {
+ public:
+  bool isValid(void) const { return false; }
+  bool isStr(void) const { return false; }
+  const char *getStr(void) const { return ""; }
+  JsonParserToken getArray(void) const { return *this; }
+  JsonParserToken operator[](int) const { return *this; }
+  operator JsonParserObject(void) const;
+};
+class JsonParserObject : public JsonParserToken {
+ public:
+  JsonParserToken operator[](const String&) const { return JsonParserToken(); }
+};
+JsonParserToken::operator JsonParserObject(void) const { return JsonParserObject(); }
+class JsonParser {
+ public:
+  JsonParser(char*) {}
+  JsonParserObject getRootObject(void) { return JsonParserObject(); }
+};
+
+struct {
+  uint32_t uptime;
+  uint8_t restart_flag;
+  uint32_t loop_load_avg;
+  uint16_t tele_period;
+  uint32_t global_update;
+  uint32_t humidity;
+  float temperature_celsius;
+  float pressure_hpa;
+  uint32_t power;
+  uint8_t devices_present;
+  uint32_t energy_power_delta;
+  struct { uint8_t mqtt_down, wifi_down; } global_state;
+  uint32_t gpio_pin[40];
+  struct {
+    uint8_t system_boot, time_init, time_set;
+    uint8_t wifi_connected, wifi_disconnected, mqtt_connected, mqtt_disconnected;
+  } rules_flag;
+} TasmotaGlobal;
+
+struct {
+  uint8_t second, minute, hour, day_of_week, day_of_month, month;
+  uint16_t year, day_of_year;
+  uint32_t nanos;
+  uint32_t valid;
+} RtcTime;
+
+struct {
+  struct { uint32_t mqtt_enabled; } flag;
+  uint8_t weblog_level;
+  uint16_t tele_period;
+  float latitude, longitude;
+  uint8_t script_pram[PMEM_SIZE];
+  uint16_t timezone;
+  uint8_t rule_enabled;
+} Settings;
+
+struct { uint32_t pulse_counter[MAX_COUNTERS]; } RtcSettings;
+struct { uint32_t RSSI(void) { return 0; } String localIP(void) { return String(); } } WiFi;
+struct { uint32_t getFreeHeap(void) { return 0; } uint32_t getChipId(void) { return 0; } uint32_t getCpuFreqMHz(void) { return 80; } } ESP;
+uint32_t UtcTime(void) { return 0; }
+uint8_t SwitchLastState(uint32_t) { return 0; }
+
+std::string out;                              // Commands and log lines of a run
+
+uint32_t millis(void) { return 0; }
+uint32_t micros(void) { return 0; }
+void delay(uint32_t) {}
+long random(long) { return 0; }
+long random(long, long) { return 0; }
+void randomSeed(uint32_t) {}
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return 0; }
+int Pin(uint32_t, uint32_t = 0) { return -1; }
+void esp_pwm(float, float, uint8_t) {}
+void WSContentFlush(void) {}
+void WSContentSend_P(const char*, ...) {}
+const char *SettingsText(uint32_t) { return ""; }
+uint32_t MinutesUptime(void) { return TasmotaGlobal.uptime / 60; }
+uint32_t MinutesPastMidnight(void) { return RtcTime.hour * 60 + RtcTime.minute; }
+String GetDateAndTime(uint8_t) { return String("2021-01-01T00:00:00"); }
+uint32_t GetStack(void) { return 0; }
+float FastPrecisePowf(float x, float y) { return powf(x, y); }
+void Scripter_save_pvars(void) {}
+uint16_t AdcRead(uint32_t, uint32_t) { return 0; }
+uint32_t ESP_getFreeHeap(void) { return 0; }
+float DoMedian5(uint8_t, float in) { return in; }
+float median_array(float *array, uint16_t) { return array[0]; }
+
+void AddLog_P(uint32_t, const char *format, ...) {
+  char line[256];
+  va_list arg;
+  va_start(arg, format);
+  vsnprintf(line, sizeof(line), format, arg);
+  va_end(arg);
+  out += "log:";
+  out += line;
+  out += "\n";
+}
+
+void ExecuteCommand(const char *cmnd, uint32_t) {
+  out += "cmd:";
+  out += cmnd;
+  out += "\n";
+}
+
+char* dtostrfd(double number, unsigned char prec, char *s) {
+  sprintf(s, "%.*f", prec, number);
+  return s;
+}
+
+#include "support.h"
+
+void toLogEOL(const char *s1, const char *str);
+char *isvar(char *lp, uint8_t *vtype, struct T_INDEX *tind, float *fp, char *sp, JsonParserObject *jo);
+char *getop(char *lp, uint8_t *operand);
+char *GetNumericArgument(char *lp, uint8_t lastop, float *fp, JsonParserObject *jo);
+char *GetStringArgument(char *lp, uint8_t lastop, char *cp, JsonParserObject *jo);
+void Replace_Cmd_Vars(char *srcbuf, uint32_t srcsize, char *dstbuf, uint32_t dstsize);
+char *scripter_sub(char *lp, uint8_t fromscriptcmd);
+void Script_Command(char *lp);
+int16_t Run_Scripter(const char *type, int8_t tlen, char *js);
+int16_t Run_script_sub(const char *type, int8_t tlen, JsonParserObject *jo);
+void Script_CompileSections(void);
+char *Script_CompileExpr(struct S_COMPILE *sc, char *lp);
+uint32_t Script_FindVar(char *lp, char *dvnam, uint8_t olen);
+void toLog(const char *str);
+int16_t Script_RunCode(union S_OP *code);
+
+#include "scripter.h"
+
+void toLogEOL(const char *s1, const char *str) {
+  out += "log:";
+  out += s1;
+  out += "\n";
+}
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+#define TEST_VARS 24
+
+char script[2048];
+char vnames[256];
+uint8_t vnp_offset[TEST_VARS];
+struct T_INDEX vtypes[TEST_VARS];
+float fvars[TEST_VARS];
+char snp[4 * SCRIPT_MAXSSIZE];
+
+// Variables are given as "name|name|$string", numeric variables get a value from seed
+void Load(const char *text, const char *vars) {
+  memset(&glob_script_mem, 0, sizeof(glob_script_mem));
+  memset(vtypes, 0, sizeof(vtypes));
+  uint32_t numvars = 0, nums = 0, strs = 0, pos = 0;
+  for (const char *vp = vars; *vp; ) {
+    bool is_string = (*vp == '$');
+    if (is_string) vp++;
+    vnp_offset[numvars] = pos;
+    while (*vp && *vp != '|') vnames[pos++] = *vp++;
+    vnames[pos++] = 0;
+    if (*vp) vp++;
+    vtypes[numvars].bits.is_string = is_string;
+    vtypes[numvars].index = is_string ? strs++ : nums++;
+    numvars++;
+  }
+  strcpy(script, text);
+  glob_script_mem.fvars = fvars;
+  glob_script_mem.type = vtypes;
+  glob_script_mem.glob_vnp = vnames;
+  glob_script_mem.vnp_offset = vnp_offset;
+  glob_script_mem.glob_snp = snp;
+  glob_script_mem.numvars = numvars;
+  glob_script_mem.max_ssize = SCRIPT_MAXSSIZE;
+  glob_script_mem.script_dprec = 2;
+  glob_script_mem.script_ram = script;
+  glob_script_mem.script_size = sizeof(script);
+  glob_script_mem.scriptptr = script;
+  glob_script_mem.scriptptr_bu = script;
+  Script_IndexSections();
+}
+
+void Seed(uint32_t seed) {
+  for (uint32_t count = 0; count < TEST_VARS; count++) {
+    fvars[count] = (float)((seed * 7 + count * 3) % 11) - 3;
+  }
+  for (uint32_t count = 0; count < glob_script_mem.numvars; count++) {
+    vtypes[count].bits.changed = 0;
+  }
+  memset(snp, 0, sizeof(snp));
+  TasmotaGlobal.uptime = 3600 + seed * 17;
+  RtcTime.hour = seed % 24;
+  RtcTime.minute = (seed * 13) % 60;
+  RtcTime.second = (seed * 7) % 60;
+  RtcTime.day_of_month = 1 + seed % 28;
+  RtcTime.day_of_week = 1 + seed % 7;
+  RtcTime.month = 1 + seed % 12;
+  RtcTime.year = 2021;
+  out.clear();
+}
+
+struct RUN {
+  float fvars[TEST_VARS];
+  uint8_t changed[TEST_VARS];
+  int16_t retval[16];
+  std::string out;
+};
+
+void Run(const char *sections, uint32_t seed, bool compiled, RUN *run) {
+  union S_OP **code = glob_script_mem.code;
+  if (!compiled) glob_script_mem.code = 0;
+  Seed(seed);
+  uint32_t index = 0;
+  char type[8];
+  while (*GetTextIndexed(type, sizeof(type), index, sections)) {
+    run->retval[index++] = Run_Scripter(type, strlen(type), 0);
+  }
+  memcpy(run->fvars, fvars, sizeof(fvars));
+  for (uint32_t count = 0; count < TEST_VARS; count++) {
+    run->changed[count] = (count < glob_script_mem.numvars) ? vtypes[count].bits.changed : 0;
+  }
+  run->out = out;
+  glob_script_mem.code = code;
+}
+
+// Run sections interpreted and compiled with several seeds and compare the results
+void Compare(const char *name, const char *text, const char *vars, const char *sections, const char *compiled) {
+  Load(text, vars);
+  for (uint32_t sect = 0; sect < glob_script_mem.numsections; sect++) {
+    bool expect = (compiled[sect] == 'c');
+    bool is = (glob_script_mem.code && glob_script_mem.code[sect]);
+    CHECK(expect == is, "%s: section %u %s", name, sect, expect ? "not compiled" : "compiled");
+  }
+  for (uint32_t seed = 0; seed < 24; seed++) {
+    RUN interpreted = {}, code = {};
+    Run(sections, seed, false, &interpreted);
+    Run(sections, seed, true, &code);
+    for (uint32_t count = 0; count < TEST_VARS; count++) {
+      bool same = (interpreted.fvars[count] == code.fvars[count]) || (isnan(interpreted.fvars[count]) && isnan(code.fvars[count]));
+      CHECK(same, "%s seed %u: var %u %f != %f", name, seed, count, interpreted.fvars[count], code.fvars[count]);
+      CHECK(interpreted.changed[count] == code.changed[count], "%s seed %u: changed %u", name, seed, count);
+    }
+    CHECK(!memcmp(interpreted.retval, code.retval, sizeof(code.retval)), "%s seed %u: return value", name, seed);
+    CHECK(interpreted.out == code.out, "%s seed %u: output\n%s---\n%s", name, seed, interpreted.out.c_str(), code.out.c_str());
+  }
+  Script_FreeIndex();
+}
+
+const char kArith[] =
+  ">A\n"
+  "x=1+2*3\n"
+  "y=x/4-1\n"
+  "z=(x+1)*(y-2)\n"
+  "w=-x+10%3\n"
+  "u=7^2\n"
+  "v=5&6|1\n"
+  "a=a+b*-c\n"
+  "b=((a))-.5+1.25\n"
+  "x+=2\n"
+  "y*=3\n"
+  "z-=1\n"
+  "w/=2\n"
+  "u%=3\n"
+  "v&=3\n"
+  "v|=8\n"
+  "v^=1\n"
+  "c=b/0\n"
+  "d=a - b ; ignored\n"
+  ">B\n"
+  "  ; comment\n"
+  "\n"
+  "\tx=5 \n"
+  "y=x\n";
+
+const char kIf[] =
+  ">A\n"
+  "if a>0\n"
+  "and b<=2\n"
+  "or c==1\n"
+  "then\n"
+  "x=1\n"
+  "if d!=0\n"
+  "then y=2\n"
+  "else y=3\n"
+  "endif\n"
+  "else\n"
+  "x=2\n"
+  "endif\n"
+  "if (a>=b or c<d) and (d>0)\n"
+  "then z=1\n"
+  "endif\n"
+  ">B\n"
+  "if a>1 {\n"
+  "x=10\n"
+  "if b<c {\n"
+  "y=11\n"
+  "} else {\n"
+  "y=12\n"
+  "}\n"
+  "} else {\n"
+  "x=13\n"
+  "}\n"
+  "if (b<(a+1)*2 and c>0) {\n"
+  "z+=1\n"
+  "}\n"
+  "if hours>=12\n"
+  "then\n"
+  "w=mins+secs+day+wday+month+year+time+uptime+upsecs\n"
+  "endif\n";
+
+const char kLoop[] =
+  ">A\n"
+  "for i 1 5 1\n"
+  "x+=i*a\n"
+  "next\n"
+  "for i 10 b -2\n"
+  "y=y+i\n"
+  "if i>4 {\n"
+  "z+=1\n"
+  "}\n"
+  "next\n"
+  "switch a\n"
+  "w=1\n"
+  "case 1\n"
+  "w=10\n"
+  "case 2\n"
+  "w=20\n"
+  "case -3\n"
+  "if b>0\n"
+  "then w=30\n"
+  "else w=31\n"
+  "endif\n"
+  "ends\n"
+  "switch (b+1)*2\n"
+  "case 4\n"
+  "u=4\n"
+  "ends\n";
+
+const char kCmd[] =
+  ">A\n"
+  "x=a+1\n"
+  "=>power %x%\n"
+  "->status 0\n"
+  "+>backlog x %1(a*2)%\n"
+  "print x is %x%\n"
+  "=#sub(x)\n"
+  "if x>2 {\n"
+  "=>dimmer %0y%\n"
+  "=#sub\n"
+  "}\n"
+  "#sub\n"
+  "y+=1\n"
+  "=>power2 %y%\n";
+
+const char kFallback[] =
+  ">A\n"
+  "$s=\"abc\"\n"
+  ">B\n"
+  "x=sin(a)\n"
+  ">C\n"
+  "order=1\n"
+  ">D\n"
+  "if a>0\n"
+  "then\n"
+  "break\n"
+  "endif\n"
+  ">E\n"
+  "if s==\"abc\"\n"
+  "then x=1\n"
+  "endif\n"
+  ">F\n"
+  "for i 1 3 1\n"
+  "for j 1 3 1\n"
+  "x+=1\n"
+  "next\n"
+  "next\n"
+  ">G\n"
+  "switch a\n"
+  "case 1\n"
+  "if b>0 {\n"
+  "x=1\n"
+  "}\n"
+  "ends\n"
+  ">H\n"
+  "x=0x10\n"
+  ">I\n"
+  "x = a\n"
+  ">J\n"
+  "if a>0 and b>0 {\n"
+  "y=1\n"
+  "}\n"
+  ">K\n"
+  "if ((a+1)*2>b) {\n"
+  "y=1\n"
+  "}\n"
+  ">L\n"
+  "x=a\n"
+  "if a>0 {\n"
+  "y=1\n";
+
+const char kBench[] =
+  ">S\n"
+  "cnt+=1\n"
+  "if cnt>=10\n"
+  "then\n"
+  "cnt=0\n"
+  "tmp=(tmp*9+val)/10\n"
+  "endif\n"
+  "if (tmp>30 and hum<60) {\n"
+  "fan=1\n"
+  "} else {\n"
+  "fan=0\n"
+  "}\n"
+  "sum=0\n"
+  "for i 1 8 1\n"
+  "sum+=i*val\n"
+  "next\n"
+  "switch mode\n"
+  "case 1\n"
+  "pwr=val*2\n"
+  "case 2\n"
+  "pwr=val/2\n"
+  "ends\n"
+  "hum=hum+(val%7)-3\n";
+
+double Time(const char *section, bool compiled, uint32_t loops) {
+  union S_OP **code = glob_script_mem.code;
+  if (!compiled) glob_script_mem.code = 0;
+  Seed(1);
+  fvars[7] = 1;
+  struct timespec start, stop;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t count = 0; count < loops; count++) {
+    fvars[5] = count % 50;
+    Run_Scripter(section, strlen(section), 0);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  glob_script_mem.code = code;
+  return ((stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec)) / loops;
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    Load(kBench, "cnt|tmp|hum|fan|sum|val|i|mode|pwr");
+    CHECK(glob_script_mem.code && glob_script_mem.code[0], "bench section not compiled");
+    uint32_t loops = 200000;
+    double interpreted = Time(">S", false, loops);
+    double compiled = Time(">S", true, loops);
+    printf("section >S, %u runs: interpreted %.0f ns, compiled %.0f ns per run, %.1fx\n", loops, interpreted, compiled, interpreted / compiled);
+    printf("section >S: %u bytes of text, %u bytes of code\n", (uint32_t)strlen(kBench), (uint32_t)(glob_script_mem.code[0]->data * sizeof(union S_OP)));
+    Script_FreeIndex();
+    return failures ? 1 : 0;
+  }
+
+  Compare("arith", kArith, "x|y|z|w|u|v|a|b|c|d", ">A|>B", "cc");
+  Compare("if", kIf, "x|y|z|w|a|b|c|d", ">A|>B", "cc");
+  Compare("loop", kLoop, "x|y|z|w|u|a|b|i", ">A", "c");
+  Compare("cmd", kCmd, "x|y|a", ">A|#sub", "cc");
+  Compare("fallback", kFallback, "x|$s|a|b|order|i|j|y", ">A|>B|>C|>D|>E|>F|>G|>H|>I|>J|>K|>L", "iiiiiiiiiiii");
+  Compare("bench", kBench, "cnt|tmp|hum|fan|sum|val|i|mode|pwr", ">S", "c");
+
+  // Compiled code runs instead of the text, constants are taken at init
+  Load(">A\nx=1\n", "x");
+  script[5] = '2';
+  RUN run = {};
+  Run(">A", 0, true, &run);
+  CHECK(run.fvars[0] == 1, "compiled section not used");
+  Run(">A", 0, false, &run);
+  CHECK(run.fvars[0] == 2, "interpreted section not used");
+  Script_FreeIndex();
+
+  // Sections reading system variables are interpreted while json input may shadow them
+  Load(kIf, "x|y|z|w|a|b|c|d");
+  CHECK(glob_script_mem.code[0] && !(glob_script_mem.code[0]->arg & SCRIPT_CODE_SYSVAR), "no system variables in >A");
+  CHECK(glob_script_mem.code[1] && (glob_script_mem.code[1]->arg & SCRIPT_CODE_SYSVAR), "system variables in >B");
+  Script_FreeIndex();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
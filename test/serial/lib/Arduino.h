@@ -0,0 +1,73 @@
+/*
+  Arduino.h - Host shim to build TasmotaSerial as ESP8266 software serial for tests
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#define ESP8266
+#define ICACHE_RAM_ATTR
+#define INPUT 0
+#define OUTPUT 1
+#define HIGH 1
+#define LOW 0
+#define CHANGE 1
+#define FALLING 2
+#define SERIAL_8N1 0
+#define SERIAL_8N2 1
+#define GPIO_STATUS_W1TC_ADDRESS 0
+#define GPIO_REG_WRITE(reg, value)
+
+inline void pinMode(int pin, int mode) {}
+inline void (*digitalWriteHook)(int pin, int value) = nullptr;   // Set by tests decoding software serial transmit
+inline void digitalWrite(int pin, int value) { if (digitalWriteHook) { digitalWriteHook(pin, value); } }
+inline int digitalRead(int pin) { return HIGH; }
+inline void attachInterruptArg(int pin, void (*handler)(void*), void* arg, int mode) {}
+inline void detachInterrupt(int pin) {}
+inline void cli(void) {}
+inline void sei(void) {}
+inline void optimistic_yield(uint32_t us) {}
+
+class EspClass {
+  public:
+    uint32_t cycles = 0;
+    uint32_t getCycleCount(void) { return cycles += 100; }   // Bit wait loops end after a few rounds
+    uint32_t getCpuFreqMHz(void) { return 80; }
+};
+inline EspClass ESP;
+
+// Hardware serial with data and overrun flag set by the test
+class HardwareSerial {
+  public:
+    uint8_t data[256] = { 0 };
+    size_t len = 0;
+    bool overrun = false;
+
+    void begin(long speed, int config) {}
+    void flush(void) {}
+    void swap(void) {}
+    bool hasOverrun(void) { bool result = overrun; overrun = false; return result; }
+    int available(void) { return len; }
+    int peek(void) { return (len) ? data[0] : -1; }
+    int read(void) {
+      if (!len) { return -1; }
+      int ch = data[0];
+      memmove(data, data +1, --len);
+      return ch;
+    }
+    size_t read(char* buffer, size_t size) {
+      size_t count = 0;
+      while ((count < size) && len) { buffer[count++] = read(); }
+      return count;
+    }
+    size_t write(uint8_t byte) { return 1; }
+    size_t write(const uint8_t* buffer, size_t size) { return size; }
+};
+inline HardwareSerial Serial;
+
+#endif  // Arduino_h
@@ -0,0 +1,176 @@
+/*
+  test-ring-isr.cpp - Host test of the TasmotaSerial receive ring against a receive interrupt
+
+  The interrupt is simulated two ways while read(buf, len), read() and peek(buf, len) consume:
+  - Preempt: memcpy in TasmotaSerial.cpp is replaced so the interrupt stores bytes after the
+    consumer took its snapshot, halfway through the copy and before the space is released.
+  - Thread: a producer thread stores bytes at full speed and paced at 921600 baud while the
+    consumer reads in blocks, like a receive interrupt on another core.
+  Each byte sent is a sequence number. The bytes read must be the sequence without the bytes the
+  interrupt found no room for, and those must match the overrun count.
+
+  Build and run with: make test
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <Arduino.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+class TasmotaSerial;
+void Interrupt(uint32_t count);
+
+// Copy in two halves with interrupts before, between and after them
+void * PreemptedMemcpy(void *dst, const void *src, size_t len) {
+  size_t half = len / 2;
+  Interrupt(rand() % 8);
+  (memcpy)(dst, src, half);
+  Interrupt(rand() % 8);
+  (memcpy)((uint8_t*)dst + half, (const uint8_t*)src + half, len - half);
+  Interrupt(rand() % 8);
+  return dst;
+}
+
+#define private public                        // Store bytes as the receive interrupt does
+#define memcpy(dst, src, len) PreemptedMemcpy(dst, src, len)
+#include "TasmotaSerial.cpp"
+#undef memcpy
+#undef private
+
+// Bytes sent by the interrupt, numbered, and the numbers it dropped as overrun
+struct Sender {
+  TasmotaSerial *serial = nullptr;
+  uint32_t next = 0;
+  std::vector<uint32_t> dropped;
+
+  void send(void) {
+    uint32_t overrun = serial->m_overrun;
+    serial->rxStore(next & 0xFF);
+    if (serial->m_overrun != overrun) { dropped.push_back(next); }
+    next++;
+  }
+};
+
+// Checks bytes read against the numbers sent and not dropped, in order
+struct Receiver {
+  uint32_t next = 0;
+  uint32_t received = 0;
+  size_t dropped_index = 0;
+  bool failed = false;
+
+  void check(const std::vector<uint32_t> &dropped, uint8_t iob) {
+    while ((dropped_index < dropped.size()) && (dropped[dropped_index] == next)) {
+      dropped_index++;
+      next++;
+    }
+    if (!failed && (iob != (next & 0xFF))) {
+      printf("FAIL byte %u is %u, expected %u\n", received, iob, next & 0xFF);
+      failures++;
+      failed = true;
+    }
+    next++;
+    received++;
+  }
+};
+
+Sender isr;
+
+void Interrupt(uint32_t count) {
+  if (!isr.serial) { return; }
+  while (count--) { isr.send(); }
+}
+
+void TestPreempt(void) {
+  TasmotaSerial serial(4, 5, 0, 0, 32);
+  Receiver receiver;
+  uint8_t buffer[48];
+  uint8_t peeked[48];
+  isr.serial = &serial;
+  srand(1);
+  for (uint32_t round = 0; round < 200000; round++) {
+    Interrupt(rand() % 24);
+    uint32_t action = rand() % 4;
+    if (0 == action) {
+      int ch = serial.read();
+      if (ch >= 0) { receiver.check(isr.dropped, ch); }
+    } else if (1 == action) {
+      size_t size = rand() % sizeof(peeked);
+      size_t len = serial.peek(peeked, size);    // Interrupted too, must not consume
+      size_t read = serial.read(buffer, len);
+      CHECK(read == len);
+      CHECK(0 == memcmp(buffer, peeked, len));
+      for (size_t i = 0; i < read; i++) { receiver.check(isr.dropped, buffer[i]); }
+    } else {
+      size_t len = serial.read(buffer, rand() % sizeof(buffer));
+      for (size_t i = 0; i < len; i++) { receiver.check(isr.dropped, buffer[i]); }
+    }
+  }
+  isr.serial = nullptr;
+  size_t len;
+  while ((len = serial.read(buffer, sizeof(buffer)))) {
+    for (size_t i = 0; i < len; i++) { receiver.check(isr.dropped, buffer[i]); }
+  }
+  CHECK(isr.dropped.size() == serial.getOverrunCount());
+  CHECK(receiver.received + isr.dropped.size() == isr.next);
+  CHECK(isr.dropped.size() && receiver.received);
+  printf("Preempt: %u bytes read, %u dropped\n", receiver.received, (uint32_t)isr.dropped.size());
+}
+
+// Producer thread storing count bytes, one every period_ns or as fast as possible if 0
+void TestThread(uint32_t count, uint32_t period_ns) {
+  TasmotaSerial serial(4, 5, 0, 0, 64);
+  Sender sender;
+  sender.serial = &serial;
+  std::atomic<bool> done(false);
+  std::thread producer([&]() {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+      if (period_ns) {
+        auto due = start + std::chrono::nanoseconds((uint64_t)i * period_ns);
+        while (std::chrono::steady_clock::now() < due) { std::this_thread::yield(); }
+      } else if (0 == (i & 127)) {
+        std::this_thread::yield();            // Let a single core consumer run between bursts
+      }
+      sender.send();
+    }
+    done = true;
+  });
+
+  std::vector<uint8_t> received;
+  received.reserve(count);
+  uint8_t buffer[48];
+  srand(2);
+  while (true) {
+    bool last = done;                         // Read once more after the producer is done
+    size_t len = serial.read(buffer, 1 + rand() % sizeof(buffer));
+    received.insert(received.end(), buffer, buffer + len);
+    if (last && !len) { break; }
+    if (!len) { std::this_thread::yield(); }
+  }
+  producer.join();
+
+  Receiver receiver;
+  for (uint8_t iob : received) { receiver.check(sender.dropped, iob); }
+  CHECK(sender.dropped.size() == serial.getOverrunCount());
+  CHECK(received.size() + sender.dropped.size() == count);
+  CHECK(0 == serial.available());
+  printf("Thread %s: %u bytes read, %u dropped\n", (period_ns) ? "921600 baud" : "full speed", (uint32_t)received.size(), (uint32_t)sender.dropped.size());
+}
+
+int main(int argc, char* argv[]) {
+  TestPreempt();
+  TestThread(2000000, 0);
+  TestThread(50000, 10850);                   // 10 bits per byte at 921600 baud
+  printf("%s\n", (failures) ? "FAILED" : "All tests passed");
+  return (failures) ? 1 : 0;
+}
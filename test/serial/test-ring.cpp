@@ -0,0 +1,145 @@
+/*
+  test-ring.cpp - Host test of the TasmotaSerial software serial receive ring
+
+  Build and run with: make test
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+
+#include <Arduino.h>
+#define private public                        // Store bytes as the receive interrupt does
+#include "TasmotaSerial.h"
+#undef private
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+void Store(TasmotaSerial &serial, uint32_t first, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    serial.rxStore((first + i) & 0xFF);
+  }
+}
+
+void TestSize(void) {
+  TasmotaSerial s64(4, 5, 0, 0, 64);
+  CHECK(64 -1 == s64.m_buffer_mask);
+  TasmotaSerial s100(4, 5, 0, 0, 100);
+  CHECK(128 -1 == s100.m_buffer_mask);        // Rounded up to power of two
+}
+
+void TestOverrun(void) {
+  TasmotaSerial serial(4, 5, 0, 0, 64);
+  Store(serial, 0, 63);                       // One slot stays free to tell full from empty
+  CHECK(63 == serial.available());
+  CHECK(0 == serial.getOverrunCount());
+  Store(serial, 63, 5);
+  CHECK(63 == serial.available());
+  CHECK(5 == serial.getOverrunCount());
+  uint8_t buffer[64];
+  CHECK(63 == serial.read(buffer, sizeof(buffer)));
+  for (uint32_t i = 0; i < 63; i++) {
+    CHECK(i == buffer[i]);                    // Oldest bytes kept, newest dropped
+  }
+  CHECK(0 == serial.available());
+}
+
+void TestWrap(void) {
+  TasmotaSerial serial(4, 5, 0, 0, 64);
+  uint8_t buffer[64];
+  Store(serial, 0, 50);
+  CHECK(50 == serial.read(buffer, 50));
+  Store(serial, 50, 40);                      // Wraps at byte 64
+  CHECK(40 == serial.available());
+  CHECK(50 == serial.peek());
+  CHECK(40 == serial.peek(buffer, sizeof(buffer)));
+  CHECK(40 == serial.available());            // Peek does not consume
+  for (uint32_t i = 0; i < 40; i++) {
+    CHECK(50 + i == buffer[i]);
+  }
+  CHECK(10 == serial.read(buffer, 10));       // Up to the wrap
+  CHECK(59 == buffer[9]);
+  CHECK(20 == serial.read(buffer, 20));       // Across the wrap
+  for (uint32_t i = 0; i < 20; i++) {
+    CHECK(60 + i == buffer[i]);
+  }
+  CHECK(80 == serial.read());
+  CHECK(9 == serial.read(buffer, sizeof(buffer)));
+  CHECK(89 == buffer[8]);
+  CHECK(-1 == serial.read());
+  CHECK(-1 == serial.peek());
+  CHECK(0 == serial.read(buffer, sizeof(buffer)));
+}
+
+void TestFlush(void) {
+  TasmotaSerial serial(4, 5, 0, 0, 64);
+  Store(serial, 0, 70);
+  serial.flush();
+  CHECK(0 == serial.available());
+  Store(serial, 0, 63);
+  CHECK(63 == serial.available());
+}
+
+// Random interleaving of stores and single or bulk reads against a reference queue
+void TestModel(void) {
+  TasmotaSerial serial(4, 5, 0, 0, 32);
+  std::deque<uint8_t> model;
+  uint32_t overrun = 0;
+  uint32_t next = 0;
+  uint8_t buffer[48];
+  srand(1);
+  for (uint32_t round = 0; round < 100000; round++) {
+    uint32_t count = rand() % 40;
+    for (uint32_t i = 0; i < count; i++) {
+      serial.rxStore(next & 0xFF);
+      if (model.size() < 31) { model.push_back(next & 0xFF); } else { overrun++; }
+      next++;
+    }
+    CHECK(model.size() == (uint32_t)serial.available());
+    if (rand() & 1) {
+      int ch = serial.read();
+      CHECK(ch == (model.empty() ? -1 : model.front()));
+      if (!model.empty()) { model.pop_front(); }
+    } else {
+      size_t size = rand() % sizeof(buffer);
+      size_t len = serial.read(buffer, size);
+      CHECK(len == ((size < model.size()) ? size : model.size()));
+      for (size_t i = 0; i < len; i++) {
+        CHECK(buffer[i] == model.front());
+        model.pop_front();
+      }
+    }
+  }
+  CHECK(overrun == serial.getOverrunCount());
+}
+
+void TestHardwareOverrun(void) {
+  TasmotaSerial serial(3, 1, 1);              // Hardware serial fallback
+  CHECK(serial.hardwareSerial());
+  uint8_t buffer[8];
+  Serial.len = 4;
+  Serial.overrun = true;
+  CHECK(0 == serial.read());
+  CHECK(1 == serial.getOverrunCount());
+  CHECK(3 == serial.read(buffer, sizeof(buffer)));
+  CHECK(1 == serial.getOverrunCount());       // Flag was cleared by previous read
+  Serial.len = 2;
+  Serial.overrun = true;
+  CHECK(2 == serial.read(buffer, sizeof(buffer)));
+  CHECK(2 == serial.getOverrunCount());
+}
+
+int main(int argc, char* argv[]) {
+  TestSize();
+  TestOverrun();
+  TestWrap();
+  TestFlush();
+  TestModel();
+  TestHardwareOverrun();
+  printf("%s\n", (failures) ? "FAILED" : "All tests passed");
+  return (failures) ? 1 : 0;
+}
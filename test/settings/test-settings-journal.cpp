@@ -0,0 +1,240 @@
+/*
+  test-settings-journal.cpp - Host test of the Settings flash journal in settings.ino
+
+  Runs SettingsSave() and SettingsLoad() with USE_SETTINGS_JOURNAL against a simulated
+  ESP8266 NOR flash that can lose power after any programmed byte.
+
+  Build and run with: make test
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ESP8266
+#define USE_SETTINGS_JOURNAL
+
+#define PSTR(x) x
+#define D_LOG_CONFIG "CFG: "
+#define D_COUNT "Count"
+#define D_BYTES "Bytes"
+#define D_SAVED_TO_FLASH_AT "Saved to flash at"
+#define D_LOADED_FROM_FLASH_AT "Loaded from flash at"
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_DEBUG 3
+#define CFG_HOLDER 4617
+#define START_VALID_TIME 1451602800
+
+typedef uint32_t uint32;
+
+struct {                                    // Same header and trailer offsets as settings.h
+  uint16_t      cfg_holder;                 // 000
+  uint16_t      cfg_size;                   // 002
+  uint32_t      save_flag;                  // 004
+  uint32_t      version;                    // 008
+  uint16_t      bootcount;                  // 00C
+  uint16_t      cfg_crc;                    // 00E
+  struct {
+    uint32_t    stop_flash_rotate : 1;
+  } flag;                                   // 010
+  uint8_t       body[0xFF8 - 0x014];        // 014
+  uint32_t      cfg_timestamp;              // FF8
+  uint32_t      cfg_crc32;                  // FFC
+} Settings;
+static_assert(sizeof(Settings) == 4096, "Settings size differs from ESP8266");
+
+struct {
+  uint8_t stop_flash_rotate;
+} TasmotaGlobal;
+
+/*********************************************************************************************\
+ * Simulated flash with power loss after a number of programmed bytes
+\*********************************************************************************************/
+
+const uint32_t SPI_FLASH_SEC_SIZE = 4096;
+const uint32_t FLASH_SECTORS = 256;
+const uint32_t SETTINGS_LOCATION = 0xFB;
+const uint8_t CFG_ROTATES = 8;
+uint32_t settings_location = SETTINGS_LOCATION;
+uint32_t settings_crc32 = 0;
+
+uint8_t flash[FLASH_SECTORS * SPI_FLASH_SEC_SIZE];
+uint32_t flash_erases = 0;
+int32_t power_loss = -1;                    // Bytes to program before power is lost, -1 = never
+
+struct PowerLoss {};
+
+struct {
+  bool flashEraseSector(uint32_t sector) {
+    if (0 == power_loss) { throw PowerLoss(); }
+    memset(flash + (sector * SPI_FLASH_SEC_SIZE), 0xFF, SPI_FLASH_SEC_SIZE);
+    flash_erases++;
+    return true;
+  }
+  bool flashWrite(uint32_t address, uint32_t *data, size_t size) {
+    if ((address & 3) || (size & 3)) { throw "Unaligned flash write"; }
+    const uint8_t *bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+      if (0 == power_loss) { throw PowerLoss(); }
+      if (power_loss > 0) { power_loss--; }
+      flash[address + i] &= bytes[i];       // NOR flash only clears bits
+    }
+    return true;
+  }
+  bool flashRead(uint32_t address, uint32_t *data, size_t size) {
+    memcpy(data, flash + address, size);
+    return true;
+  }
+} ESP;
+
+void AddLog_P(uint32_t, const char*, ...) {}
+void delay(uint32_t) {}
+void RtcSettingsSave(void) {}
+void RtcSettingsLoad(void) {}
+uint32_t UtcTime(void) { return 0; }
+void UpdateBackwardCompatibility(void) {}
+void SettingsSave(uint8_t rotate);
+
+void SettingsDefault(void) {
+  memset(&Settings, 0, sizeof(Settings));
+  Settings.cfg_holder = CFG_HOLDER;
+  SettingsSave(2);
+}
+
+#include "settings_journal.h"
+
+/*********************************************************************************************\
+ * Tests
+\*********************************************************************************************/
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+void FlashErase(void) {
+  memset(flash, 0xFF, sizeof(flash));
+  power_loss = -1;
+  settings_location = SETTINGS_LOCATION;
+  TasmotaGlobal.stop_flash_rotate = 0;
+  SettingsLoad();
+}
+
+bool SameBody(const uint8_t *body) {
+  return !memcmp(body, Settings.body, sizeof(Settings.body));
+}
+
+// An hour of saves changing a few fields every second needs few sector erases and reloads the last save
+void TestWear(void) {
+  for (uint32_t mode = 0; mode < 3; mode++) {
+    FlashErase();
+    flash_erases = 0;
+    const uint32_t saves = 3600;
+    for (uint32_t t = 0; t < saves; t++) {
+      Settings.body[100] = t;
+      if (mode >= 1) {                      // Three blocks per save
+        Settings.body[1000] = t >> 3;
+        Settings.body[3000] = t >> 5;
+      }
+      if ((2 == mode) && !(t % 10)) {
+        snprintf((char*)Settings.body + 2000, 32, "value %u", t);
+      }
+      SettingsSave(0);
+    }
+    uint8_t body[sizeof(Settings.body)];
+    memcpy(body, Settings.body, sizeof(body));
+    SettingsLoad();
+    CHECK(SameBody(body));
+    CHECK(flash_erases < saves / 10);
+  }
+}
+
+// Unchanged Settings are not written
+void TestUnchanged(void) {
+  FlashErase();
+  Settings.body[10] = 1;
+  SettingsSave(0);
+  uint32_t save_flag = Settings.save_flag;
+  uint32_t erases = flash_erases;
+  SettingsSave(0);
+  CHECK(save_flag == Settings.save_flag);
+  CHECK(erases == flash_erases);
+}
+
+// A full journal is replaced by a new image that reloads with the same content
+void TestJournalFull(void) {
+  FlashErase();
+  for (uint32_t t = 0; t < 1000; t++) {
+    memset(Settings.body, t, sizeof(Settings.body));  // Every block changes
+    SettingsSave(0);
+    uint8_t body[sizeof(Settings.body)];
+    memcpy(body, Settings.body, sizeof(body));
+    if (!(t % 97)) {
+      SettingsLoad();
+      CHECK(SameBody(body));
+    }
+  }
+}
+
+// Power lost at any byte of a save reloads either the previous or the new Settings
+void TestPowerLoss(void) {
+  srand(1);
+  for (uint32_t trial = 0; trial < 500; trial++) {
+    FlashErase();
+    uint32_t steps = 40 + rand() % 80;
+    for (uint32_t t = 0; t < steps; t++) {
+      Settings.body[(t * 37) % 4000] = t +1;
+      SettingsSave(0);
+    }
+    uint8_t before[sizeof(Settings.body)];
+    memcpy(before, Settings.body, sizeof(before));
+    Settings.body[rand() % 4000] ^= 0x5A;
+    Settings.body[rand() % 4000] ^= 0xA5;
+    uint8_t after[sizeof(Settings.body)];
+    memcpy(after, Settings.body, sizeof(after));
+
+    power_loss = rand() % 9000;
+    try { SettingsSave(0); } catch (PowerLoss&) {}
+    power_loss = -1;
+    SettingsLoad();
+    CHECK(SameBody(before) || SameBody(after));
+
+    for (uint32_t t = 0; t < 50; t++) {     // Saves after recovery still reload
+      Settings.body[(t * 53) % 4000] = t +7;
+      SettingsSave(0);
+    }
+    memcpy(after, Settings.body, sizeof(after));
+    SettingsLoad();
+    CHECK(SameBody(after));
+  }
+}
+
+// SetOption12 1 keeps writing full images to the eeprom slot
+void TestStopFlashRotate(void) {
+  FlashErase();
+  TasmotaGlobal.stop_flash_rotate = 1;
+  for (uint32_t t = 0; t < 20; t++) {
+    Settings.body[500] = t;
+    SettingsSave(0);
+    CHECK(SETTINGS_LOCATION == settings_location);
+  }
+  TasmotaGlobal.stop_flash_rotate = 0;
+  SettingsLoad();
+  CHECK(19 == Settings.body[500]);
+}
+
+int main(int argc, char* argv[]) {
+  try {
+    TestWear();
+    TestUnchanged();
+    TestJournalFull();
+    TestPowerLoss();
+    TestStopFlashRotate();
+  }
+  catch (const char *error) {
+    printf("FAIL %s\n", error);
+    failures++;
+  }
+  printf("%s\n", (failures) ? "FAILED" : "All tests passed");
+  return (failures) ? 1 : 0;
+}
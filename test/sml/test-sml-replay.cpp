@@ -0,0 +1,289 @@
+/*
+  test-sml-replay.cpp - Host replay test of the SML meter decoder in xsns_53_sml.ino
+
+  Queues recorded meter telegrams in a host serial port and reads them with SML_Poll(), which
+  decodes them byte by byte through sml_shift_in() and SML_Decode(), and compares the meter
+  variables against values recorded with the previous decoder. Checks that SML_Poll() reads
+  the serial port in blocks.
+
+  Build and run with: make test
+  Record new expected values with: make record SML_SOURCE=<xsns_53_sml.ino of reference revision>
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <deque>
+
+#define ESP8266
+#define PSTR(x) x
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+
+#define SML_MAX_VARS 20
+#define MAX_METERS 5
+#define MAX_DVARS MAX_METERS*2
+#define SML_BSIZ 48
+#define METER_ID_SIZE 24
+
+struct METER_DESC {
+  uint8_t srcpin;
+  uint8_t type;
+  uint16_t flag;
+  int32_t params;
+  char prefix[8];
+  int8_t trxpin;
+  uint8_t tsecs;
+  char *txmem;
+  uint8_t index;
+  uint8_t max_index;
+  uint8_t sopt;
+};
+
+double meter_vars[SML_MAX_VARS];
+double dvalues[MAX_DVARS];
+uint32_t dtimes[MAX_DVARS];
+uint8_t meters_used;
+struct METER_DESC const *meter_desc_p;
+const uint8_t *meter_p;
+uint8_t smltbuf[MAX_METERS][SML_BSIZ];
+char meter_id[MAX_METERS][METER_ID_SIZE];
+
+// Serial port with the TasmotaSerial read calls, counting the calls of each
+class TestSerial {
+  std::deque<uint8_t> rx;
+ public:
+  uint32_t byte_reads = 0;
+  uint32_t block_reads = 0;
+  uint32_t block_bytes = 0;
+  void queue(uint8_t iob) { rx.push_back(iob); }
+  int available(void) { return rx.size(); }
+  int read(void) {
+    if (rx.empty()) { return -1; }
+    byte_reads++;
+    uint8_t iob = rx.front();
+    rx.pop_front();
+    return iob;
+  }
+  size_t read(uint8_t *buffer, size_t size) {
+    size_t len = 0;
+    while ((len < size) && !rx.empty()) {
+      buffer[len++] = rx.front();
+      rx.pop_front();
+    }
+    block_reads++;
+    block_bytes += len;
+    return len;
+  }
+};
+TestSerial serial_ports[MAX_METERS];
+TestSerial *meter_ss[MAX_METERS];
+
+uint32_t sim_millis = 0;
+uint32_t mqtt_calls = 0;
+uint32_t mqtt_vars = 0;
+
+uint32_t millis(void) { return sim_millis; }
+void delay(uint32_t) {}
+void AddLog_P(uint32_t, const char*, ...) {}
+uint8_t lowByte(uint16_t value) { return value & 0xFF; }
+uint8_t highByte(uint16_t value) { return value >> 8; }
+size_t TestStrlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t copy = (len < size -1) ? len : size -1;
+    memcpy(dst, src, copy);
+    dst[copy] = 0;
+  }
+  return len;
+}
+#define strlcpy TestStrlcpy                   // Not in every host libc
+uint16_t MBUS_calculateCRC(uint8_t*, uint8_t) { return 0; }
+uint8_t SML_PzemCrc(uint8_t*, uint8_t) { return 0; }
+
+void SML_Immediate_MQTT(const char*, uint8_t index, uint8_t) {
+  mqtt_calls++;
+  mqtt_vars += index +1;
+}
+
+uint8_t hexnibble(char chr);
+double CharToDouble(const char *str);
+double sml_getvalue(unsigned char *cp, uint8_t index);
+void SML_DecodeEntry(uint8_t mindex, uint32_t entry_index);
+void SML_Decode(uint8_t index);
+
+#include "sml_decode.h"
+
+#ifndef SML_PBSIZ
+#define SML_PBSIZ 1                           // Revisions reading byte by byte, for make record
+#endif
+
+/*********************************************************************************************\
+ * Fixture
+ *
+ * meter <n> <type> <prefix>    Meter descriptor, n starts at 1
+ * def <line>                   Meter definition line, joined with |
+ * load                         Make the definition active in a new buffer
+ * time <ms>                    Set millis()
+ * hex <n> <bytes>              Feed hex bytes to meter n
+ * text <n> <string>            Feed text with \r and \n escapes to meter n
+ * check                        Compare state against the following vars, mqtt and id lines
+\*********************************************************************************************/
+
+static int failures = 0;
+static bool record = false;
+static uint32_t line_nr = 0;
+
+struct METER_DESC meters[MAX_METERS];
+std::string definition;
+std::vector<std::string> loaded;
+
+void Fail(const char *what, const std::string &expected, const std::string &actual) {
+  printf("FAIL line %u %s: expected %s got %s\n", line_nr, what, expected.c_str(), actual.c_str());
+  failures++;
+}
+
+std::string Vars(void) {
+  std::string vars;
+  char number[32];
+  for (uint32_t i = 0; i < SML_MAX_VARS; i++) {
+    snprintf(number, sizeof(number), "%s%.17g", (i) ? " " : "", meter_vars[i]);
+    vars += number;
+  }
+  return vars;
+}
+
+std::string Mqtt(void) {
+  char mqtt[32];
+  snprintf(mqtt, sizeof(mqtt), "%u %u", mqtt_calls, mqtt_vars);
+  return mqtt;
+}
+
+int Replay(FILE *fixture) {
+  char buffer[1024];
+  while (fgets(buffer, sizeof(buffer), fixture)) {
+    line_nr++;
+    std::string line = buffer;
+    while (!line.empty() && ((line.back() == '\n') || (line.back() == '\r'))) { line.pop_back(); }
+    size_t space = line.find(' ');
+    std::string cmnd = line.substr(0, space);
+    std::string arg = (space == std::string::npos) ? "" : line.substr(space +1);
+
+    if (record && ((cmnd == "vars") || (cmnd == "mqtt") || (cmnd == "id"))) { continue; }
+    if (record) { printf("%s\n", line.c_str()); }
+
+    if (cmnd.empty() || (cmnd[0] == '#')) {
+    }
+    else if (cmnd == "meter") {
+      uint32_t meter;
+      char type;
+      char prefix[8];
+      if (sscanf(arg.c_str(), "%u %c %7s", &meter, &type, prefix) != 3 || !meter || (meter > MAX_METERS)) { return 2; }
+      memset(&meters[meter -1], 0, sizeof(struct METER_DESC));
+      meters[meter -1].type = type;
+      meters[meter -1].trxpin = -1;
+      strcpy(meters[meter -1].prefix, prefix);
+      meter_ss[meter -1] = &serial_ports[meter -1];
+      if (meter > meters_used) { meters_used = meter; }
+    }
+    else if (cmnd == "def") {
+      if (!definition.empty()) { definition += "|"; }
+      definition += arg;
+    }
+    else if (cmnd == "load") {
+      loaded.push_back(definition);        // Keep previous buffers so each load gets a new address
+      definition.clear();
+      meter_desc_p = meters;
+      meter_p = (const uint8_t*)loaded.back().c_str();
+    }
+    else if (cmnd == "time") {
+      sim_millis = strtoul(arg.c_str(), nullptr, 10);
+    }
+    else if ((cmnd == "hex") || (cmnd == "text")) {
+      char *data;
+      uint32_t meter = strtoul(arg.c_str(), &data, 10);
+      if (!meter || (meter > meters_used) || (*data != ' ')) { return 2; }
+      data++;
+      while (*data) {
+        uint8_t iob;
+        if (cmnd == "hex") {
+          if (' ' == *data) { data++; continue; }
+          if (!isxdigit(data[0]) || !isxdigit(data[1])) { return 2; }
+          iob = (hexnibble(data[0]) << 4) | hexnibble(data[1]);
+          data += 2;
+        } else {
+          iob = *data++;
+          if (('\\' == iob) && ('r' == *data)) { iob = '\r'; data++; }
+          else if (('\\' == iob) && ('n' == *data)) { iob = '\n'; data++; }
+        }
+        serial_ports[meter -1].queue(iob);
+      }
+      SML_Poll();
+    }
+    else if (cmnd == "check") {
+      if (record) {
+        printf("vars %s\n", Vars().c_str());
+        printf("mqtt %s\n", Mqtt().c_str());
+        for (uint32_t i = 0; i < meters_used; i++) {
+          if (meter_id[i][0]) { printf("id %u %.*s\n", i +1, METER_ID_SIZE, meter_id[i]); }
+        }
+      }
+    }
+    else if (cmnd == "vars") {
+      if (arg != Vars()) { Fail("vars", arg, Vars()); }
+    }
+    else if (cmnd == "mqtt") {
+      if (arg != Mqtt()) { Fail("mqtt", arg, Mqtt()); }
+    }
+    else if (cmnd == "id") {
+      uint32_t meter = strtoul(arg.c_str(), nullptr, 10);
+      std::string expected = arg.substr(arg.find(' ') +1);
+      std::string actual = (meter && (meter <= MAX_METERS)) ? std::string(meter_id[meter -1], strnlen(meter_id[meter -1], METER_ID_SIZE)) : "";
+      if (expected != actual) { Fail("id", expected, actual); }
+    }
+    else {
+      return 2;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  int arg = 1;
+  if ((argc > arg) && !strcmp(argv[arg], "-r")) {
+    record = true;
+    arg++;
+  }
+  if (argc <= arg) {
+    printf("usage: %s [-r] <fixture>\n", argv[0]);
+    return 2;
+  }
+  FILE *fixture = fopen(argv[arg], "r");
+  if (!fixture) {
+    printf("Unable to open %s\n", argv[arg]);
+    return 2;
+  }
+  int result = Replay(fixture);
+  fclose(fixture);
+  if (result) {
+    printf("Bad fixture line %u\n", line_nr);
+    return result;
+  }
+  if (!record) {
+    uint32_t bytes = 0;
+    for (uint32_t i = 0; i < MAX_METERS; i++) {
+      bytes += serial_ports[i].block_bytes;
+      if (serial_ports[i].byte_reads || (serial_ports[i].block_bytes > serial_ports[i].block_reads * SML_PBSIZ)) {
+        printf("FAIL meter %u: %u single byte reads, %u bytes in %u block reads\n", i +1, serial_ports[i].byte_reads, serial_ports[i].block_bytes, serial_ports[i].block_reads);
+        failures++;
+      }
+    }
+    printf("%u bytes read in blocks of up to %u\n", bytes, SML_PBSIZ);
+    printf("%s\n", (failures) ? "FAILED" : "All tests passed");
+  }
+  return (failures) ? 1 : 0;
+}
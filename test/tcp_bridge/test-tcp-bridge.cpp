@@ -0,0 +1,269 @@
+/*
+  test-tcp-bridge.cpp - Host test of the TCP bridge block transfer in xdrv_41_tcp_bridge.ino
+
+  Runs TCPLoop() against the TasmotaSerial software serial built for ESP8266 and simulated
+  WiFi clients. Bytes stored in the serial receive ring as the interrupt does must reach every
+  connected client in order with one client write per ring content, and bytes sent by a client
+  must leave the serial transmit pin in order, decoded from the bit banged levels. Also checks
+  the per client counters, the hex log of a full block and the replacement of the oldest client
+  when all connections are in use.
+
+  Build and run with: make test
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#define private public                        // Store bytes as the receive interrupt does
+#include <TasmotaSerial.h>
+#undef private
+
+#define PROGMEM
+#define PSTR(x) (x)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof(a[0]))
+#define LOG_LEVEL_DEBUG 3
+#define D_LOG_TCP "TCP: "
+#define TCP_BRIDGE_CONNECTIONS 2
+#define TCP_BRIDGE_BUF_SIZE 255
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("FAIL %s:%d %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+struct {
+  uint32_t uptime = 100;
+} TasmotaGlobal;
+
+uint32_t micros_now = 0;
+uint32_t micros(void) { return micros_now += 3; }
+void yield(void) {}
+
+bool need_log = false;
+std::vector<std::string> logs;
+bool NeedLog(uint32_t loglevel) { return need_log; }
+void AddLog_P(uint32_t loglevel, const char *formatP, ...) {
+  char line[700];
+  va_list arg;
+  va_start(arg, formatP);
+  vsnprintf(line, sizeof(line), formatP, arg);
+  va_end(arg);
+  logs.push_back(line);
+}
+
+// Connection of a simulated client, shared by the copies of a WiFiClient
+struct Connection {
+  std::deque<uint8_t> to_device;              // Sent by the client and not yet read
+  std::vector<uint8_t> from_device;           // Written to the client
+  std::vector<size_t> writes;                 // Size of each client write
+  uint32_t reads = 0;                         // Number of block reads
+  bool open = true;
+};
+
+class WiFiClient {
+  public:
+    std::shared_ptr<Connection> conn;
+
+    operator bool() const { return conn && conn->open; }
+    void stop(void) { if (conn) { conn->open = false; } conn.reset(); }
+    int available(void) { return (conn) ? conn->to_device.size() : 0; }
+    int read(uint8_t *buffer, size_t size) {
+      size_t count = 0;
+      while ((count < size) && !conn->to_device.empty()) {
+        buffer[count++] = conn->to_device.front();
+        conn->to_device.pop_front();
+      }
+      conn->reads++;
+      return count;
+    }
+    size_t write(const uint8_t *buffer, size_t size) {
+      conn->from_device.insert(conn->from_device.end(), buffer, buffer + size);
+      conn->writes.push_back(size);
+      return size;
+    }
+};
+
+class WiFiServer {
+  public:
+    std::deque<std::shared_ptr<Connection>> pending;
+
+    bool hasClient(void) { return !pending.empty(); }
+    WiFiClient available(void) {
+      WiFiClient client;
+      if (!pending.empty()) {
+        client.conn = pending.front();
+        pending.pop_front();
+      }
+      return client;
+    }
+};
+
+char* ToHex_P(const unsigned char * in, size_t insz, char * out, size_t outsz, char inbetween = '\0');
+
+#include "support.h"
+#include "tcp_bridge.h"
+
+// Decode bytes from the levels written to the software serial transmit pin
+const int kTxPin = 5;
+std::vector<uint8_t> transmitted;
+int tx_bit = -1;                              // -1 idle, 0..7 data bit, 8 stop bit
+uint8_t tx_byte;
+
+void TxWrite(int pin, int value) {
+  if (pin != kTxPin) { return; }
+  if (-1 == tx_bit) {
+    if (LOW == value) { tx_bit = 0; tx_byte = 0; }   // Start bit
+  } else if (tx_bit < 8) {
+    if (HIGH == value) { tx_byte |= 1 << tx_bit; }
+    tx_bit++;
+  } else {
+    CHECK(HIGH == value);                     // Stop bit
+    transmitted.push_back(tx_byte);
+    tx_bit = -1;
+  }
+}
+
+std::shared_ptr<Connection> Connect(void) {
+  std::shared_ptr<Connection> conn = std::make_shared<Connection>();
+  server_tcp->pending.push_back(conn);
+  TCPLoop();
+  return conn;
+}
+
+void Setup(void) {
+  uint8_t buffer[TCP_BRIDGE_BUF_SIZE];
+  for (uint32_t i = 0; i < ARRAY_SIZE(client_tcp); i++) { client_tcp[i].stop(); }
+  while (TCPSerial->read(buffer, sizeof(buffer))) {}
+  transmitted.clear();
+  logs.clear();
+  need_log = false;
+  client_next = 0;
+}
+
+// Serial data of random length stored between loops reaches both clients in blocks
+void TestFromMcu(void) {
+  Setup();
+  std::shared_ptr<Connection> first = Connect();
+  std::shared_ptr<Connection> second = Connect();
+  CHECK(client_tcp[0] && client_tcp[1]);
+  std::vector<uint8_t> sent;
+  uint32_t loops_with_data = 0;
+  srand(1);
+  for (uint32_t round = 0; round < 20000; round++) {
+    uint32_t count = rand() % 256;            // Ring holds up to 255 bytes
+    for (uint32_t i = 0; i < count; i++) {
+      uint8_t byte = rand();
+      TCPSerial->rxStore(byte);
+      sent.push_back(byte);
+    }
+    if (count) { loops_with_data++; }
+    TCPLoop();
+  }
+  CHECK(0 == TCPSerial->getOverrunCount());
+  CHECK(first->from_device == sent);
+  CHECK(second->from_device == sent);
+  CHECK(loops_with_data == first->writes.size());   // Whole ring content, also across the wrap, in one write
+  CHECK(loops_with_data == second->writes.size());
+  CHECK(sent.size() == tcp_stat[0].from_mcu);
+  CHECK(sent.size() == tcp_stat[1].from_mcu);
+  CHECK(0 == tcp_stat[0].to_mcu);
+  CHECK(logs.empty());                        // No hex dump without a log destination
+}
+
+// Client data leaves the serial transmit pin in blocks of TCP_BRIDGE_BUF_SIZE
+void TestToMcu(void) {
+  Setup();
+  std::shared_ptr<Connection> first = Connect();
+  std::shared_ptr<Connection> second = Connect();
+  std::vector<uint8_t> expected;
+  srand(2);
+  for (uint32_t i = 0; i < 1000; i++) { first->to_device.push_back(rand()); }
+  for (uint32_t i = 0; i < 300; i++) { second->to_device.push_back(rand()); }
+  expected.insert(expected.end(), first->to_device.begin(), first->to_device.end());
+  expected.insert(expected.end(), second->to_device.begin(), second->to_device.end());
+  TCPLoop();
+  CHECK(first->to_device.empty() && second->to_device.empty());
+  CHECK(4 == first->reads);                   // 1000 bytes in 255 byte blocks
+  CHECK(2 == second->reads);
+  CHECK(1000 == tcp_stat[0].to_mcu);
+  CHECK(300 == tcp_stat[1].to_mcu);
+  CHECK(tcp_stat[0].max_latency > 0);
+  CHECK(-1 == tx_bit);
+  CHECK(expected.size() == transmitted.size());
+  // Both clients are served once per loop so their blocks interleave
+  std::vector<uint8_t> first_sent, second_sent;
+  uint32_t pos = 0;
+  uint32_t first_left = 1000, second_left = 300;
+  while (pos < transmitted.size()) {
+    uint32_t len = (first_left < 255) ? first_left : 255;
+    first_sent.insert(first_sent.end(), transmitted.begin() + pos, transmitted.begin() + pos + len);
+    pos += len;
+    first_left -= len;
+    len = (second_left < 255) ? second_left : 255;
+    second_sent.insert(second_sent.end(), transmitted.begin() + pos, transmitted.begin() + pos + len);
+    pos += len;
+    second_left -= len;
+  }
+  CHECK(std::vector<uint8_t>(expected.begin(), expected.begin() + 1000) == first_sent);
+  CHECK(std::vector<uint8_t>(expected.begin() + 1000, expected.end()) == second_sent);
+}
+
+// Debug log holds the full block as hex
+void TestLog(void) {
+  Setup();
+  std::shared_ptr<Connection> first = Connect();
+  need_log = true;
+  for (uint32_t i = 0; i < 255; i++) { TCPSerial->rxStore(i); }
+  first->to_device.push_back(0xAB);
+  TCPLoop();
+  CHECK(2 == logs.size());
+  std::string hex;
+  char digits[3];
+  for (uint32_t i = 0; i < 255; i++) {
+    snprintf(digits, sizeof(digits), "%02X", i);
+    hex += digits;
+  }
+  CHECK((logs.size() > 0) && (logs[0] == "TCP: from MCU: " + hex));
+  CHECK((logs.size() > 1) && (logs[1] == "TCP: to MCU/1: AB"));
+}
+
+// A new client replaces the oldest one when all connections are in use
+void TestReplace(void) {
+  Setup();
+  std::shared_ptr<Connection> first = Connect();
+  std::shared_ptr<Connection> second = Connect();
+  TCPSerial->rxStore(1);
+  TCPLoop();
+  CHECK(1 == tcp_stat[0].from_mcu);
+  TasmotaGlobal.uptime = 200;
+  std::shared_ptr<Connection> third = Connect();
+  CHECK(!first->open && second->open && third->open);
+  CHECK(client_tcp[0].conn == third);
+  CHECK(0 == tcp_stat[0].from_mcu);           // Counters restart with the client
+  CHECK(200 == tcp_stat[0].connected);
+  std::shared_ptr<Connection> fourth = Connect();
+  CHECK(!second->open && (client_tcp[1].conn == fourth));
+}
+
+int main(int argc, char* argv[]) {
+  digitalWriteHook = TxWrite;
+  tcp_buf = (uint8_t*)malloc(TCP_BRIDGE_BUF_SIZE);
+  server_tcp = new WiFiServer();
+  TCPSerial = new TasmotaSerial(4, kTxPin, 0, 0, TCP_BRIDGE_BUF_SIZE);
+  TCPSerial->begin(115200);
+
+  TestFromMcu();
+  TestToMcu();
+  TestLog();
+  TestReplace();
+  printf("%s\n", (failures) ? "FAILED" : "All tests passed");
+  return (failures) ? 1 : 0;
+}
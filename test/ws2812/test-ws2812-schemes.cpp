@@ -0,0 +1,261 @@
+/*
+  test-ws2812-schemes.cpp - Host test of the WS2812 gamma correction in xlgt_01_ws2812.ino
+
+  Renders the Gradient, Bars and Clock schemes on a simulated NeoPixelBus strip and checks that
+  Ws2812StripShow() correcting the strip buffer through the gamma table produces the same bytes
+  as the previous per pixel correction through GetPixelColor(), ledGamma() and SetPixelColor().
+  Built once for GRB and once for GRBW pixels.
+
+  Build and run with: make test
+  Time frames of 600 pixels with the previous and the table correction with: make bench
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+
+#define PROGMEM
+#define USE_WS2812_HARDWARE NEO_HW_WS2812X
+#define tmin(a,b) ((a)<(b)?(a):(b))
+
+#include "tasmota.h"
+
+#ifndef USE_WS2812_CTYPE
+#define USE_WS2812_CTYPE NEO_GRB
+#endif
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+const uint32_t kMaxPixels = 600;
+
+struct RgbColor {
+  uint8_t R, G, B;
+};
+
+struct RgbwColor {
+  uint8_t R, G, B, W;
+  RgbwColor(void) {}
+  RgbwColor(const RgbColor &c) : R(c.R), G(c.G), B(c.B), W(0) {}
+};
+
+// NeoPixelBus with NeoGrbFeature or NeoGrbwFeature buffer layout
+class Strip {
+  public:
+#if (USE_WS2812_CTYPE > NEO_3LED)
+    typedef RgbwColor Color;
+    static const uint32_t kPixelSize = 4;
+#else
+    typedef RgbColor Color;
+    static const uint32_t kPixelSize = 3;
+#endif
+    uint8_t buffer[kMaxPixels * kPixelSize];
+    bool dirty = false;
+    uint32_t shown = 0;
+
+    uint8_t *Pixels(void) { return buffer; }
+    size_t PixelSize(void) { return kPixelSize; }
+    void Dirty(void) { dirty = true; }
+    void Show(void) { dirty = false; shown++; }
+    void ClearTo(uint8_t value) { memset(buffer, value, sizeof(buffer)); dirty = true; }
+    Color GetPixelColor(uint32_t i) {
+      uint8_t *p = &buffer[i * kPixelSize];
+      Color c;
+      c.G = p[0];
+      c.R = p[1];
+      c.B = p[2];
+#if (USE_WS2812_CTYPE > NEO_3LED)
+      c.W = p[3];
+#endif
+      return c;
+    }
+    void SetPixelColor(uint32_t i, Color c) {
+      uint8_t *p = &buffer[i * kPixelSize];
+      p[0] = c.G;
+      p[1] = c.R;
+      p[2] = c.B;
+#if (USE_WS2812_CTYPE > NEO_3LED)
+      p[3] = c.W;
+#endif
+      dirty = true;
+    }
+};
+
+Strip *strip = nullptr;
+
+struct {
+  uint16_t light_pixels = kMaxPixels;
+  uint8_t light_correction = 1;
+  uint8_t light_dimmer = 80;
+  uint8_t light_width = 1;
+  uint8_t light_speed = 1;
+  uint16_t light_rotation = 0;
+  uint8_t ws_width[3] = { 1, 3, 5 };
+  uint8_t ws_color[4][3] = { { 255, 0, 255 }, { 255, 255, 0 }, { 0, 255, 0 }, { 255, 255, 255 } };
+  struct { uint32_t ws_clock_reverse : 1; } flag;
+} Settings;
+
+struct {
+  uint32_t strip_timer_counter = 0;
+} Light;
+
+struct {
+  uint8_t hour = 10, minute = 8, second = 37;
+} RtcTime;
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#include "support_float.h"
+#include "light.h"
+#include "ws2812_show.h"
+
+// Previous correction of every pixel through GetPixelColor(), ledGamma() and SetPixelColor()
+void Ws2812StripShowPixel(void)
+{
+  Strip::Color c;
+
+  if (Settings.light_correction) {
+    for (uint32_t i = 0; i < Settings.light_pixels; i++) {
+      c = strip->GetPixelColor(i);
+      c.R = ledGamma(c.R);
+      c.G = ledGamma(c.G);
+      c.B = ledGamma(c.B);
+#if (USE_WS2812_CTYPE > NEO_3LED)
+      c.W = ledGamma(c.W);
+#endif
+      strip->SetPixelColor(i, c);
+    }
+  }
+  strip->Show();
+}
+
+// Schemes show the strip through the selected correction
+void (*strip_show)(void) = Ws2812StripShow;
+#define Ws2812StripShow() strip_show()
+#include "ws2812_schemes.h"
+#undef Ws2812StripShow
+
+// Render a frame of scheme 0 (clock) or 1 to 7 as gradient or bars
+void Frame(uint32_t scheme, bool gradient) {
+  if (0 == scheme) {
+    Ws2812Clock();
+  } else if (gradient) {
+    Ws2812Gradient(scheme -1);
+  } else {
+    Ws2812Bars(scheme -1);
+  }
+}
+
+void TestBuffer(void) {
+  Strip reference;
+  srand(1);
+  for (uint32_t round = 0; round < 1000; round++) {
+    Settings.light_pixels = 1 + rand() % kMaxPixels;
+    for (uint32_t i = 0; i < sizeof(strip->buffer); i++) { strip->buffer[i] = rand(); }
+    memcpy(reference.buffer, strip->buffer, sizeof(strip->buffer));
+    strip_show = Ws2812StripShowPixel;
+    Strip *table = strip;
+    strip = &reference;
+    Ws2812StripShowPixel();
+    strip = table;
+    Ws2812StripShow();
+    if (memcmp(reference.buffer, strip->buffer, sizeof(strip->buffer))) {
+      CHECK(false, "round %u: %u pixels differ", round, Settings.light_pixels);
+      break;
+    }
+  }
+  CHECK(Ws2812.gamma != nullptr, "gamma table not allocated");
+
+  // Without light correction the buffer is shown as is
+  Settings.light_correction = 0;
+  memcpy(reference.buffer, strip->buffer, sizeof(strip->buffer));
+  Ws2812StripShow();
+  CHECK(!memcmp(reference.buffer, strip->buffer, sizeof(strip->buffer)), "changed without correction");
+  Settings.light_correction = 1;
+  Settings.light_pixels = kMaxPixels;
+}
+
+void TestSchemes(void) {
+  Strip table;
+  Strip pixel;
+  for (uint32_t width = 0; width < 5; width++) {
+    Settings.light_width = width;
+    for (uint32_t scheme = 0; scheme < WS2812_SCHEMES; scheme++) {
+      for (uint32_t gradient = 0; gradient < 2; gradient++) {
+        for (uint32_t counter = 0; counter < 400; counter += 37) {
+          Light.strip_timer_counter = counter;
+          RtcTime.second = counter % 60;
+          memset(table.buffer, 0, sizeof(table.buffer));
+          memset(pixel.buffer, 0, sizeof(pixel.buffer));
+          strip = &table;
+          strip_show = Ws2812StripShow;
+          Frame(scheme, gradient);
+          strip = &pixel;
+          strip_show = Ws2812StripShowPixel;
+          Frame(scheme, gradient);
+          if (memcmp(table.buffer, pixel.buffer, sizeof(table.buffer))) {
+            CHECK(false, "scheme %u, width %u, gradient %u, counter %u differs", scheme, width, gradient, counter);
+            return;
+          }
+          CHECK(!table.dirty && (table.shown == pixel.shown), "frame not shown");
+        }
+      }
+    }
+  }
+  Settings.light_width = 1;
+}
+
+double TimeFrames(uint32_t scheme, bool gradient) {
+  const uint32_t frames = 2000;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < frames; i++) {
+    Light.strip_timer_counter = i;
+    Frame(scheme, gradient);
+  }
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+void Bench(void) {
+  const char *names[] = { "Clock", "Gradient", "Bars" };
+  const uint32_t schemes[][2] = { { 0, 0 }, { 6, 1 }, { 6, 0 } };   // Rainbow for gradient and bars
+  printf("%u %s pixels, CPU time per frame without transmission:\n", kMaxPixels, (Strip::kPixelSize > 3) ? "GRBW" : "GRB");
+  for (uint32_t i = 0; i < 3; i++) {
+    double best[2] = { 1e30, 1e30 };
+    for (uint32_t round = 0; round < 5; round++) {
+      strip_show = Ws2812StripShowPixel;
+      double us = TimeFrames(schemes[i][0], schemes[i][1]);
+      if (us < best[0]) { best[0] = us; }
+      strip_show = Ws2812StripShow;
+      us = TimeFrames(schemes[i][0], schemes[i][1]);
+      if (us < best[1]) { best[1] = us; }
+    }
+    printf("  %-8s previous %6.1f us (%6.0f fps), table %6.1f us (%6.0f fps)\n", names[i], best[0], 1e6 / best[0], best[1], 1e6 / best[1]);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Strip frame;
+  strip = &frame;
+
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    Bench();
+    return 0;
+  }
+
+  TestBuffer();
+  TestSchemes();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    return 1;
+  }
+  printf("All tests passed\n");
+  return 0;
+}
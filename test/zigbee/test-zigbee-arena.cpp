@@ -0,0 +1,183 @@
+/*
+  test-zigbee-arena.cpp - Host test of the frame attribute arena in xdrv_23_zigbee_1z_libs.ino
+
+  Builds frame attribute lists with nested lists, key and string values from Z_Arena and checks
+  that a frame after the first one does no heap allocation, that the JSON is the same as with
+  heap lists, that copies into heap lists own no arena memory and outlive the frame, that large
+  values get their own block given back on release, and that the heap statistics are sampled
+  when a frame starts and when it is released, also for frames that allocated nothing.
+  Run it under ASAN with: make asan
+
+  Build and run with: make test
+*/
+
+#include <new>
+#include "zigbee_host.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+// Count heap allocations done with new
+uint32_t heap_news = 0;
+void * operator new(size_t size) {
+  heap_news++;
+  void * ptr = malloc(size ? size : 1);
+  if (!ptr) { throw std::bad_alloc(); }
+  return ptr;
+}
+void * operator new[](size_t size) { return operator new(size); }
+void operator delete(void * ptr) noexcept { free(ptr); }
+void operator delete[](void * ptr) noexcept { free(ptr); }
+void operator delete(void * ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void * ptr, size_t) noexcept { free(ptr); }
+
+// Attributes of a typical Aqara report, with a sub-list
+void BuildFrame(Z_attribute_list & attr_list, uint32_t n) {
+  char device[8];
+  snprintf(device, sizeof(device), "0x%04X", n);
+  attr_list.addAttributePMEM(PSTR("Device")).setStr(device);
+  attr_list.addAttribute(0x0402, 0x0000).setUInt(2150 + n);
+  attr_list.addAttribute(PSTR("ModelId"), true).setStr("lumi.weather");
+  Z_attribute_list & sub = attr_list.addAttributePMEM(PSTR("Endpoint")).newAttrList();
+  sub.addAttributePMEM(PSTR("LinkQuality")).setUInt(59);
+  sub.addAttribute("Name", "Suffix").setStr("kitchen");
+  attr_list.addAttribute(0x0405, 0x0000).setUInt(6000);
+}
+
+void TestNoHeap(void) {
+  String heap_json;
+  {
+    Z_attribute_list attr_list;
+    BuildFrame(attr_list, 1);
+    heap_json = attr_list.toString();
+  }
+  {
+    Z_attribute_list attr_list(true);         // First frame allocates the first block
+    BuildFrame(attr_list, 1);
+    CHECK(attr_list.toString() == heap_json, "arena JSON %s, heap JSON %s", attr_list.toString().c_str(), heap_json.c_str());
+    for (auto & attr : attr_list) {
+      CHECK(zigbee_arena.owns(&attr), "attribute not in arena");
+      if (attr.key_is_str && !attr.key_is_pmem) { CHECK(zigbee_arena.owns(attr.key.key), "key %s not in arena", attr.key.key); }
+      if (Za_type::Za_str == attr.type) { CHECK(zigbee_arena.owns(attr.val.sval), "value %s not in arena", attr.val.sval); }
+      if (Za_type::Za_obj == attr.type) { CHECK(zigbee_arena.owns(attr.val.objval), "sub-list not in arena"); }
+    }
+  }
+  for (uint32_t n = 0; n < 100; n++) {
+    uint32_t news = heap_news;
+    {
+      Z_attribute_list attr_list(true);
+      BuildFrame(attr_list, n);
+      attr_list.removeAttribute(attr_list.findAttribute(0x0405, 0x0000));
+      attr_list.removeAttribute(attr_list.findAttribute(PSTR("ModelId")));
+    }
+    if (heap_news != news) {
+      CHECK(false, "frame %u: %u heap allocations", n, heap_news - news);
+      break;
+    }
+  }
+  CHECK(0 == zigbee_arena.blocks, "%u blocks added", zigbee_arena.blocks);
+  CHECK(zigbee_arena.peak < Z_ARENA_BLOCK_SIZE, "peak %u", zigbee_arena.peak);
+}
+
+void TestCopy(void) {
+  Z_attribute_list pending;                   // Long lived like the pending attributes of a device
+  String expected;
+  {
+    Z_attribute_list heap_list;                // Same merge from a heap list
+    BuildFrame(heap_list, 2);
+    Z_attribute_list heap_pending;
+    heap_pending.mergeList(heap_list);
+    expected = heap_pending.toString();
+  }
+  {
+    Z_attribute_list attr_list(true);
+    BuildFrame(attr_list, 2);
+    pending.mergeList(attr_list);
+  }
+  {
+    Z_attribute_list attr_list(true);         // Overwrites the arena
+    BuildFrame(attr_list, 3);
+    CHECK(pending.toString() == expected, "copy %s after release", pending.toString().c_str());
+  }
+  for (auto & attr : pending) {
+    CHECK(!zigbee_arena.owns(&attr), "copied attribute in arena");
+    if (attr.key_is_str && !attr.key_is_pmem) { CHECK(!zigbee_arena.owns(attr.key.key), "copied key %s in arena", attr.key.key); }
+    if (Za_type::Za_str == attr.type) { CHECK(!zigbee_arena.owns(attr.val.sval), "copied value %s in arena", attr.val.sval); }
+    if ((Za_type::Za_obj == attr.type) && attr.val.objval) {    // copyVal() does not copy sub-lists
+      CHECK(!zigbee_arena.owns(attr.val.objval), "copied sub-list in arena");
+      for (auto & sub : *attr.val.objval) { CHECK(!zigbee_arena.owns(&sub), "copied sub-list attribute in arena"); }
+    }
+  }
+}
+
+void TestLarge(void) {
+  std::string large(3 * Z_ARENA_BLOCK_SIZE, 'x');
+  const char * value = nullptr;
+  uint32_t blocks = zigbee_arena.blocks;
+  {
+    Z_attribute_list attr_list(true);
+    BuildFrame(attr_list, 4);
+    Z_attribute_list inner(true);              // Second arena list alive in the same frame
+    inner.addAttributePMEM(PSTR("Large")).setStr(large.c_str());
+    value = inner.findAttribute(PSTR("Large"))->val.sval;
+    CHECK(zigbee_arena.owns(value) && (large == value), "large value not in arena");
+    BuildFrame(attr_list, 5);
+  }
+  CHECK(zigbee_arena.blocks > blocks, "no block added for a large value");
+  CHECK(!zigbee_arena.owns(value), "large block kept after release");
+  CHECK(zigbee_arena.peak > 3 * Z_ARENA_BLOCK_SIZE, "peak %u", zigbee_arena.peak);
+}
+
+void TestStats(void) {
+  zigbee_arena.resetStats();
+  CHECK(!zigbee_arena.frames && !zigbee_arena.peak && !zigbee_arena.heap_min_before && !zigbee_arena.heap_min_after, "stats not reset");
+
+  host_free_heap = 30000;
+  host_max_alloc_heap = 27000;
+  {
+    Z_attribute_list attr_list(true);
+    host_free_heap = 20000;                   // Frame leaves a fragmented heap
+    host_max_alloc_heap = 10000;
+    {
+      Z_attribute_list nested(true);          // Nested list samples nothing
+      host_free_heap = 10000;
+      host_max_alloc_heap = 1000;
+    }
+    host_free_heap = 20000;
+    host_max_alloc_heap = 10000;
+    BuildFrame(attr_list, 6);
+  }
+  CHECK(1 == zigbee_arena.frames, "%u frames", zigbee_arena.frames);
+  CHECK(30000 == zigbee_arena.heap_min_before && 10 == zigbee_arena.frag_max_before,
+    "before %u %u%%", zigbee_arena.heap_min_before, zigbee_arena.frag_max_before);
+  CHECK(20000 == zigbee_arena.heap_min_after && 50 == zigbee_arena.frag_max_after,
+    "after %u %u%%", zigbee_arena.heap_min_after, zigbee_arena.frag_max_after);
+
+  // Frame without attributes is counted and sampled
+  host_free_heap = 15000;
+  host_max_alloc_heap = 3000;
+  { Z_attribute_list attr_list(true); }
+  CHECK(2 == zigbee_arena.frames, "%u frames", zigbee_arena.frames);
+  CHECK(15000 == zigbee_arena.heap_min_before && 80 == zigbee_arena.frag_max_before,
+    "empty frame before %u %u%%", zigbee_arena.heap_min_before, zigbee_arena.frag_max_before);
+  CHECK(15000 == zigbee_arena.heap_min_after && 80 == zigbee_arena.frag_max_after,
+    "empty frame after %u %u%%", zigbee_arena.heap_min_after, zigbee_arena.frag_max_after);
+
+  // Heap lists leave the statistics alone
+  { Z_attribute_list attr_list; BuildFrame(attr_list, 7); }
+  CHECK(2 == zigbee_arena.frames, "%u frames after heap list", zigbee_arena.frames);
+}
+
+int main(int argc, char *argv[]) {
+  TestNoHeap();
+  TestCopy();
+  TestLarge();
+  TestStats();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    HostExit(1);
+  }
+  printf("All tests passed\n");
+  HostExit(0);
+}
@@ -0,0 +1,198 @@
+/*
+  test-zigbee-converters.cpp - Host test of the Z_PostProcess lookups in xdrv_23_zigbee_5_converters.ino
+
+  Z_findConverterById() is a binary search so Z_PostProcess must stay sorted by cluster and
+  attribute id. Checks the order, then that Z_findConverterById() and Z_findConverterByName()
+  return the same entry as a linear scan of the table for every entry and for unknown keys.
+  Replays ZCL attribute reports through the receive path up to Z_postProcessAttributes() and
+  checks the resulting attribute names against a linear scan and the expected JSON.
+
+  Build and run with: make test
+  Time id and name lookups of the replay against a linear scan with: make bench
+*/
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "zigbee_host.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+// Lookups of the previous implementation, first entry of the table wins
+int32_t LinearById(uint16_t cluster, uint16_t attr_id, bool catch_all = false) {
+  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    uint16_t conv_cluster = CxToCluster(pgm_read_byte(&Z_PostProcess[i].cluster_short));
+    uint16_t conv_attribute = pgm_read_word(&Z_PostProcess[i].attribute);
+    if ((conv_cluster == cluster) && ((conv_attribute == attr_id) || (catch_all && (conv_attribute == 0xFFFF)))) { return i; }
+  }
+  return -1;
+}
+
+int32_t LinearByName(const char *name, uint16_t cluster = 0xFFFF) {
+  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    if (0 == pgm_read_word(&Z_PostProcess[i].name_offset)) { continue; }
+    if ((0 == strcasecmp_P(name, Z_ConverterName(i))) &&
+        ((0xFFFF == cluster) || (cluster == CxToCluster(pgm_read_byte(&Z_PostProcess[i].cluster_short))))) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void TestSorted(void) {
+  CHECK(ARRAY_SIZE(Z_PostProcess) > 300, "%u entries", (uint32_t)ARRAY_SIZE(Z_PostProcess));
+  for (uint32_t i = 1; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    CHECK(Z_ConverterKey(i - 1) < Z_ConverterKey(i), "Z_PostProcess not sorted at entry %u: %08X after %08X",
+      i, Z_ConverterKey(i), Z_ConverterKey(i - 1));
+  }
+  CHECK(Z_ConverterSorted(), "Z_ConverterSorted() reports unsorted table");
+}
+
+void TestById(void) {
+  uint32_t clusters[64];
+  uint32_t cluster_count = 0;
+  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    uint16_t cluster = Z_ConverterKey(i) >> 16;
+    uint16_t attr_id = Z_ConverterKey(i) & 0xFFFF;
+    CHECK(Z_findConverterById(cluster, attr_id) == LinearById(cluster, attr_id),
+      "entry %u %04X/%04X: found %d", i, cluster, attr_id, Z_findConverterById(cluster, attr_id));
+    if (!cluster_count || (clusters[cluster_count - 1] != cluster)) {
+      if (cluster_count < ARRAY_SIZE(clusters)) { clusters[cluster_count++] = cluster; }
+    }
+  }
+  // Unknown attributes of known clusters, unknown clusters and clusters of 0x8000 and above
+  srand(1);
+  for (uint32_t n = 0; n < 100000; n++) {
+    uint16_t cluster = (n % 4) ? clusters[rand() % cluster_count] : rand();
+    uint16_t attr_id = (n % 3) ? rand() % 0x0120 : rand();
+    if (Z_findConverterById(cluster, attr_id) != LinearById(cluster, attr_id)) {
+      CHECK(false, "%04X/%04X: found %d, linear %d", cluster, attr_id, Z_findConverterById(cluster, attr_id), LinearById(cluster, attr_id));
+      break;
+    }
+  }
+  CHECK(-1 == Z_findConverterById(0xFFFF, 0xFFFF), "FFFF/FFFF found");
+}
+
+void TestByName(void) {
+  for (uint32_t i = 0; i < ARRAY_SIZE(Z_PostProcess); i++) {
+    if (0 == pgm_read_word(&Z_PostProcess[i].name_offset)) { continue; }
+    std::string name = Z_ConverterName(i);
+    std::string upper = name;
+    for (auto &c : upper) { c = toupper(c); }
+    uint16_t cluster = Z_ConverterKey(i) >> 16;
+    CHECK(Z_findConverterByName(name.c_str()) == LinearByName(name.c_str()), "%s", name.c_str());
+    CHECK(Z_findConverterByName(upper.c_str()) == LinearByName(upper.c_str()), "%s", upper.c_str());
+    CHECK(Z_findConverterByName(name.c_str(), cluster) == LinearByName(name.c_str(), cluster), "%s in %04X", name.c_str(), cluster);
+    CHECK(Z_findConverterByName((name + "x").c_str()) == -1, "%sx found", name.c_str());
+  }
+  CHECK(-1 == Z_findConverterByName(""), "empty name found");
+  CHECK(-1 == Z_findConverterByName("Temperature", 0x0006), "Temperature found in OnOff cluster");
+}
+
+// ZCL attribute report frames: cluster and hex of frame control, sequence, command 0x0A and attributes
+struct {
+  uint16_t cluster;
+  const char *frame;
+  const char *json;
+} kReports[] = {
+  { 0x0402, "18010A00002966080100291027",       "\"Temperature\":21.5,\"TemperatureMinMeasuredValue\":100" },
+  { 0x0405, "18020A00002170170100210000",       "\"Humidity\":60,\"HumidityMinMeasuredValue\":0" },
+  { 0x0403, "18030A000029F503",                 "\"Pressure\":1013,\"SeaPressure\":1013" },   // Synthetic at altitude 0
+  { 0x0006, "18040A00001001",                   "\"Power\":1" },
+  { 0x0008, "18050A000020FE",                   "\"Dimmer\":254" },
+  { 0x0300, "18060A03002133530400213A540700217001", "\"X\":21299,\"Y\":21562,\"CT\":368" },
+  { 0x0B04, "18070A0505215A0008052110000B05299C00", "\"RMSVoltage\":90,\"RMSCurrent\":16,\"ActivePower\":156" },
+  { 0x0001, "18080A20002020210020C8",           "\"BatteryVoltage\":3.2,\"BatteryPercentage\":100" },
+  { 0x0406, "18090A00001801",                   "\"Occupancy\":1" },
+  { 0xFC00, "180A0A01002005",                   "\"FC00/0001\":5" },              // Unknown cluster
+};
+
+void TestReplay(void) {
+  for (uint32_t r = 0; r < ARRAY_SIZE(kReports); r++) {
+    SBuffer buf = SBuffer::SBufferFromHex(kReports[r].frame, strlen(kReports[r].frame));
+    ZCLFrame zcl = ZCLFrame::parseRawFrame(buf, 0, buf.len(), kReports[r].cluster, 0,
+                                           0x1234, 1, 1, 0, 100, 0, r);
+    Z_attribute_list attr_list(true);
+    zcl.parseReportAttributes(attr_list);
+
+    // Expected names from a linear scan of the table before post processing
+    std::vector<std::string> expected;
+    for (auto &attr : attr_list) {
+      int32_t i = LinearById(attr.key.id.cluster, attr.key.id.attr_id, true);
+      if ((i >= 0) && (0 == CmToMultiplier(pgm_read_byte(&Z_PostProcess[i].multiplier_idx)))) { continue; }
+      expected.push_back((i >= 0) ? Z_ConverterName(i) : "");
+    }
+
+    zcl.generateSyntheticAttributes(attr_list);
+    zcl.removeInvalidAttributes(attr_list);
+    zcl.computeSyntheticAttributes(attr_list);
+    Z_postProcessAttributes(0x1234, 1, attr_list);
+
+    uint32_t n = 0;
+    for (auto &attr : attr_list) {
+      if (n >= expected.size()) { break; }    // Synthetic attributes are appended
+      if (expected[n].size()) {
+        CHECK(attr.key_is_str && !strcmp(attr.key.key, expected[n].c_str()), "report %u attribute %u: expected %s", r, n, expected[n].c_str());
+      } else {
+        CHECK(!attr.key_is_str, "report %u attribute %u: unexpected name %s", r, n, attr.key.key);
+      }
+      n++;
+    }
+    String json = attr_list.toString();
+    CHECK(json == kReports[r].json, "report %u: %s", r, json.c_str());
+  }
+}
+
+void Bench(void) {
+  // Attribute ids and names of the replay, looked up 100000 times
+  std::vector<std::pair<uint16_t, uint16_t>> ids;
+  std::vector<std::string> names;
+  for (uint32_t r = 0; r < ARRAY_SIZE(kReports); r++) {
+    SBuffer buf = SBuffer::SBufferFromHex(kReports[r].frame, strlen(kReports[r].frame));
+    ZCLFrame zcl = ZCLFrame::parseRawFrame(buf, 0, buf.len(), kReports[r].cluster, 0, 0x1234, 1, 1, 0, 100, 0, r);
+    Z_attribute_list attr_list(true);
+    zcl.parseReportAttributes(attr_list);
+    for (auto &attr : attr_list) {
+      ids.push_back(std::make_pair(attr.key.id.cluster, attr.key.id.attr_id));
+      int32_t i = LinearById(attr.key.id.cluster, attr.key.id.attr_id);
+      if ((i >= 0) && pgm_read_word(&Z_PostProcess[i].name_offset)) { names.push_back(Z_ConverterName(i)); }
+    }
+  }
+  const uint32_t rounds = 100000;
+  volatile int32_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < rounds; n++) { for (auto &id : ids) { sink += LinearById(id.first, id.second, true); } }
+  double linear = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * ids.size());
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < rounds; n++) { for (auto &id : ids) { sink += Z_findConverterById(id.first, id.second); } }
+  double indexed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * ids.size());
+  printf("%u entries, %u attributes of %u reports, id lookup: linear %.1f ns, binary search %.1f ns\n",
+    (uint32_t)ARRAY_SIZE(Z_PostProcess), (uint32_t)ids.size(), (uint32_t)ARRAY_SIZE(kReports), linear, indexed);
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < rounds; n++) { for (auto &name : names) { sink += LinearByName(name.c_str()); } }
+  linear = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * names.size());
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < rounds; n++) { for (auto &name : names) { sink += Z_findConverterByName(name.c_str()); } }
+  indexed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (rounds * names.size());
+  printf("%u names, name lookup: linear %.1f ns, hash %.1f ns\n", (uint32_t)names.size(), linear, indexed);
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    Bench();
+    HostExit(0);
+  }
+
+  TestSorted();
+  TestById();
+  TestByName();
+  TestReplay();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    HostExit(1);
+  }
+  printf("All tests passed\n");
+  HostExit(0);
+}
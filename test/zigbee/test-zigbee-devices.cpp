@@ -0,0 +1,212 @@
+/*
+  test-zigbee-devices.cpp - Host test of the Zigbee device index in xdrv_23_zigbee_2a_devices_impl.ino
+
+  Registers 200 devices in zigbee_devices and checks that findShortAddr(), findLongAddr() and
+  isKnownFriendlyNameDevice() return the same device as a linear scan of the device list, for
+  known and unknown keys, after devices are renamed, re-addressed, removed and added, and when
+  several devices share a friendly name. Checks that ZbReceived written by jsonPublishAttrList()
+  reports its length and the characters dropped when it does not fit in the response buffer.
+
+  Build and run with: make test
+  Time a flood of attribute reports from 200 devices with and without the index with: make bench
+*/
+
+#include <chrono>
+#include <vector>
+#include "zigbee_host.h"
+
+int failures = 0;
+#define CHECK(cond, ...) do { if (!(cond)) { printf("FAILED %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+// Lookups of the previous implementation, first device of the list wins
+const Z_Device & LinearShortAddr(uint16_t shortaddr) {
+  for (const auto & elem : zigbee_devices.getDevices()) {
+    if (elem.shortaddr == shortaddr) { return elem; }
+  }
+  return device_unk;
+}
+
+const Z_Device & LinearLongAddr(uint64_t longaddr) {
+  if (!longaddr) { return device_unk; }
+  for (const auto & elem : zigbee_devices.getDevices()) {
+    if (elem.longaddr == longaddr) { return elem; }
+  }
+  return device_unk;
+}
+
+const Z_Device & LinearFriendlyName(const char * name) {
+  if (!name[0]) { return device_unk; }
+  for (const auto & elem : zigbee_devices.getDevices()) {
+    if (elem.friendlyName && (strcasecmp(elem.friendlyName, name) == 0)) { return elem; }
+  }
+  return device_unk;
+}
+
+std::vector<uint16_t> short_addrs;
+std::vector<uint64_t> long_addrs;
+
+void AddDevice(uint32_t n) {
+  uint16_t shortaddr;
+  do { shortaddr = 1 + rand() % 0xFFF0; } while (zigbee_devices.foundDevice(LinearShortAddr(shortaddr)));
+  uint64_t longaddr = 0x00158D0000000000ULL | ((uint64_t)rand() << 8) | n;
+  Z_Device & device = zigbee_devices.updateDevice(shortaddr, longaddr);
+  char name[24];
+  snprintf(name, sizeof(name), "Sensor_%u", n);
+  device.setFriendlyName(name);
+  short_addrs.push_back(shortaddr);
+  long_addrs.push_back(longaddr);
+}
+
+// Random lookups of known and unknown keys, returns the number of mismatches
+uint32_t CompareLookups(uint32_t count) {
+  uint32_t mismatches = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t n = rand() % short_addrs.size();
+    bool known = rand() % 4;
+    uint16_t shortaddr = known ? short_addrs[n] : rand();
+    uint64_t longaddr = known ? long_addrs[n] : ((uint64_t)rand() << 32) | rand();
+    char name[24];
+    snprintf(name, sizeof(name), known ? "sensor_%u" : "Sensor_%ux", n);
+    if (&zigbee_devices.findShortAddr(shortaddr) != &LinearShortAddr(shortaddr)) {
+      CHECK(false, "shortaddr 0x%04X", shortaddr);
+      mismatches++;
+    }
+    if (&zigbee_devices.findLongAddr(longaddr) != &LinearLongAddr(longaddr)) {
+      CHECK(false, "longaddr 0x%016llX", (unsigned long long)longaddr);
+      mismatches++;
+    }
+    if (&zigbee_devices.isKnownFriendlyNameDevice(name) != &LinearFriendlyName(name)) {
+      CHECK(false, "friendly name %s", name);
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+void TestIndex(void) {
+  srand(1);
+  for (uint32_t n = 0; n < 200; n++) { AddDevice(n); }
+  CHECK(zigbee_devices.devicesSize() == 200, "%u devices", (uint32_t)zigbee_devices.devicesSize());
+  CHECK(0 == CompareLookups(100000), "lookups of 200 devices");
+
+  // Null and empty keys are never found
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.findLongAddr(0)), "longaddr 0");
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.isKnownFriendlyNameDevice("")), "empty name");
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.isKnownFriendlyNameDevice(nullptr)), "null name");
+
+  // Rename
+  zigbee_devices.findShortAddr(short_addrs[10]).setFriendlyName("Kitchen");
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.isKnownFriendlyNameDevice("Sensor_10")), "old name found");
+  CHECK(zigbee_devices.isKnownFriendlyNameDevice("KITCHEN").shortaddr == short_addrs[10], "new name");
+
+  // Device rejoins with a new shortaddr
+  uint16_t old_short = short_addrs[20];
+  short_addrs[20] = 0xFFF5;
+  zigbee_devices.updateDevice(short_addrs[20], long_addrs[20]);
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.findShortAddr(old_short)), "old shortaddr found");
+  CHECK(zigbee_devices.findShortAddr(short_addrs[20]).longaddr == long_addrs[20], "new shortaddr");
+  CHECK(zigbee_devices.findLongAddr(long_addrs[20]).shortaddr == short_addrs[20], "longaddr after rejoin");
+
+  // Remove
+  CHECK(zigbee_devices.removeDevice(short_addrs[30]), "remove");
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.findShortAddr(short_addrs[30])), "removed shortaddr found");
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.findLongAddr(long_addrs[30])), "removed longaddr found");
+  CHECK(!zigbee_devices.foundDevice(zigbee_devices.isKnownFriendlyNameDevice("Sensor_30")), "removed name found");
+
+  // Shared friendly name, first device in the list wins
+  zigbee_devices.findShortAddr(short_addrs[150]).setFriendlyName("Kitchen");
+  CHECK(zigbee_devices.isKnownFriendlyNameDevice("kitchen").shortaddr == short_addrs[10], "shared name");
+  zigbee_devices.findShortAddr(short_addrs[10]).setFriendlyName("");
+  CHECK(zigbee_devices.isKnownFriendlyNameDevice("kitchen").shortaddr == short_addrs[150], "shared name after rename");
+
+  // Growing past the table size
+  for (uint32_t n = 200; n < 300; n++) { AddDevice(n); }
+  CHECK(0 == CompareLookups(100000), "lookups of 300 devices");
+
+  // getShortAddr creates unknown devices which are found at the next lookup
+  Z_Device & created = zigbee_devices.getShortAddr(0xFFF6);
+  CHECK(&zigbee_devices.findShortAddr(0xFFF6) == &created, "created device");
+}
+
+// Attribute reports from 200 devices, each looks up the device and its friendly name
+void Bench(void) {
+  srand(1);
+  for (uint32_t n = 0; n < 200; n++) { AddDevice(n); }
+  const uint32_t reports = 2000000;
+  std::vector<uint16_t> flood(reports);
+  for (auto & shortaddr : flood) { shortaddr = short_addrs[rand() % short_addrs.size()]; }
+  volatile uintptr_t sink = 0;
+  double best[2] = { 1e30, 1e30 };
+  for (uint32_t round = 0; round < 5; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto shortaddr : flood) { sink += (uintptr_t)LinearShortAddr(shortaddr).friendlyName; }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / reports;
+    if (ns < best[0]) { best[0] = ns; }
+    start = std::chrono::steady_clock::now();
+    for (auto shortaddr : flood) { sink += (uintptr_t)zigbee_devices.getFriendlyName(shortaddr); }
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / reports;
+    if (ns < best[1]) { best[1] = ns; }
+  }
+  printf("%u attribute reports from 200 devices, shortaddr lookup: linear %.1f ns, indexed %.1f ns, %.1fx\n",
+    reports, best[0], best[1], best[0] / best[1]);
+
+  const uint32_t lookups = 200000;
+  std::vector<std::string> names(lookups);
+  for (auto & name : names) { name = "sensor_" + std::to_string(rand() % 200); }
+  best[0] = best[1] = 1e30;
+  for (uint32_t round = 0; round < 5; round++) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto & name : names) { sink += (uintptr_t)&LinearFriendlyName(name.c_str()); }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+    if (ns < best[0]) { best[0] = ns; }
+    start = std::chrono::steady_clock::now();
+    for (auto & name : names) { sink += (uintptr_t)&zigbee_devices.isKnownFriendlyNameDevice(name.c_str()); }
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / lookups;
+    if (ns < best[1]) { best[1] = ns; }
+  }
+  printf("%u friendly name lookups: linear %.1f ns, indexed %.1f ns, %.1fx\n", lookups, best[0], best[1], best[0] / best[1]);
+}
+
+void TestPublish(void) {
+  const Z_Device & device = zigbee_devices.findShortAddr(short_addrs[0]);
+  Z_attribute_list attr_list;
+  attr_list.addAttributePMEM(PSTR("Temperature")).setInt(2150);
+  attr_list.addAttributePMEM(PSTR("Weather")).setStr("sunny \"day\"");
+  mqtt_published = 0;
+  device.jsonPublishAttrList(PSTR(D_JSON_ZIGBEE_RECEIVED), attr_list);
+  std::string json = TasmotaGlobal.mqtt_data;
+  CHECK((response_length == json.size()) && !response_overflow, "length %u of %u, overflow %u", response_length, (uint32_t)json.size(), response_overflow);
+  char hex[8];
+  snprintf(hex, sizeof(hex), "0x%04X", device.shortaddr);
+  JsonParser parser(&json[0]);
+  CHECK(parser && parser.getRootObject()[PSTR(D_JSON_ZIGBEE_RECEIVED)].getObject()[hex].getObject().getInt(PSTR("Temperature"), 0) == 2150,
+    "response %s", TasmotaGlobal.mqtt_data);
+
+  // Too large for the response buffer, truncated and reported
+  for (uint32_t i = 0; i < 40; i++) {
+    char name[16];
+    snprintf(name, sizeof(name), "Attribute%02u", i);
+    attr_list.addAttribute(name).setStr("a value of thirty characters..");
+  }
+  device.jsonPublishAttrList(PSTR(D_JSON_ZIGBEE_RECEIVED), attr_list);
+  uint32_t len = strlen(TasmotaGlobal.mqtt_data);
+  CHECK((response_length == len) && (len == sizeof(TasmotaGlobal.mqtt_data) - 1), "truncated length %u of %u", response_length, len);
+  CHECK(response_overflow > 0, "overflow not reported");
+}
+
+int main(int argc, char *argv[]) {
+  if ((argc > 1) && !strcmp(argv[1], "-b")) {
+    Bench();
+    HostExit(0);
+  }
+
+  TestIndex();
+  TestPublish();
+
+  if (failures) {
+    printf("FAILED %d checks\n", failures);
+    HostExit(1);
+  }
+  printf("All tests passed\n");
+  HostExit(0);
+}
@@ -0,0 +1,153 @@
+/*
+  zigbee_host.h - Host replacement of the Tasmota core for tests that build the Zigbee driver
+
+  Defines the globals and core functions the Zigbee sources use and includes the driver files
+  in build order, with the prototypes the Arduino builder would generate for functions used
+  before their definition. Functions of driver files that are not built record nothing.
+*/
+
+#ifndef _ZIGBEE_HOST_H_
+#define _ZIGBEE_HOST_H_
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <math.h>
+#include <unistd.h>
+#include <JsonGenerator.h>
+#include <JsonParser.h>
+
+#define USE_ZIGBEE
+#define USE_ZIGBEE_ZNP
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcat_P strcat
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define MQTT_LWT_OFFLINE "Offline"
+#define MQTT_LWT_ONLINE "Online"
+
+#include "i18n.h"
+#include "tasmota.h"
+
+struct {
+  uint32_t utc_time = 1606816800;
+} Rtc;
+
+struct {
+  struct { uint32_t mqtt_sensor_retain : 1; } flag;
+  struct { uint32_t tuya_serial_mqtt_publish : 1; } flag3;
+  struct { uint32_t remove_zbreceived : 1, zb_topic_fname : 1, zigbee_distinct_topics : 1, zigbee_use_names : 1, zb_index_ep : 1; } flag4;
+  struct { uint32_t zb_disable_autoquery : 1; } flag5;
+  int16_t altitude;
+} Settings;
+
+struct {
+  char mqtt_topic[TOPSZ] = "zigbee";
+  char mqtt_data[MIN_MESSZ];
+} TasmotaGlobal;
+
+struct {
+  int32_t payload;
+} XdrvMailbox;
+
+uint32_t host_millis = 0;
+uint32_t millis(void) { return host_millis; }
+uint32_t host_free_heap = 30000;
+uint32_t host_max_alloc_heap = 20000;
+uint32_t ESP_getFreeHeap(void) { return host_free_heap; }
+uint32_t ESP_getMaxAllocHeap(void) { return host_max_alloc_heap; }
+
+void AddLog_P(uint32_t loglevel, const char *formatP, ...) {}
+
+int ResponseClear(void) { TasmotaGlobal.mqtt_data[0] = 0; return 0; }
+void ResponseInvalidate(void) {}
+uint32_t response_length = 0;                 // Length and characters dropped of the last streamed response
+uint32_t response_overflow = 0;
+void ResponseWritten(uint32_t len, uint32_t overflow) {
+  response_length = len;
+  response_overflow = overflow;
+}
+int Response_P(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(TasmotaGlobal.mqtt_data, sizeof(TasmotaGlobal.mqtt_data), format, args);
+  va_end(args);
+  return len;
+}
+
+uint32_t mqtt_published = 0;                  // Number of MQTT messages published
+char* MakeValidMqtt(uint32_t option, char* str) { return str; }
+char* GetTopic_P(char *stopic, uint32_t prefix, char *topic, const char* subtopic) {
+  snprintf(stopic, TOPSZ, "tele/%s/%s", topic, subtopic);
+  return stopic;
+}
+void MqttPublish(const char* topic, bool retained) { mqtt_published++; }
+void MqttPublishPrefixTopic_P(uint32_t prefix, const char* subtopic, bool retained) { mqtt_published++; }
+void MqttPublishPrefixTopicRulesProcess_P(uint32_t prefix, const char* subtopic, bool retained = false) { mqtt_published++; }
+bool XdrvRulesProcess(void) { return false; }
+
+char* ulltoa(unsigned long long value, char *str, int radix) {
+  char digits[65];
+  int i = 0;
+  do { digits[i++] = "0123456789ABCDEF"[value % radix]; value /= radix; } while (value);
+  for (int j = 0; j < i; j++) { str[j] = digits[i -1 -j]; }
+  str[i] = 0;
+  return str;
+}
+char* dtostrf(double number, signed char width, unsigned char prec, char *s) {
+  sprintf(s, "%*.*f", width, prec, number);
+  return s;
+}
+
+char* ToHex_P(const unsigned char * in, size_t insz, char * out, size_t outsz, char inbetween = '\0');
+
+#include "support.h"                          // Extracted from support.ino
+#include "support_float.h"                    // Extracted from support_float.ino
+#include "zigbee_hex.h"                       // Extracted from xdrv_23_zigbee_6_commands.ino
+
+class SBuffer;
+class Z_attribute;
+class Z_attribute_list;
+class ZCLFrame;
+class ZigbeeZCLSendMessage;
+void Z_OccupancyCallback(uint16_t shortaddr, uint16_t groupaddr, uint16_t cluster, uint8_t endpoint, uint32_t value);
+void Z_ReadAttrCallback(uint16_t shortaddr, uint16_t groupaddr, uint16_t cluster, uint8_t endpoint, uint32_t value);
+void Z_Unreachable(uint16_t shortaddr, uint16_t groupaddr, uint16_t cluster, uint8_t endpoint, uint32_t value);
+void convertClusterSpecific(class Z_attribute_list &attr_list, uint16_t cluster, uint8_t cmd, bool direction, uint16_t shortaddr, uint8_t srcendpoint, const SBuffer &payload);
+void Z_postProcessAttributes(uint16_t shortaddr, uint16_t src_ep, class Z_attribute_list& attr_list);
+void ZigbeeZCLSend_Raw(const ZigbeeZCLSendMessage &zcl);
+void saveZigbeeDevices(void) {}
+
+#pragma GCC diagnostic push                   // Driver sources are only warning free with the ESP toolchain
+#pragma GCC diagnostic ignored "-Waddress"
+#pragma GCC diagnostic ignored "-Wnonnull-compare"
+#pragma GCC diagnostic ignored "-Wstrict-aliasing"
+#pragma GCC diagnostic ignored "-Wrestrict"
+#pragma GCC diagnostic ignored "-Wuse-after-free"
+#define strchr(s, c) ((char*)strchr(s, c))   // Returns char* like the C library of the ESP toolchain
+#include "support_static_buffer.ino"
+#include "support_light_list.ino"
+#include "xdrv_23_zigbee_0_constants.ino"
+#include "xdrv_23_zigbee_1_headers.ino"
+#include "xdrv_23_zigbee_1z_libs.ino"
+#include "xdrv_23_zigbee_2_devices.ino"
+#include "xdrv_23_zigbee_2a_devices_impl.ino"
+#include "xdrv_23_zigbee_5__constants.ino"
+#include "xdrv_23_zigbee_5_converters.ino"
+#undef strchr
+#pragma GCC diagnostic pop
+
+// Defined in driver files that are not built
+void Z_ReadAttrCallback(uint16_t shortaddr, uint16_t groupaddr, uint16_t cluster, uint8_t endpoint, uint32_t value) {}
+void Z_Unreachable(uint16_t shortaddr, uint16_t groupaddr, uint16_t cluster, uint8_t endpoint, uint32_t value) {}
+void convertClusterSpecific(class Z_attribute_list &attr_list, uint16_t cluster, uint8_t cmd, bool direction, uint16_t shortaddr, uint8_t srcendpoint, const SBuffer &payload) {}
+void ZigbeeZCLSend_Raw(const ZigbeeZCLSendMessage &zcl) {}
+void ZCLFrame::autoResponder(const uint16_t *attr_list_ids, size_t attr_len) {}
+
+// Leave without destroying globals as the device never does. LList<Z_Data> of the devices
+// deletes Z_Data_Thermo and other derived elements through the base type.
+void HostExit(int code) {
+  fflush(stdout);
+  _exit(code);
+}
+
+#endif  // _ZIGBEE_HOST_H_